@@ -108,10 +108,18 @@ Collection(url, lazy)
     return dlite_collection_create(id);
   }
   _DLiteCollection(struct _DLiteStorage *storage, const char *id, int lazy=0) {
-    return dlite_collection_load(storage, id, lazy);
+    DLiteCollection *coll;
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
+    coll = dlite_collection_load(storage, id, lazy);
+    DLITE_SWIG_END_ALLOW_THREADS
+    return coll;
   }
   _DLiteCollection(const char *url, int lazy) {
-    return dlite_collection_load_url(url, lazy);
+    DLiteCollection *coll;
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
+    coll = dlite_collection_load_url(url, lazy);
+    DLITE_SWIG_END_ALLOW_THREADS
+    return coll;
   }
 
   ~_DLiteCollection(void) {
@@ -120,15 +128,21 @@ Collection(url, lazy)
 
   %feature("docstring", "Saves this instance to url or storage.") save;
   void save(struct _DLiteStorage *storage) {
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
     dlite_collection_save($self, storage);
+    DLITE_SWIG_END_ALLOW_THREADS
   }
   void save(const char *url) {
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
     dlite_collection_save_url($self, url);
+    DLITE_SWIG_END_ALLOW_THREADS
   }
   void save(const char *driver, const char *path, const char *options=NULL) {
     DLiteStorage *s;
     if ((s = dlite_storage_open(driver, path, options))) {
+      DLITE_SWIG_BEGIN_ALLOW_THREADS
       dlite_collection_save($self, s);
+      DLITE_SWIG_END_ALLOW_THREADS
       dlite_storage_close(s);
     }
   }
@@ -172,6 +172,42 @@ def standardise(v, asdict=True):
     return strdup(buff);
   }
 
+  %feature("docstring", "\
+Lets dimensional property `name` use the data of numpy array `arr`
+without copying it.  The array must have the same dtype and shape as
+the property and be C-contiguous, aligned and writable.
+
+The instance keeps a reference to `arr` and writes to the property
+are visible in `arr` (and vice versa) until the property is resized.
+") adopt_property;
+  void adopt_property(const char *name, obj_t *arr) {
+    int i;
+    if ((i = dlite_meta_get_property_index($self->meta, name)) < 0) return;
+    dlite_swig_adopt_property_by_index($self, i, arr);
+  }
+
+  %feature("docstring", "\
+Returns a PropertyBuffer exposing the data of property `name` without
+copying.  It supports the buffer protocol (`memoryview(buf)`,
+`numpy.asarray(buf)`) and DLPack (`numpy.from_dlpack(buf)`).
+
+The buffer keeps a reference to the instance.  The exported memory
+becomes invalid if the property is resized.
+") get_property_buffer;
+  %newobject get_property_buffer;
+  obj_t *get_property_buffer(const char *name) {
+    int i;
+    if ((i = dlite_meta_get_property_index($self->meta, name)) < 0)
+      return NULL;
+    return dlite_swig_property_buffer($self, i);
+  }
+
+  void _assign_column(const char *name, obj_t *column) {
+    int i;
+    if ((i = dlite_meta_get_property_index($self->meta, name)) < 0) return;
+    dlite_swig_assign_column_by_index($self, i, column);
+  }
+
   %newobject _c_ptr;
   PyObject *_c_ptr(void) {
     return PyCapsule_New($self, NULL, NULL);
@@ -213,6 +249,21 @@ def standardise(v, asdict=True):
     def __contains__(self, item):
         return item in self.properties.keys()
 
+    def assign_columns(self, columns):
+        """Assigns dimensional properties from `columns`, which should be
+        a mapping of property names to arrays (like a dict of numpy
+        arrays or a pandas DataFrame).
+
+        Unlike item assignment, there is no per-element conversion.
+        Numerical and boolean columns are converted to the property type
+        in one vectorised operation and their buffers are moved into the
+        instance without copying whenever possible.  Hence, writes to
+        the instance may be visible in the original arrays and vice
+        versa.  String columns are copied into a single string heap.
+        """
+        for name in columns.keys():
+            self._assign_column(name, columns[name])
+
     def __getattr__(self, name):
         if name == 'this':
             return object.__getattribute__(self, name)
@@ -305,3 +356,31 @@ def standardise(v, asdict=True):
   %}
 
 }
+
+
+/* ----------------
+ * Module functions
+ * ---------------- */
+%{
+/* Returns a new reference to the instance in capsule `cap`, as
+   returned by Instance._c_ptr(). */
+struct _DLiteInstance *dlite_swig_from_c_ptr(obj_t *cap)
+{
+  DLiteInstance *inst;
+  if (!PyCapsule_CheckExact(cap))
+    return dlite_err(1, "expected a capsule"), NULL;
+  if (!(inst = PyCapsule_GetPointer(cap, NULL)))
+    return dlite_err(1, "cannot get instance pointer from capsule"), NULL;
+  dlite_instance_incref(inst);
+  return inst;
+}
+%}
+
+%feature("docstring", "\
+Returns a new reference to the instance in capsule `cap`, as returned
+by Instance._c_ptr().  Used by the embedding layer to wrap instances
+without looking them up by id.
+") dlite_swig_from_c_ptr;
+%rename(_from_c_ptr) dlite_swig_from_c_ptr;
+%newobject dlite_swig_from_c_ptr;
+struct _DLiteInstance *dlite_swig_from_c_ptr(obj_t *cap);
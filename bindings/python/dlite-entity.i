@@ -290,7 +290,10 @@ struct _DLiteInstance {
     return inst;
   }
   _DLiteInstance(const char *url, const char *metaid=NULL) {
-    DLiteInstance *inst2, *inst = dlite_instance_load_url(url);
+    DLiteInstance *inst2, *inst;
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
+    inst = dlite_instance_load_url(url);
+    DLITE_SWIG_END_ALLOW_THREADS
     if (inst) {
       dlite_errclr();
       if (metaid) {
@@ -303,7 +306,10 @@ struct _DLiteInstance {
   }
   _DLiteInstance(struct _DLiteStorage *storage, const char *id=NULL,
                  const char *metaid=NULL) {
-    DLiteInstance *inst = dlite_instance_load_casted(storage, id, metaid);
+    DLiteInstance *inst;
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
+    inst = dlite_instance_load_casted(storage, id, metaid);
+    DLITE_SWIG_END_ALLOW_THREADS
     if (inst) dlite_errclr();
     return inst;
   }
@@ -312,7 +318,9 @@ struct _DLiteInstance {
     DLiteStorage *s;
     DLiteInstance *inst;
     if (!(s = dlite_storage_open(driver, location, options))) return NULL;
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
     inst = dlite_instance_load(s, id);
+    DLITE_SWIG_END_ALLOW_THREADS
     dlite_storage_close(s);
     if (inst) dlite_errclr();
     return inst;
@@ -352,15 +360,21 @@ struct _DLiteInstance {
 
   %feature("docstring", "Saves this instance to url or storage.") save;
   void save(const char *url) {
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
     dlite_instance_save_url(url, $self);
+    DLITE_SWIG_END_ALLOW_THREADS
   }
   void save(struct _DLiteStorage *storage) {
+    DLITE_SWIG_BEGIN_ALLOW_THREADS
     dlite_instance_save(storage, $self);
+    DLITE_SWIG_END_ALLOW_THREADS
   }
   void save(const char *driver, const char *path, const char *options=NULL) {
     DLiteStorage *s;
     if ((s = dlite_storage_open(driver, path, options))) {
+      DLITE_SWIG_BEGIN_ALLOW_THREADS
       dlite_instance_save(s, $self);
+      DLITE_SWIG_END_ALLOW_THREADS
       dlite_storage_close(s);
     }
   }
@@ -452,6 +466,18 @@ struct _DLiteInstance {
     return dlite_instance_decref($self);
   }
 
+  %feature("docstring", "\
+Returns a copy of this instance with id `newid`.
+
+If `cow` is true, the copy shares the data of dimensional properties
+with this instance until either of them writes to it (copy-on-write).
+") copy;
+  %newobject copy;
+  struct _DLiteInstance *copy(const char *newid=NULL, bool cow=false) {
+    if (cow) return dlite_instance_copy_cow($self, newid);
+    return dlite_instance_copy($self, newid);
+  }
+
 };
 
 
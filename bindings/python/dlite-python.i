@@ -12,6 +12,8 @@
 #include "floats.h"
 #include "dlite.h"
 
+#include <pythread.h>
+
 #define DLITE_INSTANCE_CAPSULA_NAME ((char *)"dlite.Instance")
 #define DLITE_DATA_CAPSULA_NAME ((char *)"dlite.data")
 
@@ -19,6 +21,7 @@
 
   /* forward declarations */
   static PyObject *DLiteError = NULL;
+  static PyThread_type_lock dlite_swig_lock_handle = NULL;
   char *strndup(const char *s, size_t n);
 %}
 
@@ -29,6 +32,13 @@ typedef PyObject obj_t;
 #define DLiteSwigNone Py_None
 %}
 
+/* Releases the GIL around C code that does not access Python objects,
+   allowing other Python threads to run. */
+%{
+#define DLITE_SWIG_BEGIN_ALLOW_THREADS Py_BEGIN_ALLOW_THREADS
+#define DLITE_SWIG_END_ALLOW_THREADS Py_END_ALLOW_THREADS
+%}
+
 /* Forward declarations */
 %{
 obj_t *dlite_swig_get_scalar(DLiteType type, size_t size, void *data);
@@ -60,6 +70,8 @@ int dlite_swig_set_scalar(void *ptr, DLiteType type, size_t size, obj_t *obj);
     NULL,                                    // base
     NULL                                     // dict
   );
+  dlite_swig_lock_handle = PyThread_allocate_lock();
+  PyType_Ready(&DLiteSwigPropertyBufferType);
 %}
 
 %numpy_typemaps(unsigned char, NPY_UBYTE,  size_t)
@@ -209,6 +221,46 @@ void dlite_swig_errclr(void)
 }
 
 
+/*
+  Calls into dlite from Python are serialised by a recursive lock,
+  since the GIL is released around heavy C calls (see
+  DLITE_SWIG_BEGIN_ALLOW_THREADS) and dlite itself is not thread safe.
+
+  To avoid deadlocks with plugins that acquire the GIL, the lock is
+  never waited for while holding the GIL.
+*/
+static unsigned long dlite_swig_lock_owner = 0;
+static int dlite_swig_lock_count = 0;
+
+/* Acquires the dlite lock.  Must be called with the GIL held. */
+void dlite_swig_lock(void)
+{
+  unsigned long ident = PyThread_get_thread_ident();
+  if (!dlite_swig_lock_handle) return;
+  if (dlite_swig_lock_count && dlite_swig_lock_owner == ident) {
+    dlite_swig_lock_count++;
+    return;
+  }
+  if (!PyThread_acquire_lock(dlite_swig_lock_handle, NOWAIT_LOCK)) {
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(dlite_swig_lock_handle, WAIT_LOCK);
+    Py_END_ALLOW_THREADS
+  }
+  dlite_swig_lock_owner = ident;
+  dlite_swig_lock_count = 1;
+}
+
+/* Releases the dlite lock. */
+void dlite_swig_unlock(void)
+{
+  if (!dlite_swig_lock_handle) return;
+  if (--dlite_swig_lock_count == 0) {
+    dlite_swig_lock_owner = 0;
+    PyThread_release_lock(dlite_swig_lock_handle);
+  }
+}
+
+
 /* Returns a new array object for the target language or NULL on error.
 
    `inst` : The DLite instance that own the data. If NULL, the returned
@@ -935,7 +987,7 @@ int dlite_swig_set_scalar(void *ptr, DLiteType type, size_t size, obj_t *obj)
 obj_t *dlite_swig_get_property_by_index(DLiteInstance *inst, int i)
 {
   int j, n=i, *dims=NULL;
-  void **ptr;
+  void *data;
   DLiteProperty *p;
   obj_t *obj=NULL;
 
@@ -944,18 +996,27 @@ obj_t *dlite_swig_get_property_by_index(DLiteInstance *inst, int i)
   if (n < 0 || n >= (int)inst->meta->_nproperties)
     return dlite_err(-1, "Property index is out or range: %d", i), NULL;
   dlite_instance_sync_to_properties(inst);
-  ptr = DLITE_PROP(inst, n);
   p = inst->meta->_properties + n;
   if (p->ndims == 0) {
-    obj = dlite_swig_get_scalar(p->type, p->size, ptr);
+    obj = dlite_swig_get_scalar(p->type, p->size, DLITE_PROP(inst, n));
   } else {
+    /* Arrays of non-allocated types are returned as writable views
+       into the property data.  Request a writable pointer for them,
+       such that buffers shared with copy-on-write copies are unshared
+       first.  Other arrays are copied. */
+    dlite_errclr();
+    if (dlite_type_is_allocated(p->type))
+      data = (void *)dlite_instance_peek_property_by_index(inst, n);
+    else
+      data = dlite_instance_get_property_by_index(inst, n);
+    if (!data && dlite_errval()) goto fail;
     if (!(dims = malloc(p->ndims*sizeof(int)))) FAIL("allocation failure");
     for (j=0; j<p->ndims; j++) {
       if (!p->dims[j])
         FAIL2("missing dimension %d of property %d", j, i);
-      dims[j] = (int)DLITE_PROP_DIM(inst, i, j);
+      dims[j] = (int)DLITE_PROP_DIM(inst, n, j);
     }
-    obj = dlite_swig_get_array(inst, p->ndims, dims, p->type, p->size, *ptr);
+    obj = dlite_swig_get_array(inst, p->ndims, dims, p->type, p->size, data);
   }
  fail:
   if (dims) free(dims);
@@ -976,9 +1037,15 @@ int dlite_swig_set_property_by_index(DLiteInstance *inst, int i, obj_t *obj)
   if (n < 0) n += (int)inst->meta->_nproperties;
   if (n < 0 || n >= (int)inst->meta->_nproperties)
     FAIL1("Property index is out or range: %d", i);
-  ptr = DLITE_PROP(inst, n);
   p = inst->meta->_properties + n;
 
+  /* Request a writable pointer, such that shared buffers and string
+     heaps are unpacked. */
+  dlite_errclr();
+  if (!dlite_instance_get_property_by_index(inst, n) && dlite_errval())
+    goto fail;
+  ptr = DLITE_PROP(inst, n);
+
   if (p->ndims == 0) {
     if (dlite_swig_set_scalar(ptr, p->type, p->size, obj)) goto fail;
   } else {
@@ -999,6 +1066,490 @@ int dlite_swig_set_property_by_index(DLiteInstance *inst, int i, obj_t *obj)
   return status;
 }
 
+
+/* Releases the reference to Python object `owner`.  Called when an
+   instance no longer uses an adopted array buffer, possibly from a
+   thread not holding the GIL. */
+static void dlite_swig_release_pyobject(void *owner)
+{
+  PyGILState_STATE gstate = PyGILState_Ensure();
+  Py_DECREF((PyObject *)owner);
+  PyGILState_Release(gstate);
+}
+
+/* Lets dimensional property `i` use the data of numpy array `obj`
+   without copying.  The array must have the same type and shape as
+   the property and be C-contiguous, aligned and writable.  The
+   instance keeps a reference to the array until it no longer uses
+   its data.  Returns non-zero on error. */
+int dlite_swig_adopt_property_by_index(DLiteInstance *inst, int i, obj_t *obj)
+{
+  int j, n=i, typecode;
+  DLiteProperty *p;
+  PyArrayObject *arr = (PyArrayObject *)obj;
+
+  if (n < 0) n += (int)inst->meta->_nproperties;
+  if (n < 0 || n >= (int)inst->meta->_nproperties)
+    return dlite_err(-1, "Property index is out or range: %d", i);
+  p = inst->meta->_properties + n;
+  if (p->ndims <= 0 || p->type == dliteFixString ||
+      dlite_type_is_allocated(p->type))
+    return dlite_err(-1, "cannot adopt array for property '%s'", p->name);
+  if ((typecode = npy_type(p->type, p->size)) < 0) return -1;
+  if (!PyArray_Check(obj))
+    return dlite_err(-1, "property '%s' can only adopt numpy arrays",
+                     p->name);
+  if (!PyArray_EquivTypenums(PyArray_TYPE(arr), typecode) ||
+      PyArray_ITEMSIZE(arr) != (npy_intp)p->size ||
+      !PyArray_ISNOTSWAPPED(arr))
+    return dlite_err(-1, "array type does not match property '%s'",
+                     p->name);
+  if (!PyArray_ISCARRAY(arr))
+    return dlite_err(-1, "cannot adopt array that is not C-contiguous, "
+                     "aligned and writable");
+  if (dlite_instance_sync_to_dimension_sizes(inst)) return -1;
+  if (PyArray_NDIM(arr) != p->ndims)
+    return dlite_err(-1, "expected array with %d dimensions, got %d",
+                     p->ndims, PyArray_NDIM(arr));
+  for (j=0; j<p->ndims; j++)
+    if (PyArray_DIM(arr, j) != (npy_intp)DLITE_PROP_DIM(inst, n, j))
+      return dlite_err(-1, "expected length of dimension %d to be %d, "
+                       "got %ld", j, (int)DLITE_PROP_DIM(inst, n, j),
+                       (long)PyArray_DIM(arr, j));
+
+  Py_INCREF(obj);
+  if (dlite_instance_adopt_property(inst, n, PyArray_DATA(arr),
+                                    dlite_swig_release_pyobject, obj)) {
+    Py_DECREF(obj);
+    return -1;
+  }
+  return 0;
+}
+
+/* Help function for dlite_swig_assign_column_by_index().  Assigns the
+   sequence of strings `obj` to string array property `n` using a
+   single string heap.  Elements that are not strings (like None or
+   NaN for missing values in pandas) are assigned NULL.
+   Returns non-zero on error. */
+static int dlite_swig_assign_strings(DLiteInstance *inst, int n, obj_t *obj,
+                                     size_t nelem)
+{
+  int retval=-1;
+  Py_ssize_t k, len;
+  size_t size=0;
+  char **strings, *heap;
+  const char *s;
+  PyObject *seq, **items;
+  DLiteProperty *p = inst->meta->_properties + n;
+
+  if (!(seq = PySequence_Fast(obj, "expected a sequence of strings"))) {
+    PyErr_Clear();
+    return dlite_err(-1, "cannot assign non-sequence to property '%s'",
+                     p->name);
+  }
+  if ((size_t)PySequence_Fast_GET_SIZE(seq) != nelem)
+    FAIL3("expected %lu strings for property '%s', got %ld",
+          (unsigned long)nelem, p->name,
+          (long)PySequence_Fast_GET_SIZE(seq));
+  items = PySequence_Fast_ITEMS(seq);
+  for (k=0; k < (Py_ssize_t)nelem; k++) {
+    if (!PyUnicode_Check(items[k])) continue;
+    if (!PyUnicode_AsUTF8AndSize(items[k], &len)) {
+      PyErr_Clear();
+      FAIL1("cannot encode string in property '%s' as UTF-8", p->name);
+    }
+    size += len + 1;
+  }
+  if (!(heap = dlite_instance_string_heap(inst, n, size))) goto fail;
+  strings = *(char ***)DLITE_PROP(inst, n);
+  for (k=0, size=0; k < (Py_ssize_t)nelem; k++) {
+    if (!PyUnicode_Check(items[k])) continue;
+    s = PyUnicode_AsUTF8AndSize(items[k], &len);
+    memcpy(heap + size, s, len + 1);
+    strings[k] = heap + size;
+    size += len + 1;
+  }
+  retval = 0;
+ fail:
+  Py_DECREF(seq);
+  return retval;
+}
+
+/* Assigns the column `obj` to dimensional property `i` without
+   per-element conversions.
+
+   Numerical and boolean columns are converted to a C-contiguous numpy
+   array of the property type (which is a no-op if `obj` already is
+   such an array) and adopted by the instance without copying, see
+   dlite_swig_adopt_property_by_index().  String columns are copied
+   into a single string heap.  Other types are assigned with
+   dlite_swig_set_property_by_index().
+
+   Returns non-zero on error. */
+int dlite_swig_assign_column_by_index(DLiteInstance *inst, int i, obj_t *obj)
+{
+  int j, n=i, typecode, retval=-1;
+  size_t nelem=1;
+  DLiteProperty *p;
+  PyObject *arr=NULL, *reshaped=NULL;
+  npy_intp dims[NPY_MAXDIMS];
+
+  if (n < 0) n += (int)inst->meta->_nproperties;
+  if (n < 0 || n >= (int)inst->meta->_nproperties)
+    return dlite_err(-1, "Property index is out or range: %d", i);
+  p = inst->meta->_properties + n;
+  if (p->ndims <= 0 || p->ndims > NPY_MAXDIMS)
+    return dlite_swig_set_property_by_index(inst, n, obj);
+  if (dlite_instance_sync_to_dimension_sizes(inst)) return -1;
+  for (j=0; j < p->ndims; j++) {
+    dims[j] = DLITE_PROP_DIM(inst, n, j);
+    nelem *= dims[j];
+  }
+
+  switch (p->type) {
+  case dliteBool:
+  case dliteInt:
+  case dliteUInt:
+  case dliteFloat:
+    break;
+  case dliteStringPtr:
+    return dlite_swig_assign_strings(inst, n, obj, nelem);
+  default:
+    return dlite_swig_set_property_by_index(inst, n, obj);
+  }
+
+  if ((typecode = npy_type(p->type, p->size)) < 0) return -1;
+  if (!(arr = PyArray_FROM_OTF(obj, typecode, NPY_ARRAY_CARRAY |
+                               NPY_ARRAY_FORCECAST)))
+    FAIL1("cannot convert column to the type of property '%s'", p->name);
+  if ((size_t)PyArray_SIZE((PyArrayObject *)arr) != nelem)
+    FAIL3("expected %lu elements for property '%s', got %ld",
+          (unsigned long)nelem, p->name,
+          (long)PyArray_SIZE((PyArrayObject *)arr));
+  if (PyArray_NDIM((PyArrayObject *)arr) != p->ndims) {
+    PyArray_Dims shape = {dims, p->ndims};
+    if (!(reshaped = PyArray_Newshape((PyArrayObject *)arr, &shape,
+                                      NPY_CORDER)))
+      FAIL1("cannot reshape column for property '%s'", p->name);
+  }
+  retval = dlite_swig_adopt_property_by_index(inst, n,
+                                              (reshaped) ? reshaped : arr);
+ fail:
+  if (retval) PyErr_Clear();
+  Py_XDECREF(reshaped);
+  Py_XDECREF(arr);
+  return retval;
+}
+
+
+
+/**********************************************
+ ** Property buffers
+ **********************************************/
+
+/*
+  A PropertyBuffer exposes the data of a property of an instance
+  without copying, via the Python buffer protocol and DLPack.  It
+  holds a reference to the instance.  The exported memory becomes
+  invalid if the property is resized.
+*/
+typedef struct {
+  PyObject_HEAD
+  DLiteInstance *inst;  /* new reference to the instance */
+  int index;            /* property index */
+} DLiteSwigPropertyBuffer;
+
+/* Memory owned by a buffer view: format string, shape and strides */
+typedef struct {
+  char format[24];
+  Py_ssize_t dims[];  /* shape followed by strides */
+} DLiteSwigViewInfo;
+
+/* Minimal DLPack (v0.x) ABI, see https://github.com/dmlc/dlpack */
+typedef struct {
+  int32_t device_type;  /* 1: kDLCPU */
+  int32_t device_id;
+} DLiteSwigDLDevice;
+
+typedef struct {
+  uint8_t code;         /* 0: int, 1: uint, 2: float, 6: bool */
+  uint8_t bits;
+  uint16_t lanes;
+} DLiteSwigDLDataType;
+
+typedef struct {
+  void *data;
+  DLiteSwigDLDevice device;
+  int32_t ndim;
+  DLiteSwigDLDataType dtype;
+  int64_t *shape;
+  int64_t *strides;
+  uint64_t byte_offset;
+} DLiteSwigDLTensor;
+
+typedef struct DLiteSwigDLManagedTensor {
+  DLiteSwigDLTensor dl_tensor;
+  void *manager_ctx;
+  void (*deleter)(struct DLiteSwigDLManagedTensor *self);
+} DLiteSwigDLManagedTensor;
+
+
+/* Writes the struct format character of `type` and `size` to
+   `format`.  Returns non-zero if the type has no buffer format. */
+static int dlite_swig_buffer_format(char *format, size_t n,
+                                    DLiteType type, size_t size)
+{
+  const char *c=NULL;
+  switch (type) {
+  case dliteBlob:
+  case dliteFixString:
+    snprintf(format, n, "%ds", (int)size);
+    return 0;
+  case dliteBool:
+    if (size == 1) c = "?";
+    break;
+  case dliteInt:
+    c = (size == 1) ? "b" : (size == 2) ? "h" : (size == 4) ? "i" :
+      (size == 8) ? "q" : NULL;
+    break;
+  case dliteUInt:
+    c = (size == 1) ? "B" : (size == 2) ? "H" : (size == 4) ? "I" :
+      (size == 8) ? "Q" : NULL;
+    break;
+  case dliteFloat:
+    c = (size == 2) ? "e" : (size == 4) ? "f" : (size == 8) ? "d" : NULL;
+    break;
+  default:
+    break;
+  }
+  if (!c) return 1;
+  snprintf(format, n, "%s", c);
+  return 0;
+}
+
+/* Returns a pointer to the data of the property referred to by `self`.
+   If `writable` is non-zero, the property is prepared for being
+   written to.  Returns NULL on error with a Python exception set. */
+static void *dlite_swig_buffer_data(DLiteSwigPropertyBuffer *self,
+                                    int writable)
+{
+  DLiteInstance *inst = self->inst;
+  void *ptr;
+  dlite_swig_lock();
+  dlite_errclr();
+  if (writable)
+    ptr = dlite_instance_get_property_by_index(inst, self->index);
+  else
+    ptr = (void *)dlite_instance_peek_property_by_index(inst, self->index);
+  dlite_swig_unlock();
+  if (!ptr && dlite_errval()) {
+    PyErr_SetString(PyExc_BufferError, dlite_errmsg());
+    return NULL;
+  }
+  return ptr;
+}
+
+static int dlite_swig_propbuf_getbuffer(PyObject *obj, Py_buffer *view,
+                                        int flags)
+{
+  DLiteSwigPropertyBuffer *self = (DLiteSwigPropertyBuffer *)obj;
+  DLiteProperty *p = self->inst->meta->_properties + self->index;
+  DLiteSwigViewInfo *info;
+  Py_ssize_t len=p->size, *shape, *strides;
+  int j;
+
+  if (!(info = PyMem_Calloc(1, sizeof(DLiteSwigViewInfo) +
+                            2*p->ndims*sizeof(Py_ssize_t)))) {
+    PyErr_NoMemory();
+    return -1;
+  }
+  shape = info->dims;
+  strides = info->dims + p->ndims;
+  if (dlite_swig_buffer_format(info->format, sizeof(info->format),
+                               p->type, p->size)) {
+    PyErr_Format(PyExc_BufferError,
+                 "property '%s' of type %s does not support the buffer "
+                 "protocol", p->name, dlite_type_get_dtypename(p->type));
+    goto fail;
+  }
+  view->buf = dlite_swig_buffer_data(self, flags & PyBUF_WRITABLE);
+  if (!view->buf && PyErr_Occurred()) goto fail;
+  for (j=p->ndims-1; j >= 0; j--) {
+    shape[j] = DLITE_PROP_DIM(self->inst, self->index, j);
+    strides[j] = len;
+    len *= shape[j];
+  }
+  view->obj = obj;
+  Py_INCREF(obj);
+  view->len = len;
+  view->readonly = !(flags & PyBUF_WRITABLE);
+  view->itemsize = p->size;
+  view->format = (flags & PyBUF_FORMAT) ? info->format : NULL;
+  view->ndim = p->ndims;
+  view->shape = (flags & PyBUF_ND) ? shape : NULL;
+  view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? strides : NULL;
+  view->suboffsets = NULL;
+  view->internal = info;
+  if (!view->shape) view->ndim = 1;
+  return 0;
+ fail:
+  PyMem_Free(info);
+  view->obj = NULL;
+  return -1;
+}
+
+static void dlite_swig_propbuf_releasebuffer(PyObject *obj, Py_buffer *view)
+{
+  (void)obj;
+  PyMem_Free(view->internal);
+}
+
+/* Deleter of DLPack managed tensors.  May be called without the GIL. */
+static void dlite_swig_dlpack_deleter(DLiteSwigDLManagedTensor *self)
+{
+  PyGILState_STATE gstate = PyGILState_Ensure();
+  dlite_swig_lock();
+  dlite_instance_decref((DLiteInstance *)self->manager_ctx);
+  dlite_swig_unlock();
+  PyGILState_Release(gstate);
+  free(self);
+}
+
+/* Destructor of DLPack capsules that are not consumed. */
+static void dlite_swig_dlpack_capsule_destructor(PyObject *cap)
+{
+  DLiteSwigDLManagedTensor *tensor;
+  PyObject *type, *value, *tb;
+  if (PyCapsule_IsValid(cap, "used_dltensor")) return;
+  PyErr_Fetch(&type, &value, &tb);
+  if ((tensor = PyCapsule_GetPointer(cap, "dltensor")) && tensor->deleter)
+    tensor->deleter(tensor);
+  PyErr_Restore(type, value, tb);
+}
+
+static PyObject *dlite_swig_propbuf_dlpack(PyObject *obj, PyObject *args,
+                                           PyObject *kwargs)
+{
+  DLiteSwigPropertyBuffer *self = (DLiteSwigPropertyBuffer *)obj;
+  DLiteProperty *p = self->inst->meta->_properties + self->index;
+  DLiteSwigDLManagedTensor *tensor;
+  int64_t *dims, stride=1;
+  uint8_t code;
+  PyObject *cap;
+  void *data;
+  int j;
+  (void)args;
+  (void)kwargs;  /* `stream` and friends are irrelevant for CPU data */
+
+  switch (p->type) {
+  case dliteInt:   code = 0; break;
+  case dliteUInt:  code = 1; break;
+  case dliteFloat: code = 2; break;
+  case dliteBool:  code = 6; break;
+  default:
+    return PyErr_Format(PyExc_BufferError,
+                        "property '%s' of type %s cannot be exported to "
+                        "DLPack", p->name, dlite_type_get_dtypename(p->type));
+  }
+  if (!(data = dlite_swig_buffer_data(self, 1)) && PyErr_Occurred())
+    return NULL;
+
+  if (!(tensor = calloc(1, sizeof(DLiteSwigDLManagedTensor) +
+                        2*p->ndims*sizeof(int64_t))))
+    return PyErr_NoMemory();
+  dims = (int64_t *)(tensor + 1);
+  for (j=p->ndims-1; j >= 0; j--) {
+    dims[j] = DLITE_PROP_DIM(self->inst, self->index, j);
+    dims[p->ndims + j] = stride;  /* strides are in number of elements */
+    stride *= dims[j];
+  }
+  tensor->dl_tensor.data = data;
+  tensor->dl_tensor.device.device_type = 1;
+  tensor->dl_tensor.device.device_id = 0;
+  tensor->dl_tensor.ndim = p->ndims;
+  tensor->dl_tensor.dtype.code = code;
+  tensor->dl_tensor.dtype.bits = (uint8_t)(8*p->size);
+  tensor->dl_tensor.dtype.lanes = 1;
+  tensor->dl_tensor.shape = (p->ndims) ? dims : NULL;
+  tensor->dl_tensor.strides = (p->ndims) ? dims + p->ndims : NULL;
+  tensor->manager_ctx = self->inst;
+  tensor->deleter = dlite_swig_dlpack_deleter;
+  dlite_instance_incref(self->inst);
+
+  if (!(cap = PyCapsule_New(tensor, "dltensor",
+                            dlite_swig_dlpack_capsule_destructor))) {
+    dlite_instance_decref(self->inst);
+    free(tensor);
+  }
+  return cap;
+}
+
+static PyObject *dlite_swig_propbuf_dlpack_device(PyObject *obj,
+                                                  PyObject *args)
+{
+  (void)obj;
+  (void)args;
+  return Py_BuildValue("(ii)", 1, 0);  /* kDLCPU, device 0 */
+}
+
+static void dlite_swig_propbuf_dealloc(PyObject *obj)
+{
+  DLiteSwigPropertyBuffer *self = (DLiteSwigPropertyBuffer *)obj;
+  dlite_swig_lock();
+  dlite_instance_decref(self->inst);
+  dlite_swig_unlock();
+  Py_TYPE(obj)->tp_free(obj);
+}
+
+static PyBufferProcs dlite_swig_propbuf_as_buffer = {
+  dlite_swig_propbuf_getbuffer,
+  dlite_swig_propbuf_releasebuffer
+};
+
+static PyMethodDef dlite_swig_propbuf_methods[] = {
+  {"__dlpack__", (PyCFunction)(void (*)(void))dlite_swig_propbuf_dlpack,
+   METH_VARARGS | METH_KEYWORDS,
+   "Exports the property as a DLPack capsule."},
+  {"__dlpack_device__", dlite_swig_propbuf_dlpack_device, METH_NOARGS,
+   "Returns the DLPack device (CPU) of the property data."},
+  {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject DLiteSwigPropertyBufferType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  .tp_name = "dlite.PropertyBuffer",
+  .tp_basicsize = sizeof(DLiteSwigPropertyBuffer),
+  .tp_dealloc = dlite_swig_propbuf_dealloc,
+  .tp_as_buffer = &dlite_swig_propbuf_as_buffer,
+  .tp_flags = Py_TPFLAGS_DEFAULT,
+  .tp_doc = "Zero-copy view of the data of an instance property.",
+  .tp_methods = dlite_swig_propbuf_methods,
+};
+
+/* Returns a new PropertyBuffer for property `i` of `inst` or NULL on
+   error. */
+obj_t *dlite_swig_property_buffer(DLiteInstance *inst, int i)
+{
+  DLiteSwigPropertyBuffer *self;
+  int n=i;
+  if (n < 0) n += (int)inst->meta->_nproperties;
+  if (n < 0 || n >= (int)inst->meta->_nproperties)
+    return dlite_err(-1, "Property index is out or range: %d", i), NULL;
+  if (!(self = PyObject_New(DLiteSwigPropertyBuffer,
+                            &DLiteSwigPropertyBufferType)))
+    return dlite_err(-1, "cannot create property buffer"), NULL;
+  self->inst = inst;
+  self->index = n;
+  dlite_instance_incref(inst);
+  return (obj_t *)self;
+}
+
+/* Returns a new reference to the PropertyBuffer type object. */
+PyObject *_get_PropertyBufferType(void) {
+  Py_INCREF(&DLiteSwigPropertyBufferType);
+  return (PyObject *)&DLiteSwigPropertyBufferType;
+}
+
 %}
 
 
@@ -1240,8 +1791,10 @@ int dlite_swig_set_property_by_index(DLiteInstance *inst, int i, obj_t *obj)
  * Expose generic api
  * ------------------ */
 PyObject *_get_DLiteError(void);
+PyObject *_get_PropertyBufferType(void);
 
 
 %pythoncode %{
   DLiteError = _dlite._get_DLiteError()
+  PropertyBuffer = _dlite._get_PropertyBufferType()
 %}
@@ -39,9 +39,13 @@ Returns UUID of next instance or None if exhausted.") next;
   %newobject next;
   struct _DLiteInstance *next(void) {
     char uuid[DLITE_UUID_LENGTH+1];
-    if (dlite_storage_iter_next($self->s, $self->state, uuid) == 0)
-      return dlite_instance_load($self->s, uuid);
-    return NULL;
+    DLiteInstance *inst=NULL;
+    if (dlite_storage_iter_next($self->s, $self->state, uuid) == 0) {
+      DLITE_SWIG_BEGIN_ALLOW_THREADS
+      inst = dlite_instance_load($self->s, uuid);
+      DLITE_SWIG_END_ALLOW_THREADS
+    }
+    return inst;
   }
   struct StorageIterator *__iter__(void) {
     return $self;
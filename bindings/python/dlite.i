@@ -41,6 +41,10 @@
  * language-specific interface files are expected to define:
  *   - obj_t: typedef for target-language objects.
  *   - DLiteSwigNone: target-language representation for None.
+ *   - dlite_swig_lock(), dlite_swig_unlock(): serialise calls into dlite.
+ *   - DLITE_SWIG_BEGIN_ALLOW_THREADS, DLITE_SWIG_END_ALLOW_THREADS:
+ *     enclose heavy C calls during which other target-language threads
+ *     may run.
  */
 
 %include "dlite-macros.i"
@@ -63,7 +67,9 @@
 %include <exception.i>
 %exception {
   dlite_swig_errclr();
+  dlite_swig_lock();
   $action
+  dlite_swig_unlock();
   if (dlite_errval()) {
 #ifdef SWIGPYTHON
     PyErr_SetString(DLiteError, dlite_errmsg());
@@ -0,0 +1,50 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Benchmark of the arrow and parquet storage plugins.
+
+Not run by ctest.  Run it manually with the same environment as the
+tests, optionally with the number of rows as argument."""
+import os
+import sys
+import tempfile
+import time
+
+import numpy as np
+
+import dlite
+
+
+rows = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+
+Table = dlite.Instance(
+    'http://onto-ns.com/meta/0.1/ArrowBenchmarkTable',
+    [dlite.Dimension('rows', 'Number of rows.')],
+    [dlite.Property('x', 'float64', ['rows'], 'm'),
+     dlite.Property('n', 'int32', ['rows']),
+     dlite.Property('flag', 'bool', ['rows']),
+     dlite.Property('label', 'string', ['rows'])],
+    None, 'Table used for benchmarking the arrow storage plugins.')
+
+big = Table(dims=[rows])
+big.assign_columns({
+    'x': np.random.rand(rows),
+    'n': np.arange(rows, dtype='int32'),
+    'flag': np.arange(rows) % 2 == 0,
+    'label': np.array(['label%d' % (i % 100) for i in range(rows)],
+                      dtype=object),
+})
+
+print(f'Saving and loading {rows} rows:')
+with tempfile.TemporaryDirectory() as tmpdir:
+    for driver in 'arrow', 'parquet':
+        path = os.path.join(tmpdir, f'benchmark.{driver}')
+        t0 = time.perf_counter()
+        big.save(f'{driver}://{path}?mode=w')
+        t1 = time.perf_counter()
+        t = dlite.Instance(f'{driver}://{path}')
+        t2 = time.perf_counter()
+        t = dlite.Instance(f'{driver}://{path}?columns=x,n;rows=1000:2000')
+        t3 = time.perf_counter()
+        print(f'  {driver:8s} save: {t1 - t0:.3f} s   load: {t2 - t1:.3f} s   '
+              f'load 1000 rows of 2 columns: {t3 - t2:.3f} s')
+        del t
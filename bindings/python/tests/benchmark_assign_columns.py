@@ -0,0 +1,59 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Benchmark of loading a csv table with pandas and assigning it to an
+instance with Instance.assign_columns() and with item assignment.
+
+Not run by ctest.  Run it manually with the same environment as the
+tests, optionally with the number of rows as argument.  Requires pandas."""
+import os
+import sys
+import tempfile
+import time
+
+import numpy as np
+import pandas as pd
+
+import dlite
+
+
+rows = int(sys.argv[1]) if len(sys.argv) > 1 else 500000
+
+Table = dlite.Instance(
+    'http://onto-ns.com/meta/0.1/BenchmarkTable',
+    [dlite.Dimension('rows', 'Number of rows.')],
+    [dlite.Property('x', 'float64', ['rows']),
+     dlite.Property('n', 'int32', ['rows']),
+     dlite.Property('flag', 'bool', ['rows']),
+     dlite.Property('label', 'string', ['rows'])],
+    None, 'Table used for benchmarking column assignment.')
+
+df = pd.DataFrame({
+    'x': np.random.rand(rows),
+    'n': np.arange(rows, dtype='int32'),
+    'flag': np.arange(rows) % 2 == 0,
+    'label': ['label%d' % i for i in range(rows)],
+})
+
+with tempfile.TemporaryDirectory() as tmpdir:
+    csvfile = os.path.join(tmpdir, 'benchmark.csv')
+    df.to_csv(csvfile, index=False)
+
+    t0 = time.perf_counter()
+    data = pd.read_csv(csvfile)
+    t1 = time.perf_counter()
+    table = Table(dims=[rows])
+    table.assign_columns({
+        p.name: data.iloc[:, i].to_numpy()
+        for i, p in enumerate(table.meta['properties'])})
+    t2 = time.perf_counter()
+    for i in range(len(table)):
+        table[i] = data.iloc[:, i]
+    t3 = time.perf_counter()
+
+print(f'Loading {rows} rows:')
+print(f'  pandas.read_csv():    {t1 - t0:.3f} s')
+print(f'  assign_columns():     {t2 - t1:.3f} s')
+print(f'  item assignment:      {t3 - t2:.3f} s')
+
+assert table.label[-1] == 'label%d' % (rows - 1)
+assert table.n[-1] == rows - 1
@@ -0,0 +1,108 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+import importlib.util
+import os
+
+import numpy as np
+import pyarrow as pa
+import pyarrow.parquet as pq
+
+import dlite
+
+
+thisdir = os.path.abspath(os.path.dirname(__file__))
+plugindir = os.path.join(thisdir, '..', '..', '..', 'storages', 'python',
+                         'python-storage-plugins')
+
+
+Table = dlite.Instance(
+    'http://onto-ns.com/meta/0.1/ArrowTable',
+    [dlite.Dimension('rows', 'Number of rows.')],
+    [dlite.Property('x', 'float64', ['rows'], 'm'),
+     dlite.Property('n', 'int32', ['rows']),
+     dlite.Property('flag', 'bool', ['rows']),
+     dlite.Property('label', 'string', ['rows'])],
+    None, 'Table used for testing the arrow storage plugins.')
+
+n = 10
+data = {
+    'x': np.linspace(0, 1, n),
+    'n': np.arange(n, dtype='int32'),
+    'flag': np.arange(n) % 2 == 0,
+    'label': np.array(['row%d' % i for i in range(n)], dtype=object),
+}
+table = Table(dims=[n], id='arrow-table')
+table.assign_columns(data)
+table.save('arrow://test_arrow_storage.arrow?mode=w;row_group_size=4')
+table.save('parquet://test_arrow_storage.parquet?mode=w;row_group_size=4')
+del table
+
+for driver in 'arrow', 'parquet':
+    path = f'test_arrow_storage.{driver}'
+
+    # Load the whole file
+    t = dlite.Instance(f'{driver}://{path}')
+    assert t.uri == 'arrow-table'
+    assert t.meta.uri == Table.uri
+    assert np.all(t.x == data['x'])
+    assert t.n.tolist() == data['n'].tolist()
+    assert t.flag.tolist() == data['flag'].tolist()
+    assert t.label.tolist() == data['label'].tolist()
+
+    # Loaded data can be modified without changing the file
+    t.x[0] = -1.0
+    t = dlite.Instance(f'{driver}://{path}?id=reloaded-{driver}')
+    assert t.uri == f'reloaded-{driver}'
+    assert t.x[0] == 0.0
+
+    # Read a subset of the rows.  Only the last two row groups are read.
+    t = dlite.Instance(f'{driver}://{path}?rows=5:9')
+    assert t.rows == 4
+    assert t.n.tolist() == [5, 6, 7, 8]
+    assert t.label.tolist() == ['row5', 'row6', 'row7', 'row8']
+
+    # Project columns
+    t = dlite.Instance(f'{driver}://{path}?columns=n,label;rows=8:')
+    assert [p.name for p in t.meta['properties']] == ['n', 'label']
+    assert t.meta.uri != Table.uri
+    assert t.n.tolist() == [8, 9]
+
+# Row groups are pruned using the parquet statistics
+assert pq.ParquetFile('test_arrow_storage.parquet').num_row_groups == 3
+t = dlite.Instance(
+    'parquet://test_arrow_storage.parquet?filters=[("n", ">=", 7)]')
+assert t.n.tolist() == [7, 8, 9]
+
+
+# Integer columns with missing values cannot be loaded into int properties
+pq.write_table(pa.table({'n': pa.array([1, None, 3], type=pa.int32())}),
+               'test_arrow_storage_nulls.parquet')
+try:
+    dlite.Instance('parquet://test_arrow_storage_nulls.parquet')
+except dlite.DLiteError:
+    pass
+else:
+    assert False, 'loading int column with nulls should fail'
+
+
+# Single-batch arrow IPC files (the default) are loaded without copying
+table = Table(dims=[n])
+table.assign_columns(data)
+table.save('arrow://test_arrow_storage_single.arrow?mode=w')
+
+spec = importlib.util.spec_from_file_location(
+    'arrow_plugin', os.path.join(plugindir, 'arrow.py'))
+arrow = importlib.util.module_from_spec(spec)
+arrow.DLiteStorageBase = object
+spec.loader.exec_module(arrow)
+
+base = arrow.map_file('test_arrow_storage_single.arrow')
+mapped = np.frombuffer(base, dtype=np.uint8)
+columns = pa.ipc.open_file(pa.py_buffer(base)).read_all()
+assert columns.column('x').num_chunks == 1
+x = arrow.column_array(columns.column('x'), base)
+assert np.shares_memory(x, mapped)
+assert np.all(x == data['x'])
+nview = arrow.column_array(columns.column('n').slice(3), base)
+assert np.shares_memory(nview, mapped)
+assert nview.tolist() == data['n'][3:].tolist()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+import numpy as np
+
+import dlite
+
+try:
+    import pandas as pd
+except ImportError:
+    pd = None
+
+
+Table = dlite.Instance(
+    'http://onto-ns.com/meta/0.1/Table',
+    [dlite.Dimension('rows', 'Number of rows.')],
+    [dlite.Property('x', 'float64', ['rows']),
+     dlite.Property('n', 'int32', ['rows']),
+     dlite.Property('flag', 'bool', ['rows']),
+     dlite.Property('label', 'string', ['rows'])],
+    None, 'Table used for testing column assignment.')
+
+
+# Check assignment
+n = 5
+x = np.linspace(0, 1, n)
+table = Table(dims=[n])
+table.assign_columns({
+    'x': x,
+    'n': np.arange(n, dtype='int64'),  # converted to int32
+    'flag': [True, False, True, False, True],
+    'label': np.array(['a', 'bb', None, 'dddd', 'é'], dtype=object),
+})
+assert np.all(table.x == x)
+assert table.n.dtype == np.int32
+assert table.n.tolist() == [0, 1, 2, 3, 4]
+assert table.flag.tolist() == [True, False, True, False, True]
+assert table.label.tolist() == ['a', 'bb', None, 'dddd', 'é']
+
+# Compatible arrays are moved into the instance without copying
+x[0] = -1.0
+assert table.x[0] == -1.0
+
+try:
+    table.assign_columns({'x': np.zeros(n + 1)})
+except dlite.DLiteError:
+    pass
+else:
+    assert False, 'expected DLiteError for wrong number of elements'
+
+
+# Assign columns of a pandas DataFrame.  Missing strings become None.
+if pd is not None:
+    df = pd.DataFrame({
+        'x': [0.5, 1.5, 2.5],
+        'n': [1, 2, 3],
+        'flag': [True, True, False],
+        'label': ['a', np.nan, 'c'],
+    })
+    table = Table(dims=[len(df)])
+    table.assign_columns(df)
+    assert table.x.tolist() == [0.5, 1.5, 2.5]
+    assert table.n.tolist() == [1, 2, 3]
+    assert table.flag.tolist() == [True, True, False]
+    assert table.label.tolist() == ['a', None, 'c']
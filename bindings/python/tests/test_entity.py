@@ -1,8 +1,12 @@
 #!/usr/bin/env python
 # -*- coding: utf-8 -*-
+import glob
+import importlib.util
 import os
 import pickle
 
+import numpy as np
+
 import dlite
 from dlite import Instance, Dimension, Property, Relation
 
@@ -59,6 +63,37 @@ inst['a-relation-array'] = [
     dlite.Relation('cat', 'is_a', 'mammal'),
     ]
 
+# Adopt numpy array without copying
+arr = np.array([1.5, 2.5, 3.5])
+inst.adopt_property('a-float64-array', arr)
+arr[0] = -1.0
+assert inst['a-float64-array'][0] == -1.0
+inst['a-float64-array'] = 3.14, 5.0, 42.3
+assert arr[2] == 42.3
+del arr
+assert inst['a-float64-array'][1] == 5.0
+try:
+    inst.adopt_property('a-float64-array', np.array([1, 2, 3]))
+except dlite.DLiteError:
+    pass
+else:
+    assert False, 'expected DLiteError for mismatching dtype'
+
+# Zero-copy export via the buffer protocol and DLPack
+buf = inst.get_property_buffer('a-float64-array')
+assert isinstance(buf, dlite.PropertyBuffer)
+m = memoryview(buf)
+assert m.readonly  # memoryview() does not request a writable buffer
+assert m.format == 'd'
+assert m.shape == (3, )
+assert m.tolist() == [3.14, 5.0, 42.3]
+view = np.asarray(buf)
+view[1] = 7.0
+assert inst['a-float64-array'][1] == 7.0
+if hasattr(np, 'from_dlpack'):
+    assert np.from_dlpack(buf)[1] == 7.0
+del m, view
+
 # Print the value of all properties
 for i in range(len(inst)):
     print('prop%d:' % i, inst[i])
@@ -108,13 +143,28 @@ e3 = Instance(
      Property('v', type='double', unit='m/s', description='Velocity')],
     'Something new...')
 
+# Copy-on-write copies share array data until one of them writes to it
+cow1 = inst.copy(cow=True)
+cow2 = inst.copy(cow=True)
+assert cow1.uuid != inst.uuid
+assert cow1['an-int-array'].tolist() == [1, 2, 3]
+view = cow1['an-int-array']
+view[0] = 100
+assert cow1['an-int-array'].tolist() == [100, 2, 3]
+assert cow2['an-int-array'].tolist() == [1, 2, 3]
+assert inst['an-int-array'].tolist() == [1, 2, 3]
+cow2['a-float64-array'][1] = -1.0
+assert cow2['a-float64-array'][1] == -1.0
+assert inst['a-float64-array'][1] == 5.0
+del view, cow1, cow2
+
 inst.save('json://yyy.json')
 
-try:
-    import yaml
-except ImportError:
-    pass
-else:
+# The yaml driver is provided by the native libyaml plugin or, if dlite
+# is built without libyaml, by a Python plugin that requires PyYAML
+if (any(glob.glob(os.path.join(path, '*dlite-plugins-yaml*'))
+        for path in dlite.storage_plugin_path) or
+        importlib.util.find_spec('yaml')):
     inst.save('yaml://yyy.yaml')
 
 del inst
@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Tests the binary COPY encoding and the error handling of the postgresql
+storage plugin.
+
+No PostgreSQL server is needed, only psycopg2."""
+import importlib.util
+import os
+import struct
+
+import numpy as np
+
+import dlite
+
+
+thisdir = os.path.abspath(os.path.dirname(__file__))
+plugindir = os.path.join(thisdir, '..', '..', '..', 'storages', 'python',
+                         'python-storage-plugins')
+
+spec = importlib.util.spec_from_file_location(
+    'postgresql_plugin', os.path.join(plugindir, 'postgresql.py'))
+pg = importlib.util.module_from_spec(spec)
+pg.DLiteStorageBase = object
+spec.loader.exec_module(pg)
+
+
+# Scalars
+assert pg.encode_scalar(None, 'integer') is None
+assert pg.encode_scalar(True, 'bool') == b'\x01'
+assert pg.encode_scalar(-2, 'smallint') == struct.pack('!h', -2)
+assert pg.encode_scalar(5, 'integer') == struct.pack('!i', 5)
+assert pg.encode_scalar(2**40, 'bigint') == struct.pack('!q', 2**40)
+assert pg.encode_scalar(1.5, 'real') == struct.pack('!f', 1.5)
+assert pg.encode_scalar(0.1, 'float8') == struct.pack('!d', 0.1)
+assert pg.encode_scalar('abc', 'varchar') == b'abc'
+assert pg.encode_scalar(b'\x00\x01', 'bytea') == b'\x00\x01'
+
+
+# Numerical arrays: ndim, hasnull, element oid, (dim, lower bound) for
+# each dimension followed by (length, value) for each element
+arr = np.array([[1, 2, 3], [4, 5, 6]], dtype='int32')
+expected = struct.pack('!iii', 2, 0, 23) + struct.pack('!iiii', 2, 1, 3, 1)
+for v in arr.flat:
+    expected += struct.pack('!ii', 4, v)
+assert pg.encode_array(arr, 'integer') == expected
+
+expected = struct.pack('!iii', 1, 0, 701) + struct.pack('!ii', 2, 1)
+expected += struct.pack('!id', 8, 0.5) + struct.pack('!id', 8, -1.0)
+assert pg.encode_array([0.5, -1.0], 'float8') == expected
+
+# Empty arrays have no dimensions
+assert pg.encode_array([], 'float8') == struct.pack('!iii', 0, 0, 701)
+
+
+# String arrays with NULL elements
+expected = struct.pack('!iii', 1, 1, 1043) + struct.pack('!ii', 3, 1)
+expected += struct.pack('!i', 2) + b'ab' + struct.pack('!i', -1)
+expected += struct.pack('!i', 0)
+assert pg.encode_array(['ab', None, ''], 'varchar') == expected
+
+
+# Column encoders
+assert pg.column_encoder('float8')(2.0) == struct.pack('!d', 2.0)
+assert pg.column_encoder('varchar[2]')(['a', 'b']) == (
+    struct.pack('!iiiii', 1, 0, 1043, 2, 1) +
+    struct.pack('!i', 1) + b'a' + struct.pack('!i', 1) + b'b')
+
+
+# COPY stream: header, field count and (length, data) for each field in
+# each row, where NULL fields have length -1, and the trailer
+header = b'PGCOPY\n\xff\r\n\x00' + struct.pack('!ii', 0, 0)
+trailer = struct.pack('!h', -1)
+assert pg.copy_data([]) == header + trailer
+data = pg.copy_data([[b'abc', None], [b'', b'\x01']])
+assert data == (
+    header +
+    struct.pack('!hi', 2, 3) + b'abc' + struct.pack('!i', -1) +
+    struct.pack('!hi', 2, 0) + struct.pack('!i', 1) + b'\x01' +
+    trailer)
+
+
+# LIKE patterns
+assert pg.glob_to_like('http://onto-ns.com/*') == 'http://onto-ns.com/%'
+assert pg.glob_to_like('a?c') == 'a_c'
+assert pg.glob_to_like('my_entity') == 'my\\_entity'
+assert pg.glob_to_like('100%*') == '100\\%%'
+assert pg.glob_to_like('a\\b') == 'a\\\\b'
+
+
+# Failed flushes are rolled back and close() always closes the connection
+class Mock:
+    def __init__(self):
+        self.calls = []
+
+    def __getattr__(self, name):
+        return lambda *args: self.calls.append(name)
+
+
+class FailingCursor(Mock):
+    def execute(self, *args):
+        raise RuntimeError('execute failed')
+
+
+storage = pg.postgresql()
+storage.conn = Mock()
+storage.cur = FailingCursor()
+storage.tables = {'uuidtable', 'http://onto-ns.com/meta/0.1/Item'}
+storage.pending = {'http://onto-ns.com/meta/0.1/Item': {'id': [b'row']}}
+storage.npending = 1
+try:
+    storage.close()
+except RuntimeError:
+    pass
+else:
+    assert False, 'expected RuntimeError'
+assert storage.npending == 0 and not storage.pending
+assert storage.conn.calls == ['rollback', 'close']
+assert storage.cur.calls[-1] == 'close'
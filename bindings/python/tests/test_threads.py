@@ -0,0 +1,66 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+import os
+import tempfile
+import threading
+
+import dlite
+
+
+thisdir = os.path.abspath(os.path.dirname(__file__))
+
+url = 'json://' + os.path.join(thisdir, 'Person.json')
+Person = dlite.Instance(url)
+
+n = 100000
+person = Person(dims=[n])
+person.name = 'Ada'
+person.age = 12.5
+person.skills = ['skill%d' % i for i in range(n)]
+tmpdir = tempfile.TemporaryDirectory()
+path = os.path.join(tmpdir.name, 'test_threads.json')
+person.save('json', path, 'mode=w')
+loadurl = 'json://%s?mode=r#%s' % (path, person.uuid)
+
+
+# Load the instance from several threads at once
+results = {}
+
+def load(i):
+    inst = dlite.Instance(loadurl)
+    results[i] = (inst.name, inst.skills[-1])
+
+threads = [threading.Thread(target=load, args=(i, )) for i in range(4)]
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+assert len(results) == 4
+for name, skill in results.values():
+    assert name == 'Ada'
+    assert skill == 'skill%d' % (n - 1)
+
+
+# The GIL is released while loading, so other Python threads should
+# be able to run in the meantime
+ticks = 0
+running = True
+
+def ticker():
+    global ticks
+    while running:
+        ticks += 1
+
+t = threading.Thread(target=ticker)
+t.start()
+while not ticks:
+    pass
+before = ticks
+inst = dlite.Instance(loadurl)
+during = ticks - before
+running = False
+t.join()
+print('ticks during load:', during)
+assert during > 0
+
+tmpdir.cleanup()
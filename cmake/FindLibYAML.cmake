@@ -0,0 +1,48 @@
+# - Try to find libyaml
+# Once done this will define
+#
+#  LIBYAML_FOUND        - system has libyaml
+#  LIBYAML_INCLUDE_DIRS - the libyaml include directory
+#  LIBYAML_LIBRARIES    - link these to use libyaml
+#
+
+if(LIBYAML_LIBRARIES AND LIBYAML_INCLUDE_DIRS)
+  # in cache already
+  set(LIBYAML_FOUND TRUE)
+else()
+
+  find_path(LIBYAML_INCLUDE_DIR
+    NAMES
+      yaml.h
+    PATHS
+      ${LIBYAML_ROOT}/include
+      $ENV{LIBYAML_ROOT}/include
+      $ENV{HOME}/.local/include
+      /usr/include
+      /usr/local/include
+      /opt/local/include
+    )
+  list(APPEND LIBYAML_INCLUDE_DIRS ${LIBYAML_INCLUDE_DIR})
+
+  find_library(LIBYAML_LIBRARY
+    NAMES
+      yaml
+    PATHS
+      ${LIBYAML_ROOT}/lib
+      $ENV{LIBYAML_ROOT}/lib
+      $ENV{HOME}/.local/lib
+      /usr/lib
+      /usr/local/lib
+      /opt/local/lib
+    )
+  list(APPEND LIBYAML_LIBRARIES ${LIBYAML_LIBRARY})
+
+  include(FindPackageHandleStandardArgs)
+  find_package_handle_standard_args(LibYAML DEFAULT_MSG
+    LIBYAML_LIBRARIES LIBYAML_INCLUDE_DIRS)
+
+  # show the LIBYAML_INCLUDE_DIRS and LIBYAML_LIBRARIES variables only
+  # in the advanced view
+  mark_as_advanced(LIBYAML_INCLUDE_DIRS LIBYAML_LIBRARIES)
+
+endif()
@@ -1,6 +1,8 @@
 #include "config.h"
 
 #include <assert.h>
+#include <math.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #ifdef HAVE_STDARG_H
@@ -8,6 +10,8 @@
 #endif
 
 #include "utils/err.h"
+#include "utils/integers.h"
+#include "utils/floats.h"
 #include "dlite.h"
 #include "dlite-macros.h"
 #include "dlite-arrays.h"
@@ -145,11 +149,15 @@ void *dlite_array_vindex(const DLiteArray *arr, ...)
 */
 int dlite_array_iter_init(DLiteArrayIter *iter, const DLiteArray *arr)
 {
+  int n;
   memset(iter, 0, sizeof(DLiteArrayIter));
+  if (arr->ndims > DLITE_ARRAY_MAXDIMS)
+    return err(1, "cannot iterate over arrays with more than %d dimensions",
+               DLITE_ARRAY_MAXDIMS);
   iter->arr = arr;
-  if (!(iter->ind = calloc(arr->ndims, sizeof(int))))
-    return err(1, "allocation failure");
-  iter->ind[arr->ndims-1]--;
+  iter->ptr = arr->data;
+  for (n=0; n<arr->ndims; n++)
+    if (arr->dims[n] == 0) iter->state = 2;  /* empty array */
   return 0;
 }
 
@@ -158,7 +166,7 @@ int dlite_array_iter_init(DLiteArrayIter *iter, const DLiteArray *arr)
 */
 void dlite_array_iter_deinit(DLiteArrayIter *iter)
 {
-  free(iter->ind);
+  UNUSED(iter);
 }
 
 /*
@@ -168,20 +176,79 @@ void dlite_array_iter_deinit(DLiteArrayIter *iter)
 void *dlite_array_iter_next(DLiteArrayIter *iter)
 {
   int n;
-  DLiteArray *arr = (DLiteArray *)iter->arr;
-  if (iter->ind[0] < 0) return NULL;  /* check stop indicator */
-  for (n=arr->ndims-1; n>=0; n--)
-    if (arr->dims[n] <= 0) return NULL;  /* check that all dimensions has
-					    positive length */
+  const DLiteArray *arr = iter->arr;
+  if (iter->state == 2) return NULL;
+  if (iter->state == 0) {
+    iter->state = 1;
+    return iter->ptr;
+  }
   for (n=arr->ndims-1; n>=0; n--) {
-    if (++iter->ind[n] < (int)arr->dims[n]) break;
+    iter->ptr += arr->strides[n];
+    if (++iter->ind[n] < (int)arr->dims[n]) return iter->ptr;
     iter->ind[n] = 0;
+    iter->ptr -= arr->strides[n] * (ptrdiff_t)arr->dims[n];
   }
-  if (n < 0) {
-    iter->ind[0] = -1;  /* stop indicator */
-    return NULL;
+  iter->state = 2;
+  return NULL;
+}
+
+
+/*
+  Initialise block iterator `iter` for iteration over array `arr` in
+  blocks of contiguous elements.
+
+  Returns non-zero on error.
+*/
+int dlite_array_blockiter_init(DLiteArrayBlockIter *iter,
+                               const DLiteArray *arr)
+{
+  int n;
+  memset(iter, 0, sizeof(DLiteArrayBlockIter));
+  if (arr->ndims > DLITE_ARRAY_MAXDIMS)
+    return err(1, "cannot iterate over arrays with more than %d dimensions",
+               DLITE_ARRAY_MAXDIMS);
+  iter->arr = arr;
+  iter->ptr = arr->data;
+  iter->len = 1;
+  for (n=0; n<arr->ndims; n++)
+    if (arr->dims[n] == 0) iter->state = 2;  /* empty array */
+
+  /* the innermost dimensions that are C-contiguous form a block */
+  for (n=arr->ndims; n>0; n--) {
+    if (arr->dims[n-1] > 1 &&
+        arr->strides[n-1] != (int)(iter->len * arr->size)) break;
+    iter->len *= arr->dims[n-1];
   }
-  return dlite_array_index(arr, iter->ind);
+  iter->nouter = n;
+  return 0;
+}
+
+/*
+  Returns a pointer to the next block of contiguous elements or NULL
+  if all blocks have been visited.  If `len` is not NULL, the number
+  of elements in the block is written to it.
+*/
+void *dlite_array_blockiter_next(DLiteArrayBlockIter *iter, size_t *len)
+{
+  int n;
+  const DLiteArray *arr = iter->arr;
+  if (iter->state == 2) return NULL;
+  if (iter->state == 0) {
+    iter->state = 1;
+  } else {
+    for (n=iter->nouter-1; n>=0; n--) {
+      iter->ptr += arr->strides[n];
+      if (++iter->ind[n] < (int)arr->dims[n]) break;
+      iter->ind[n] = 0;
+      iter->ptr -= arr->strides[n] * (ptrdiff_t)arr->dims[n];
+    }
+    if (n < 0) {
+      iter->state = 2;
+      return NULL;
+    }
+  }
+  if (len) *len = iter->len;
+  return iter->ptr;
 }
 
 
@@ -191,6 +258,9 @@ void *dlite_array_iter_next(DLiteArrayIter *iter)
 int dlite_array_compare(const DLiteArray *a, const DLiteArray *b)
 {
   int i;
+  size_t n;
+  void *pa, *pb;
+  DLiteArrayBlockIter ia, ib;
   /* check whether the array structures are equal */
   if (a->type != b->type) return 0;
   if (a->size != b->size) return 0;
@@ -199,8 +269,13 @@ int dlite_array_compare(const DLiteArray *a, const DLiteArray *b)
     if (a->dims[i] != b->dims[i]) return 0;
     if (a->strides[i] != b->strides[i]) return 0;
   }
-  /* check whether the array data are equal */
-  if (memcmp(a->data, b->data, dlite_array_size(a))) return 0;
+  /* check whether the array data are equal, block by block.  Since
+     the arrays have the same layout, the blocks are the same. */
+  if (dlite_array_blockiter_init(&ia, a) ||
+      dlite_array_blockiter_init(&ib, b)) return 0;
+  while ((pa = dlite_array_blockiter_next(&ia, &n)) &&
+         (pb = dlite_array_blockiter_next(&ib, NULL)))
+    if (memcmp(pa, pb, n * a->size)) return 0;
   return 1;
 }
 
@@ -324,21 +399,24 @@ DLiteArray *dlite_array_transpose(DLiteArray *arr)
  */
 void *dlite_array_make_continuous(DLiteArray *arr)
 {
-  int n, size=arr->size;
+  int n;
+  size_t len, size=arr->size;
   void *data, *p;
   char *q;
-  DLiteArrayIter iter;
+  DLiteArrayBlockIter iter;
   for (n=0; n < arr->ndims; n++) size *= arr->dims[n];
   if (!(data = malloc(size))) return err(1, "allocation failure"), NULL;
   if (dlite_array_is_continuous(arr)) return memcpy(data, arr->data, size);
 
   q = data;
-  dlite_array_iter_init(&iter, arr);
-  while ((p = dlite_array_iter_next(&iter))) {
-    memcpy(q, p, arr->size);
-    q += arr->size;
+  if (dlite_array_blockiter_init(&iter, arr)) {
+    free(data);
+    return NULL;
+  }
+  while ((p = dlite_array_blockiter_next(&iter, &len))) {
+    memcpy(q, p, len * arr->size);
+    q += len * arr->size;
   }
-  dlite_array_iter_deinit(&iter);
 
   /* Update `arr` */
   arr->data = data;
@@ -363,24 +441,386 @@ void *dlite_array_make_continuous(DLiteArray *arr)
  */
 int dlite_array_printf(FILE *fp, const DLiteArray *arr, int width, int prec)
 {
-  void *p;
-  int i, N=arr->ndims-1, NN=arr->dims[N]-1;
-  DLiteArrayIter iter;
+  char *p;
+  int i, ind[DLITE_ARRAY_MAXDIMS], N=arr->ndims-1, NN=arr->dims[N]-1;
+  size_t j, len;
+  DLiteArrayBlockIter iter;
   char buf[80];
-  dlite_array_iter_init(&iter, arr);
-  while ((p = dlite_array_iter_next(&iter))) {
-    char *sep = (iter.ind[N] < NN) ? " " : "";
-    int m=0;
-    for (i=arr->ndims-1; i >= 0 && iter.ind[i] == 0; i--) m++;
-    if (iter.ind[N] == 0)
-      for (; i >= 0; i--) fprintf(fp, " ");
-    for (i=0; i<m; i++) fprintf(fp, "[");
-    dlite_type_print(buf, sizeof(buf), p, arr->type, arr->size, width, prec, 0);
-    fprintf(fp, "%s%s", buf, sep);
-    for (i=N; i >= 0 && iter.ind[i] == (int)arr->dims[i]-1; i--)
-      fprintf(fp, "]");
-    if (iter.ind[N] == NN) fprintf(fp, "\n");
+  if (dlite_array_blockiter_init(&iter, arr)) return 1;
+  while ((p = dlite_array_blockiter_next(&iter, &len))) {
+    /* index of the first element in the block */
+    for (i=0; i<=N; i++) ind[i] = (i < iter.nouter) ? iter.ind[i] : 0;
+    for (j=0; j<len; j++, p+=arr->size) {
+      char *sep = (ind[N] < NN) ? " " : "";
+      int m=0;
+      for (i=N; i >= 0 && ind[i] == 0; i--) m++;
+      if (ind[N] == 0)
+        for (; i >= 0; i--) fprintf(fp, " ");
+      for (i=0; i<m; i++) fprintf(fp, "[");
+      dlite_type_print(buf, sizeof(buf), p, arr->type, arr->size, width,
+                       prec, 0);
+      fprintf(fp, "%s%s", buf, sep);
+      for (i=N; i >= 0 && ind[i] == (int)arr->dims[i]-1; i--)
+        fprintf(fp, "]");
+      if (ind[N] == NN) fprintf(fp, "\n");
+
+      /* advance index within the block */
+      for (i=N; i >= iter.nouter; i--) {
+        if (++ind[i] < (int)arr->dims[i]) break;
+        ind[i] = 0;
+      }
+    }
+  }
+  return 0;
+}
+
+
+
+/********************************************************************
+ *  Numerical functions
+ *
+ *  The numerical functions loop over the rows (innermost dimension)
+ *  of the arrays with a RowIter and call a typed kernel for each row.
+ *  The kernels have a separate loop for contiguous rows, which the
+ *  compiler is able to vectorise.
+ ********************************************************************/
+
+/* Iterator over the rows of one or two arrays with equal dimensions. */
+typedef struct {
+  const DLiteArray *a;     /* first array */
+  const DLiteArray *b;     /* second array or NULL */
+  int nouter;              /* number of outer dimensions */
+  size_t n;                /* number of elements in each row */
+  ptrdiff_t sa, sb;        /* strides along the rows */
+  char *pa, *pb;           /* pointers to start of current rows */
+  int state;               /* 0: not started, 1: running, 2: done */
+  size_t idx[DLITE_ARRAY_MAXDIMS];  /* index of current row */
+} RowIter;
+
+/* Initialise row iterator over `a` and `b`.  `b` may be NULL.
+   Returns non-zero on error. */
+static int rowiter_init(RowIter *it, const DLiteArray *a, const DLiteArray *b)
+{
+  int i;
+  memset(it, 0, sizeof(RowIter));
+  if (a->ndims > DLITE_ARRAY_MAXDIMS)
+    return err(1, "arrays with more than %d dimensions are not supported",
+               DLITE_ARRAY_MAXDIMS);
+  if (b) {
+    if (b->ndims != a->ndims)
+      return err(1, "arrays have different number of dimensions");
+    for (i=0; i<a->ndims; i++)
+      if (a->dims[i] != b->dims[i])
+        return err(1, "arrays have different dimensions");
+  }
+  it->a = a;
+  it->b = b;
+  it->pa = a->data;
+  it->pb = (b) ? b->data : NULL;
+  for (i=0; i<a->ndims; i++)
+    if (a->dims[i] == 0) it->state = 2;  /* empty array */
+
+  if (a->ndims == 0) {
+    it->n = 1;
+  } else if (dlite_array_is_continuous(a) &&
+             (!b || dlite_array_is_continuous(b))) {
+    it->n = 1;
+    for (i=0; i<a->ndims; i++) it->n *= a->dims[i];
+    it->sa = a->size;
+    it->sb = (b) ? (ptrdiff_t)b->size : 0;
+  } else {
+    it->nouter = a->ndims - 1;
+    it->n = a->dims[a->ndims-1];
+    it->sa = a->strides[a->ndims-1];
+    it->sb = (b) ? b->strides[b->ndims-1] : 0;
+  }
+  return 0;
+}
+
+/* Advances the iterator to the next row.  Returns non-zero if a new
+   row is available in `it->pa` and `it->pb`, and zero if all rows
+   have been visited. */
+static int rowiter_next(RowIter *it)
+{
+  int i;
+  if (it->state == 2) return 0;
+  if (it->state == 0) {
+    it->state = 1;
+    return 1;
+  }
+  for (i=it->nouter-1; i>=0; i--) {
+    it->pa += it->a->strides[i];
+    if (it->b) it->pb += it->b->strides[i];
+    if (++it->idx[i] < it->a->dims[i]) return 1;
+    it->idx[i] = 0;
+    it->pa -= it->a->strides[i] * (ptrdiff_t)it->a->dims[i];
+    if (it->b) it->pb -= it->b->strides[i] * (ptrdiff_t)it->b->dims[i];
   }
-  dlite_array_iter_deinit(&iter);
+  it->state = 2;
   return 0;
 }
+
+
+/* Typed kernels operating on a single row of `n` elements with
+   stride `s` (in bytes) */
+typedef struct {
+  double (*sum)(const char *p, ptrdiff_t s, size_t n);
+  double (*min)(const char *p, ptrdiff_t s, size_t n);
+  double (*max)(const char *p, ptrdiff_t s, size_t n);
+  void (*scale)(char *p, ptrdiff_t s, size_t n, double a, double b);
+  void (*axpy)(char *y, ptrdiff_t sy, const char *x, ptrdiff_t sx, size_t n,
+               double a);
+} ArrayKernels;
+
+/* Defines kernels for C type `T`.  The sums use four partial sums to
+   allow vectorisation of floating point sums. */
+#define DEFINE_ARRAY_KERNELS(name, T)                                   \
+  static double sum_##name(const char *p, ptrdiff_t s, size_t n)        \
+  {                                                                     \
+    size_t i=0;                                                         \
+    double s0=0, s1=0, s2=0, s3=0;                                      \
+    if (s == (ptrdiff_t)sizeof(T)) {                                               \
+      const T *q = (const T *)p;                                        \
+      for (; i+4<=n; i+=4) {                                            \
+        s0 += q[i];                                                     \
+        s1 += q[i+1];                                                   \
+        s2 += q[i+2];                                                   \
+        s3 += q[i+3];                                                   \
+      }                                                                 \
+      for (; i<n; i++) s0 += q[i];                                      \
+    } else {                                                            \
+      for (; i<n; i++, p+=s) s0 += *(const T *)p;                       \
+    }                                                                   \
+    return (s0 + s1) + (s2 + s3);                                       \
+  }                                                                     \
+  static double min_##name(const char *p, ptrdiff_t s, size_t n)        \
+  {                                                                     \
+    size_t i;                                                           \
+    T m = *(const T *)p;                                                \
+    if (s == (ptrdiff_t)sizeof(T)) {                                               \
+      const T *q = (const T *)p;                                        \
+      for (i=1; i<n; i++) m = (q[i] < m) ? q[i] : m;                    \
+    } else {                                                            \
+      for (i=1, p+=s; i<n; i++, p+=s)                                   \
+        m = (*(const T *)p < m) ? *(const T *)p : m;                    \
+    }                                                                   \
+    return m;                                                           \
+  }                                                                     \
+  static double max_##name(const char *p, ptrdiff_t s, size_t n)        \
+  {                                                                     \
+    size_t i;                                                           \
+    T m = *(const T *)p;                                                \
+    if (s == (ptrdiff_t)sizeof(T)) {                                               \
+      const T *q = (const T *)p;                                        \
+      for (i=1; i<n; i++) m = (q[i] > m) ? q[i] : m;                    \
+    } else {                                                            \
+      for (i=1, p+=s; i<n; i++, p+=s)                                   \
+        m = (*(const T *)p > m) ? *(const T *)p : m;                    \
+    }                                                                   \
+    return m;                                                           \
+  }                                                                     \
+  static void scale_##name(char *p, ptrdiff_t s, size_t n,              \
+                           double a, double b)                          \
+  {                                                                     \
+    size_t i;                                                           \
+    if (s == (ptrdiff_t)sizeof(T)) {                                               \
+      T *q = (T *)p;                                                    \
+      for (i=0; i<n; i++) q[i] = (T)(a*q[i] + b);                       \
+    } else {                                                            \
+      for (i=0; i<n; i++, p+=s) *(T *)p = (T)(a * *(T *)p + b);         \
+    }                                                                   \
+  }                                                                     \
+  static void axpy_##name(char *y, ptrdiff_t sy, const char *x,         \
+                          ptrdiff_t sx, size_t n, double a)             \
+  {                                                                     \
+    size_t i;                                                           \
+    if (sy == (ptrdiff_t)sizeof(T) && sx == (ptrdiff_t)sizeof(T)) {                           \
+      T *qy = (T *)y;                                                   \
+      const T *qx = (const T *)x;                                       \
+      for (i=0; i<n; i++) qy[i] = (T)(a*qx[i] + qy[i]);                 \
+    } else {                                                            \
+      for (i=0; i<n; i++, y+=sy, x+=sx)                                 \
+        *(T *)y = (T)(a * *(const T *)x + *(T *)y);                     \
+    }                                                                   \
+  }                                                                     \
+  static const ArrayKernels kernels_##name = {                          \
+    sum_##name, min_##name, max_##name, scale_##name, axpy_##name       \
+  };
+
+DEFINE_ARRAY_KERNELS(int8, int8_t)
+DEFINE_ARRAY_KERNELS(int16, int16_t)
+DEFINE_ARRAY_KERNELS(int32, int32_t)
+DEFINE_ARRAY_KERNELS(int64, int64_t)
+DEFINE_ARRAY_KERNELS(uint8, uint8_t)
+DEFINE_ARRAY_KERNELS(uint16, uint16_t)
+DEFINE_ARRAY_KERNELS(uint32, uint32_t)
+DEFINE_ARRAY_KERNELS(uint64, uint64_t)
+DEFINE_ARRAY_KERNELS(float32, float32_t)
+DEFINE_ARRAY_KERNELS(float64, float64_t)
+
+/* Returns kernels for the element type of `arr` or NULL on error. */
+static const ArrayKernels *get_kernels(const DLiteArray *arr)
+{
+  char typename[32];
+  switch (arr->type) {
+  case dliteInt:
+    switch (arr->size) {
+    case 1: return &kernels_int8;
+    case 2: return &kernels_int16;
+    case 4: return &kernels_int32;
+    case 8: return &kernels_int64;
+    }
+    break;
+  case dliteUInt:
+    switch (arr->size) {
+    case 1: return &kernels_uint8;
+    case 2: return &kernels_uint16;
+    case 4: return &kernels_uint32;
+    case 8: return &kernels_uint64;
+    }
+    break;
+  case dliteFloat:
+    switch (arr->size) {
+    case 4: return &kernels_float32;
+    case 8: return &kernels_float64;
+    }
+    break;
+  default:
+    break;
+  }
+  dlite_type_set_typename(arr->type, arr->size, typename, sizeof(typename));
+  return err(1, "numerical array operations are not supported for type %s",
+             typename), NULL;
+}
+
+/* Number of elements in `arr`. */
+static size_t array_length(const DLiteArray *arr)
+{
+  int i;
+  size_t n=1;
+  for (i=0; i<arr->ndims; i++) n *= arr->dims[i];
+  return n;
+}
+
+
+/*
+  Stores the sum of all elements in `arr` to `*result`.  The sum of an
+  empty array is zero.  Returns non-zero on error.
+ */
+int dlite_array_sum(const DLiteArray *arr, double *result)
+{
+  const ArrayKernels *k;
+  RowIter it;
+  double sum=0;
+  if (!(k = get_kernels(arr))) return 1;
+  if (rowiter_init(&it, arr, NULL)) return 1;
+  while (rowiter_next(&it)) sum += k->sum(it.pa, it.sa, it.n);
+  *result = sum;
+  return 0;
+}
+
+/*
+  Stores the mean of all elements in `arr` to `*result`.
+  Returns non-zero on error or if `arr` is empty.
+ */
+int dlite_array_mean(const DLiteArray *arr, double *result)
+{
+  double sum;
+  size_t n = array_length(arr);
+  if (n == 0) return err(1, "cannot calculate mean of empty array");
+  if (dlite_array_sum(arr, &sum)) return 1;
+  *result = sum / n;
+  return 0;
+}
+
+/*
+  Stores the smallest element in `arr` to `*result`.
+  Returns non-zero on error or if `arr` is empty.
+ */
+int dlite_array_min(const DLiteArray *arr, double *result)
+{
+  const ArrayKernels *k;
+  RowIter it;
+  double v, m=HUGE_VAL;
+  if (!(k = get_kernels(arr))) return 1;
+  if (array_length(arr) == 0)
+    return err(1, "cannot calculate minimum of empty array");
+  if (rowiter_init(&it, arr, NULL)) return 1;
+  while (rowiter_next(&it))
+    if ((v = k->min(it.pa, it.sa, it.n)) < m) m = v;
+  *result = m;
+  return 0;
+}
+
+/*
+  Stores the largest element in `arr` to `*result`.
+  Returns non-zero on error or if `arr` is empty.
+ */
+int dlite_array_max(const DLiteArray *arr, double *result)
+{
+  const ArrayKernels *k;
+  RowIter it;
+  double v, m=-HUGE_VAL;
+  if (!(k = get_kernels(arr))) return 1;
+  if (array_length(arr) == 0)
+    return err(1, "cannot calculate maximum of empty array");
+  if (rowiter_init(&it, arr, NULL)) return 1;
+  while (rowiter_next(&it))
+    if ((v = k->max(it.pa, it.sa, it.n)) > m) m = v;
+  *result = m;
+  return 0;
+}
+
+/*
+  Updates each element `x` of `arr` in place to `scale*x + offset`.
+  Returns non-zero on error.
+ */
+int dlite_array_scale(DLiteArray *arr, double scale, double offset)
+{
+  const ArrayKernels *k;
+  RowIter it;
+  if (!(k = get_kernels(arr))) return 1;
+  if (rowiter_init(&it, arr, NULL)) return 1;
+  while (rowiter_next(&it)) k->scale(it.pa, it.sa, it.n, scale, offset);
+  return 0;
+}
+
+/*
+  Updates `y` in place to `a*x + y`.  `x` and `y` must have the same
+  type and dimensions, but may have different strides.
+
+  Returns non-zero on error.
+ */
+int dlite_array_axpy(DLiteArray *y, double a, const DLiteArray *x)
+{
+  const ArrayKernels *k;
+  RowIter it;
+  if (x->type != y->type || x->size != y->size)
+    return err(1, "axpy requires arrays of same type");
+  if (!(k = get_kernels(y))) return 1;
+  if (rowiter_init(&it, y, x)) return 1;
+  while (rowiter_next(&it)) k->axpy(it.pa, it.sa, it.pb, it.sb, it.n, a);
+  return 0;
+}
+
+/*
+  Copies the elements of `src` to `dest`, casting them to the type of
+  `dest`.  `src` and `dest` must have the same dimensions, but may have
+  different types and strides.
+
+  Returns non-zero on error.
+ */
+int dlite_array_copy_cast(DLiteArray *dest, const DLiteArray *src)
+{
+  int i;
+  if (dest->ndims != src->ndims)
+    return err(1, "arrays have different number of dimensions");
+  for (i=0; i<src->ndims; i++)
+    if (dest->dims[i] != src->dims[i])
+      return err(1, "arrays have different dimensions");
+  return dlite_type_ndcast(src->ndims,
+                           dest->data, dest->type, dest->size,
+                           dest->dims, dest->strides,
+                           src->data, src->type, src->size,
+                           src->dims, src->strides, NULL);
+}
@@ -7,8 +7,9 @@
 
   The DLiteArray structure adds some basic functionality for accessing
   multidimensional array data.  It it not a complete array library and
-  do no memory management.  It is neither optimised for speed, so don't
-  use it for writing optimised solvers.
+  do no memory management.  Except for the numerical functions, it is
+  neither optimised for speed, so don't use it for writing optimised
+  solvers.
 
   Included features:
     - indexing
@@ -19,6 +20,14 @@
     - transpose
     - make_continuous
     - pretty printing
+    - reductions (sum, mean, min, max) of numerical arrays
+    - element-wise scaling and axpy of numerical arrays
+    - type-converting copy
+
+  The numerical functions work on any array, including strided views
+  like slices and transposes.  They loop over the innermost dimension
+  with typed kernels that the compiler can vectorise.  C-continuous
+  arrays are handled as a single row.
  */
 
 #include <stdio.h>
@@ -26,6 +35,11 @@
 #include "dlite-type.h"
 
 
+/** Maximum number of dimensions supported by the array iterators and
+    numerical functions. */
+#define DLITE_ARRAY_MAXDIMS 32
+
+
 /** DLite n-dimensional arrays */
 typedef struct _DLiteArray {
   void *data;      /*!< pointer to array data */
@@ -43,10 +57,24 @@ typedef struct _DLiteArray {
 /** Array iterator object. */
 typedef struct _DLiteArrayIter {
   const DLiteArray *arr;  /*!< pointer to the array we are iterating over */
-  int *ind;               /*!< the current index */
+  int ind[DLITE_ARRAY_MAXDIMS];  /*!< the current index */
+  char *ptr;              /*!< pointer to the current element */
+  int state;              /*!< 0: not started, 1: running, 2: exhausted */
 } DLiteArrayIter;
 
 
+/** Iterator over contiguous blocks of an array.  Each block is a run of
+    elements that are consecutive in memory. */
+typedef struct _DLiteArrayBlockIter {
+  const DLiteArray *arr;  /*!< pointer to the array we are iterating over */
+  int nouter;             /*!< number of dimensions iterated over */
+  size_t len;             /*!< number of elements in each block */
+  int ind[DLITE_ARRAY_MAXDIMS];  /*!< index of the current block */
+  char *ptr;              /*!< pointer to the current block */
+  int state;              /*!< 0: not started, 1: running, 2: exhausted */
+} DLiteArrayBlockIter;
+
+
 /**
   Creates a new array object.
 
@@ -104,13 +132,15 @@ void *dlite_array_vindex(const DLiteArray *arr, ...);
 
 /**
   Initialise array iterator object `iter`, for iteration over array `arr`.
+  No memory is allocated.
 
   Returns non-zero on error.
 */
 int dlite_array_iter_init(DLiteArrayIter *iter, const DLiteArray *arr);
 
 /**
-  Deinitialise array iterator object `iter`.
+  Deinitialise array iterator object `iter`.  Since the iterator holds
+  no allocated memory, this is currently a no-op.
 */
 void dlite_array_iter_deinit(DLiteArrayIter *iter);
 
@@ -120,6 +150,36 @@ void dlite_array_iter_deinit(DLiteArrayIter *iter);
 */
 void *dlite_array_iter_next(DLiteArrayIter *iter);
 
+/**
+  Initialise block iterator `iter` for iteration over array `arr` in
+  blocks of contiguous elements.  The block length is determined by
+  the number of innermost dimensions that are C-contiguous.  If the
+  innermost dimension is not contiguous, each block is a single
+  element.  No memory is allocated.
+
+  Returns non-zero on error.
+
+  Example:
+
+  ```C
+  DLiteArrayBlockIter iter;
+  size_t n;
+  char *p;
+  dlite_array_blockiter_init(&iter, arr);
+  while ((p = dlite_array_blockiter_next(&iter, &n)))
+    fwrite(p, arr->size, n, fp);
+  ```
+*/
+int dlite_array_blockiter_init(DLiteArrayBlockIter *iter,
+                               const DLiteArray *arr);
+
+/**
+  Returns a pointer to the next block of contiguous elements or NULL
+  if all blocks have been visited.  If `len` is not NULL, the number
+  of elements in the block is written to it.
+*/
+void *dlite_array_blockiter_next(DLiteArrayBlockIter *iter, size_t *len);
+
 /**
   Returns 1 is arrays `a` and `b` are equal, zero otherwise.
  */
@@ -215,4 +275,64 @@ void *dlite_array_make_continuous(DLiteArray *arr);
  */
 int dlite_array_printf(FILE *fp, const DLiteArray *arr, int width, int prec);
 
+
+/**
+  @name Numerical functions
+  These functions are supported for arrays of signed and unsigned
+  integers of size 1, 2, 4 and 8 and floats of size 4 and 8.
+  Reductions are accumulated in double precision.
+*/
+/** @{ */
+
+/**
+  Stores the sum of all elements in `arr` to `*result`.  The sum of an
+  empty array is zero.  Returns non-zero on error.
+ */
+int dlite_array_sum(const DLiteArray *arr, double *result);
+
+/**
+  Stores the mean of all elements in `arr` to `*result`.
+  Returns non-zero on error or if `arr` is empty.
+ */
+int dlite_array_mean(const DLiteArray *arr, double *result);
+
+/**
+  Stores the smallest element in `arr` to `*result`.
+  Returns non-zero on error or if `arr` is empty.
+ */
+int dlite_array_min(const DLiteArray *arr, double *result);
+
+/**
+  Stores the largest element in `arr` to `*result`.
+  Returns non-zero on error or if `arr` is empty.
+ */
+int dlite_array_max(const DLiteArray *arr, double *result);
+
+/**
+  Updates each element `x` of `arr` in place to `scale*x + offset`.
+  For integer arrays the result is truncated like a C cast.
+
+  Returns non-zero on error.
+ */
+int dlite_array_scale(DLiteArray *arr, double scale, double offset);
+
+/**
+  Updates `y` in place to `a*x + y`.  `x` and `y` must have the same
+  type and dimensions, but may have different strides.
+
+  Returns non-zero on error.
+ */
+int dlite_array_axpy(DLiteArray *y, double a, const DLiteArray *x);
+
+/**
+  Copies the elements of `src` to `dest`, casting them to the type of
+  `dest`.  `src` and `dest` must have the same dimensions, but may have
+  different types and strides.  Uses dlite_type_ndcast().
+
+  Returns non-zero on error.
+ */
+int dlite_array_copy_cast(DLiteArray *dest, const DLiteArray *src);
+
+/** @} */
+
 #endif /* _DLITE_ARRAYS_H */
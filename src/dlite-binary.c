@@ -0,0 +1,947 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/err.h"
+#include "utils/byteorder.h"
+
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-binary.h"
+
+
+/* Length of an encoded NULL string */
+#define NULL_STRING UINT64_MAX
+
+
+/* Output buffer.  Like snprintf(), data that does not fit into the
+   buffer is dropped, but `pos` is still advanced. */
+typedef struct {
+  unsigned char *dest;  /* output buffer, may be NULL if `n` is zero */
+  size_t n;             /* size of output buffer */
+  size_t pos;           /* current position */
+} Writer;
+
+/* Input buffer */
+typedef struct {
+  const unsigned char *src;  /* input buffer */
+  size_t n;                  /* size of input buffer */
+  size_t pos;                /* current position */
+} Reader;
+
+
+/*
+  Copies `nelem` elements of size `size` from `src` to `dest`,
+  reversing the byte order of each element.
+ */
+static void swap_copy(unsigned char *dest, const unsigned char *src,
+                      size_t size, size_t nelem)
+{
+  size_t i, j;
+  switch (size) {
+  case 1:
+    memcpy(dest, src, nelem);
+    break;
+  case 2:
+    for (i=0; i<nelem; i++) {
+      uint16_t v;
+      memcpy(&v, src + 2*i, 2);
+      v = bswap_16(v);
+      memcpy(dest + 2*i, &v, 2);
+    }
+    break;
+  case 4:
+    for (i=0; i<nelem; i++) {
+      uint32_t v;
+      memcpy(&v, src + 4*i, 4);
+      v = bswap_32(v);
+      memcpy(dest + 4*i, &v, 4);
+    }
+    break;
+  case 8:
+    for (i=0; i<nelem; i++) {
+      uint64_t v;
+      memcpy(&v, src + 8*i, 8);
+      v = bswap_64(v);
+      memcpy(dest + 8*i, &v, 8);
+    }
+    break;
+  default:
+    for (i=0; i<nelem; i++)
+      for (j=0; j<size; j++)
+        dest[i*size + j] = src[i*size + size - 1 - j];
+  }
+}
+
+/*
+  Copies `nelem` numerical elements of size `size` between host and
+  little endian byte order.  The conversion is its own inverse.
+ */
+static void copy_le(unsigned char *dest, const unsigned char *src,
+                    size_t size, size_t nelem)
+{
+  if (BYTE_ORDER == BIG_ENDIAN)
+    swap_copy(dest, src, size, nelem);
+  else if (size && nelem)
+    memcpy(dest, src, size*nelem);
+}
+
+
+/* Writes `len` bytes from `src` */
+static void put(Writer *w, const void *src, size_t len)
+{
+  if (len && w->pos + len <= w->n) memcpy(w->dest + w->pos, src, len);
+  w->pos += len;
+}
+
+/* Writes `nelem` numerical elements of size `size` in little endian */
+static void put_le(Writer *w, const void *src, size_t size, size_t nelem)
+{
+  size_t len = size * nelem;
+  if (len && w->pos + len <= w->n) copy_le(w->dest + w->pos, src, size, nelem);
+  w->pos += len;
+}
+
+static void put_uint32(Writer *w, uint32_t v)
+{
+  put_le(w, &v, sizeof(v), 1);
+}
+
+static void put_uint64(Writer *w, uint64_t v)
+{
+  put_le(w, &v, sizeof(v), 1);
+}
+
+static void put_string(Writer *w, const char *s)
+{
+  if (s) {
+    size_t len = strlen(s);
+    put_uint64(w, len);
+    put(w, s, len);
+  } else {
+    put_uint64(w, NULL_STRING);
+  }
+}
+
+
+/* Reads `len` bytes to `dest`.  Returns non-zero on error. */
+static int get(Reader *r, void *dest, size_t len)
+{
+  if (len > r->n - r->pos)
+    return errx(1, "unexpected end of binary data at position %lu",
+                (unsigned long)r->pos);
+  if (len) memcpy(dest, r->src + r->pos, len);
+  r->pos += len;
+  return 0;
+}
+
+/* Reads `nelem` little endian numerical elements of size `size` to `dest`.
+   Returns non-zero on error. */
+static int get_le(Reader *r, void *dest, size_t size, size_t nelem)
+{
+  size_t len = size * nelem;
+  if (len > r->n - r->pos)
+    return errx(1, "unexpected end of binary data at position %lu",
+                (unsigned long)r->pos);
+  copy_le(dest, r->src + r->pos, size, nelem);
+  r->pos += len;
+  return 0;
+}
+
+static int get_uint32(Reader *r, uint32_t *v)
+{
+  return get_le(r, v, sizeof(*v), 1);
+}
+
+static int get_uint64(Reader *r, uint64_t *v)
+{
+  return get_le(r, v, sizeof(*v), 1);
+}
+
+/* Reads a string and assigns it to `*s`.  Any previous value of `*s`
+   is free'ed.  Returns non-zero on error. */
+static int get_string(Reader *r, char **s)
+{
+  uint64_t len;
+  char *p=NULL;
+  if (get_uint64(r, &len)) return 1;
+  if (len != NULL_STRING) {
+    if (len > r->n - r->pos)
+      return errx(1, "string length %llu exceeds binary data",
+                  (unsigned long long)len);
+    if (!(p = malloc(len + 1))) return err(1, "allocation failure");
+    memcpy(p, r->src + r->pos, len);
+    p[len] = '\0';
+    r->pos += len;
+  }
+  if (*s) free(*s);
+  *s = p;
+  return 0;
+}
+
+
+/* Encodes `nelem` elements to `w`.  Returns non-zero on error. */
+static int encode(Writer *w, const void *p, DLiteType dtype, size_t size,
+                  size_t nelem)
+{
+  const unsigned char *q = p;
+  size_t i;
+  int j;
+
+  if (size && nelem > PTRDIFF_MAX / size)
+    return errx(1, "too many elements to encode: %lu", (unsigned long)nelem);
+
+  switch (dtype) {
+  case dliteBlob:
+  case dliteFixString:
+    put(w, p, size*nelem);
+    break;
+  case dliteBool:
+    for (i=0; i<nelem; i++) {
+      unsigned char v = (((const bool *)p)[i]) ? 1 : 0;
+      put(w, &v, 1);
+    }
+    break;
+  case dliteInt:
+  case dliteUInt:
+  case dliteFloat:
+    put_le(w, p, size, nelem);
+    break;
+  case dliteStringPtr:
+    for (i=0; i<nelem; i++)
+      put_string(w, ((char * const *)p)[i]);
+    break;
+  case dliteDimension:
+    for (i=0; i<nelem; i++, q+=size) {
+      const DLiteDimension *d = (const DLiteDimension *)q;
+      put_string(w, d->name);
+      put_string(w, d->description);
+    }
+    break;
+  case dliteProperty:
+    for (i=0; i<nelem; i++, q+=size) {
+      const DLiteProperty *prop = (const DLiteProperty *)q;
+      char typename[32];
+      if (dlite_type_set_typename(prop->type, prop->size, typename,
+                                  sizeof(typename))) return 1;
+      put_string(w, prop->name);
+      put_string(w, typename);
+      put_uint32(w, prop->ndims);
+      for (j=0; j<prop->ndims; j++)
+        put_string(w, (prop->dims) ? prop->dims[j] : NULL);
+      put_string(w, prop->unit);
+      put_string(w, prop->iri);
+      put_string(w, prop->description);
+    }
+    break;
+  case dliteRelation:
+    for (i=0; i<nelem; i++, q+=size) {
+      const DLiteRelation *rel = (const DLiteRelation *)q;
+      put_string(w, rel->s);
+      put_string(w, rel->p);
+      put_string(w, rel->o);
+      put_string(w, rel->id);
+    }
+    break;
+  default:
+    return errx(1, "cannot encode unknown type number %d", dtype);
+  }
+  return 0;
+}
+
+
+/* Decodes `nelem` elements from `r`.  Returns non-zero on error. */
+static int decode(Reader *r, void *p, DLiteType dtype, size_t size,
+                  size_t nelem)
+{
+  unsigned char *q = p;
+  size_t i;
+  uint32_t ndims;
+  int j;
+
+  if (size && nelem > PTRDIFF_MAX / size)
+    return errx(1, "too many elements to decode: %lu", (unsigned long)nelem);
+
+  switch (dtype) {
+  case dliteBlob:
+    return get(r, p, size*nelem);
+  case dliteFixString:
+    if (get(r, p, size*nelem)) return 1;
+    if (size)
+      for (i=0; i<nelem; i++) q[i*size + size - 1] = '\0';
+    break;
+  case dliteBool:
+    for (i=0; i<nelem; i++) {
+      unsigned char v;
+      if (get(r, &v, 1)) return 1;
+      ((bool *)p)[i] = (v) ? 1 : 0;
+    }
+    break;
+  case dliteInt:
+  case dliteUInt:
+  case dliteFloat:
+    return get_le(r, p, size, nelem);
+  case dliteStringPtr:
+    for (i=0; i<nelem; i++)
+      if (get_string(r, ((char **)p) + i)) return 1;
+    break;
+  case dliteDimension:
+    for (i=0; i<nelem; i++, q+=size) {
+      DLiteDimension *d = (DLiteDimension *)q;
+      if (get_string(r, &d->name) ||
+          get_string(r, &d->description)) return 1;
+    }
+    break;
+  case dliteProperty:
+    for (i=0; i<nelem; i++, q+=size) {
+      DLiteProperty *prop = (DLiteProperty *)q;
+      char *typename=NULL;
+      int stat;
+      dlite_type_clear(prop, dliteProperty, size);
+      if (get_string(r, &prop->name) || get_string(r, &typename)) return 1;
+      stat = (typename) ?
+        dlite_type_set_dtype_and_size(typename, &prop->type, &prop->size) :
+        errx(1, "missing type of property '%s'", prop->name);
+      free(typename);
+      if (stat) return 1;
+      if (get_uint32(r, &ndims)) return 1;
+      if (ndims > r->n - r->pos)
+        return errx(1, "invalid number of dimensions: %u", (unsigned)ndims);
+      if (ndims) {
+        if (!(prop->dims = calloc(ndims, sizeof(char *))))
+          return err(1, "allocation failure");
+        prop->ndims = ndims;
+        for (j=0; j<prop->ndims; j++)
+          if (get_string(r, prop->dims + j)) return 1;
+      }
+      if (get_string(r, &prop->unit) ||
+          get_string(r, &prop->iri) ||
+          get_string(r, &prop->description)) return 1;
+    }
+    break;
+  case dliteRelation:
+    for (i=0; i<nelem; i++, q+=size) {
+      DLiteRelation *rel = (DLiteRelation *)q;
+      if (get_string(r, &rel->s) ||
+          get_string(r, &rel->p) ||
+          get_string(r, &rel->o) ||
+          get_string(r, &rel->id)) return 1;
+    }
+    break;
+  default:
+    return errx(1, "cannot decode unknown type number %d", dtype);
+  }
+  return 0;
+}
+
+
+/*
+  Encodes `nelem` elements of type `dtype` and size `size` pointed to
+  by `p` to `dest`.  No more than `n` bytes are written.
+
+  Returns number of bytes written to `dest`.  If the output is
+  truncated because it exceeds `n`, the number of bytes that would
+  have been written if `n` was large enough is returned.  On error, a
+  negative value is returned.
+ */
+ptrdiff_t dlite_type_encode(unsigned char *dest, size_t n, const void *p,
+                            DLiteType dtype, size_t size, size_t nelem)
+{
+  Writer w = {dest, n, 0};
+  if (encode(&w, p, dtype, size, nelem)) return -1;
+  return w.pos;
+}
+
+
+/*
+  Decodes `nelem` elements of type `dtype` and size `size` from `src`
+  and writes them to memory pointed to by `p`.  At most `n` bytes are
+  read from `src`.
+
+  Returns number of bytes consumed or -1 on error.
+ */
+ptrdiff_t dlite_type_decode(const unsigned char *src, size_t n, void *p,
+                            DLiteType dtype, size_t size, size_t nelem)
+{
+  Reader r = {src, n, 0};
+  if (decode(&r, p, dtype, size, nelem)) return -1;
+  return r.pos;
+}
+
+
+/* Returns the number of elements of property `i` in `inst`. */
+static size_t property_nelem(const DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *p = inst->meta->_properties + i;
+  size_t nelem=1;
+  int j;
+  for (j=0; j<p->ndims; j++) nelem *= DLITE_PROP_DIM(inst, i, j);
+  return nelem;
+}
+
+/* Encodes property `i` of `inst` to `w`.  Returns non-zero on error. */
+static int encode_property(Writer *w, const DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *p;
+  const void *ptr;
+  size_t nelem;
+  if (i >= inst->meta->_nproperties)
+    return errx(1, "property index %d out of range for %s",
+                (int)i, inst->meta->uri);
+  ptr = dlite_instance_peek_property_by_index(inst, i);
+  p = inst->meta->_properties + i;
+  nelem = property_nelem(inst, i);
+  if (!ptr && nelem) return 1;
+  put_uint64(w, nelem);
+  return encode(w, ptr, p->type, p->size, nelem);
+}
+
+/* Decodes `nelem` strings from `r` into a string heap of string array
+   property `i` of `inst`.  Returns non-zero on error. */
+static int decode_string_array(Reader *r, DLiteInstance *inst, size_t i,
+                               size_t nelem)
+{
+  Reader r2 = *r;
+  uint64_t len;
+  size_t n, size=0;
+  char **strings, *heap;
+
+  /* first pass: validate and find size of the heap */
+  for (n=0; n<nelem; n++) {
+    if (get_uint64(&r2, &len)) return 1;
+    if (len == NULL_STRING) continue;
+    if (len > r2.n - r2.pos)
+      return errx(1, "string length %llu exceeds binary data",
+                  (unsigned long long)len);
+    r2.pos += len;
+    size += len + 1;
+  }
+  if (!(heap = dlite_instance_string_heap(inst, i, size))) return 1;
+  strings = *(char ***)DLITE_PROP(inst, i);
+
+  /* second pass: copy strings to the heap */
+  for (n=0, size=0; n<nelem; n++) {
+    get_uint64(r, &len);
+    if (len == NULL_STRING) continue;
+    memcpy(heap + size, r->src + r->pos, len);
+    heap[size + len] = '\0';
+    strings[n] = heap + size;
+    size += len + 1;
+    r->pos += len;
+  }
+  return 0;
+}
+
+/* Decodes property `i` of `inst` from `r`.  Returns non-zero on error. */
+static int decode_property(Reader *r, DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *p = inst->meta->_properties + i;
+  size_t nelem = property_nelem(inst, i);
+  uint64_t m;
+  void *ptr;
+  if (get_uint64(r, &m)) return 1;
+  if (m != nelem)
+    return errx(1, "property '%s' has %lu elements, got %llu",
+                p->name, (unsigned long)nelem, (unsigned long long)m);
+  if (p->type == dliteStringPtr && p->ndims > 0 && nelem &&
+      !dlite_instance_is_meta(inst)) {
+    if (decode_string_array(r, inst, i, nelem)) return 1;
+    if (inst->meta->_loadprop && inst->meta->_loadprop(inst, i)) return 1;
+    return 0;
+  }
+  /* request a writable pointer, such that shared buffers are unshared */
+  ptr = dlite_instance_get_property_by_index(inst, i);
+  if (!ptr && nelem) return 1;
+  if (decode(r, ptr, p->type, p->size, nelem)) return 1;
+  if (inst->meta->_loadprop && inst->meta->_loadprop(inst, i)) return 1;
+  return 0;
+}
+
+
+/*
+  Encodes property number `i` of instance `inst` to `dest`, prefixed
+  with its number of elements.  No more than `n` bytes are written.
+
+  Returns number of bytes needed to encode the property or a negative
+  number on error.
+ */
+ptrdiff_t dlite_binary_encode_property(unsigned char *dest, size_t n,
+                                       const DLiteInstance *inst, size_t i)
+{
+  Writer w = {dest, n, 0};
+  if (encode_property(&w, inst, i)) return -1;
+  return w.pos;
+}
+
+
+/*
+  Decodes a property encoded with dlite_binary_encode_property() from
+  `src` and assigns it to property number `i` of `inst`.
+
+  Returns number of bytes consumed or -1 on error.
+ */
+ptrdiff_t dlite_binary_decode_property(const unsigned char *src, size_t n,
+                                       DLiteInstance *inst, size_t i)
+{
+  Reader r = {src, n, 0};
+  if (i >= inst->meta->_nproperties)
+    return errx(1, "index %d exceeds number of properties (%d) in %s",
+                (int)i, (int)inst->meta->_nproperties, inst->meta->uri);
+  if (decode_property(&r, inst, i)) return -1;
+  return r.pos;
+}
+
+
+/*
+  Encodes instance `inst` to `dest`.  No more than `n` bytes are
+  written.
+
+  Returns number of bytes needed to encode the instance or a negative
+  number on error.
+ */
+ptrdiff_t dlite_binary_encode(unsigned char *dest, size_t n,
+                              const DLiteInstance *inst)
+{
+  Writer w = {dest, n, 0};
+  size_t i;
+
+  if (!inst->meta) return errx(-1, "no metadata available");
+  if (dlite_instance_sync_to_dimension_sizes((DLiteInstance *)inst))
+    return -1;
+
+  put(&w, DLITE_BINARY_MAGIC, 4);
+  put_uint32(&w, DLITE_BINARY_VERSION);
+  put_string(&w, inst->uuid);
+  put_string(&w, inst->uri);
+  put_string(&w, inst->meta->uri);
+  put_uint64(&w, inst->meta->_ndimensions);
+  for (i=0; i < inst->meta->_ndimensions; i++)
+    put_uint64(&w, DLITE_DIM(inst, i));
+  put_uint64(&w, inst->meta->_nproperties);
+  for (i=0; i < inst->meta->_nproperties; i++)
+    if (encode_property(&w, inst, i)) return -1;
+  return w.pos;
+}
+
+
+/*
+  Like dlite_binary_encode(), but returns a newly allocated buffer
+  with the encoded instance.
+ */
+unsigned char *dlite_binary_aencode(const DLiteInstance *inst, size_t *len)
+{
+  unsigned char *buf;
+  ptrdiff_t m, n;
+  if ((n = dlite_binary_encode(NULL, 0, inst)) < 0) return NULL;
+  if (!(buf = malloc(n))) return err(1, "allocation failure"), NULL;
+  if ((m = dlite_binary_encode(buf, n, inst)) != n) {
+    free(buf);
+    if (m >= 0) errx(1, "instance '%s' changed while encoding", inst->uuid);
+    return NULL;
+  }
+  if (len) *len = n;
+  return buf;
+}
+
+
+/*
+  Returns a new instance decoded from the `n` bytes in `src`.
+ */
+DLiteInstance *dlite_binary_decode(const unsigned char *src, size_t n,
+                                   size_t *consumed)
+{
+  Reader r = {src, n, 0};
+  char magic[4], *uuid=NULL, *uri=NULL, *metauri=NULL;
+  uint32_t version;
+  uint64_t ndims, nprops, v;
+  size_t i, *dims=NULL;
+  DLiteMeta *meta=NULL;
+  DLiteInstance *inst=NULL;
+  int ok=0;
+
+  if (get(&r, magic, 4)) goto fail;
+  if (memcmp(magic, DLITE_BINARY_MAGIC, 4))
+    FAIL("not a binary encoded dlite instance");
+  if (get_uint32(&r, &version)) goto fail;
+  if (version != DLITE_BINARY_VERSION)
+    FAIL1("unsupported binary format version: %u", (unsigned)version);
+  if (get_string(&r, &uuid) || get_string(&r, &uri) ||
+      get_string(&r, &metauri)) goto fail;
+  if (!uuid || strlen(uuid) != DLITE_UUID_LENGTH)
+    FAIL("invalid uuid in binary encoded instance");
+  if (!metauri) FAIL1("missing metadata uri for instance %s", uuid);
+  if (!(meta = dlite_meta_get(metauri)))
+    FAIL2("cannot find metadata '%s' when decoding '%s'", metauri, uuid);
+
+  if (get_uint64(&r, &ndims)) goto fail;
+  if (ndims != meta->_ndimensions)
+    FAIL3("expected %d dimensions, got %d in instance %s",
+          (int)meta->_ndimensions, (int)ndims, uuid);
+  if (!(dims = calloc(meta->_ndimensions + 1, sizeof(size_t))))
+    FAIL("allocation failure");
+  for (i=0; i < meta->_ndimensions; i++) {
+    if (get_uint64(&r, &v)) goto fail;
+    dims[i] = v;
+  }
+  if (get_uint64(&r, &nprops)) goto fail;
+  if (nprops != meta->_nproperties)
+    FAIL3("expected %d properties, got %d in instance %s",
+          (int)meta->_nproperties, (int)nprops, uuid);
+
+  if (!(inst = dlite_instance_create(meta, dims, (uri) ? uri : uuid)))
+    goto fail;
+  if (strcmp(inst->uuid, uuid) != 0)
+    FAIL2("instance has uuid \"%s\", expected \"%s\"", inst->uuid, uuid);
+  for (i=0; i < meta->_ndimensions; i++)
+    if (DLITE_DIM(inst, i) != dims[i])
+      FAIL2("existing instance %s has different size of dimension '%s'",
+            uuid, meta->_dimensions[i].name);
+  for (i=0; i < meta->_nproperties; i++)
+    if (decode_property(&r, inst, i)) goto fail;
+  if (dlite_instance_is_meta(inst)) dlite_meta_init((DLiteMeta *)inst);
+
+  if (consumed) *consumed = r.pos;
+  ok = 1;
+ fail:
+  if (uuid) free(uuid);
+  if (uri) free(uri);
+  if (metauri) free(metauri);
+  if (dims) free(dims);
+  if (meta) dlite_meta_decref(meta);
+  if (!ok && inst) {
+    dlite_instance_decref(inst);
+    inst = NULL;
+  }
+  return inst;
+}
+
+
+/**************************************************************
+ * Instance patches
+ **************************************************************/
+
+/* Kinds of property entries in a patch */
+#define PATCH_FULL   0  /* the whole property is replaced */
+#define PATCH_RANGES 1  /* only the given element ranges are replaced */
+
+/* Unchanged elements between two changed ranges are included in the
+   same range if they take up no more than this number of bytes, which
+   is the overhead of an extra range (offset and count). */
+#define RANGE_OVERHEAD 16
+
+/* Returns non-zero if strings `a` and `b` are equal.  NULL equals NULL. */
+static int streq(const char *a, const char *b)
+{
+  if (!a || !b) return a == b;
+  return strcmp(a, b) == 0;
+}
+
+/* Returns non-zero if the elements pointed to by `p` and `q` are equal. */
+static int elem_equal(const void *p, const void *q, DLiteType dtype,
+                      size_t size)
+{
+  int j;
+  switch (dtype) {
+  case dliteBool:
+    return !(*(const bool *)p) == !(*(const bool *)q);
+  case dliteStringPtr:
+    return streq(*(char * const *)p, *(char * const *)q);
+  case dliteDimension:
+    {
+      const DLiteDimension *a=p, *b=q;
+      return streq(a->name, b->name) && streq(a->description, b->description);
+    }
+  case dliteProperty:
+    {
+      const DLiteProperty *a=p, *b=q;
+      if (a->type != b->type || a->size != b->size || a->ndims != b->ndims ||
+          !streq(a->name, b->name) || !streq(a->unit, b->unit) ||
+          !streq(a->iri, b->iri) || !streq(a->description, b->description))
+        return 0;
+      for (j=0; j<a->ndims; j++)
+        if (!streq((a->dims) ? a->dims[j] : NULL,
+                   (b->dims) ? b->dims[j] : NULL)) return 0;
+      return 1;
+    }
+  case dliteRelation:
+    {
+      const DLiteRelation *a=p, *b=q;
+      return streq(a->s, b->s) && streq(a->p, b->p) && streq(a->o, b->o) &&
+        streq(a->id, b->id);
+    }
+  default:
+    return memcmp(p, q, size) == 0;
+  }
+}
+
+/* Returns non-zero if property `i` has the same shape in `a` and `b`. */
+static int same_shape(const DLiteInstance *a, const DLiteInstance *b,
+                      size_t i)
+{
+  int j;
+  for (j=0; j < a->meta->_properties[i].ndims; j++)
+    if (DLITE_PROP_DIM(a, i, j) != DLITE_PROP_DIM(b, i, j)) return 0;
+  return 1;
+}
+
+/*
+  Writes the changed element ranges of the `nelem` elements pointed to
+  by `p` (old) and `q` (new) to `w`.  Returns the number of ranges
+  written or -1 on error.
+ */
+static ptrdiff_t put_ranges(Writer *w, const unsigned char *p,
+                            const unsigned char *q, DLiteType dtype,
+                            size_t size, size_t nelem)
+{
+  size_t i=0, start, end, gap, maxgap;
+  ptrdiff_t nranges=0;
+
+  /* maximum number of unchanged elements to include in a range */
+  maxgap = (dlite_type_is_allocated(dtype) || !size) ? 0 :
+    RANGE_OVERHEAD / size;
+
+  while (i < nelem) {
+    if (elem_equal(p + i*size, q + i*size, dtype, size)) {
+      i++;
+      continue;
+    }
+    start = i;
+    end = ++i;
+    for (gap=0; i < nelem && gap <= maxgap; i++) {
+      if (elem_equal(p + i*size, q + i*size, dtype, size)) {
+        gap++;
+      } else {
+        gap = 0;
+        end = i + 1;
+      }
+    }
+    i = end;
+    put_uint64(w, start);
+    put_uint64(w, end - start);
+    if (encode(w, q + start*size, dtype, size, end - start)) return -1;
+    nranges++;
+  }
+  return nranges;
+}
+
+/*
+  Writes the changes of property `i` from `a` to `b` to `w`.
+  Returns 1 if the property has changed, 0 if not and -1 on error.
+ */
+static int put_property_change(Writer *w, const DLiteInstance *a,
+                               const DLiteInstance *b, size_t i)
+{
+  const DLiteProperty *prop = a->meta->_properties + i;
+  const unsigned char *p, *q;
+  size_t nelem = property_nelem(b, i), start = w->pos, full, pos;
+  ptrdiff_t nranges;
+  unsigned char kind;
+
+  p = dlite_instance_peek_property_by_index(a, i);
+  if (!p && property_nelem(a, i)) return -1;
+  q = dlite_instance_peek_property_by_index(b, i);
+  if (!q && nelem) return -1;
+
+  if (prop->ndims == 0) {
+    if (elem_equal(p, q, prop->type, prop->size)) return 0;
+  } else if (same_shape(a, b, i)) {
+    /* try element ranges, with a placeholder for the number of ranges */
+    put_uint64(w, i);
+    kind = PATCH_RANGES;
+    put(w, &kind, 1);
+    pos = w->pos;
+    put_uint64(w, 0);
+    if ((nranges = put_ranges(w, p, q, prop->type, prop->size, nelem)) < 0)
+      return -1;
+    if (nranges == 0) {
+      w->pos = start;
+      return 0;
+    }
+    if (pos + 8 <= w->n) {
+      uint64_t v = nranges;
+      copy_le(w->dest + pos, (unsigned char *)&v, sizeof(v), 1);
+    }
+
+    /* fall back to replacing the whole property if that is smaller */
+    full = 8 + 1 + 8 + (size_t)dlite_type_encode(NULL, 0, q, prop->type,
+                                                 prop->size, nelem);
+    if (w->pos - start <= full) return 1;
+    w->pos = start;
+  }
+
+  put_uint64(w, i);
+  kind = PATCH_FULL;
+  put(w, &kind, 1);
+  put_uint64(w, nelem);
+  if (encode(w, q, prop->type, prop->size, nelem)) return -1;
+  return 1;
+}
+
+
+/*
+  Writes a patch that transforms instance `a` into `b` to `dest`.
+ */
+ptrdiff_t dlite_instance_diff(unsigned char *dest, size_t n,
+                              const DLiteInstance *a, const DLiteInstance *b)
+{
+  Writer w = {dest, n, 0};
+  size_t i, pos;
+  uint64_t count=0;
+  int stat;
+
+  if (!a->meta || !b->meta) return errx(-1, "no metadata available");
+  if (a->meta != b->meta && strcmp(a->meta->uri, b->meta->uri))
+    return errx(-1, "cannot diff instances of different metadata: %s, %s",
+                a->meta->uri, b->meta->uri);
+  if (dlite_instance_sync_to_dimension_sizes((DLiteInstance *)a) ||
+      dlite_instance_sync_to_dimension_sizes((DLiteInstance *)b))
+    return -1;
+
+  put(&w, DLITE_PATCH_MAGIC, 4);
+  put_uint32(&w, DLITE_PATCH_VERSION);
+  put_string(&w, b->meta->uri);
+
+  for (i=0; i < b->meta->_ndimensions; i++)
+    if (DLITE_DIM(a, i) != DLITE_DIM(b, i)) count++;
+  put_uint64(&w, count);
+  for (i=0; i < b->meta->_ndimensions; i++) {
+    if (DLITE_DIM(a, i) == DLITE_DIM(b, i)) continue;
+    put_uint64(&w, i);
+    put_uint64(&w, DLITE_DIM(b, i));
+  }
+
+  pos = w.pos;
+  count = 0;
+  put_uint64(&w, 0);
+  for (i=0; i < b->meta->_nproperties; i++) {
+    if ((stat = put_property_change(&w, a, b, i)) < 0) return -1;
+    count += stat;
+  }
+  if (pos + 8 <= w.n)
+    copy_le(w.dest + pos, (unsigned char *)&count, sizeof(count), 1);
+  return w.pos;
+}
+
+
+/*
+  Like dlite_instance_diff(), but returns a newly allocated buffer
+  with the patch.
+ */
+unsigned char *dlite_instance_adiff(const DLiteInstance *a,
+                                    const DLiteInstance *b, size_t *len)
+{
+  unsigned char *buf;
+  ptrdiff_t m, n;
+  if ((n = dlite_instance_diff(NULL, 0, a, b)) < 0) return NULL;
+  if (!(buf = malloc(n))) return err(1, "allocation failure"), NULL;
+  if ((m = dlite_instance_diff(buf, n, a, b)) != n) {
+    free(buf);
+    if (m >= 0) errx(1, "instances changed while computing diff");
+    return NULL;
+  }
+  if (len) *len = n;
+  return buf;
+}
+
+
+/* Applies the element ranges of property `i` from `r` to `inst`.
+   Returns non-zero on error. */
+static int apply_ranges(Reader *r, DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *prop = inst->meta->_properties + i;
+  size_t nelem = property_nelem(inst, i);
+  uint64_t nranges, offset, count, k;
+  unsigned char *ptr;
+
+  if (prop->ndims == 0)
+    return errx(1, "element ranges in patch of scalar property '%s'",
+                prop->name);
+  if (get_uint64(r, &nranges)) return 1;
+  if (!(ptr = dlite_instance_get_property_by_index(inst, i)) && nelem)
+    return 1;
+  for (k=0; k<nranges; k++) {
+    if (get_uint64(r, &offset) || get_uint64(r, &count)) return 1;
+    if (offset > nelem || count > nelem - offset)
+      return errx(1, "range [%llu, %llu) out of bounds for property '%s' "
+                  "with %lu elements", (unsigned long long)offset,
+                  (unsigned long long)(offset + count), prop->name,
+                  (unsigned long)nelem);
+    if (decode(r, ptr + offset*prop->size, prop->type, prop->size, count))
+      return 1;
+  }
+  if (inst->meta->_loadprop && inst->meta->_loadprop(inst, i)) return 1;
+  return 0;
+}
+
+
+/*
+  Applies the patch in `src` to `inst`.
+ */
+ptrdiff_t dlite_instance_apply_patch(DLiteInstance *inst,
+                                     const unsigned char *src, size_t n)
+{
+  Reader r = {src, n, 0};
+  char magic[4], *metauri=NULL;
+  uint32_t version;
+  uint64_t count, k, idx, v;
+  unsigned char kind;
+  int *dims=NULL;
+  size_t i;
+  ptrdiff_t retval=-1;
+
+  if (!inst->meta) return errx(-1, "no metadata available");
+  if (get(&r, magic, 4)) goto fail;
+  if (memcmp(magic, DLITE_PATCH_MAGIC, 4)) FAIL("not a dlite instance patch");
+  if (get_uint32(&r, &version)) goto fail;
+  if (version != DLITE_PATCH_VERSION)
+    FAIL1("unsupported patch format version: %u", (unsigned)version);
+  if (get_string(&r, &metauri)) goto fail;
+  if (!metauri || strcmp(metauri, inst->meta->uri))
+    FAIL2("cannot apply patch for '%s' to instance of '%s'",
+          (metauri) ? metauri : "(null)", inst->meta->uri);
+
+  /* dimensions */
+  if (get_uint64(&r, &count)) goto fail;
+  if (count) {
+    if (!(dims = malloc(inst->meta->_ndimensions * sizeof(int))))
+      FAIL("allocation failure");
+    for (i=0; i < inst->meta->_ndimensions; i++) dims[i] = -1;
+    for (k=0; k<count; k++) {
+      if (get_uint64(&r, &idx) || get_uint64(&r, &v)) goto fail;
+      if (idx >= inst->meta->_ndimensions)
+        FAIL2("dimension index %llu out of range for %s",
+              (unsigned long long)idx, inst->meta->uri);
+      if (v > INT_MAX) FAIL1("dimension size too large: %llu",
+                             (unsigned long long)v);
+      dims[idx] = (int)v;
+    }
+    if (dlite_instance_set_dimension_sizes(inst, dims)) goto fail;
+  }
+
+  /* properties */
+  if (get_uint64(&r, &count)) goto fail;
+  for (k=0; k<count; k++) {
+    if (get_uint64(&r, &idx) || get(&r, &kind, 1)) goto fail;
+    if (idx >= inst->meta->_nproperties)
+      FAIL2("property index %llu out of range for %s",
+            (unsigned long long)idx, inst->meta->uri);
+    switch (kind) {
+    case PATCH_FULL:
+      if (decode_property(&r, inst, idx)) goto fail;
+      break;
+    case PATCH_RANGES:
+      if (apply_ranges(&r, inst, idx)) goto fail;
+      break;
+    default:
+      FAIL1("invalid kind of property patch: %d", kind);
+    }
+  }
+  retval = r.pos;
+ fail:
+  if (metauri) free(metauri);
+  if (dims) free(dims);
+  return retval;
+}
@@ -0,0 +1,212 @@
+#ifndef _DLITE_BINARY_H
+#define _DLITE_BINARY_H
+
+/**
+  @file
+  @brief Portable binary encoding of property data and instances
+
+  The wire format is fixed and independent of the host:
+
+  type      | encoding
+  ----      | --------
+  blob      | `size` raw bytes
+  bool      | one byte, 0 or 1
+  int       | `size` bytes two's complement, little endian
+  uint      | `size` bytes, little endian
+  float     | `size` bytes IEEE 754, little endian
+  fixstring | `size` raw bytes (NUL-padded)
+  string    | string (see below)
+  dimension | name and description as strings
+  property  | name, type name, ndims (uint32), dims, unit, iri, description
+  relation  | s, p, o and id as strings
+
+  A string is encoded as its length as a little endian uint64 followed
+  by the bytes of the string (without the terminating NUL).  A NULL
+  pointer is encoded with length 0xffffffffffffffff.
+
+  Arrays are encoded as the concatenation of their elements in C order.
+  On little endian hosts numerical arrays are copied directly, on big
+  endian hosts they are byte-swapped in a tight loop.
+
+  An instance is encoded as:
+
+      "DLTB"                      magic (4 bytes)
+      uint32                      format version
+      string                      uuid
+      string                      uri (may be NULL)
+      string                      metadata uri
+      uint64                      number of dimensions
+      uint64 * ndimensions        dimension values
+      uint64                      number of properties
+      for each property:
+        uint64                    number of elements
+        elements                  encoded property data
+
+  A patch created with dlite_instance_diff() transforms one instance
+  into another instance of the same metadata.  It is encoded as:
+
+      "DLTP"                      magic (4 bytes)
+      uint32                      format version
+      string                      metadata uri
+      uint64                      number of changed dimensions
+      for each changed dimension:
+        uint64                    dimension index
+        uint64                    new dimension value
+      uint64                      number of changed properties
+      for each changed property:
+        uint64                    property index
+        uint8                     kind: 0 (full) or 1 (ranges)
+        full:
+          uint64                  number of elements
+          elements                encoded property data
+        ranges:
+          uint64                  number of ranges
+          for each range:
+            uint64                offset of first element (C order)
+            uint64                number of elements
+            elements              encoded elements
+
+  Dimensional properties whose shape is unchanged are patched with the
+  ranges of changed elements, unless replacing the whole property is
+  smaller.  The uuid and uri of the instances are not part of the patch.
+
+  All encoding functions follow the conventions of snprintf(): at
+  most `n` bytes are written to `dest` and the number of bytes
+  that would have been written if `n` was large enough is returned.
+  Hence, the needed size can be obtained by calling them with `dest`
+  set to NULL and `n` to zero.
+*/
+
+#include <stddef.h>
+
+#include "dlite-type.h"
+#include "dlite-entity.h"
+
+
+/** Magic bytes starting an encoded instance */
+#define DLITE_BINARY_MAGIC "DLTB"
+
+/** Version of the binary format for instances */
+#define DLITE_BINARY_VERSION 1
+
+/** Magic bytes starting an instance patch */
+#define DLITE_PATCH_MAGIC "DLTP"
+
+/** Version of the patch format */
+#define DLITE_PATCH_VERSION 1
+
+
+/**
+  Encodes `nelem` elements of type `dtype` and size `size` pointed to
+  by `p` to `dest`.  No more than `n` bytes are written.
+
+  Returns number of bytes written to `dest`.  If the output is
+  truncated because it exceeds `n`, the number of bytes that would
+  have been written if `n` was large enough is returned.  On error, a
+  negative value is returned.
+ */
+ptrdiff_t dlite_type_encode(unsigned char *dest, size_t n, const void *p,
+                            DLiteType dtype, size_t size, size_t nelem);
+
+/**
+  Decodes `nelem` elements of type `dtype` and size `size` from `src`
+  and writes them to memory pointed to by `p`.  At most `n` bytes are
+  read from `src`.
+
+  For allocated types, the memory pointed to by `p` should either be
+  initialized to zero or contain valid data.
+
+  Returns number of bytes consumed or -1 on error.
+ */
+ptrdiff_t dlite_type_decode(const unsigned char *src, size_t n, void *p,
+                            DLiteType dtype, size_t size, size_t nelem);
+
+/**
+  Encodes property number `i` of instance `inst` to `dest`, prefixed
+  with its number of elements.  No more than `n` bytes are written.
+
+  Returns number of bytes needed to encode the property or a negative
+  number on error.
+ */
+ptrdiff_t dlite_binary_encode_property(unsigned char *dest, size_t n,
+                                       const DLiteInstance *inst, size_t i);
+
+/**
+  Decodes a property encoded with dlite_binary_encode_property() from
+  `src` and assigns it to property number `i` of `inst`.  The number
+  of elements must match the current dimensions of the property.  At
+  most `n` bytes are read from `src`.
+
+  Returns number of bytes consumed or -1 on error.
+ */
+ptrdiff_t dlite_binary_decode_property(const unsigned char *src, size_t n,
+                                       DLiteInstance *inst, size_t i);
+
+/**
+  Encodes instance `inst` to `dest`.  No more than `n` bytes are
+  written.
+
+  Returns number of bytes needed to encode the instance or a negative
+  number on error.
+ */
+ptrdiff_t dlite_binary_encode(unsigned char *dest, size_t n,
+                              const DLiteInstance *inst);
+
+/**
+  Like dlite_binary_encode(), but returns a newly allocated buffer
+  with the encoded instance.  If `len` is not NULL, the length of the
+  buffer is written to it.
+
+  Returns NULL on error.
+ */
+unsigned char *dlite_binary_aencode(const DLiteInstance *inst, size_t *len);
+
+/**
+  Returns a new instance decoded from the `n` bytes in `src`.  The
+  metadata of the instance must be available via dlite_meta_get().
+
+  If `consumed` is not NULL, the number of bytes consumed is written
+  to it.
+
+  Returns NULL on error.
+ */
+DLiteInstance *dlite_binary_decode(const unsigned char *src, size_t n,
+                                   size_t *consumed);
+
+
+/**
+  Writes a patch that transforms instance `a` into instance `b` to
+  `dest`.  No more than `n` bytes are written.  `a` and `b` must be
+  instances of the same metadata.
+
+  Returns number of bytes needed to encode the patch or a negative
+  number on error.
+ */
+ptrdiff_t dlite_instance_diff(unsigned char *dest, size_t n,
+                              const DLiteInstance *a, const DLiteInstance *b);
+
+/**
+  Like dlite_instance_diff(), but returns a newly allocated buffer
+  with the patch.  If `len` is not NULL, the length of the patch is
+  written to it.
+
+  Returns NULL on error.
+ */
+unsigned char *dlite_instance_adiff(const DLiteInstance *a,
+                                    const DLiteInstance *b, size_t *len);
+
+/**
+  Applies the patch in `src` created with dlite_instance_diff() to
+  `inst`.  At most `n` bytes are read from `src`.
+
+  Applying a patch created from `a` and `b` to an instance equal to
+  `a` makes it equal to `b` (except for its uuid and uri).  If an
+  error occurs, `inst` may be partially patched.
+
+  Returns number of bytes consumed or -1 on error.
+ */
+ptrdiff_t dlite_instance_apply_patch(DLiteInstance *inst,
+                                     const unsigned char *src, size_t n);
+
+
+#endif /* _DLITE_BINARY_H */
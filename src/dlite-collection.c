@@ -4,6 +4,8 @@
 #include <string.h>
 
 #include "utils/err.h"
+#include "utils/integers.h"
+#include "utils/map.h"
 #include "dlite-macros.h"
 #include "dlite-store.h"
 #include "dlite-mapping.h"
@@ -60,20 +62,13 @@ int dlite_collection_getdim(const DLiteInstance *inst, size_t i)
   return triplestore_length(coll->rstore);
 }
 
-/* Loads instance relations to triplestore.  Returns -1 on error. */
-int dlite_collection_loadprop(const DLiteInstance *inst, size_t i)
+/* Loads the instances corresponding to "_has-uuid" relations in
+   collection `coll`.  Returns non-zero on error. */
+static int load_members(const DLiteCollection *coll)
 {
   int retval = 0;
-  DLiteCollection *coll = (DLiteCollection *)inst;
   TripleState state;
   const Triple *t;
-  if (i != 0) return err(-1, "index out of range: %lu", (unsigned long)i);
-  triplestore_clear(coll->rstore);
-  if (triplestore_add_triples(coll->rstore, coll->relations, coll->nrelations))
-    return -1;
-
-  /* Iterate over all newly added triples and load instances corresponding
-     to "_has-uuid" relations. */
   triplestore_init_state(coll->rstore, &state);
   while ((t = triplestore_find(&state, NULL, "_has-uuid", NULL))) {
     DLiteInstance *inst2 = dlite_instance_get(t->o);
@@ -83,10 +78,23 @@ int dlite_collection_loadprop(const DLiteInstance *inst, size_t i)
                               t->o, t->s, coll->uuid);
   }
   triplestore_deinit_state(&state);
-
   return retval;
 }
 
+/* Loads instance relations to triplestore.  Returns -1 on error. */
+int dlite_collection_loadprop(const DLiteInstance *inst, size_t i)
+{
+  DLiteCollection *coll = (DLiteCollection *)inst;
+  if (i != 0) return err(-1, "index out of range: %lu", (unsigned long)i);
+  triplestore_clear(coll->rstore);
+  if (triplestore_add_triples(coll->rstore, coll->relations, coll->nrelations))
+    return -1;
+
+  /* Load instances corresponding to the newly added "_has-uuid"
+     relations. */
+  return load_members(coll);
+}
+
 /* Saves triplestore to instance relations. Returns non-zero on error. */
 int dlite_collection_saveprop(DLiteInstance *inst, size_t i)
 {
@@ -346,6 +354,20 @@ const DLiteRelation *dlite_collection_find_first(const DLiteCollection *coll,
   return r;
 }
 
+/*
+  Evaluates a query consisting of the `n` relation patterns in
+  `patterns` against the relations in the collection.
+
+  Returns a new result object that should be free'ed with
+  triplestore_result_free(), or NULL on error.
+ */
+TripleResult *dlite_collection_query(const DLiteCollection *coll,
+                                     const TriplePattern *patterns, size_t n)
+{
+  return triplestore_query(coll->rstore, patterns, n);
+}
+
+
 /*
   Adds instance `inst` to collection, making `coll` the owner of the instance.
   Hence `coll` "steals" the reference to `inst`.
@@ -542,3 +564,331 @@ int dlite_collection_count(DLiteCollection *coll)
   triplestore_deinit_state(&state);
   return count;
 }
+
+
+/**************************************************************
+ * Binary encoding
+ **************************************************************/
+
+/*
+  Compact binary encoding of the relations in a collection.  All
+  integers are 32-bit unsigned little endian.
+
+      magic       "DLC1"
+      nstrings    number of strings in the string table
+      strsize     size of the string table in bytes
+      nuuids      number of uuids
+      ndigests    number of SHA-1 digests
+      nrelations  number of relations
+      strings     `strsize` bytes of nul-terminated strings
+      uuids       `nuuids` x 16 bytes
+      digests     `ndigests` x 20 bytes
+      relations   `nrelations` x 4 references (s, p, o, id)
+
+  A reference is an index into the concatenated string, uuid and
+  digest tables.  Strings and uuids are interned, such that each
+  distinct term is only stored once.  Canonical (lower case) uuids
+  are stored as 16 bytes and relation ids that are hex-encoded SHA-1
+  digests (as generated by triple_get_id()) as 20 bytes.  The latter
+  avoids recalculating the ids when the relations are loaded.
+ */
+#define BINCOLL_MAGIC "DLC1"
+#define BINCOLL_HEADSIZE 24
+#define BINCOLL_MAXINDEX (1<<28)
+
+/* Kinds of encoded terms */
+enum { kindString, kindUuid, kindDigest };
+
+/* State used when encoding */
+typedef struct {
+  map_int_t map;             /* maps term to `kind<<28 | index` */
+  char *strings;             /* string table */
+  size_t strsize;            /* used size of string table */
+  size_t stralloc;           /* allocated size of string table */
+  size_t nstrings;           /* number of strings */
+  unsigned char *uuids;      /* uuid table */
+  size_t nuuids;             /* number of uuids */
+  size_t uuidalloc;          /* allocated number of uuids */
+  unsigned char *digests;    /* digest table */
+  size_t ndigests;           /* number of digests */
+  size_t digestalloc;        /* allocated number of digests */
+} BinEncoder;
+
+/* Writes `v` as little endian to `p`. */
+static void put_uint32(unsigned char *p, uint32_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+  p[2] = (v >> 16) & 0xff;
+  p[3] = (v >> 24) & 0xff;
+}
+
+/* Returns little endian integer at `p`. */
+static uint32_t get_uint32(const unsigned char *p)
+{
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+    (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Returns value of lower case hex digit `c` or -1 if `c` is not a
+   lower case hex digit. */
+static int hexval(int c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+/* Decodes `n` bytes of lower case hex string `s` to `dest`, skipping
+   dashes.  Returns non-zero if `s` contains invalid characters. */
+static int hexdecode(unsigned char *dest, const char *s, size_t n)
+{
+  size_t i;
+  for (i=0; i<n; i++) {
+    int hi, lo;
+    if (*s == '-') s++;
+    if ((hi = hexval(s[0])) < 0 || (lo = hexval(s[1])) < 0) return 1;
+    dest[i] = (unsigned char)(hi << 4 | lo);
+    s += 2;
+  }
+  return 0;
+}
+
+/* Writes `n` bytes from `src` as lower case hex to `dest`, inserting
+   a dash before byte number 4, 6, 8 and 10 if `uuid` is non-zero. */
+static char *hexencode(char *dest, const unsigned char *src, size_t n,
+                       int uuid)
+{
+  static const char hexchars[] = "0123456789abcdef";
+  size_t i;
+  char *d = dest;
+  for (i=0; i<n; i++) {
+    if (uuid && (i == 4 || i == 6 || i == 8 || i == 10)) *d++ = '-';
+    *d++ = hexchars[src[i] >> 4];
+    *d++ = hexchars[src[i] & 0xf];
+  }
+  *d = '\0';
+  return dest;
+}
+
+/* Returns non-zero if `s` is a canonical lower case uuid. */
+static int is_uuid(const char *s, size_t len)
+{
+  unsigned char buf[16];
+  if (len != DLITE_UUID_LENGTH) return 0;
+  if (s[8] != '-' || s[13] != '-' || s[18] != '-' || s[23] != '-') return 0;
+  return hexdecode(buf, s, 16) == 0;
+}
+
+/* Returns non-zero if `s` is a hex-encoded SHA-1 digest. */
+static int is_digest(const char *s, size_t len)
+{
+  unsigned char buf[20];
+  if (len != 40) return 0;
+  return hexdecode(buf, s, 20) == 0;
+}
+
+/* Ensures that `*ptr` has space for `n` items of size `itemsize`.
+   Returns non-zero on error. */
+static int reserve(void **ptr, size_t *alloc, size_t n, size_t itemsize)
+{
+  void *p;
+  size_t m = (*alloc) ? *alloc : 64;
+  if (n <= *alloc) return 0;
+  while (m < n) m *= 2;
+  if (!(p = realloc(*ptr, m * itemsize))) return err(1, "allocation failure");
+  *ptr = p;
+  *alloc = m;
+  return 0;
+}
+
+/* Adds `term` to encoder and returns its code (`kind<<28 | index`), or
+   -1 on error.  If `id` is non-zero, `term` is a relation id. */
+static int encode_term(BinEncoder *enc, const char *term, int id)
+{
+  int *code, c;
+  size_t len = strlen(term);
+  if (id && is_digest(term, len)) {
+    if (enc->ndigests >= BINCOLL_MAXINDEX)
+      return err(-1, "too many relations for binary collection format");
+    if (reserve((void **)&enc->digests, &enc->digestalloc,
+                enc->ndigests+1, 20)) return -1;
+    hexdecode(enc->digests + 20*enc->ndigests, term, 20);
+    return kindDigest << 28 | (int)enc->ndigests++;
+  }
+  if ((code = map_get(&enc->map, term))) return *code;
+  if (is_uuid(term, len)) {
+    if (enc->nuuids >= BINCOLL_MAXINDEX)
+      return err(-1, "too many uuids for binary collection format");
+    if (reserve((void **)&enc->uuids, &enc->uuidalloc, enc->nuuids+1, 16))
+      return -1;
+    hexdecode(enc->uuids + 16*enc->nuuids, term, 16);
+    c = kindUuid << 28 | (int)enc->nuuids++;
+  } else {
+    if (enc->nstrings >= BINCOLL_MAXINDEX)
+      return err(-1, "too many strings for binary collection format");
+    if (reserve((void **)&enc->strings, &enc->stralloc,
+                enc->strsize + len + 1, 1)) return -1;
+    memcpy(enc->strings + enc->strsize, term, len + 1);
+    enc->strsize += len + 1;
+    c = kindString << 28 | (int)enc->nstrings++;
+  }
+  if (map_set(&enc->map, term, c)) return err(-1, "allocation failure");
+  return c;
+}
+
+/*
+  Returns a newly malloc'ed compact binary encoding of the relations
+  in collection `coll`.  The size of the returned buffer is written to
+  `*size`.
+
+  Returns NULL on error.
+ */
+unsigned char *dlite_collection_to_binary(const DLiteCollection *coll,
+                                          size_t *size)
+{
+  BinEncoder enc;
+  TripleState state;
+  const Triple *t;
+  int *codes=NULL;
+  size_t i, n=0, nrelations = triplestore_length(coll->rstore);
+  unsigned char *buf=NULL, *retval=NULL, *p;
+
+  memset(&enc, 0, sizeof(enc));
+  map_init(&enc.map);
+  if (nrelations >= BINCOLL_MAXINDEX)
+    FAIL("too many relations for binary collection format");
+  if (nrelations && !(codes = malloc(4 * nrelations * sizeof(int))))
+    FAIL("allocation failure");
+
+  triplestore_init_state(coll->rstore, &state);
+  while ((t = triplestore_next(&state))) {
+    assert(n < nrelations);
+    if ((codes[4*n]   = encode_term(&enc, t->s, 0)) < 0 ||
+        (codes[4*n+1] = encode_term(&enc, t->p, 0)) < 0 ||
+        (codes[4*n+2] = encode_term(&enc, t->o, 0)) < 0 ||
+        (codes[4*n+3] = encode_term(&enc, t->id, 1)) < 0) break;
+    n++;
+  }
+  triplestore_deinit_state(&state);
+  if (n < nrelations) goto fail;
+
+  *size = BINCOLL_HEADSIZE + enc.strsize + 16*enc.nuuids + 20*enc.ndigests +
+    16*nrelations;
+  if (!(buf = malloc(*size))) FAIL("allocation failure");
+  memcpy(buf, BINCOLL_MAGIC, 4);
+  put_uint32(buf+4,  (uint32_t)enc.nstrings);
+  put_uint32(buf+8,  (uint32_t)enc.strsize);
+  put_uint32(buf+12, (uint32_t)enc.nuuids);
+  put_uint32(buf+16, (uint32_t)enc.ndigests);
+  put_uint32(buf+20, (uint32_t)nrelations);
+  p = buf + BINCOLL_HEADSIZE;
+  if (enc.strsize) memcpy(p, enc.strings, enc.strsize);
+  p += enc.strsize;
+  if (enc.nuuids) memcpy(p, enc.uuids, 16*enc.nuuids);
+  p += 16*enc.nuuids;
+  if (enc.ndigests) memcpy(p, enc.digests, 20*enc.ndigests);
+  p += 20*enc.ndigests;
+  for (i=0; i<4*nrelations; i++, p+=4) {
+    uint32_t index = codes[i] & (BINCOLL_MAXINDEX-1);
+    switch (codes[i] >> 28) {
+    case kindString: break;
+    case kindUuid:   index += enc.nstrings; break;
+    case kindDigest: index += enc.nstrings + enc.nuuids; break;
+    }
+    put_uint32(p, index);
+  }
+  assert(p == buf + *size);
+  retval = buf;
+ fail:
+  if (!retval && buf) free(buf);
+  if (codes) free(codes);
+  if (enc.strings) free(enc.strings);
+  if (enc.uuids) free(enc.uuids);
+  if (enc.digests) free(enc.digests);
+  map_deinit(&enc.map);
+  return retval;
+}
+
+/*
+  Replaces the relations in collection `coll` with the relations
+  decoded from `buf`, which should be a binary encoding of size
+  `size` created with dlite_collection_to_binary().
+
+  The instances referred to by the relations are not loaded.
+
+  Returns non-zero on error.
+ */
+int dlite_collection_from_binary(DLiteCollection *coll,
+                                 const unsigned char *buf, size_t size)
+{
+  size_t nstrings, strsize, nuuids, ndigests, nrelations, nterms, i;
+  const unsigned char *p, *end;
+  const char **terms=NULL;
+  char *pool=NULL, *q;
+  Triple *triples=NULL;
+  int retval=1;
+
+  if (size < BINCOLL_HEADSIZE || memcmp(buf, BINCOLL_MAGIC, 4))
+    FAIL("invalid binary collection: bad header");
+  nstrings   = get_uint32(buf+4);
+  strsize    = get_uint32(buf+8);
+  nuuids     = get_uint32(buf+12);
+  ndigests   = get_uint32(buf+16);
+  nrelations = get_uint32(buf+20);
+  if (size != BINCOLL_HEADSIZE + strsize + 16*nuuids + 20*ndigests +
+      16*nrelations)
+    FAIL("invalid binary collection: size mismatch");
+  if (strsize && buf[BINCOLL_HEADSIZE + strsize - 1])
+    FAIL("invalid binary collection: unterminated string table");
+
+  nterms = nstrings + nuuids + ndigests;
+  if (nterms && !(terms = malloc(nterms * sizeof(char *))))
+    FAIL("allocation failure");
+  if (nuuids + ndigests &&
+      !(pool = malloc((DLITE_UUID_LENGTH+1)*nuuids + 41*ndigests)))
+    FAIL("allocation failure");
+  if (nrelations && !(triples = malloc(nrelations * sizeof(Triple))))
+    FAIL("allocation failure");
+
+  /* string table */
+  p = buf + BINCOLL_HEADSIZE;
+  end = p + strsize;
+  for (i=0; i<nstrings; i++) {
+    if (p >= end) FAIL("invalid binary collection: too short string table");
+    terms[i] = (const char *)p;
+    p += strlen((const char *)p) + 1;
+  }
+  if (p != end) FAIL("invalid binary collection: too long string table");
+
+  /* uuids and digests */
+  q = pool;
+  for (i=0; i<nuuids; i++, p+=16, q+=DLITE_UUID_LENGTH+1)
+    terms[nstrings + i] = hexencode(q, p, 16, 1);
+  for (i=0; i<ndigests; i++, p+=20, q+=41)
+    terms[nstrings + nuuids + i] = hexencode(q, p, 20, 0);
+
+  /* relations */
+  for (i=0; i<nrelations; i++, p+=16) {
+    uint32_t s=get_uint32(p), r=get_uint32(p+4), o=get_uint32(p+8),
+      id=get_uint32(p+12);
+    if (s >= nterms || r >= nterms || o >= nterms || id >= nterms)
+      FAIL1("invalid binary collection: reference out of range in "
+            "relation %lu", (unsigned long)i);
+    triples[i].s = (char *)terms[s];
+    triples[i].p = (char *)terms[r];
+    triples[i].o = (char *)terms[o];
+    triples[i].id = (char *)terms[id];
+  }
+
+  triplestore_clear(coll->rstore);
+  if (triplestore_add_triples(coll->rstore, triples, nrelations)) goto fail;
+  if (load_members(coll)) goto fail;
+  retval = 0;
+ fail:
+  if (terms) free(terms);
+  if (pool) free(pool);
+  if (triples) free(triples);
+  return retval;
+}
+
@@ -2,6 +2,7 @@
 #define _DLITE_COLLECTION_H
 
 #include "triplestore.h"
+#include "triplestore-query.h"
 #include "dlite-entity.h"
 #include "dlite-type.h"
 
@@ -207,6 +208,29 @@ const DLiteRelation *dlite_collection_find_first(const DLiteCollection *coll,
                                                  const char *o);
 
 
+/**
+  Evaluates a query consisting of the `n` relation patterns in
+  `patterns` against the relations in the collection.  Terms starting
+  with "?" are variables and NULL terms are wildcards.  See
+  triplestore_query() for details.
+
+  Example: labels of all instances of a given metadata
+
+  ```C
+  TriplePattern patterns[] = {
+    {"?label", "_is-a",     "Instance"},
+    {"?label", "_has-meta", "http://onto-ns.com/meta/0.1/MyEntity"},
+  };
+  TripleResult *r = dlite_collection_query(coll, patterns, 2);
+  ```
+
+  Returns a new result object that should be free'ed with
+  triplestore_result_free(), or NULL on error.
+ */
+TripleResult *dlite_collection_query(const DLiteCollection *coll,
+                                     const TriplePattern *patterns, size_t n);
+
+
 /**
   Adds instance `inst` to collection, making `coll` the owner of the instance.
 
@@ -290,4 +314,33 @@ DLiteInstance *dlite_collection_next_new(DLiteCollection *coll,
 int dlite_collection_count(DLiteCollection *coll);
 
 
+/**
+  Returns a newly malloc'ed compact binary encoding of the relations
+  in collection `coll`.  The size of the returned buffer is written to
+  `*size`.
+
+  The encoding consists of a table of interned strings, member uuids
+  stored as 16 bytes and relations stored as integer references into
+  these tables.
+
+  Returns NULL on error.
+ */
+unsigned char *dlite_collection_to_binary(const DLiteCollection *coll,
+                                          size_t *size);
+
+/**
+  Replaces the relations in collection `coll` with the relations
+  decoded from `buf`, which should be a binary encoding of size
+  `size` created with dlite_collection_to_binary().
+
+  Like when a collection is loaded from its relations property, the
+  instances labeled with "_has-uuid" relations are looked up with
+  dlite_instance_get().
+
+  Returns non-zero on error.
+ */
+int dlite_collection_from_binary(DLiteCollection *coll,
+                                 const unsigned char *buf, size_t size);
+
+
 #endif /* _DLITE_COLLECTION_H */
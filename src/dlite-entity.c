@@ -174,6 +174,400 @@ static DLiteInstance *_instance_store_get(const char *id)
 
 
 
+/********************************************************************
+ *  Shared property buffers
+ *
+ *  Copy-on-write copies (see dlite_instance_copy_cow()) share the
+ *  buffers of their dimensional properties with the source.  This
+ *  global registry maps the address of each shared buffer to the
+ *  number of instances sharing it.  A buffer that is not in the
+ *  registry is owned by a single instance.
+ *
+ *  A shared buffer is duplicated (unshared) before it is modified
+ *  through dlite_instance_set_property*(), before a writable pointer
+ *  to it is returned by dlite_instance_get_property*() and before it
+ *  is resized.
+ ********************************************************************/
+
+/* Forward declarations */
+static void _shared_buffers_free(void *shared_buffers);
+static char *_string_heap_take(const void *buf);
+static int _instance_unpack_strings(const DLiteInstance *inst, size_t i,
+                                    int copy);
+static int _external_buffer_release(const void *buf);
+
+/* Returns the registry of shared buffers.  If `create` is zero, NULL
+   is returned if the registry doesn't exists.  NULL is also returned
+   in atexit handlers, where only metadata (which is never shared) is
+   free'ed. */
+static map_int_t *_shared_buffers(int create)
+{
+  map_int_t *shared;
+  if (dlite_globals_in_atexit()) return NULL;
+  shared = dlite_globals_get_state("dlite-shared-buffers");
+  if (!shared && create) {
+    if (!(shared = malloc(sizeof(map_int_t))))
+      return err(1, "allocation failure"), NULL;
+    map_init(shared);
+    dlite_globals_add_state("dlite-shared-buffers", shared,
+                            _shared_buffers_free);
+  }
+  return shared;
+}
+
+/* Frees the registry of shared buffers. */
+static void _shared_buffers_free(void *shared_buffers)
+{
+  map_int_t *shared = shared_buffers;
+  map_deinit(shared);
+  free(shared);
+}
+
+/* Registers that `buf` is shared by one more instance.
+   Returns non-zero on error. */
+static int _buffer_share(const void *buf)
+{
+  char key[32];
+  map_int_t *shared;
+  int *count;
+  if (!buf) return 0;
+  if (!(shared = _shared_buffers(1))) return 1;
+  snprintf(key, sizeof(key), "%p", buf);
+  if ((count = map_get(shared, key)))
+    (*count)++;
+  else if (map_set(shared, key, 2))
+    return err(1, "cannot register shared buffer");
+  return 0;
+}
+
+/* Releases one reference to `buf`.  Returns 1 if `buf` is still used
+   by other instances and 0 if the caller is the sole owner. */
+static int _buffer_release(const void *buf)
+{
+  char key[32];
+  map_int_t *shared;
+  int *count;
+  if (!buf || !(shared = _shared_buffers(0))) return 0;
+  snprintf(key, sizeof(key), "%p", buf);
+  if (!(count = map_get(shared, key))) return 0;
+  if (--(*count) <= 1) map_remove(shared, key);
+  return 1;
+}
+
+/* If the buffer of dimensional property `i` is shared with other
+   instances, replace it with a private buffer.  If `copy` is non-zero,
+   the content is copied to the new buffer, otherwise it is zeroed.
+   A private buffer backed by a string heap is unpacked.
+   Returns non-zero on error. */
+static int _instance_unshare_property(const DLiteInstance *inst, size_t i,
+                                      int copy)
+{
+  DLiteProperty *p = inst->meta->_properties + i;
+  void **ptr, *buf;
+  size_t n, nmemb=1;
+  char key[32];
+  map_int_t *shared;
+  int j;
+
+  if (p->ndims <= 0) return 0;
+  ptr = DLITE_PROP(inst, i);
+  if (!*ptr) return 0;
+  if (!(shared = _shared_buffers(0)))
+    return _instance_unpack_strings(inst, i, copy);
+  snprintf(key, sizeof(key), "%p", *ptr);
+  if (!map_get(shared, key))
+    return _instance_unpack_strings(inst, i, copy);
+
+  for (j=0; j < p->ndims; j++) nmemb *= DLITE_PROP_DIM(inst, i, j);
+  if (!(buf = calloc(nmemb, p->size)))
+    return err(1, "allocation failure");
+  if (!copy) {
+    /* pass */
+  } else if (dlite_type_is_allocated(p->type)) {
+    for (n=0; n < nmemb; n++)
+      if (!dlite_type_copy((char *)buf + n*p->size,
+                           (char *)(*ptr) + n*p->size,
+                           p->type, p->size)) {
+        while (n--) dlite_type_clear((char *)buf + n*p->size,
+                                     p->type, p->size);
+        free(buf);
+        return 1;
+      }
+  } else {
+    memcpy(buf, *ptr, nmemb*p->size);
+  }
+  _buffer_release(*ptr);
+  *ptr = buf;
+  return 0;
+}
+
+/* Releases the buffer of dimensional property `i` and sets it to NULL.
+   The buffer (and the allocated data it refers to) is only free'ed
+   if it is not shared with other instances.  External buffers are
+   returned to their owner. */
+static void _instance_release_property(const DLiteInstance *inst, size_t i)
+{
+  DLiteProperty *p = inst->meta->_properties + i;
+  void **ptr = DLITE_PROP(inst, i);
+  char *heap;
+  if (!*ptr) return;
+  if (!_buffer_release(*ptr) && !_external_buffer_release(*ptr)) {
+    if ((heap = _string_heap_take(*ptr))) {
+      free(heap);
+    } else if (dlite_type_is_allocated(p->type)) {
+      int j;
+      size_t n, nmemb=1;
+      for (j=0; j<p->ndims; j++)
+        nmemb *= DLITE_PROP_DIM(inst, i, j);
+      for (n=0; n<nmemb; n++)
+        dlite_type_clear((char *)(*ptr) + n*p->size, p->type, p->size);
+    }
+    free(*ptr);
+  }
+  *ptr = NULL;
+}
+
+
+/********************************************************************
+ *  String heaps
+ *
+ *  The elements of a dimensional string property are normally
+ *  individually allocated.  Alternatively, they may point into a
+ *  single contiguous string heap, which is allocated and free'ed in
+ *  one go.  This global registry maps the address of the property
+ *  buffer to its string heap.
+ *
+ *  A string heap is read-only.  It is unpacked to individually
+ *  allocated strings at the same places as shared buffers are
+ *  unshared, i.e. before the property is written to.
+ ********************************************************************/
+
+/* Forward declarations */
+static void _string_heaps_free(void *string_heaps);
+
+/* Returns the registry of string heaps.  If `create` is zero, NULL is
+   returned if the registry doesn't exists.  NULL is also returned in
+   atexit handlers, where only metadata (which never has string heaps)
+   is free'ed. */
+static map_void_t *_string_heaps(int create)
+{
+  map_void_t *heaps;
+  if (dlite_globals_in_atexit()) return NULL;
+  heaps = dlite_globals_get_state("dlite-string-heaps");
+  if (!heaps && create) {
+    if (!(heaps = malloc(sizeof(map_void_t))))
+      return err(1, "allocation failure"), NULL;
+    map_init(heaps);
+    dlite_globals_add_state("dlite-string-heaps", heaps, _string_heaps_free);
+  }
+  return heaps;
+}
+
+/* Frees the registry of string heaps. */
+static void _string_heaps_free(void *string_heaps)
+{
+  map_void_t *heaps = string_heaps;
+  map_deinit(heaps);
+  free(heaps);
+}
+
+/* Returns the string heap of property buffer `buf` or NULL if `buf`
+   has no string heap. */
+static char *_string_heap_get(const void *buf)
+{
+  char key[32];
+  map_void_t *heaps;
+  void **heap;
+  if (!buf || !(heaps = _string_heaps(0))) return NULL;
+  snprintf(key, sizeof(key), "%p", buf);
+  if (!(heap = map_get(heaps, key))) return NULL;
+  return *heap;
+}
+
+/* Like _string_heap_get(), but also removes the heap from the
+   registry.  The caller takes ownership of the returned heap. */
+static char *_string_heap_take(const void *buf)
+{
+  char key[32], *heap;
+  if (!(heap = _string_heap_get(buf))) return NULL;
+  snprintf(key, sizeof(key), "%p", buf);
+  map_remove(_string_heaps(0), key);
+  return heap;
+}
+
+/* Registers `heap` as the string heap of property buffer `buf`.
+   Returns non-zero on error. */
+static int _string_heap_add(const void *buf, char *heap)
+{
+  char key[32];
+  map_void_t *heaps;
+  if (!(heaps = _string_heaps(1))) return 1;
+  snprintf(key, sizeof(key), "%p", buf);
+  if (map_set(heaps, key, heap))
+    return err(1, "cannot register string heap");
+  return 0;
+}
+
+/* Returns the number of elements of dimensional property `i`. */
+static size_t _instance_property_nmemb(const DLiteInstance *inst, size_t i)
+{
+  size_t nmemb=1;
+  int j;
+  for (j=0; j < inst->meta->_properties[i].ndims; j++)
+    nmemb *= DLITE_PROP_DIM(inst, i, j);
+  return nmemb;
+}
+
+/* If property `i` is backed by a string heap, replace it with
+   individually allocated strings.  If `copy` is zero, the elements
+   are set to NULL instead.  Returns non-zero on error. */
+static int _instance_unpack_strings(const DLiteInstance *inst, size_t i,
+                                    int copy)
+{
+  char **strings = *(char ***)DLITE_PROP(inst, i), **tmp=NULL, *heap;
+  size_t n, nmemb;
+  if (!_string_heap_get(strings)) return 0;
+  nmemb = _instance_property_nmemb(inst, i);
+  if (copy) {
+    if (!(tmp = calloc(nmemb, sizeof(char *))))
+      return err(1, "allocation failure");
+    for (n=0; n < nmemb; n++) {
+      if (strings[n] && !(tmp[n] = strdup(strings[n]))) {
+        while (n--) if (tmp[n]) free(tmp[n]);
+        free(tmp);
+        return err(1, "allocation failure");
+      }
+    }
+  }
+  heap = _string_heap_take(strings);
+  if (copy)
+    memcpy(strings, tmp, nmemb*sizeof(char *));
+  else
+    memset(strings, 0, nmemb*sizeof(char *));
+  free(heap);
+  if (tmp) free(tmp);
+  return 0;
+}
+
+/* Checks that property `i` of `inst` is a dimensional string property
+   that may have a string heap.  Returns non-zero on error. */
+static int _check_string_heap_property(const DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *p;
+  if (!inst->meta) return errx(1, "no metadata available");
+  if (i >= inst->meta->_nproperties)
+    return errx(1, "index %d exceeds number of properties (%d) in %s",
+                (int)i, (int)inst->meta->_nproperties, inst->meta->uri);
+  p = inst->meta->_properties + i;
+  if (p->type != dliteStringPtr || p->ndims <= 0)
+    return errx(1, "property '%s' is not a string array", p->name);
+  if (dlite_instance_is_meta(inst))
+    return errx(1, "string heaps are not supported for metadata");
+  return 0;
+}
+
+
+
+/********************************************************************
+ *  External buffers
+ *
+ *  A dimensional property may use a buffer owned by someone else,
+ *  e.g. the data of a NumPy array (see dlite_instance_adopt_property()).
+ *  This global registry maps the address of each external buffer to
+ *  the function that releases it.
+ *
+ *  External buffers are written to in place.  They are replaced with a
+ *  private buffer before they are resized.
+ ********************************************************************/
+
+/* Release function and owner of an external buffer */
+typedef struct {
+  DLiteBufferRelease release;
+  void *owner;
+} _ExternalBuffer;
+
+/* Forward declarations */
+static void _external_buffers_free(void *external_buffers);
+
+/* Returns the registry of external buffers.  If `create` is zero, NULL
+   is returned if the registry doesn't exists.  NULL is also returned
+   in atexit handlers, where only metadata (which never has external
+   buffers) is free'ed. */
+static map_void_t *_external_buffers(int create)
+{
+  map_void_t *external;
+  if (dlite_globals_in_atexit()) return NULL;
+  external = dlite_globals_get_state("dlite-external-buffers");
+  if (!external && create) {
+    if (!(external = malloc(sizeof(map_void_t))))
+      return err(1, "allocation failure"), NULL;
+    map_init(external);
+    dlite_globals_add_state("dlite-external-buffers", external,
+                            _external_buffers_free);
+  }
+  return external;
+}
+
+/* Frees the registry of external buffers. */
+static void _external_buffers_free(void *external_buffers)
+{
+  map_void_t *external = external_buffers;
+  const char *key;
+  map_iter_t iter = map_iter(external);
+  while ((key = map_next(external, &iter)))
+    free(*map_get(external, key));
+  map_deinit(external);
+  free(external);
+}
+
+/* Returns non-zero if `buf` is an external buffer. */
+static int _external_buffer_has(const void *buf)
+{
+  char key[32];
+  map_void_t *external;
+  if (!buf || !(external = _external_buffers(0))) return 0;
+  snprintf(key, sizeof(key), "%p", buf);
+  return map_get(external, key) != NULL;
+}
+
+/* If `buf` is an external buffer, remove it from the registry and call
+   its release function.  Returns non-zero if `buf` was an external
+   buffer. */
+static int _external_buffer_release(const void *buf)
+{
+  char key[32];
+  map_void_t *external;
+  _ExternalBuffer *ext;
+  void **extp;
+  if (!buf || !(external = _external_buffers(0))) return 0;
+  snprintf(key, sizeof(key), "%p", buf);
+  if (!(extp = map_get(external, key))) return 0;
+  ext = *extp;
+  map_remove(external, key);
+  ext->release(ext->owner);
+  free(ext);
+  return 1;
+}
+
+/* If the buffer of dimensional property `i` is an external buffer,
+   replace it with a private copy of its first `nmemb` elements.
+   Returns non-zero on error. */
+static int _instance_own_property(const DLiteInstance *inst, size_t i,
+                                  size_t nmemb)
+{
+  DLiteProperty *p = inst->meta->_properties + i;
+  void **ptr = DLITE_PROP(inst, i), *buf;
+  if (!_external_buffer_has(*ptr)) return 0;
+  if (!(buf = malloc((nmemb) ? nmemb*p->size : 1)))
+    return err(1, "allocation failure");
+  memcpy(buf, *ptr, nmemb*p->size);
+  _external_buffer_release(*ptr);
+  *ptr = buf;
+  return 0;
+}
+
+
+
 /********************************************************************
  *  Framework internals and debugging
  ********************************************************************/
@@ -538,15 +932,7 @@ static void dlite_instance_free(DLiteInstance *inst)
       DLiteProperty *p = (DLiteProperty *)meta->_properties + i;
       void *ptr = DLITE_PROP(inst, i);
       if (p->ndims > 0 && p->dims) {
-        if (dlite_type_is_allocated(p->type)) {
-          int j;
-          size_t n, nmemb=1;
-          for (j=0; j<p->ndims; j++)
-            nmemb *= DLITE_PROP_DIM(inst, i, j);
-          for (n=0; n<nmemb; n++)
-            dlite_type_clear(*(char **)ptr + n*p->size, p->type, p->size);
-        }
-        free(*(void **)ptr);
+        _instance_release_property(inst, i);
       } else {
         dlite_type_clear(ptr, p->type, p->size);
       }
@@ -1102,6 +1488,7 @@ void *dlite_instance_get_property_by_index(const DLiteInstance *inst, size_t i)
 		(int)i, (int)inst->meta->_nproperties, inst->meta->uri), NULL;
   if (dlite_instance_sync_to_dimension_sizes((DLiteInstance *)inst))
     return NULL;
+  if (_instance_unshare_property(inst, i, 1)) return NULL;
   if (inst->meta->_saveprop &&
       inst->meta->_saveprop((DLiteInstance *)inst, i)) return NULL;
   ptr = DLITE_PROP(inst, i);
@@ -1125,6 +1512,7 @@ int dlite_instance_set_property_by_index(DLiteInstance *inst, size_t i,
   if (p->ndims > 0) {
     int j;
     size_t n, nmemb=1;
+    if (_instance_unshare_property(inst, i, 0)) return -1;
     dest = *((void **)DLITE_PROP(inst, i));
     for (j=0; j<p->ndims; j++) nmemb *= DLITE_PROP_DIM(inst, i, j);
     if (dlite_type_is_allocated(p->type)) {
@@ -1226,6 +1614,45 @@ void *dlite_instance_get_property(const DLiteInstance *inst, const char *name)
   return dlite_instance_get_property_by_index(inst, i);
 }
 
+/*
+  Like dlite_instance_get_property_by_index(), but returns a read-only
+  pointer.  Unlike dlite_instance_get_property_by_index(), this does
+  not unshare the buffers of copy-on-write copies.  Returns NULL on
+  error.
+ */
+const void *dlite_instance_peek_property_by_index(const DLiteInstance *inst,
+                                                  size_t i)
+{
+  const void *ptr;
+  if (!inst->meta)
+    return errx(-1, "no metadata available"), NULL;
+  if (i >= inst->meta->_nproperties)
+    return errx(1, "index %d exceeds number of properties (%d) in %s",
+		(int)i, (int)inst->meta->_nproperties, inst->meta->uri), NULL;
+  if (dlite_instance_sync_to_dimension_sizes((DLiteInstance *)inst))
+    return NULL;
+  if (inst->meta->_saveprop &&
+      inst->meta->_saveprop((DLiteInstance *)inst, i)) return NULL;
+  ptr = DLITE_PROP(inst, i);
+  if (inst->meta->_properties[i].ndims > 0)
+    ptr = *(void **)ptr;
+  return ptr;
+}
+
+/*
+  Like dlite_instance_get_property(), but returns a read-only pointer.
+  Returns NULL on error.
+ */
+const void *dlite_instance_peek_property(const DLiteInstance *inst,
+                                         const char *name)
+{
+  int i;
+  if (!inst->meta)
+    return errx(-1, "no metadata available"), NULL;
+  if ((i = dlite_meta_get_property_index(inst->meta, name)) < 0) return NULL;
+  return dlite_instance_peek_property_by_index(inst, i);
+}
+
 /*
   Copies memory pointed to by `ptr` to property `name`.
   Returns non-zero on error.
@@ -1418,6 +1845,9 @@ int dlite_instance_set_dimension_sizes(DLiteInstance *inst, const int *dims)
     for (n=0; n < inst->meta->_ndimensions; n++)
       if (inst->meta->_setdim(inst, n, dims[n]) < 0) goto fail;
 
+  for (n=0; n < inst->meta->_nproperties; n++)
+    if (_instance_unshare_property(inst, n, 1)) goto fail;
+
   if (!(xdims = calloc(inst->meta->_ndimensions, sizeof(size_t))))
     FAIL("Allocation failure");
   for (n=0; n < inst->meta->_ndimensions; n++)
@@ -1454,6 +1884,8 @@ int dlite_instance_set_dimension_sizes(DLiteInstance *inst, const int *dims)
     newsize = newmembs * p->size;
     if (newmembs == oldmembs[n]) {
       continue;
+    } else if (_instance_own_property(inst, n, oldmembs[n])) {
+      goto fail;
     } else if (newmembs > 0) {
       void *q;
       if (newmembs < oldmembs[n])
@@ -1543,7 +1975,7 @@ DLiteInstance *dlite_instance_copy(const DLiteInstance *inst, const char *newid)
     return NULL;
   for (n=0; n < inst->meta->_nproperties; n++) {
     DLiteProperty *p = inst->meta->_properties + n;
-    void *src = dlite_instance_get_property_by_index(inst, n);
+    const void *src = dlite_instance_peek_property_by_index(inst, n);
     void *dst = dlite_instance_get_property_by_index(new, n);
    if (p->ndims > 0) {
       int nmembs=1;
@@ -1564,6 +1996,187 @@ DLiteInstance *dlite_instance_copy(const DLiteInstance *inst, const char *newid)
 }
 
 
+/*
+  Like dlite_instance_copy(), but the new instance shares the buffers
+  of dimensional properties with `inst` (copy-on-write).
+
+  Returns NULL on error.
+ */
+DLiteInstance *dlite_instance_copy_cow(const DLiteInstance *inst,
+                                       const char *newid)
+{
+  const DLiteMeta *meta = inst->meta;
+  DLiteInstance *new=NULL;
+  size_t n;
+
+  /* Extended metadata may keep the properties in sync with an internal
+     state, so fall back to a deep copy */
+  if (!dlite_instance_is_data(inst) || meta->_getdim || meta->_setdim ||
+      meta->_loadprop || meta->_saveprop)
+    return dlite_instance_copy(inst, newid);
+
+  if (!(new = dlite_instance_create(meta, DLITE_DIMS(inst), newid)))
+    return NULL;
+  if (new == inst) return new;
+  for (n=0; n < meta->_nproperties; n++) {
+    DLiteProperty *p = meta->_properties + n;
+    if (p->ndims > 0) {
+      void *buf = *(void **)DLITE_PROP(inst, n);
+      _instance_release_property(new, n);
+      if (_buffer_share(buf)) goto fail;
+      *(void **)DLITE_PROP(new, n) = buf;
+    } else {
+      if (!dlite_type_copy(DLITE_PROP(new, n), DLITE_PROP(inst, n),
+                           p->type, p->size)) goto fail;
+    }
+  }
+  return new;
+ fail:
+  if (new) dlite_instance_decref(new);
+  return NULL;
+}
+
+/*
+  Returns a newly allocated string heap of `size` bytes for string
+  array property `i`.
+ */
+char *dlite_instance_string_heap(DLiteInstance *inst, size_t i, size_t size)
+{
+  char **strings, *heap;
+  size_t n, nmemb;
+  if (_check_string_heap_property(inst, i)) return NULL;
+  if (dlite_instance_sync_to_dimension_sizes(inst)) return NULL;
+  if (_instance_unshare_property(inst, i, 0)) return NULL;
+  if (!(strings = *(char ***)DLITE_PROP(inst, i)))
+    return errx(1, "cannot create string heap for empty property '%s'",
+                inst->meta->_properties[i].name), NULL;
+  nmemb = _instance_property_nmemb(inst, i);
+  for (n=0; n < nmemb; n++) {
+    if (strings[n]) free(strings[n]);
+    strings[n] = NULL;
+  }
+  if (!(heap = malloc((size) ? size : 1)))
+    return err(1, "allocation failure"), NULL;
+  if (_string_heap_add(strings, heap)) {
+    free(heap);
+    return NULL;
+  }
+  return heap;
+}
+
+
+/*
+  Packs the elements of all string array properties of `inst` into
+  string heaps.
+ */
+int dlite_instance_pack_strings(DLiteInstance *inst)
+{
+  size_t i, n, nmemb, size, len;
+  char **strings, *heap;
+  if (!inst->meta) return errx(1, "no metadata available");
+  if (dlite_instance_is_meta(inst)) return 0;
+  if (dlite_instance_sync_to_dimension_sizes(inst)) return 1;
+  for (i=0; i < inst->meta->_nproperties; i++) {
+    DLiteProperty *p = inst->meta->_properties + i;
+    if (p->type != dliteStringPtr || p->ndims <= 0) continue;
+    if (!(strings = *(char ***)DLITE_PROP(inst, i))) continue;
+    if (_string_heap_get(strings)) continue;
+    nmemb = _instance_property_nmemb(inst, i);
+    for (size=0, n=0; n < nmemb; n++)
+      if (strings[n]) size += strlen(strings[n]) + 1;
+    if (!(heap = malloc((size) ? size : 1)))
+      return err(1, "allocation failure");
+    if (_string_heap_add(strings, heap)) {
+      free(heap);
+      return 1;
+    }
+    for (size=0, n=0; n < nmemb; n++) {
+      if (!strings[n]) continue;
+      len = strlen(strings[n]) + 1;
+      memcpy(heap + size, strings[n], len);
+      free(strings[n]);
+      strings[n] = heap + size;
+      size += len;
+    }
+  }
+  return 0;
+}
+
+
+/*
+  Returns non-zero if string array property `i` of `inst` is backed
+  by a string heap.
+ */
+int dlite_instance_has_string_heap(const DLiteInstance *inst, size_t i)
+{
+  if (!inst->meta || i >= inst->meta->_nproperties ||
+      inst->meta->_properties[i].ndims <= 0) return 0;
+  return _string_heap_get(*(void **)DLITE_PROP(inst, i)) != NULL;
+}
+
+
+/*
+  Lets dimensional property `i` of `inst` use the external buffer
+  `buf`.  `release(owner)` is called when the buffer is no longer used.
+ */
+int dlite_instance_adopt_property(DLiteInstance *inst, size_t i, void *buf,
+                                  DLiteBufferRelease release, void *owner)
+{
+  const DLiteProperty *p;
+  void **ptr;
+  char key[32];
+  map_void_t *external;
+  _ExternalBuffer *ext=NULL;
+
+  if (!inst->meta) return errx(1, "no metadata available");
+  if (i >= inst->meta->_nproperties)
+    return errx(1, "index %d exceeds number of properties (%d) in %s",
+                (int)i, (int)inst->meta->_nproperties, inst->meta->uri);
+  p = inst->meta->_properties + i;
+  if (p->ndims <= 0)
+    return errx(1, "cannot adopt buffer for scalar property '%s'", p->name);
+  if (dlite_type_is_allocated(p->type))
+    return errx(1, "cannot adopt buffer for property '%s' of type %s",
+                p->name, dlite_type_get_dtypename(p->type));
+  if (!dlite_instance_is_data(inst) || inst->meta->_getdim ||
+      inst->meta->_setdim || inst->meta->_loadprop || inst->meta->_saveprop)
+    return errx(1, "adopting buffers is only supported for instances of "
+                "plain metadata");
+  if (!buf) return errx(1, "cannot adopt NULL buffer");
+  ptr = DLITE_PROP(inst, i);
+  if (buf == *ptr || _external_buffer_has(buf))
+    return errx(1, "buffer is already used by a property");
+
+  if (release) {
+    if (!(external = _external_buffers(1))) return 1;
+    if (!(ext = malloc(sizeof(_ExternalBuffer))))
+      return err(1, "allocation failure");
+    ext->release = release;
+    ext->owner = owner;
+    snprintf(key, sizeof(key), "%p", buf);
+    if (map_set(external, key, ext)) {
+      free(ext);
+      return err(1, "cannot register external buffer");
+    }
+  }
+  _instance_release_property(inst, i);
+  *ptr = buf;
+  return 0;
+}
+
+
+/*
+  Returns non-zero if dimensional property `i` of `inst` uses an
+  external buffer.
+ */
+int dlite_instance_has_external_buffer(const DLiteInstance *inst, size_t i)
+{
+  if (!inst->meta || i >= inst->meta->_nproperties ||
+      inst->meta->_properties[i].ndims <= 0) return 0;
+  return _external_buffer_has(*(void **)DLITE_PROP(inst, i));
+}
+
+
 /*
   Returns a new DLiteArray object for property number `i` in instance `inst`.
 
@@ -2418,8 +3031,19 @@ static int scandim(int d, const char *src, void **pptr,
       if (scandim(d+1, src, pptr, p, dims, flags, t)) goto fail;
     }
   } else {
-    if ((m = dlite_type_scan(src+(*t)->start, (*t)->end-(*t)->start, *pptr,
-                             p->type, p->size, flags)) < 0) return m;
+    /* Scan primitives from a NUL-terminated copy, since sscanf() may
+       call strlen() on the remaining source, which would make
+       scanning of large arrays quadratic */
+    const char *s = src + (*t)->start;
+    int len = (*t)->end - (*t)->start;
+    char buf[64];
+    if ((*t)->type == JSMN_PRIMITIVE && len < (int)sizeof(buf)) {
+      memcpy(buf, s, len);
+      buf[len] = '\0';
+      s = buf;
+    }
+    if ((m = dlite_type_scan(s, len, *pptr, p->type, p->size, flags)) < 0)
+      return m;
     *((char **)pptr) += p->size;
     *t += jsmn_count(*t);
   }
@@ -623,6 +623,18 @@ size_t dlite_instance_get_dimension_size_by_index(const DLiteInstance *inst,
  */
 void *dlite_instance_get_property_by_index(const DLiteInstance *inst, size_t i);
 
+/**
+  Like dlite_instance_get_property_by_index(), but returns a read-only
+  pointer.
+
+  Since the caller promises not to write through the returned pointer,
+  this function does not duplicate buffers shared by copy-on-write
+  copies (see dlite_instance_copy_cow()).  Prefer this function for
+  read-only access.
+ */
+const void *dlite_instance_peek_property_by_index(const DLiteInstance *inst,
+                                                  size_t i);
+
 /**
   Sets property `i` to the value pointed to by `ptr`.
   Returns non-zero on error.
@@ -659,6 +671,13 @@ int dlite_instance_get_dimension_size(const DLiteInstance *inst,
  */
 void *dlite_instance_get_property(const DLiteInstance *inst, const char *name);
 
+/**
+  Like dlite_instance_get_property(), but returns a read-only pointer.
+  See dlite_instance_peek_property_by_index().
+ */
+const void *dlite_instance_peek_property(const DLiteInstance *inst,
+                                         const char *name);
+
 /**
   Copies memory pointed to by `ptr` to property `name`.
   Returns non-zero on error.
@@ -782,6 +801,129 @@ int dlite_instance_set_dimension_size(DLiteInstance *inst, const char *name,
 DLiteInstance *dlite_instance_copy(const DLiteInstance *inst,
                                    const char *newid);
 
+/**
+  Like dlite_instance_copy(), but creates a copy-on-write copy.
+
+  The new instance shares the buffers of its dimensional properties
+  (including the strings they refer to) with `inst`.  A shared buffer
+  is duplicated the first time any of the instances sharing it:
+    - assigns the property with dlite_instance_set_property*(),
+    - requests a writable pointer with dlite_instance_get_property*()
+      or dlite_instance_get_property_array*(), or
+    - changes its dimensions.
+
+  Hence, large instances can be copied cheaply when the copy is only
+  read (use dlite_instance_peek_property*() for reading) or when only
+  a few properties are changed.  Writing directly to property memory
+  obtained by other means (e.g. DLITE_PROP()) bypasses this and
+  modifies all sharing instances.
+
+  Scalar properties are always copied.  Metadata and instances of
+  extended metadata (with internal state, like collections) are
+  deep-copied like with dlite_instance_copy().
+
+  Returns NULL on error.
+ */
+DLiteInstance *dlite_instance_copy_cow(const DLiteInstance *inst,
+                                       const char *newid);
+
+/*
+  String heaps
+  ------------
+  The elements of a string array property are normally individually
+  allocated.  Alternatively, they may point into a single contiguous
+  string heap owned by the instance.  This makes loading and freeing
+  large string arrays much cheaper and improves locality when reading
+  them.
+
+  Code reading string arrays does not need to care about how they are
+  stored.  A string heap is read-only.  It is transparently unpacked
+  to individually allocated strings before the property is modified
+  with dlite_instance_set_property*(), before a writable pointer to it
+  is returned by dlite_instance_get_property*() and before it is
+  resized.  Use dlite_instance_peek_property*() for reading string
+  arrays without unpacking them.  Writing directly to string elements
+  obtained by other means (e.g. DLITE_PROP()) is not allowed for
+  properties with a string heap.
+
+  String heaps are not supported for metadata.
+*/
+
+/**
+  Returns a newly allocated string heap of `size` bytes for string
+  array property `i` of `inst`.  All current elements of the property
+  are free'ed and set to NULL.
+
+  The caller should write NUL-terminated strings to the returned heap
+  and let the elements of the property point to them.  The heap is
+  owned by the instance.
+
+  This is intended for loaders that know the total size of the strings
+  before assigning them.
+
+  Returns NULL on error.
+ */
+char *dlite_instance_string_heap(DLiteInstance *inst, size_t i, size_t size);
+
+/**
+  Packs the elements of all string array properties of `inst` into
+  string heaps.  Properties that already have a string heap are left
+  untouched.
+
+  Returns non-zero on error.
+ */
+int dlite_instance_pack_strings(DLiteInstance *inst);
+
+/**
+  Returns non-zero if string array property `i` of `inst` is backed
+  by a string heap.
+ */
+int dlite_instance_has_string_heap(const DLiteInstance *inst, size_t i);
+
+/*
+  External buffers
+  ----------------
+  A dimensional property may use a buffer owned by someone else, like
+  the data of a NumPy array, instead of a copy of it.  The owner is
+  notified via a release function when the instance no longer uses
+  the buffer, i.e. when the instance is free'ed, the property is
+  resized or another buffer is adopted.
+
+  An external buffer is written to in place, so changes made through
+  the instance are visible to the owner and vice versa.  It is shared
+  like any other buffer by copy-on-write copies.
+*/
+
+/**
+  Function releasing an external buffer.  `owner` is the pointer
+  passed to dlite_instance_adopt_property().
+*/
+typedef void (*DLiteBufferRelease)(void *owner);
+
+/**
+  Lets dimensional property `i` of `inst` use `buf` as its buffer
+  without copying.  `buf` must hold the property data in C order and
+  match the current dimensions of the property.  It must remain valid
+  and writable until `release(owner)` is called.
+
+  If `release` is NULL, the instance takes over the ownership of
+  `buf`, which must then be allocated with malloc().
+
+  Only properties of types that are not allocated (i.e. not strings,
+  properties or relations) in instances of plain metadata may adopt
+  buffers.  The previous buffer of the property is released.
+
+  Returns non-zero on error, in which case `release` is not called.
+ */
+int dlite_instance_adopt_property(DLiteInstance *inst, size_t i, void *buf,
+                                  DLiteBufferRelease release, void *owner);
+
+/**
+  Returns non-zero if dimensional property `i` of `inst` uses an
+  external buffer adopted with dlite_instance_adopt_property().
+ */
+int dlite_instance_has_external_buffer(const DLiteInstance *inst, size_t i);
+
 /**
   Returns a new DLiteArray object for property number `i` in instance `inst`.
 
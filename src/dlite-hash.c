@@ -0,0 +1,284 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/err.h"
+#include "utils/sha3.h"
+#include "utils/byteorder.h"
+
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-binary.h"
+#include "dlite-hash.h"
+
+
+/* Primes used by the fast hash (from xxHash) */
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+
+/* Streaming non-cryptographic 64-bit hash */
+typedef struct {
+  uint64_t acc;             /* accumulator */
+  uint64_t len;             /* total number of bytes hashed */
+  unsigned char tail[8];    /* bytes not yet consumed */
+  size_t ntail;             /* number of bytes in `tail` */
+} FastHash;
+
+/* Sink for the canonical byte stream */
+typedef struct {
+  void (*update)(void *ctx, const void *buf, size_t len);
+  void *ctx;
+} Sink;
+
+/* Temporary buffer for encoded data */
+typedef struct {
+  unsigned char *data;
+  size_t size;
+} Buffer;
+
+
+/********************************************************************
+ *  Fast hash
+ ********************************************************************/
+
+static void fasthash_init(FastHash *h)
+{
+  memset(h, 0, sizeof(FastHash));
+  h->acc = PRIME5;
+}
+
+static uint64_t fasthash_round(uint64_t acc, uint64_t lane)
+{
+  lane *= PRIME2;
+  lane = ROTL64(lane, 31);
+  acc ^= lane * PRIME1;
+  return ROTL64(acc, 27) * PRIME1 + PRIME4;
+}
+
+static uint64_t fasthash_lane(const unsigned char *p)
+{
+  uint64_t lane;
+  memcpy(&lane, p, 8);
+  return le64toh(lane);
+}
+
+static void fasthash_update(void *ctx, const void *buf, size_t len)
+{
+  FastHash *h = ctx;
+  const unsigned char *p = buf, *end = p + len;
+  h->len += len;
+  if (h->ntail) {
+    size_t m = 8 - h->ntail;
+    if (m > len) m = len;
+    memcpy(h->tail + h->ntail, p, m);
+    h->ntail += m;
+    p += m;
+    if (h->ntail < 8) return;
+    h->acc = fasthash_round(h->acc, fasthash_lane(h->tail));
+    h->ntail = 0;
+  }
+  for (; p + 8 <= end; p += 8)
+    h->acc = fasthash_round(h->acc, fasthash_lane(p));
+  if (p < end) {
+    h->ntail = end - p;
+    memcpy(h->tail, p, h->ntail);
+  }
+}
+
+static uint64_t fasthash_final(FastHash *h)
+{
+  uint64_t acc = h->acc + h->len;
+  size_t i;
+  for (i=0; i < h->ntail; i++) {
+    acc ^= h->tail[i] * PRIME5;
+    acc = ROTL64(acc, 11) * PRIME1;
+  }
+  acc ^= acc >> 33;
+  acc *= PRIME2;
+  acc ^= acc >> 29;
+  acc *= PRIME3;
+  acc ^= acc >> 32;
+  return acc;
+}
+
+
+/********************************************************************
+ *  Canonical byte stream
+ ********************************************************************/
+
+static void feed_uint64(Sink *sink, uint64_t v)
+{
+  v = htole64(v);
+  sink->update(sink->ctx, &v, sizeof(v));
+}
+
+static void feed_string(Sink *sink, const char *s)
+{
+  if (s) {
+    size_t len = strlen(s);
+    feed_uint64(sink, len);
+    sink->update(sink->ctx, s, len);
+  } else {
+    feed_uint64(sink, UINT64_MAX);
+  }
+}
+
+/* Feeds instance header and dimensions to `sink`.  The uuid and uri
+   are only included if `identity` is non-zero. */
+static void feed_header(Sink *sink, const DLiteInstance *inst, int identity)
+{
+  size_t i;
+  if (identity) {
+    feed_string(sink, inst->uuid);
+    feed_string(sink, inst->uri);
+  }
+  feed_string(sink, inst->meta->uri);
+  feed_uint64(sink, inst->meta->_ndimensions);
+  for (i=0; i < inst->meta->_ndimensions; i++)
+    feed_uint64(sink, DLITE_DIM(inst, i));
+  feed_uint64(sink, inst->meta->_nproperties);
+}
+
+/* Feeds the number of elements and the encoded data of property `i`
+   to `sink`.  Returns non-zero on error. */
+static int feed_property(Sink *sink, const DLiteInstance *inst, size_t i,
+                         Buffer *buf)
+{
+  const DLiteProperty *p = inst->meta->_properties + i;
+  const void *ptr = DLITE_PROP(inst, i);
+  size_t nelem=1;
+  ptrdiff_t n;
+  int j;
+
+  for (j=0; j < p->ndims; j++) nelem *= DLITE_PROP_DIM(inst, i, j);
+  if (p->ndims > 0) ptr = *(void **)ptr;
+  feed_uint64(sink, nelem);
+  if (!nelem) return 0;
+
+  /* On little endian hosts, the memory of non-allocated types is
+     identical to its encoded form */
+  if (BYTE_ORDER == LITTLE_ENDIAN && p->type != dliteBool &&
+      !dlite_type_is_allocated(p->type)) {
+    sink->update(sink->ctx, ptr, nelem * p->size);
+    return 0;
+  }
+
+  if ((n = dlite_type_encode(NULL, 0, ptr, p->type, p->size, nelem)) < 0)
+    return 1;
+  if ((size_t)n > buf->size) {
+    void *q;
+    if (!(q = realloc(buf->data, n))) return err(1, "allocation failure");
+    buf->data = q;
+    buf->size = n;
+  }
+  if (dlite_type_encode(buf->data, n, ptr, p->type, p->size, nelem) != n)
+    return errx(1, "property '%s' changed while hashing", p->name);
+  sink->update(sink->ctx, buf->data, n);
+  return 0;
+}
+
+
+/********************************************************************
+ *  Hashing
+ ********************************************************************/
+
+/* Returns the fast hash of property `i`.  Returns non-zero on error. */
+static int property_hash(const DLiteInstance *inst, size_t i, Buffer *buf,
+                         uint64_t *hash)
+{
+  FastHash h;
+  Sink sink = {fasthash_update, &h};
+  fasthash_init(&h);
+  if (feed_property(&sink, inst, i, buf)) return 1;
+  *hash = fasthash_final(&h);
+  return 0;
+}
+
+/* Common implementation of dlite_instance_hash() and
+   dlite_instance_payload_hash(). */
+static int instance_hash(const DLiteInstance *inst, uint64_t *hash,
+                         int identity)
+{
+  FastHash h;
+  Sink sink = {fasthash_update, &h};
+  Buffer buf = {NULL, 0};
+  size_t i;
+  int retval=1;
+
+  if (!inst->meta) return errx(1, "no metadata available");
+  if (dlite_instance_sync_to_dimension_sizes((DLiteInstance *)inst) ||
+      dlite_instance_sync_to_properties((DLiteInstance *)inst)) return 1;
+
+  fasthash_init(&h);
+  feed_header(&sink, inst, identity);
+  for (i=0; i < inst->meta->_nproperties; i++) {
+    uint64_t phash;
+    if (property_hash(inst, i, &buf, &phash)) goto fail;
+    feed_uint64(&sink, phash);
+  }
+  *hash = fasthash_final(&h);
+  retval = 0;
+ fail:
+  if (buf.data) free(buf.data);
+  return retval;
+}
+
+
+/********************************************************************
+ *  Public functions
+ ********************************************************************/
+
+/*
+  Writes the 64-bit content hash of `inst` to `*hash`.
+  Returns non-zero on error.
+ */
+int dlite_instance_hash(const DLiteInstance *inst, uint64_t *hash)
+{
+  return instance_hash(inst, hash, 1);
+}
+
+/*
+  Like dlite_instance_hash(), but the uuid and uri of the instance are
+  not included.  Returns non-zero on error.
+ */
+int dlite_instance_payload_hash(const DLiteInstance *inst, uint64_t *hash)
+{
+  return instance_hash(inst, hash, 0);
+}
+
+/*
+  Writes the SHA3 digest of the content of `inst` to `digest`.
+  Returns non-zero on error.
+ */
+int dlite_instance_sha3(const DLiteInstance *inst, int bits,
+                        unsigned char *digest)
+{
+  sha3_context c;
+  Sink sink = {sha3_Update, &c};
+  Buffer buf = {NULL, 0};
+  size_t i;
+  int retval=1;
+
+  if (bits != 256 && bits != 384 && bits != 512)
+    return errx(1, "SHA3 digest size must be 256, 384 or 512, got %d", bits);
+  if (!inst->meta) return errx(1, "no metadata available");
+  if (dlite_instance_sync_to_dimension_sizes((DLiteInstance *)inst) ||
+      dlite_instance_sync_to_properties((DLiteInstance *)inst)) return 1;
+
+  sha3_Init(&c, bits);
+  feed_header(&sink, inst, 1);
+  for (i=0; i < inst->meta->_nproperties; i++)
+    if (feed_property(&sink, inst, i, &buf)) goto fail;
+  memcpy(digest, sha3_Finalize(&c), bits / 8);
+  retval = 0;
+ fail:
+  if (buf.data) free(buf.data);
+  return retval;
+}
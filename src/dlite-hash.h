@@ -0,0 +1,58 @@
+#ifndef _DLITE_HASH_H
+#define _DLITE_HASH_H
+
+/**
+  @file
+  @brief Content hashing and change detection for instances
+
+  The content of an instance is hashed from a canonical byte stream
+  consisting of a header (uuid, uri and metadata uri), the dimension
+  values and the data of each property, using the host-independent
+  representation of dlite_type_encode().  Hence, equal instances have
+  equal hashes, regardless of the host they are created on.
+
+  The fast hash is a non-cryptographic 64-bit hash combined from the
+  header, the dimensions and a hash of each property.  It is always
+  computed from the current content of the instance.  Nothing is
+  cached, since the property memory may be written to through
+  pointers obtained at any earlier time.
+
+  A cryptographic SHA3 digest of the same byte stream may be obtained
+  with dlite_instance_sha3().  It is not cached.
+*/
+
+#include <stdint.h>
+
+#include "dlite-entity.h"
+
+
+/**
+  Writes the 64-bit content hash of `inst` to `*hash`.  The hash
+  covers the uuid, uri, metadata, dimensions and all properties.
+
+  Returns non-zero on error.
+ */
+int dlite_instance_hash(const DLiteInstance *inst, uint64_t *hash);
+
+/**
+  Like dlite_instance_hash(), but the uuid and uri of the instance are
+  not included.  Hence, instances with identical metadata, dimensions
+  and property values get the same payload hash.  Useful for
+  deduplicating identical payloads.
+
+  Returns non-zero on error.
+ */
+int dlite_instance_payload_hash(const DLiteInstance *inst, uint64_t *hash);
+
+/**
+  Writes the SHA3 digest of the content of `inst` to `digest`.
+  `bits` is the size of the digest and may be 256, 384 or 512.
+  `digest` must have space for at least `bits/8` bytes.
+
+  Returns non-zero on error.
+ */
+int dlite_instance_sha3(const DLiteInstance *inst, int bits,
+                        unsigned char *digest);
+
+
+#endif /* _DLITE_HASH_H */
@@ -5,10 +5,12 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <float.h>
 
 #include "utils/err.h"
 #include "utils/compat.h"
 #include "utils/strutils.h"
+#include "utils/byteorder.h"
 
 #include "dlite.h"
 #include "dlite-macros.h"
@@ -351,6 +353,356 @@ static int get_meta_uuid(char *uuid, const char *src, const jsmntok_t *obj)
 }
 
 
+/*
+  Help function for scan_array().  Returns non-zero if the json array
+  starting at `*t` has shape `dims[d:ndims]` and all its leaves are
+  primitives (or strings if `strings` is non-zero).  `*t` is advanced
+  past the array.
+*/
+static int check_array(const jsmntok_t **t, int d, const size_t *dims,
+                       int ndims, int strings)
+{
+  const jsmntok_t *tok = *t;
+  int k;
+  (*t)++;
+  if (d < ndims) {
+    if (tok->type != JSMN_ARRAY || tok->size != (int)dims[d]) return 0;
+    for (k=0; k < tok->size; k++)
+      if (!check_array(t, d+1, dims, ndims, strings)) return 0;
+    return 1;
+  }
+  return (tok->type == JSMN_PRIMITIVE ||
+          (strings && tok->type == JSMN_STRING));
+}
+
+/*
+  Help function for scan_array().  Assigns the leaves of the json
+  array `t` (ending before `end`) to string array property `i` of
+  `inst`.  Instead of allocating each element separately, the strings
+  are stored in a single string heap (see dlite_instance_string_heap()).
+
+  Returns non-zero on error.
+*/
+static int scan_string_array(const char *src, const jsmntok_t *t,
+                             const jsmntok_t *end, DLiteInstance *inst,
+                             size_t i)
+{
+  const jsmntok_t *tok;
+  char **strings, *heap;
+  size_t n=0, size=0, len;
+
+  for (tok=t; tok < end; tok++)
+    if (tok->type != JSMN_ARRAY) size += tok->end - tok->start + 1;
+  if (!(heap = dlite_instance_string_heap(inst, i, size))) return 1;
+  strings = *(char ***)DLITE_PROP(inst, i);
+
+  /* Like dlite_property_scan(), the strings are copied verbatim */
+  for (tok=t, size=0; tok < end; tok++) {
+    if (tok->type == JSMN_ARRAY) continue;
+    len = tok->end - tok->start;
+    memcpy(heap + size, src + tok->start, len);
+    heap[size + len] = '\0';
+    strings[n++] = heap + size;
+    size += len + 1;
+  }
+  return 0;
+}
+
+
+/* A json number split into its decimal components */
+typedef struct {
+  int neg;            /* whether the number is negative */
+  int isint;          /* whether the number has no fraction or exponent */
+  uint64_t mantissa;  /* decimal digits */
+  int exp10;          /* decimal exponent */
+} JsonNumber;
+
+/* Returns non-zero if the 8 bytes in `v` are all decimal digits. */
+static int is_eight_digits(uint64_t v)
+{
+  return (((v & 0xF0F0F0F0F0F0F0F0) |
+           (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+          0x3333333333333333);
+}
+
+/* Returns the value of the 8 decimal digits in `v`, where the first
+   digit is in the least significant byte.  Uses SWAR to combine the
+   digits pairwise with three multiplications. */
+static uint32_t parse_eight_digits(uint64_t v)
+{
+  const uint64_t mask = 0x000000FF000000FF;
+  const uint64_t mul1 = 0x000F424000000064;  /* 100 + (1000000 << 32) */
+  const uint64_t mul2 = 0x0000271000000001;  /* 1 + (10000 << 32) */
+  v -= 0x3030303030303030;
+  v = (v * 10) + (v >> 8);
+  v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+  return (uint32_t)v;
+}
+
+/* Appends the decimal digits starting at `*p` (before `end`) to
+   `*mantissa`.  `*ndigits` is incremented with the number of digits
+   read.  Returns non-zero if the mantissa may overflow. */
+static int parse_digits(const char **p, const char *end, uint64_t *mantissa,
+                        int *ndigits)
+{
+  const char *q = *p;
+  uint64_t m = *mantissa;
+  int n = *ndigits;
+#if BYTE_ORDER == LITTLE_ENDIAN
+  while (end - q >= 8 && n <= 11) {
+    uint64_t v;
+    memcpy(&v, q, 8);
+    if (!is_eight_digits(v)) break;
+    m = m * 100000000 + parse_eight_digits(v);
+    q += 8;
+    n += 8;
+  }
+#endif
+  while (q < end && *q >= '0' && *q <= '9') {
+    if (n >= 19) return 1;
+    m = m * 10 + (*q++ - '0');
+    n++;
+  }
+  *p = q;
+  *mantissa = m;
+  *ndigits = n;
+  return 0;
+}
+
+/*
+  Parses the json number in the `len` first bytes of `s` to `num`.
+
+  Returns non-zero if `s` is not a json number or if it has more than
+  19 significant digits.
+*/
+static int parse_number(const char *s, size_t len, JsonNumber *num)
+{
+  const char *p=s, *end=s+len, *q;
+  int ndigits=0, e=0, eneg=0;
+
+  memset(num, 0, sizeof(JsonNumber));
+  num->isint = 1;
+  if (p < end && *p == '-') {
+    num->neg = 1;
+    p++;
+  }
+  if (p >= end || *p < '0' || *p > '9') return 1;
+  if (*p == '0' && p+1 < end && p[1] >= '0' && p[1] <= '9') return 1;
+  while (p < end && *p == '0') p++;  /* skip leading zeros */
+  if (parse_digits(&p, end, &num->mantissa, &ndigits)) return 1;
+
+  if (p < end && *p == '.') {
+    q = ++p;
+    if (num->mantissa == 0)
+      while (p < end && *p == '0') p++;  /* leading zeros of fraction */
+    if (parse_digits(&p, end, &num->mantissa, &ndigits)) return 1;
+    if (p == q) return 1;
+    num->exp10 -= p - q;
+    num->isint = 0;
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (p < end && (*p == '+' || *p == '-')) eneg = (*p++ == '-');
+    if (p >= end || *p < '0' || *p > '9') return 1;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (e > 9999) return 1;
+      e = e * 10 + (*p++ - '0');
+    }
+    num->exp10 += (eneg) ? -e : e;
+    num->isint = 0;
+  }
+  return (p != end);
+}
+
+/* Exact powers of ten representable in a double */
+static const double pow10tab[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+  Writes the json number `num` to `p` as a value of type `dtype` and
+  size `size`.
+
+  Floats are converted with the exact fast path of Clinger, which
+  applies when both the mantissa and the power of ten are exactly
+  representable.
+
+  Returns non-zero if `num` cannot be converted exactly (or would be
+  parsed differently by dlite_type_scan()).  The caller should then
+  fall back to dlite_type_scan().
+*/
+static int assign_number(void *p, const JsonNumber *num, DLiteType dtype,
+                         size_t size)
+{
+  uint64_t m = num->mantissa;
+  switch (dtype) {
+  case dliteInt:
+    if (!num->isint) return 1;
+    switch (size) {
+    case 1:
+      if (m > (uint64_t)INT8_MAX + num->neg) return 1;
+      *(int8_t *)p = (num->neg) ? (int8_t)(-(int64_t)m) : (int8_t)m;
+      break;
+    case 2:
+      if (m > (uint64_t)INT16_MAX + num->neg) return 1;
+      *(int16_t *)p = (num->neg) ? (int16_t)(-(int64_t)m) : (int16_t)m;
+      break;
+    case 4:
+      if (m > (uint64_t)INT32_MAX + num->neg) return 1;
+      *(int32_t *)p = (num->neg) ? (int32_t)(-(int64_t)m) : (int32_t)m;
+      break;
+    case 8:
+      if (m > (uint64_t)INT64_MAX) return 1;
+      *(int64_t *)p = (num->neg) ? -(int64_t)m : (int64_t)m;
+      break;
+    default:
+      return 1;
+    }
+    break;
+  case dliteUInt:
+    if (!num->isint || num->neg) return 1;
+    switch (size) {
+    case 1: if (m > UINT8_MAX) return 1;  *(uint8_t *)p = (uint8_t)m; break;
+    case 2: if (m > UINT16_MAX) return 1; *(uint16_t *)p = (uint16_t)m; break;
+    case 4: if (m > UINT32_MAX) return 1; *(uint32_t *)p = (uint32_t)m; break;
+    case 8: *(uint64_t *)p = m; break;
+    default: return 1;
+    }
+    break;
+  case dliteFloat:
+#if FLT_EVAL_METHOD == 0
+    if (size == 8) {
+      double v;
+      if (m > ((uint64_t)1 << 53) || num->exp10 < -22 || num->exp10 > 22)
+        return 1;
+      v = (double)m;
+      v = (num->exp10 < 0) ? v / pow10tab[-num->exp10] :
+        v * pow10tab[num->exp10];
+      *(double *)p = (num->neg) ? -v : v;
+    } else if (size == 4) {
+      float v;
+      if (m > ((uint64_t)1 << 24) || num->exp10 < -10 || num->exp10 > 10)
+        return 1;
+      v = (float)m;
+      v = (num->exp10 < 0) ? v / (float)pow10tab[-num->exp10] :
+        v * (float)pow10tab[num->exp10];
+      *(float *)p = (num->neg) ? -v : v;
+    } else {
+      return 1;
+    }
+    break;
+#else
+    return 1;
+#endif
+  default:
+    return 1;
+  }
+  return 0;
+}
+
+/*
+  Help function for scan_array().  Assigns the leaves of the json
+  array `t` (ending before `end`) to numerical or boolean array
+  property `i` of `inst`.
+
+  The numbers are parsed directly from the json source.  Elements
+  that are not plain json numbers (or booleans) are handled by
+  dlite_type_scan().
+
+  Returns non-zero on error.
+*/
+static int scan_numeric_array(const char *src, const jsmntok_t *t,
+                              const jsmntok_t *end, DLiteInstance *inst,
+                              size_t i)
+{
+  const DLiteProperty *p = inst->meta->_properties + i;
+  const jsmntok_t *tok;
+  char *ptr = *(char **)DLITE_PROP(inst, i), buf[64], *elem;
+  JsonNumber num;
+  int stat;
+
+  for (tok=t; tok < end; tok++) {
+    const char *s = src + tok->start;
+    int len = tok->end - tok->start;
+    if (tok->type == JSMN_ARRAY) continue;
+    if (p->type == dliteBool) {
+      if (len == 4 && strncmp(s, "true", 4) == 0) {
+        *(bool *)ptr = 1;
+      } else if (len == 5 && strncmp(s, "false", 5) == 0) {
+        *(bool *)ptr = 0;
+      } else {
+        goto fallback;
+      }
+    } else if (parse_number(s, len, &num) ||
+               assign_number(ptr, &num, p->type, p->size)) {
+      goto fallback;
+    }
+    ptr += p->size;
+    continue;
+
+  fallback:
+    /* copy the token, since dlite_type_scan() may read the rest of
+       the source.  Long tokens are copied to the heap */
+    if (len >= (int)sizeof(buf)) {
+      if (!(elem = malloc(len + 1))) return err(1, "allocation failure");
+    } else {
+      elem = buf;
+    }
+    memcpy(elem, s, len);
+    elem[len] = '\0';
+    stat = dlite_type_scan(elem, len, ptr, p->type, p->size, 0);
+    if (stat < 0)
+      errx(1, "failed to scan element of array '%s': '%s'", p->name, elem);
+    if (elem != buf) free(elem);
+    if (stat < 0) return 1;
+    ptr += p->size;
+  }
+  return 0;
+}
+
+/*
+  Help function for parse_instance().  Assigns the json array `t` to
+  dimensional property `i` of `inst` directly from the tokens, without
+  re-tokenising the array text like dlite_property_scan().
+
+  Returns zero on success, non-zero on error and -1 if the fast path
+  does not apply (the caller should then use dlite_property_scan()).
+*/
+static int scan_array(const char *src, const jsmntok_t *t,
+                      DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *p = inst->meta->_properties + i;
+  const size_t *dims = DLITE_PROP_DIMS(inst, i);
+  const jsmntok_t *end = t;
+  size_t nmemb=1;
+  int j;
+
+  if (t->type != JSMN_ARRAY || p->ndims <= 0) return -1;
+  switch (p->type) {
+  case dliteStringPtr:
+    if (dlite_instance_is_meta(inst)) return -1;
+    if (!check_array(&end, 0, dims, p->ndims, 1)) return -1;
+    break;
+  case dliteBool:
+  case dliteInt:
+  case dliteUInt:
+  case dliteFloat:
+    if (!check_array(&end, 0, dims, p->ndims, 0)) return -1;
+    break;
+  default:
+    return -1;
+  }
+  for (j=0; j < p->ndims; j++) nmemb *= dims[j];
+  if (nmemb == 0) return 0;
+
+  if (p->type == dliteStringPtr)
+    return scan_string_array(src, t, end, inst, i);
+  return scan_numeric_array(src, t, end, inst, i);
+}
+
+
 /*
   Help function for parsing an instance.
   - src: json source
@@ -362,7 +714,7 @@ static int get_meta_uuid(char *uuid, const char *src, const jsmntok_t *obj)
 static DLiteInstance *parse_instance(const char *src, jsmntok_t *obj,
                                      const char *id)
 {
-  int ok=0;
+  int ok=0, stat;
   const jsmntok_t *item, *t;
   char *buf=NULL, *uri=NULL, *metauri=NULL, uuid[DLITE_UUID_LENGTH+1];
   size_t i, size=0, *dims=NULL;
@@ -487,7 +839,10 @@ static DLiteInstance *parse_instance(const char *src, jsmntok_t *obj,
       size_t *pdims = DLITE_PROP_DIMS(inst, i);
       void *ptr = DLITE_PROP(inst, i);
       if (DLITE_PROP_NDIM(inst, i) > 0) ptr = *(void **)ptr;
-      if ((t = jsmn_item(src, base, p->name))) {
+      if ((t = jsmn_item(src, base, p->name)) &&
+          (stat = scan_array(src, t, inst, i)) >= 0) {
+        if (stat) goto fail;
+      } else if (t) {
         strnput(&buf, &size, 0, src+t->start, t->end-t->start);
         if (dlite_property_scan(buf, ptr, p, pdims, 0) < 0) goto fail;
       //} else {
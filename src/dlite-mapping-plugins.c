@@ -255,7 +255,7 @@ FUPaths *dlite_mapping_plugin_paths_get(void)
   if no search path is defined.
 
   Use dlite_mapping_plugin_path_insert(), dlite_mapping_plugin_path_append()
-  and dlite_mapping_plugin_path_remove() to modify it.
+  and dlite_mapping_plugin_path_delete() to modify it.
 */
 const char **dlite_mapping_plugin_paths()
 {
@@ -328,3 +328,15 @@ int dlite_mapping_plugin_path_delete_index(int index)
   if (!(info = get_mapping_plugin_info())) return 1;
   return plugin_path_delete_index(info, index);
 }
+
+/*
+  Removes path `path` from current search path.
+
+  Returns non-zero if there is no such path.
+*/
+int dlite_mapping_plugin_path_delete(const char *path)
+{
+  PluginInfo *info;
+  if (!(info = get_mapping_plugin_info())) return 1;
+  return plugin_path_delete(info, path);
+}
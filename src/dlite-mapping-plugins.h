@@ -122,7 +122,7 @@ FUPaths *dlite_mapping_plugin_paths_get(void);
   initialised from the environment variable `DLITE_MAPPING_PLUGIN_DIRS`.
 
   Use dlite_mapping_plugin_path_insert(), dlite_mapping_plugin_path_append()
-  and dlite_mapping_plugin_path_remove() to modify it.
+  and dlite_mapping_plugin_path_delete() to modify it.
 */
 const char **dlite_mapping_plugin_paths(void);
 
@@ -164,7 +164,14 @@ int dlite_mapping_plugin_path_appendn(const char *path, size_t n);
 
   Returns non-zero on error.
 */
-int dlite_mapping_plugin_path_delete(int n);
+int dlite_mapping_plugin_path_delete_index(int n);
+
+/**
+  Removes path `path` from current search path.
+
+  Returns non-zero if there is no such path.
+*/
+int dlite_mapping_plugin_path_delete(const char *path);
 
 
 /** @} */
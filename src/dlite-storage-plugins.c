@@ -234,7 +234,7 @@ FUPaths *dlite_storage_plugin_paths_get(void)
   if no search path is defined.
 
   Use dlite_storage_plugin_path_insert(), dlite_storage_plugin_path_append()
-  and dlite_storage_plugin_path_remove() to modify it.
+  and dlite_storage_plugin_path_delete() to modify it.
 */
 const char **dlite_storage_plugin_paths(void)
 {
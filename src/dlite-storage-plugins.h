@@ -157,7 +157,7 @@ FUPaths *dlite_storage_plugin_paths_get(void);
   initialised from the environment variable `DLITE_STORAGE_PLUGIN_DIRS`.
 
   Use dlite_storage_plugin_path_insert(), dlite_storage_plugin_path_append()
-  and dlite_storage_plugin_path_remove() to modify it.
+  and dlite_storage_plugin_path_delete() to modify it.
 */
 const char **dlite_storage_plugin_paths(void);
 
@@ -199,14 +199,14 @@ int dlite_storage_plugin_path_appendn(const char *path, size_t n);
 
   Returns non-zero on error.
 */
-int dlite_storage_plugin_path_delete(int n);
+int dlite_storage_plugin_path_delete_index(int n);
 
 /**
   Removes path `path` from current search path.
 
   Returns non-zero if there is no such path.
 */
-int dlite_storage_plugin_path_remove(const char *path);
+int dlite_storage_plugin_path_delete(const char *path);
 
 
 /** @} */
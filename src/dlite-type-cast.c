@@ -774,3 +774,136 @@ int dlite_type_copy_cast(void *dest, DLiteType dest_type, size_t dest_size,
   dlite_type_set_typename(dest_type, dest_size, dtype, sizeof(dtype));
   return err(1, "cannot cast %s to %s", stype, dtype);
 }
+
+
+
+/********************************************************************
+ *  Cast kernels
+ *
+ *  Each kernel casts a contiguous array with a simple loop over the
+ *  elements, which the compiler is able to vectorise.  Kernels casting
+ *  signed types to unsigned integers first check that no element is
+ *  negative.
+ ********************************************************************/
+
+#define DEFINE_KERNEL(dname, dtype, sname, stype)                       \
+  static int cast_##sname##_to_##dname(void *dest, const void *src,     \
+                                       size_t n)                        \
+  {                                                                     \
+    dtype *d = dest;                                                    \
+    const stype *s = src;                                               \
+    size_t i;                                                           \
+    for (i=0; i<n; i++) d[i] = (dtype)s[i];                             \
+    return 0;                                                           \
+  }
+
+#define DEFINE_KERNEL_NONNEG(dname, dtype, sname, stype)                \
+  static int cast_##sname##_to_##dname(void *dest, const void *src,     \
+                                       size_t n)                        \
+  {                                                                     \
+    dtype *d = dest;                                                    \
+    const stype *s = src;                                               \
+    size_t i;                                                           \
+    int neg=0;                                                          \
+    for (i=0; i<n; i++) neg |= (s[i] < 0);                              \
+    if (neg) return 1;                                                  \
+    for (i=0; i<n; i++) d[i] = (dtype)s[i];                             \
+    return 0;                                                           \
+  }
+
+/* Defines kernels casting signed integers and floats to `dtype` */
+#define DEFINE_KERNELS_FROM_SIGNED(dname, dtype, DEF)   \
+  DEF(dname, dtype, int8, int8_t)                       \
+  DEF(dname, dtype, int16, int16_t)                     \
+  DEF(dname, dtype, int32, int32_t)                     \
+  DEF(dname, dtype, int64, int64_t)                     \
+  DEF(dname, dtype, float32, float32_t)                 \
+  DEF(dname, dtype, float64, float64_t)
+
+/* Defines kernels casting unsigned integers to `dtype` */
+#define DEFINE_KERNELS_FROM_UNSIGNED(dname, dtype)      \
+  DEFINE_KERNEL(dname, dtype, uint8, uint8_t)           \
+  DEFINE_KERNEL(dname, dtype, uint16, uint16_t)         \
+  DEFINE_KERNEL(dname, dtype, uint32, uint32_t)         \
+  DEFINE_KERNEL(dname, dtype, uint64, uint64_t)
+
+/* Defines kernels casting all numerical types to signed `dtype` */
+#define DEFINE_KERNELS_TO_SIGNED(dname, dtype)                  \
+  DEFINE_KERNELS_FROM_SIGNED(dname, dtype, DEFINE_KERNEL)       \
+  DEFINE_KERNELS_FROM_UNSIGNED(dname, dtype)
+
+/* Defines kernels casting all numerical types to unsigned `dtype` */
+#define DEFINE_KERNELS_TO_UNSIGNED(dname, dtype)                        \
+  DEFINE_KERNELS_FROM_SIGNED(dname, dtype, DEFINE_KERNEL_NONNEG)        \
+  DEFINE_KERNELS_FROM_UNSIGNED(dname, dtype)
+
+DEFINE_KERNELS_TO_SIGNED(int8, int8_t)
+DEFINE_KERNELS_TO_SIGNED(int16, int16_t)
+DEFINE_KERNELS_TO_SIGNED(int32, int32_t)
+DEFINE_KERNELS_TO_SIGNED(int64, int64_t)
+DEFINE_KERNELS_TO_UNSIGNED(uint8, uint8_t)
+DEFINE_KERNELS_TO_UNSIGNED(uint16, uint16_t)
+DEFINE_KERNELS_TO_UNSIGNED(uint32, uint32_t)
+DEFINE_KERNELS_TO_UNSIGNED(uint64, uint64_t)
+DEFINE_KERNELS_TO_SIGNED(float32, float32_t)
+DEFINE_KERNELS_TO_SIGNED(float64, float64_t)
+
+/* Row in the kernel table, for casting all types to `dname`.  The
+   order must match kernel_index(). */
+#define KERNEL_ROW(dname)                                               \
+  {cast_int8_to_##dname,    cast_int16_to_##dname,                      \
+   cast_int32_to_##dname,   cast_int64_to_##dname,                      \
+   cast_uint8_to_##dname,   cast_uint16_to_##dname,                     \
+   cast_uint32_to_##dname,  cast_uint64_to_##dname,                     \
+   cast_float32_to_##dname, cast_float64_to_##dname}
+
+/* Table of cast kernels, indexed by [dest][src] */
+static const DLiteTypeCastKernel cast_kernels[10][10] = {
+  KERNEL_ROW(int8),    KERNEL_ROW(int16),
+  KERNEL_ROW(int32),   KERNEL_ROW(int64),
+  KERNEL_ROW(uint8),   KERNEL_ROW(uint16),
+  KERNEL_ROW(uint32),  KERNEL_ROW(uint64),
+  KERNEL_ROW(float32), KERNEL_ROW(float64)
+};
+
+/* Returns the index of `type` and `size` in the kernel table or -1 if
+   there are no kernels for this type. */
+static int kernel_index(DLiteType type, size_t size)
+{
+  switch (type) {
+  case dliteInt:
+  case dliteUInt:
+    switch (size) {
+    case 1: return (type == dliteInt) ? 0 : 4;
+    case 2: return (type == dliteInt) ? 1 : 5;
+    case 4: return (type == dliteInt) ? 2 : 6;
+    case 8: return (type == dliteInt) ? 3 : 7;
+    default: return -1;
+    }
+  case dliteFloat:
+    switch (size) {
+    case 4: return 8;
+    case 8: return 9;
+    default: return -1;
+    }
+  default:
+    return -1;
+  }
+}
+
+
+/*
+  Returns a kernel casting contiguous arrays of `src_type` and
+  `src_size` to `dest_type` and `dest_size`, or NULL if there is no
+  kernel for this combination of types.
+*/
+DLiteTypeCastKernel dlite_type_get_cast_kernel(DLiteType dest_type,
+                                               size_t dest_size,
+                                               DLiteType src_type,
+                                               size_t src_size)
+{
+  int i = kernel_index(dest_type, dest_size);
+  int j = kernel_index(src_type, src_size);
+  if (i < 0 || j < 0) return NULL;
+  return cast_kernels[i][j];
+}
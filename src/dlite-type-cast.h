@@ -21,5 +21,30 @@ int dlite_type_copy_cast(void *dest, DLiteType dest_type, size_t dest_size,
                          const void *src, DLiteType src_type, size_t src_size);
 
 
+/** Function prototype for a kernel casting `n` contiguous elements
+    from `src` to `dest`.
+
+    Returns non-zero if the kernel cannot cast the data (e.g. a
+    negative value is casted to an unsigned integer).  The caller
+    should then fall back to casting element by element with
+    dlite_type_copy_cast(), which reports the error. */
+typedef int (*DLiteTypeCastKernel)(void *dest, const void *src, size_t n);
+
+
+/**
+  Returns a kernel casting contiguous arrays of `src_type` and
+  `src_size` to `dest_type` and `dest_size`.  The result is the same
+  as calling dlite_type_copy_cast() on each element.
+
+  Kernels exist for all combinations of signed and unsigned integers
+  of size 1, 2, 4 and 8 and floats of size 4 and 8.  NULL is returned
+  for other types.
+*/
+DLiteTypeCastKernel dlite_type_get_cast_kernel(DLiteType dest_type,
+                                               size_t dest_size,
+                                               DLiteType src_type,
+                                               size_t src_size);
+
+
 
 #endif /* _DLITE_TYPE_CAST_H */
@@ -601,6 +601,7 @@ void *dlite_type_clear(void *p, DLiteType dtype, size_t size)
       free(((DLiteProperty *)p)->dims);
     }
     if (((DLiteProperty *)p)->unit) free(((DLiteProperty *)p)->unit);
+    if (((DLiteProperty *)p)->iri) free(((DLiteProperty *)p)->iri);
     if (((DLiteProperty *)p)->description)
       free(((DLiteProperty *)p)->description);
     break;
@@ -988,7 +989,7 @@ int dlite_type_scan(const char *src, int len, void *p, DLiteType dtype,
       assert(n >= 0);
       if (!(q = realloc(*((char **)p), n+1)))
         return err(-1, "allocation failure");
-      n = strunquote(q, n+1, src, NULL, qflags);
+      n = strnunquote(q, n+1, src, len, NULL, qflags);
       assert(n >= 0);
       *(char **)p = q;
     }
@@ -1178,6 +1179,145 @@ int dlite_type_get_member_offset(size_t prev_offset, size_t prev_size,
 }
 
 
+/* Maximum number of dimensions supported by dlite_type_ndcast() */
+#define NDCAST_MAXDIMS 32
+
+/* Size of the blocks in cache-blocked transposes */
+#define NDCAST_BLOCKSIZE 32
+
+/* How dlite_type_ndcast() casts a single element */
+typedef struct {
+  DLiteTypeCast castfun;       /* cast function */
+  DLiteTypeCastKernel kernel;  /* cast kernel or NULL */
+  int copy;                    /* whether elements can be copied bitwise */
+  DLiteType dest_type;
+  size_t dest_size;
+  DLiteType src_type;
+  size_t src_size;
+} NdCaster;
+
+/* Casts a single element from `sp` to `dp`.  Returns non-zero on error. */
+static int ndcast_element(const NdCaster *c, char *dp, const char *sp)
+{
+  if (c->copy) {
+    memcpy(dp, sp, c->dest_size);
+    return 0;
+  }
+  if (c->kernel && c->kernel(dp, sp, 1) == 0) return 0;
+  return c->castfun(dp, c->dest_type, c->dest_size,
+                    sp, c->src_type, c->src_size);
+}
+
+/* Casts `n` elements with source and dest strides `ss` and `ds`.
+   Contiguous rows are casted with a single kernel call.
+   Returns non-zero on error. */
+static int ndcast_row(const NdCaster *c, char *dp, ptrdiff_t ds,
+                      const char *sp, ptrdiff_t ss, size_t n)
+{
+  size_t i;
+  if (c->kernel && ss == (ptrdiff_t)c->src_size &&
+      ds == (ptrdiff_t)c->dest_size && c->kernel(dp, sp, n) == 0)
+    return 0;
+  for (i=0; i<n; i++, dp+=ds, sp+=ss)
+    if (ndcast_element(c, dp, sp)) return 1;
+  return 0;
+}
+
+/* Casts a 2D block in tiles of NDCAST_BLOCKSIZE x NDCAST_BLOCKSIZE
+   elements, such that both source and dest stay in cache while
+   copying a tile.  Returns non-zero on error. */
+static int ndcast_blocked(const NdCaster *c, size_t n0, size_t n1,
+                          char *dp, ptrdiff_t ds0, ptrdiff_t ds1,
+                          const char *sp, ptrdiff_t ss0, ptrdiff_t ss1)
+{
+  size_t i0, i1, i;
+  for (i0=0; i0<n0; i0+=NDCAST_BLOCKSIZE) {
+    size_t m0 = (n0 - i0 < NDCAST_BLOCKSIZE) ? n0 - i0 : NDCAST_BLOCKSIZE;
+    for (i1=0; i1<n1; i1+=NDCAST_BLOCKSIZE) {
+      size_t m1 = (n1 - i1 < NDCAST_BLOCKSIZE) ? n1 - i1 : NDCAST_BLOCKSIZE;
+      for (i=0; i<m0; i++)
+        if (ndcast_row(c, dp + (ptrdiff_t)(i0+i)*ds0 + (ptrdiff_t)i1*ds1, ds1,
+                       sp + (ptrdiff_t)(i0+i)*ss0 + (ptrdiff_t)i1*ss1, ss1,
+                       m1)) return 1;
+    }
+  }
+  return 0;
+}
+
+/* Removes dimensions of size one and merges adjacent dimensions that
+   can be iterated over as one.  If `strides2` is not NULL, dimensions
+   are only merged if they can be merged with both `strides` and
+   `strides2`.  Returns the new number of dimensions. */
+static int ndcast_collapse(int ndims, size_t *dims, ptrdiff_t *strides,
+                           ptrdiff_t *strides2)
+{
+  int i, n=0;
+  for (i=0; i<ndims; i++) {
+    if (dims[i] == 1) continue;
+    if (n > 0 && strides[n-1] == strides[i]*(ptrdiff_t)dims[i] &&
+        (!strides2 || strides2[n-1] == strides2[i]*(ptrdiff_t)dims[i])) {
+      dims[n-1] *= dims[i];
+      strides[n-1] = strides[i];
+      if (strides2) strides2[n-1] = strides2[i];
+    } else {
+      dims[n] = dims[i];
+      strides[n] = strides[i];
+      if (strides2) strides2[n] = strides2[i];
+      n++;
+    }
+  }
+  return n;
+}
+
+/* Combines source and dest shapes with equal number of elements into
+   a common shape by splitting dimensions, such that source and dest
+   can be iterated over jointly.  The result is written to `dims`,
+   `ss` and `ds`, which must have length `sn + dn`.  Returns the number
+   of dimensions of the common shape or -1 if it doesn't exists. */
+static int ndcast_common_shape(int sn, const size_t *sdims,
+                               const ptrdiff_t *sstrides,
+                               int dn, const size_t *ddims,
+                               const ptrdiff_t *dstrides,
+                               size_t *dims, ptrdiff_t *ss, ptrdiff_t *ds)
+{
+  int i=sn-1, j=dn-1, n=0, k;
+  size_t a=0, b=0;
+  ptrdiff_t as=0, bs=0;
+  if (i >= 0) { a = sdims[i]; as = sstrides[i]; }
+  if (j >= 0) { b = ddims[j]; bs = dstrides[j]; }
+  while (i >= 0 && j >= 0) {
+    size_t m = (a < b) ? a : b;
+    if ((a > b && a % b) || (b > a && b % a)) return -1;
+    dims[n] = m;
+    ss[n] = as;
+    ds[n] = bs;
+    n++;
+    if (a == m && --i >= 0) { a = sdims[i]; as = sstrides[i]; }
+    else { a /= m; as *= m; }
+    if (b == m && --j >= 0) { b = ddims[j]; bs = dstrides[j]; }
+    else { b /= m; bs *= m; }
+  }
+  if (i >= 0 || j >= 0) return -1;
+
+  /* reverse, since the dimensions were added starting from the innermost */
+  for (k=0; k<n/2; k++) {
+    size_t d = dims[k];
+    ptrdiff_t t;
+    dims[k] = dims[n-k-1];
+    dims[n-k-1] = d;
+    t = ss[k]; ss[k] = ss[n-k-1]; ss[n-k-1] = t;
+    t = ds[k]; ds[k] = ds[n-k-1]; ds[n-k-1] = t;
+  }
+  return n;
+}
+
+/* Returns the absolute value of `x`. */
+static ptrdiff_t ndcast_abs(ptrdiff_t x)
+{
+  return (x < 0) ? -x : x;
+}
+
+
 /*
   Copies n-dimensional array `src` to `dest` by calling `castfun` on
   each element.  `dest` must have sufficient size to hold the result.
@@ -1204,7 +1344,18 @@ int dlite_type_get_member_offset(size_t prev_offset, size_t prev_size,
     - src_dims: Source dimensions.  Length: `ndims`, required if ndims > 0
     - src_strides: Source strides.  Length: `ndims`, optional
     - castfun: Function that is doing the actually casting. Called on each
-          element.
+          element.  If NULL, dlite_type_copy_cast() is used.
+
+  If `castfun` is NULL or dlite_type_copy_cast(), numerical data is
+  casted with specialised kernels (see dlite_type_get_cast_kernel())
+  instead of element by element, whenever the innermost dimensions of
+  both source and dest are contiguous.
+
+  Before copying, dimensions of size one are dropped and dimensions
+  that can be iterated over as one are merged.  If source and dest
+  are laid out in different order (like when converting between C
+  and Fortran order), the two innermost dimensions are copied in
+  cache-sized blocks.
 
   Returns non-zero on error.
 
@@ -1219,9 +1370,16 @@ int dlite_type_ndcast(int ndims,
                       const size_t *src_dims, const int *src_strides,
                       DLiteTypeCast castfun)
 {
-  int i, retval=1, samelayout=1, *sstrides=NULL, *dstrides=NULL;
-  size_t *sidx=NULL, *didx=NULL;
-  size_t j, n, N=1;
+  int i, samelayout=1, sn, dn, n;
+  int sstrides[NDCAST_MAXDIMS], dstrides[NDCAST_MAXDIMS];
+  size_t sdims[NDCAST_MAXDIMS], ddims[NDCAST_MAXDIMS];
+  ptrdiff_t ss[NDCAST_MAXDIMS], ds[NDCAST_MAXDIMS];
+  size_t dims[2*NDCAST_MAXDIMS], idx[2*NDCAST_MAXDIMS];
+  ptrdiff_t jss[2*NDCAST_MAXDIMS], jds[2*NDCAST_MAXDIMS];
+  size_t j, N=1, M=1;
+  const char *sp = src;  /* pointer to current element in `src` */
+  char *dp = dest;       /* pointer to current element in `dest` */
+  NdCaster c;
 
   assert(src);
   assert(dest);
@@ -1233,20 +1391,23 @@ int dlite_type_ndcast(int ndims,
 
   assert(src_dims);
   assert(dest_dims);
+  if (ndims < 0 || ndims > NDCAST_MAXDIMS)
+    return err(1, "number of dimensions must be in range [0, %d], got %d",
+               NDCAST_MAXDIMS, ndims);
 
   /* Total number of elements: N */
-  for (i=0, n=1; i<ndims; i++) {
+  for (i=0; i<ndims; i++) {
     N *= src_dims[i];
-    n *= dest_dims[i];
+    M *= dest_dims[i];
   }
-  if (n != N)
+  if (M != N)
     return err(1, "incompatible sizes of source (%lu) and dest (%lu)",
-               (unsigned long)N, (unsigned long)n);
+               (unsigned long)N, (unsigned long)M);
+  if (N == 0) return 0;
 
   /* Default source strides */
   if (!src_strides) {
     size_t size = src_size;
-    if (!(sstrides = calloc(ndims, sizeof(size_t)))) FAIL("allocation failure");
     for (i=ndims-1; i >= 0; i--) {
       sstrides[i] = size;
       size *= src_dims[i];
@@ -1257,7 +1418,6 @@ int dlite_type_ndcast(int ndims,
   /* Default dest strides */
   if (!dest_strides) {
     size_t size = dest_size;
-    if (!(dstrides = calloc(ndims, sizeof(size_t)))) FAIL("allocation failure");
     for (i=ndims-1; i >= 0; i--) {
       dstrides[i] = size;
       size *= dest_dims[i];
@@ -1279,7 +1439,7 @@ int dlite_type_ndcast(int ndims,
     int size = src_size;
     for (i=0; i<ndims; i++) {
       int iscont=0;
-      for (j=0; j < src_dims[j]; j++)
+      for (j=0; j < (size_t)ndims; j++)
         if (src_strides[j] == size) { iscont = 1; break; }
       if (!iscont) { samelayout = 0; break; }
       size *= src_dims[i];
@@ -1290,58 +1450,108 @@ int dlite_type_ndcast(int ndims,
     /* Special case: if source and dest have same layout and are
        contiguous, copy all data in one chunck */
     memcpy(dest, src, N * src_size);
+    return 0;
+  }
 
-  } else {
-    /* General case: copy all elements individually using castfun()
-
-       We make a single loop over the total number of elements.  The
-       current index in each dimension in `src` and `dest` are stored
-       in `sidx` and `didx`, respectively.
-    */
-    size_t M=ndims-1;
-    const char *sp = src;  /* pointer to current element in `src` */
-    char *dp = dest;       /* pointer to current element in `dest` */
-    if (!(sidx = calloc(ndims, sizeof(size_t)))) FAIL("allocation failure");
-    if (!(didx = calloc(ndims, sizeof(size_t)))) FAIL("allocation failure");
-
-    n = 0;
-    while (1) {
-      if (castfun(dp, dest_type, dest_size, sp, src_type, src_size)) goto fail;
+  /* How to cast each element */
+  memset(&c, 0, sizeof(c));
+  c.castfun = castfun;
+  c.dest_type = dest_type;
+  c.dest_size = dest_size;
+  c.src_type = src_type;
+  c.src_size = src_size;
+  if (castfun == dlite_type_copy_cast) {
+    c.kernel = dlite_type_get_cast_kernel(dest_type, dest_size,
+                                          src_type, src_size);
+    c.copy = (dest_type == src_type && dest_size == src_size &&
+              (dest_type == dliteBlob || dest_type == dliteBool ||
+               dest_type == dliteInt || dest_type == dliteUInt ||
+               dest_type == dliteFloat));
+  }
 
-      if (++n >= N) break;
+  /* Simplify source and dest shapes */
+  for (i=0; i<ndims; i++) {
+    sdims[i] = src_dims[i];
+    ss[i] = src_strides[i];
+    ddims[i] = dest_dims[i];
+    ds[i] = dest_strides[i];
+  }
+  sn = ndcast_collapse(ndims, sdims, ss, NULL);
+  dn = ndcast_collapse(ndims, ddims, ds, NULL);
+
+  if ((n = ndcast_common_shape(sn, sdims, ss, dn, ddims, ds,
+                               dims, jss, jds)) >= 0) {
+    /* Source and dest can be iterated over jointly.  The innermost
+       dimension (or two innermost dimensions for blocked transposes)
+       are handled by ndcast_row() (or ndcast_blocked()), while the
+       outer dimensions are iterated over by incrementally updating
+       the source and dest pointers. */
+    int k, nouter;
+    n = ndcast_collapse(n, dims, jss, jds);
+    if (n == 0) return ndcast_element(&c, dp, sp);
+
+    /* Find the dimension along which dest is most contiguous.  If it
+       is not the innermost, move it to the second innermost position
+       and use blocked copying over the two innermost dimensions. */
+    for (i=0, k=n-1; i<n-1; i++)
+      if (ndcast_abs(jds[i]) < ndcast_abs(jds[k])) k = i;
+    if (k < n-1 && ndcast_abs(jss[n-1]) <= ndcast_abs(jss[k])) {
+      size_t d = dims[k];
+      ptrdiff_t t1 = jss[k], t2 = jds[k];
+      for (i=k; i<n-2; i++) {
+        dims[i] = dims[i+1];
+        jss[i] = jss[i+1];
+        jds[i] = jds[i+1];
+      }
+      dims[n-2] = d;
+      jss[n-2] = t1;
+      jds[n-2] = t2;
+      nouter = n - 2;
+    } else {
+      nouter = n - 1;
+    }
 
-      /* update src pointer and index */
-      if (++sidx[M] < src_dims[M]) {
-        sp += src_strides[M];
+    memset(idx, 0, nouter*sizeof(size_t));
+    while (1) {
+      if (nouter == n - 2) {
+        if (ndcast_blocked(&c, dims[n-2], dims[n-1], dp, jds[n-2], jds[n-1],
+                           sp, jss[n-2], jss[n-1])) return 1;
       } else {
-        sidx[M] = 0;
-        for (i=M-1; i>=0; i--) {
-          if (++sidx[i] < src_dims[i]) break;
-          sidx[i] = 0;
-        }
-        for (j=0, sp=src; j<M; j++)
-          sp += src_strides[j] * sidx[j];
+        if (ndcast_row(&c, dp, jds[n-1], sp, jss[n-1], dims[n-1])) return 1;
+      }
+      for (i=nouter-1; i>=0; i--) {
+        sp += jss[i];
+        dp += jds[i];
+        if (++idx[i] < dims[i]) break;
+        idx[i] = 0;
+        sp -= jss[i] * (ptrdiff_t)dims[i];
+        dp -= jds[i] * (ptrdiff_t)dims[i];
       }
+      if (i < 0) break;
+    }
 
-      /* update dest pointer and index */
-      if (++didx[M] < dest_dims[M]) {
-        dp += dest_strides[M];
-      } else {
-        didx[M] = 0;
-        for (i=M-1; i>=0; i--) {
-          if (++didx[i] < dest_dims[i]) break;
-          didx[i] = 0;
-        }
-        for (j=0, dp=dest; j<M; j++)
-          dp += dest_strides[j] * didx[j];
+  } else {
+    /* General case: source and dest have incompatible shapes.  Copy
+       all elements individually, iterating over source and dest
+       separately.  The current index in each dimension in `src` and
+       `dest` are stored in `idx` and `idx + ndims`, respectively. */
+    size_t *sidx = idx, *didx = idx + ndims;
+    memset(idx, 0, 2*ndims*sizeof(size_t));
+    for (j=0; j<N; j++) {
+      if (ndcast_element(&c, dp, sp)) return 1;
+      for (i=sn-1; i>=0; i--) {
+        sp += ss[i];
+        if (++sidx[i] < sdims[i]) break;
+        sidx[i] = 0;
+        sp -= ss[i] * (ptrdiff_t)sdims[i];
+      }
+      for (i=dn-1; i>=0; i--) {
+        dp += ds[i];
+        if (++didx[i] < ddims[i]) break;
+        didx[i] = 0;
+        dp -= ds[i] * (ptrdiff_t)ddims[i];
       }
     }
   }
-  retval = 0;
- fail:
-  if (sidx) free(sidx);
-  if (didx) free(didx);
-  if (sstrides) free(sstrides);
-  if (dstrides) free(dstrides);
-  return retval;
+  return 0;
 }
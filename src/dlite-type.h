@@ -313,7 +313,12 @@ int dlite_type_get_member_offset(size_t prev_offset, size_t prev_size,
     - src_dims: Source dimensions.  Length: `ndims`, required if ndims > 0
     - src_strides: Source strides.  Length: `ndims`, optional
     - castfun: Function that is doing the actually casting. Called on each
-          element.
+          element.  If NULL, dlite_type_copy_cast() is used.
+
+  If `castfun` is NULL or dlite_type_copy_cast() and both source and
+  dest are C-contiguous, numerical data is casted with a specialised
+  kernel (see dlite_type_get_cast_kernel()) instead of element by
+  element.
 
   Returns non-zero on error.
 */
@@ -19,6 +19,8 @@
 #include "dlite-collection.h"
 #include "dlite-getlicense.h"
 #include "dlite-json.h"
+#include "dlite-binary.h"
+#include "dlite-hash.h"
 
 
 #endif /* _DLITE_H */
@@ -0,0 +1,467 @@
+/* ntriples.c -- streaming parser and serialiser for N-Triples and N-Quads */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "utils/err.h"
+#include "ntriples.h"
+
+
+struct _NTriplesParser {
+  NTriplesHandler handler;  /*!< handler called for each statement */
+  void *data;               /*!< user data passed to handler */
+  char *line;               /*!< buffer with incomplete line */
+  size_t linelen;           /*!< length of incomplete line */
+  size_t linesize;          /*!< allocated size of `line` */
+  char *buf;                /*!< buffer for unescaped terms */
+  size_t bufsize;           /*!< allocated size of `buf` */
+  size_t lineno;            /*!< current line number */
+  size_t count;             /*!< number of parsed statements */
+};
+
+
+/* Returns non-zero if `c` is a whitespace character (excluding newline). */
+#define ISWS(c) ((c) == ' ' || (c) == '\t' || (c) == '\r')
+
+
+/* Returns the value of hexadecimal digit `c` or -1 if `c` is not a hex
+   digit. */
+static int hexval(int c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* Writes code point `cp` UTF-8 encoded to `out` and returns number of
+   bytes written or -1 if `cp` is not a valid code point. */
+static int utf8_encode(char *out, unsigned long cp)
+{
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    return 1;
+  } else if (cp < 0x800) {
+    out[0] = (char)(0xc0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3f));
+    return 2;
+  } else if (cp < 0x10000) {
+    out[0] = (char)(0xe0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[2] = (char)(0x80 | (cp & 0x3f));
+    return 3;
+  } else if (cp < 0x110000) {
+    out[0] = (char)(0xf0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (cp & 0x3f));
+    return 4;
+  }
+  return -1;
+}
+
+/* Parses an UCHAR escape (\uXXXX or \UXXXXXXXX) starting at `*pp`
+   (pointing at the 'u' or 'U').  The UTF-8 encoded result is written to
+   `*out`.  On success `*pp` and `*out` are advanced and zero is
+   returned. */
+static int parse_uchar(const char **pp, const char *end, char **out)
+{
+  const char *p = *pp;
+  int i, n = (*p == 'u') ? 4 : 8, len;
+  unsigned long cp = 0;
+  if (p + n >= end) return 1;
+  for (i=1; i<=n; i++) {
+    int v = hexval((unsigned char)p[i]);
+    if (v < 0) return 1;
+    cp = (cp << 4) | v;
+  }
+  if ((len = utf8_encode(*out, cp)) < 0) return 1;
+  *out += len;
+  *pp = p + n + 1;
+  return 0;
+}
+
+/* Parses an IRI starting at `*pp` (pointing at '<').  The unescaped
+   IRI is written NUL-terminated to `*out`.  Returns zero on success. */
+static int parse_iri(const char **pp, const char *end, char **out)
+{
+  const char *p = *pp + 1;
+  char *q = *out;
+  assert(**pp == '<');
+  while (p < end && *p != '>') {
+    if (*p == '\\') {
+      p++;
+      if (p >= end || (*p != 'u' && *p != 'U')) return 1;
+      if (parse_uchar(&p, end, &q)) return 1;
+    } else {
+      *q++ = *p++;
+    }
+  }
+  if (p >= end) return 1;
+  *q++ = '\0';
+  *pp = p + 1;
+  *out = q;
+  return 0;
+}
+
+/* Parses a blank node starting at `*pp` (pointing at "_:").  The blank
+   node, including the "_:" prefix, is written NUL-terminated to `*out`.
+   Returns zero on success. */
+static int parse_bnode(const char **pp, const char *end, char **out)
+{
+  const char *p = *pp + 2, *start = *pp;
+  char *q = *out;
+  assert(start[0] == '_' && start[1] == ':');
+  while (p < end && !ISWS(*p) && *p != '<' && *p != '"') p++;
+  /* a label may contain, but not end with a dot */
+  while (p > start + 2 && p[-1] == '.') p--;
+  if (p == start + 2) return 1;
+  memcpy(q, start, p - start);
+  q += p - start;
+  *q++ = '\0';
+  *pp = p;
+  *out = q;
+  return 0;
+}
+
+/* Parses a literal starting at `*pp` (pointing at '"').  The unescaped
+   value is written NUL-terminated to `*out`, followed by the language
+   tag and datatype IRI (if any).  `type` is updated to point to the
+   language and datatype.  Returns zero on success. */
+static int parse_literal(const char **pp, const char *end, char **out,
+                         TripleObjType *type)
+{
+  const char *p = *pp + 1;
+  char *q = *out;
+  assert(**pp == '"');
+  while (p < end && *p != '"') {
+    if (*p == '\\') {
+      p++;
+      if (p >= end) return 1;
+      switch (*p) {
+      case 't':  *q++ = '\t'; p++; break;
+      case 'b':  *q++ = '\b'; p++; break;
+      case 'n':  *q++ = '\n'; p++; break;
+      case 'r':  *q++ = '\r'; p++; break;
+      case 'f':  *q++ = '\f'; p++; break;
+      case '"':  *q++ = '"';  p++; break;
+      case '\'': *q++ = '\''; p++; break;
+      case '\\': *q++ = '\\'; p++; break;
+      case 'u':
+      case 'U':
+        if (parse_uchar(&p, end, &q)) return 1;
+        break;
+      default:
+        return 1;
+      }
+    } else {
+      *q++ = *p++;
+    }
+  }
+  if (p >= end) return 1;
+  *q++ = '\0';
+  p++;
+  type->literal = 1;
+  type->lang = NULL;
+  type->datatype_uri = NULL;
+  if (p < end && *p == '@') {
+    const char *start = ++p;
+    while (p < end && (*p == '-' || (*p >= 'a' && *p <= 'z') ||
+                       (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9')))
+      p++;
+    if (p == start) return 1;
+    memcpy(q, start, p - start);
+    type->lang = q;
+    q += p - start;
+    *q++ = '\0';
+  } else if (p + 1 < end && p[0] == '^' && p[1] == '^') {
+    p += 2;
+    if (p >= end || *p != '<') return 1;
+    type->datatype_uri = q;
+    if (parse_iri(&p, end, &q)) return 1;
+  }
+  *pp = p;
+  *out = q;
+  return 0;
+}
+
+/* Parses an IRI or blank node. */
+static int parse_node(const char **pp, const char *end, char **out)
+{
+  const char *p = *pp;
+  if (p < end && *p == '<') return parse_iri(pp, end, out);
+  if (p + 1 < end && p[0] == '_' && p[1] == ':')
+    return parse_bnode(pp, end, out);
+  return 1;
+}
+
+/* Skips whitespace. */
+static const char *skipws(const char *p, const char *end)
+{
+  while (p < end && ISWS(*p)) p++;
+  return p;
+}
+
+
+/* Parses a single line `line` of length `len` (excluding newline).
+   Returns non-zero on error. */
+static int parse_line(NTriplesParser *parser, const char *line, size_t len)
+{
+  const char *p = line, *end = line + len;
+  const char *s, *pred, *o, *g=NULL;
+  char *q;
+  TripleObjType type = {0, NULL, NULL};
+  int stat;
+
+  parser->lineno++;
+  p = skipws(p, end);
+  if (p >= end || *p == '#') return 0;
+
+  /* Unescaped terms are never longer than their escaped representation,
+     so the line length (plus NUL-terminators) is always sufficient. */
+  if (parser->bufsize < len + 8) {
+    size_t size = len + 8;
+    void *ptr;
+    if (size < 256) size = 256;
+    if (!(ptr = realloc(parser->buf, size)))
+      return err(1, "allocation failure");
+    parser->buf = ptr;
+    parser->bufsize = size;
+  }
+  q = parser->buf;
+
+  s = q;
+  if (parse_node(&p, end, &q)) goto fail;
+  p = skipws(p, end);
+  pred = q;
+  if (p >= end || *p != '<' || parse_iri(&p, end, &q)) goto fail;
+  p = skipws(p, end);
+  o = q;
+  if (p < end && *p == '"') {
+    if (parse_literal(&p, end, &q, &type)) goto fail;
+  } else {
+    if (parse_node(&p, end, &q)) goto fail;
+  }
+  p = skipws(p, end);
+  if (p < end && *p != '.') {
+    g = q;
+    if (parse_node(&p, end, &q)) goto fail;
+    p = skipws(p, end);
+  }
+  if (p >= end || *p != '.') goto fail;
+  p = skipws(p + 1, end);
+  if (p < end && *p != '#') goto fail;
+
+  if ((stat = parser->handler(parser->data, s, pred, o, &type, g)))
+    return stat;
+  parser->count++;
+  return 0;
+ fail:
+  return err(1, "invalid N-Triples statement on line %lu: %.*s",
+             (unsigned long)parser->lineno, (int)len, line);
+}
+
+
+/*
+  Returns a new N-Triples/N-Quads parser calling `handler` for each
+  parsed statement, or NULL on error.
+ */
+NTriplesParser *ntriples_parser_create(NTriplesHandler handler, void *data)
+{
+  NTriplesParser *parser;
+  if (!(parser = calloc(1, sizeof(NTriplesParser))))
+    return err(1, "allocation failure"), NULL;
+  parser->handler = handler;
+  parser->data = data;
+  return parser;
+}
+
+/*
+  Frees parser created with ntriples_parser_create().
+ */
+void ntriples_parser_free(NTriplesParser *parser)
+{
+  if (parser->line) free(parser->line);
+  if (parser->buf) free(parser->buf);
+  free(parser);
+}
+
+/* Appends `len` bytes from `s` to the incomplete line buffer. */
+static int append_line(NTriplesParser *parser, const char *s, size_t len)
+{
+  if (parser->linelen + len > parser->linesize) {
+    size_t size = (parser->linesize) ? parser->linesize : 256;
+    void *ptr;
+    while (size < parser->linelen + len) size *= 2;
+    if (!(ptr = realloc(parser->line, size)))
+      return err(1, "allocation failure");
+    parser->line = ptr;
+    parser->linesize = size;
+  }
+  memcpy(parser->line + parser->linelen, s, len);
+  parser->linelen += len;
+  return 0;
+}
+
+/*
+  Feeds `len` bytes from `chunk` to the parser.  Complete lines are
+  parsed immediately, while an incomplete last line is kept until the
+  next call.
+
+  Returns non-zero on error.
+ */
+int ntriples_parser_feed(NTriplesParser *parser, const char *chunk,
+                         size_t len)
+{
+  const char *p = chunk, *end = chunk + len, *nl;
+  int stat;
+  while (p < end && (nl = memchr(p, '\n', end - p))) {
+    if (parser->linelen) {
+      /* complete the line started in a previous chunk */
+      if (append_line(parser, p, nl - p)) return 1;
+      stat = parse_line(parser, parser->line, parser->linelen);
+      parser->linelen = 0;
+    } else {
+      /* parse directly from chunk */
+      stat = parse_line(parser, p, nl - p);
+    }
+    if (stat) return stat;
+    p = nl + 1;
+  }
+  if (p < end && append_line(parser, p, end - p)) return 1;
+  return 0;
+}
+
+/*
+  Parses any remaining input not terminated by a newline.  Should be
+  called after the last call to ntriples_parser_feed().
+
+  Returns non-zero on error.
+ */
+int ntriples_parser_finish(NTriplesParser *parser)
+{
+  int stat = 0;
+  if (parser->linelen) {
+    stat = parse_line(parser, parser->line, parser->linelen);
+    parser->linelen = 0;
+  }
+  return stat;
+}
+
+/*
+  Returns the number of statements parsed so far.
+ */
+size_t ntriples_parser_count(const NTriplesParser *parser)
+{
+  return parser->count;
+}
+
+
+/*
+  Parses N-Triples/N-Quads from stream `fp` in chunks of
+  NTRIPLES_CHUNKSIZE bytes, calling `handler` for each statement.
+
+  Returns the number of parsed statements or -1 on error.
+ */
+int ntriples_parse_file(FILE *fp, NTriplesHandler handler, void *data)
+{
+  NTriplesParser *parser=NULL;
+  char *chunk=NULL;
+  size_t n;
+  int retval=-1;
+  if (!(chunk = malloc(NTRIPLES_CHUNKSIZE))) {
+    err(1, "allocation failure");
+    goto fail;
+  }
+  if (!(parser = ntriples_parser_create(handler, data))) goto fail;
+  while ((n = fread(chunk, 1, NTRIPLES_CHUNKSIZE, fp)) > 0)
+    if (ntriples_parser_feed(parser, chunk, n)) goto fail;
+  if (ferror(fp)) {
+    err(1, "error reading N-Triples stream");
+    goto fail;
+  }
+  if (ntriples_parser_finish(parser)) goto fail;
+  retval = (int)parser->count;
+ fail:
+  if (parser) ntriples_parser_free(parser);
+  if (chunk) free(chunk);
+  return retval;
+}
+
+
+/* Writes IRI `iri` to `fp`, escaping characters not allowed in IRIs. */
+static void write_iri(FILE *fp, const char *iri)
+{
+  const unsigned char *p;
+  putc('<', fp);
+  for (p=(const unsigned char *)iri; *p; p++) {
+    if (*p <= 0x20 || strchr("<>\"{}|^`\\", *p))
+      fprintf(fp, "\\u%04X", *p);
+    else
+      putc(*p, fp);
+  }
+  putc('>', fp);
+}
+
+/* Writes IRI or blank node `node` to `fp`. */
+static void write_node(FILE *fp, const char *node)
+{
+  if (node[0] == '_' && node[1] == ':')
+    fputs(node, fp);
+  else
+    write_iri(fp, node);
+}
+
+/* Writes literal `value` to `fp`. */
+static void write_literal(FILE *fp, const char *value)
+{
+  const char *p;
+  putc('"', fp);
+  for (p=value; *p; p++) {
+    switch (*p) {
+    case '"':  fputs("\\\"", fp); break;
+    case '\\': fputs("\\\\", fp); break;
+    case '\n': fputs("\\n", fp);  break;
+    case '\r': fputs("\\r", fp);  break;
+    default:   putc(*p, fp);
+    }
+  }
+  putc('"', fp);
+}
+
+/*
+  Writes a single statement to `fp`.  If `type` is NULL, the object
+  is considered to be a literal with no language.  If `g` is not NULL,
+  a N-Quads statement is written.
+
+  Returns non-zero on error.
+ */
+int ntriples_write(FILE *fp, const char *s, const char *p, const char *o,
+                   const TripleObjType *type, const char *g)
+{
+  write_node(fp, s);
+  putc(' ', fp);
+  write_iri(fp, p);
+  putc(' ', fp);
+  if (!type || type->literal) {
+    write_literal(fp, o);
+    if (type && type->lang) {
+      putc('@', fp);
+      fputs(type->lang, fp);
+    } else if (type && type->datatype_uri) {
+      fputs("^^", fp);
+      write_iri(fp, type->datatype_uri);
+    }
+  } else {
+    write_node(fp, o);
+  }
+  if (g) {
+    putc(' ', fp);
+    write_node(fp, g);
+  }
+  fputs(" .\n", fp);
+  if (ferror(fp)) return err(1, "error writing N-Triples statement");
+  return 0;
+}
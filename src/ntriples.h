@@ -0,0 +1,112 @@
+/**
+  @file
+  @brief Streaming parser and serialiser for N-Triples and N-Quads.
+
+  The parser is push-based.  Input is fed in chunks of arbitrary size
+  with ntriples_parser_feed() and a handler is called for each parsed
+  statement.  Only the current (incomplete) line is kept in memory, so
+  arbitrary large documents can be parsed in bounded memory.
+
+  Terms are passed to the handler in the following form:
+    - IRIs without the enclosing angle brackets
+    - blank nodes including the "_:" prefix
+    - literals unescaped and without quotes, with language and datatype
+      described by a TripleObjType
+
+  See https://www.w3.org/TR/n-triples/ and https://www.w3.org/TR/n-quads/
+ */
+#ifndef _NTRIPLES_H
+#define _NTRIPLES_H
+
+#include <stdio.h>
+
+#include "triplestore.h"
+
+/** Default size of chunks read by ntriples_parse_file(). */
+#define NTRIPLES_CHUNKSIZE 65536
+
+
+/** Opaque parser type. */
+typedef struct _NTriplesParser NTriplesParser;
+
+
+/**
+  Prototype for handler called for each statement.
+
+  Arguments:
+    data:  Pointer to user data passed to ntriples_parser_create().
+    s:     Subject.
+    p:     Predicate.
+    o:     Object.
+    type:  Type of the object.
+    g:     Graph label for N-Quads or NULL if no graph is given.
+
+  The strings are only valid during the call.
+
+  Should return zero on success.  A non-zero return value stops the
+  parsing and is returned by ntriples_parser_feed().
+ */
+typedef int (*NTriplesHandler)(void *data, const char *s, const char *p,
+                               const char *o, const TripleObjType *type,
+                               const char *g);
+
+
+/**
+  Returns a new N-Triples/N-Quads parser calling `handler` for each
+  parsed statement, or NULL on error.
+ */
+NTriplesParser *ntriples_parser_create(NTriplesHandler handler, void *data);
+
+/**
+  Frees parser created with ntriples_parser_create().
+ */
+void ntriples_parser_free(NTriplesParser *parser);
+
+/**
+  Feeds `len` bytes from `chunk` to the parser.  Complete lines are
+  parsed immediately, while an incomplete last line is kept until the
+  next call.
+
+  Returns non-zero on error.
+ */
+int ntriples_parser_feed(NTriplesParser *parser, const char *chunk,
+                         size_t len);
+
+/**
+  Parses any remaining input not terminated by a newline.  Should be
+  called after the last call to ntriples_parser_feed().
+
+  Returns non-zero on error.
+ */
+int ntriples_parser_finish(NTriplesParser *parser);
+
+/**
+  Returns the number of statements parsed so far.
+ */
+size_t ntriples_parser_count(const NTriplesParser *parser);
+
+
+/**
+  Parses N-Triples/N-Quads from stream `fp` in chunks of
+  NTRIPLES_CHUNKSIZE bytes, calling `handler` for each statement.
+
+  Returns the number of parsed statements or -1 on error.
+ */
+int ntriples_parse_file(FILE *fp, NTriplesHandler handler, void *data);
+
+
+/**
+  Writes a single statement to `fp`.  If `type` is NULL, the object
+  is considered to be a literal with no language.  If `g` is not NULL,
+  a N-Quads statement is written.
+
+  Subjects, predicates, non-literal objects and graphs starting with
+  "_:" are written as blank nodes.  Everything else is written as IRIs.
+
+  Returns non-zero on error.
+ */
+int ntriples_write(FILE *fp, const char *s, const char *p, const char *o,
+                   const TripleObjType *type, const char *g);
+
+
+#endif /* _NTRIPLES_H */
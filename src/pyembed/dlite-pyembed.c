@@ -1,4 +1,6 @@
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "dlite-macros.h"
 #include "dlite-misc.h"
@@ -6,6 +8,8 @@
 #include "dlite-python-storage.h"
 #include "dlite-python-mapping.h"
 #include "config-paths.h"
+#include "utils/sha3.h"
+#include "utils/tmpfileplus.h"
 
 /* Get rid of MSVS warnings */
 #if defined WIN32 || defined _WIN32 || defined __WIN32__
@@ -15,17 +19,44 @@
 
 static int python_initialized = 0;
 
+/* Thread state of the thread that initialised the embedded interpreter.
+   NULL if Python was already initialised (e.g. when dlite is imported
+   from Python). */
+static PyThreadState *main_thread_state = NULL;
+
+/* Cached references to attributes of the dlite Python package.  They
+   are only valid for the interpreter stored in `cache_interp`. */
+static PyInterpreterState *cache_interp = NULL;
+static PyObject *cached_get_instance = NULL;
+static PyObject *cached_from_c_ptr = NULL;
+
+/* Returns the current interpreter.  The GIL must be held. */
+#if PY_VERSION_HEX >= 0x03090000
+#define current_interp() PyInterpreterState_Get()
+#else
+#define current_interp() (PyThreadState_Get()->interp)
+#endif
+
 /* Initialises the embedded Python environment. */
 void dlite_pyembed_initialise(void)
 {
   wchar_t *progname;
   if (!python_initialized) {
+    PyGILState_STATE gstate;
     python_initialized = 1;
 
-    Py_Initialize();
+    if (!Py_IsInitialized()) {
+      Py_Initialize();
+
+      /* Release the GIL held by the initialising thread, such that any
+         thread can acquire it with dlite_pyembed_gil_ensure() */
+      main_thread_state = PyEval_SaveThread();
+    }
+    gstate = PyGILState_Ensure();
 
     if (!(progname = Py_DecodeLocale("dlite", NULL))) {
       dlite_err(1, "allocation/decoding failure");
+      PyGILState_Release(gstate);
       return;
     }
     Py_SetProgramName(progname);
@@ -48,6 +79,7 @@ void dlite_pyembed_initialise(void)
       Py_XDECREF(sys_path);
       Py_XDECREF(path);
     }
+    PyGILState_Release(gstate);
   }
 }
 
@@ -56,6 +88,17 @@ int dlite_pyembed_finalise(void)
 {
   int status=0;
   if (python_initialized) {
+    /* Py_FinalizeEx() must be called by the initialising thread with
+       the GIL held */
+    if (main_thread_state) {
+      PyEval_RestoreThread(main_thread_state);
+      main_thread_state = NULL;
+    }
+    if (cache_interp == current_interp()) {
+      Py_CLEAR(cached_get_instance);
+      Py_CLEAR(cached_from_c_ptr);
+      cache_interp = NULL;
+    }
     status = Py_FinalizeEx();
     python_initialized = 0;
   } else {
@@ -65,6 +108,27 @@ int dlite_pyembed_finalise(void)
 }
 
 
+/*
+  Ensures that the calling thread holds the Python GIL and returns the
+  previous GIL state.  The embedded Python environment is initialised
+  if needed.
+*/
+PyGILState_STATE dlite_pyembed_gil_ensure(void)
+{
+  dlite_pyembed_initialise();
+  return PyGILState_Ensure();
+}
+
+/*
+  Restores the GIL state to `state`, as returned by
+  dlite_pyembed_gil_ensure().
+*/
+void dlite_pyembed_gil_release(PyGILState_STATE state)
+{
+  PyGILState_Release(state);
+}
+
+
 /*
   Returns a static pointer to the class name of python object cls or
   NULL on error.
@@ -278,36 +342,78 @@ void *dlite_pyembed_get_address(const char *symbol)
 }
 
 
+/*
+  Returns a borrowed reference to attribute `name` of the dlite Python
+  package or NULL on error.  The attribute is looked up once per
+  interpreter and stored in `*cache`.
+*/
+static PyObject *get_dlite_attr(const char *name, PyObject **cache)
+{
+  PyObject *module;
+  PyInterpreterState *interp = current_interp();
+
+  /* Forget (without decref'ing) references from a previous interpreter */
+  if (interp != cache_interp) {
+    cached_get_instance = NULL;
+    cached_from_c_ptr = NULL;
+    cache_interp = interp;
+  }
+  if (!*cache) {
+    if (!(module = PyImport_ImportModule("dlite")))
+      return dlite_pyembed_err(1, "cannot import Python package: dlite"),
+        NULL;
+    *cache = PyObject_GetAttrString(module, name);
+    Py_DECREF(module);
+    if (!*cache)
+      return dlite_pyembed_err(1, "no such Python attribute: dlite.%s",
+                               name), NULL;
+  }
+  return *cache;
+}
+
+
 /*
   Returns a Python representation of dlite instance with given id or NULL
   on error.
 */
 PyObject *dlite_pyembed_from_instance(const char *id)
 {
-  PyObject *pyid=NULL, *dlite_name=NULL, *dlite_module=NULL, *dlite_dict=NULL;
-  PyObject *get_instance=NULL, *instance=NULL;
+  PyObject *pyid=NULL, *get_instance, *instance=NULL;
 
+  if (!(get_instance = get_dlite_attr("get_instance", &cached_get_instance)))
+    goto fail;
   if (!(pyid = PyUnicode_FromString(id)))
     FAIL("cannot create python string");
-
-  /* Import dlite */
-  if (!(dlite_name = PyUnicode_FromString("dlite")) ||
-      !(dlite_module = PyImport_Import(dlite_name)))
-    FAIL("cannot import Python package: dlite");
-
-  /* Get reference to Python function get_instance() */
-  if (!(dlite_dict = PyModule_GetDict(dlite_module)) ||
-      !(get_instance = PyDict_GetItemString(dlite_dict, "get_instance")))
-    FAIL("no such Python function: dlite.get_instance()");
-
-  /* Call get_instance() */
   if (!(instance = PyObject_CallFunctionObjArgs(get_instance, pyid, NULL)))
     FAIL("failure calling dlite.get_instance()");
 
  fail:
   Py_XDECREF(pyid);
-  Py_XDECREF(dlite_module);
-  Py_XDECREF(dlite_name);
+  return instance;
+}
+
+
+/*
+  Returns a Python representation of dlite instance `inst` or NULL on
+  error.
+
+  Unlike dlite_pyembed_from_instance(), the instance is wrapped
+  directly from its pointer, without looking it up in the instance
+  store.
+*/
+PyObject *dlite_pyembed_from_instance_ptr(const DLiteInstance *inst)
+{
+  PyObject *from_c_ptr, *cap=NULL, *instance=NULL;
+
+  if (!(from_c_ptr = get_dlite_attr("_from_c_ptr", &cached_from_c_ptr)))
+    goto fail;
+  if (!(cap = PyCapsule_New((void *)inst, NULL, NULL)))
+    FAIL("cannot create capsule");
+  if (!(instance = PyObject_CallFunctionObjArgs(from_c_ptr, cap, NULL)))
+    dlite_pyembed_err(1, "failure calling dlite._from_c_ptr()");
+
+ fail:
+  Py_XDECREF(cap);
   return instance;
 }
 
@@ -338,6 +444,55 @@ DLiteInstance *dlite_pyembed_get_instance(PyObject *pyinst)
 }
 
 
+/*
+  Compiles and executes the Python source file `path` in the namespace
+  `dict`, with `__file__` set to `path`.
+
+  The source is compiled with the importlib machinery, such that the
+  bytecode is cached in `__pycache__` and the source only is parsed
+  again when it has changed.
+
+  Returns non-zero on error.
+ */
+static int run_plugin_file(PyObject *dict, const char *path)
+{
+  int retval=1;
+  char *modname=NULL, *ext;
+  PyObject *ppath=NULL, *machinery=NULL, *loader=NULL, *code=NULL, *ret=NULL;
+
+  if (!(ppath = PyUnicode_FromString(path)))
+    FAIL1("cannot create Python string from path: '%s'", path);
+  if (PyDict_SetItemString(dict, "__file__", ppath))
+    FAIL("cannot assign path to '__file__' in dict of main module");
+
+  /* The module name is only used in error messages */
+  if (!(modname = fu_basename(path))) goto fail;
+  if ((ext = strrchr(modname, '.'))) *ext = '\0';
+
+  if (!(machinery = PyImport_ImportModule("importlib.machinery")))
+    FAIL("cannot import importlib.machinery");
+  if (!(loader = PyObject_CallMethod(machinery, "SourceFileLoader", "ss",
+                                     modname, path)) ||
+      !(code = PyObject_CallMethod(loader, "get_code", "s", modname))) {
+    dlite_pyembed_err(1, "error compiling '%s'", path);
+    goto fail;
+  }
+  if (!(ret = PyEval_EvalCode(code, dict, dict))) {
+    dlite_pyembed_err(1, "error parsing '%s'", path);
+    goto fail;
+  }
+  retval = 0;
+ fail:
+  if (modname) free(modname);
+  Py_XDECREF(ret);
+  Py_XDECREF(code);
+  Py_XDECREF(loader);
+  Py_XDECREF(machinery);
+  Py_XDECREF(ppath);
+  return retval;
+}
+
+
 /*
   This function loads all Python modules found in `paths` and returns
   a list of plugin objects.
@@ -352,13 +507,14 @@ PyObject *dlite_pyembed_load_plugins(FUPaths *paths, const char *baseclassname)
   char initcode[96];
   const char *path;
   PyObject *baseclass=NULL, *main_module=NULL, *main_dict=NULL;
-  PyObject *ppath=NULL, *pfun=NULL, *subclasses=NULL, *lst=NULL;
+  PyObject *pfun=NULL, *subclasses=NULL, *lst=NULL;
   PyObject *subclassnames=NULL;
   FUIter *iter;
   int i;
+  PyGILState_STATE gstate;
 
   dlite_errclr();
-  dlite_pyembed_initialise();
+  gstate = dlite_pyembed_gil_ensure();
 
   /* Inject base class into the __main__ module */
   if (snprintf(initcode, sizeof(initcode), "class %s: pass\n",
@@ -397,29 +553,8 @@ PyObject *dlite_pyembed_load_plugins(FUPaths *paths, const char *baseclassname)
 
   /* Load all modules in `paths` */
   if (!(iter = fu_pathsiter_init(paths, "*.py"))) goto fail;
-  while ((path = fu_pathsiter_next(iter))) {
-    int stat;
-    FILE *fp=NULL;
-    char *basename=NULL;
-
-    if (!(ppath = PyUnicode_FromString(path)))
-      FAIL1("cannot create Python string from path: '%s'", path);
-    stat = PyDict_SetItemString(main_dict, "__file__", ppath);
-    Py_DECREF(ppath);
-    if (stat) FAIL("cannot assign path to '__file__' in dict of main module");
-
-    if ((basename = fu_basename(path)) && (fp = fopen(path, "r"))) {
-      PyObject *ret = PyRun_File(fp, basename, Py_file_input, main_dict,
-                                 main_dict);
-      free(basename);
-      if (!ret) {
-        dlite_pyembed_err(1, "error parsing '%s'", path);
-      } else {
-        Py_DECREF(ret);
-      }
-      fclose(fp);
-    }
-  }
+  while ((path = fu_pathsiter_next(iter)))
+    run_plugin_file(main_dict, path);
   if (fu_pathsiter_deinit(iter)) goto fail;
 
   /* Append new subclasses to the list of Python plugins that will be
@@ -447,5 +582,512 @@ PyObject *dlite_pyembed_load_plugins(FUPaths *paths, const char *baseclassname)
  fail:
   Py_XDECREF(lst);
   Py_XDECREF(subclassnames);
+  dlite_pyembed_gil_release(gstate);
   return subclasses;
 }
+
+
+/**********************************************
+ ** Plugin manifest
+ **********************************************/
+
+/* First line of manifest cache files */
+#define MANIFEST_HEADER "# dlite python plugin manifest v1"
+
+/* Growable array of manifest entries */
+typedef struct {
+  DLitePyembedPluginEntry *entries;
+  size_t n;
+  size_t size;
+} Manifest;
+
+/* Frees all entries in `m`. */
+static void manifest_clear(Manifest *m)
+{
+  dlite_pyembed_plugin_manifest_free(m->entries, m->n);
+  memset(m, 0, sizeof(Manifest));
+}
+
+/* Appends a new entry to `m`.  `classname`, `name` and `attrs` are
+   NULL for source files that define no plugins.
+   Returns non-zero on error. */
+static int manifest_add(Manifest *m, const char *hash, const char *path,
+                        const char *classname, const char *name,
+                        const char *attrs)
+{
+  DLitePyembedPluginEntry *e;
+  if (m->n >= m->size) {
+    size_t size = m->size + 16;
+    if (!(e = realloc(m->entries, size*sizeof(DLitePyembedPluginEntry))))
+      return dlite_err(1, "allocation failure");
+    m->entries = e;
+    m->size = size;
+  }
+  e = m->entries + m->n;
+  memset(e, 0, sizeof(DLitePyembedPluginEntry));
+  strncpy(e->hash, hash, sizeof(e->hash) - 1);
+  if (!(e->path = strdup(path)) ||
+      (classname && !(e->classname = strdup(classname))) ||
+      (name && !(e->name = strdup(name))) ||
+      (attrs && !(e->attrs = strdup(attrs)))) {
+    free(e->path);
+    free(e->classname);
+    free(e->name);
+    return dlite_err(1, "allocation failure");
+  }
+  m->n++;
+  return 0;
+}
+
+/* Returns a newly malloc'ed path to the manifest cache file for
+   plugins with base class `baseclassname` or NULL if the cache is
+   disabled.
+
+   The cache directory is given by the DLITE_PYTHON_PLUGIN_CACHE_DIR
+   environment variable.  If it is unset, the user cache directory is
+   used.  If it is set to an empty string, the cache is disabled. */
+static char *manifest_path(const char *baseclassname)
+{
+  char filename[128];
+  const char *dir;
+  snprintf(filename, sizeof(filename), "%s.manifest", baseclassname);
+  if ((dir = getenv("DLITE_PYTHON_PLUGIN_CACHE_DIR")))
+    return (*dir) ? fu_join(dir, filename, NULL) : NULL;
+  if ((dir = getenv("XDG_CACHE_HOME")) && *dir)
+    return fu_join(dir, "dlite", filename, NULL);
+  if ((dir = getenv("LOCALAPPDATA")) && *dir)
+    return fu_join(dir, "dlite", filename, NULL);
+  if ((dir = getenv("HOME")) && *dir)
+    return fu_join(dir, ".cache", "dlite", filename, NULL);
+  return NULL;
+}
+
+/* Reads manifest cache file `filename` into `m`.  Malformed lines
+   are ignored.  Returns non-zero if the file cannot be read. */
+static int manifest_read(Manifest *m, const char *filename)
+{
+  FILE *fp;
+  char *buf, *line, *next;
+  if (!(fp = fopen(filename, "r"))) return 1;
+  buf = fu_readfile(fp);
+  fclose(fp);
+  if (!buf) return 1;
+  if (strncmp(buf, MANIFEST_HEADER "\n", strlen(MANIFEST_HEADER) + 1) == 0) {
+    for (line=buf; line && *line; line=next) {
+      char *field[5];
+      int i;
+      if ((next = strchr(line, '\n'))) *(next++) = '\0';
+      if (line[0] == '#') continue;
+      for (i=0, field[0]=line; i < 4 && field[i]; i++)
+        if ((field[i+1] = strchr(field[i], '\t'))) *(field[i+1]++) = '\0';
+      if (i < 4 || !field[4] || strlen(field[0]) != 64) continue;
+      if (field[2][0])
+        manifest_add(m, field[0], field[1], field[2], field[3], field[4]);
+      else
+        manifest_add(m, field[0], field[1], NULL, NULL, NULL);
+    }
+  }
+  free(buf);
+  return 0;
+}
+
+/* Writes entries in `m` followed by the entries in `cached` that
+   refer to source files not in `m` to manifest cache file `filename`.
+
+   The manifest is written to a temporary file in the same directory,
+   which is then renamed to `filename`.  Hence, other processes never
+   see a partly written manifest.  Returns non-zero on error. */
+static int manifest_write(const Manifest *m, const Manifest *cached,
+                          const char *filename)
+{
+  FILE *fp=NULL;
+  size_t i, j;
+  int retval=1, stat;
+  char *dir, *tmpname=NULL;
+  PyObject *os, *ret=NULL;
+
+  if (!(dir = fu_dirname(filename))) goto fail;
+
+  /* Ensure that the cache directory exists */
+  if ((os = PyImport_ImportModule("os"))) {
+    ret = PyObject_CallMethod(os, "makedirs", "sO", dir, Py_True);
+    Py_DECREF(os);
+  }
+  Py_XDECREF(ret);
+  PyErr_Clear();
+
+  if (!(fp = tmpfileplus(dir, "manifest.", &tmpname, 1)))
+    FAIL1("cannot create temporary plugin manifest in: %s", dir);
+  fprintf(fp, "%s\n", MANIFEST_HEADER);
+  for (i=0; i < m->n; i++) {
+    DLitePyembedPluginEntry *e = m->entries + i;
+    fprintf(fp, "%s\t%s\t%s\t%s\t%s\n", e->hash, e->path,
+            (e->classname) ? e->classname : "", (e->name) ? e->name : "",
+            (e->attrs) ? e->attrs : "");
+  }
+  for (i=0; i < cached->n; i++) {
+    DLitePyembedPluginEntry *e = cached->entries + i;
+    for (j=0; j < m->n; j++)
+      if (strcmp(e->path, m->entries[j].path) == 0) break;
+    if (j < m->n) continue;
+    fprintf(fp, "%s\t%s\t%s\t%s\t%s\n", e->hash, e->path,
+            (e->classname) ? e->classname : "", (e->name) ? e->name : "",
+            (e->attrs) ? e->attrs : "");
+  }
+  stat = ferror(fp);
+  if (fclose(fp) || stat) {
+    fp = NULL;
+    FAIL1("cannot write plugin manifest: %s", tmpname);
+  }
+  fp = NULL;
+
+#if defined WIN32 || defined _WIN32 || defined __WIN32__
+  /* rename() does not replace existing files on Windows */
+  remove(filename);
+#endif
+  if (rename(tmpname, filename))
+    FAIL1("cannot write plugin manifest: %s", filename);
+  retval = 0;
+ fail:
+  if (fp) fclose(fp);
+  if (tmpname) {
+    if (retval) remove(tmpname);
+    free(tmpname);
+  }
+  if (dir) free(dir);
+  return retval;
+}
+
+/* Writes the hex-encoded sha3-256 hash of the content of file `path`
+   to `hash`, which must have space for 65 bytes.
+   Returns non-zero on error. */
+static int hash_file(const char *path, char *hash)
+{
+  FILE *fp;
+  char *buf;
+  sha3_context c;
+  const unsigned char *digest;
+  int i;
+  if (!(fp = fopen(path, "rb")))
+    return dlite_err(1, "cannot open plugin: %s", path);
+  buf = fu_readfile(fp);
+  fclose(fp);
+  if (!buf) return dlite_err(1, "cannot read plugin: %s", path);
+  sha3_Init256(&c);
+  sha3_Update(&c, buf, strlen(buf));
+  digest = sha3_Finalize(&c);
+  free(buf);
+  for (i=0; i < 32; i++) sprintf(hash + 2*i, "%02x", digest[i]);
+  return 0;
+}
+
+/* Returns a borrowed reference to the base class `baseclassname` in
+   the __main__ module.  It is created if it does not exist.  If
+   `main_dict` is not NULL, a borrowed reference to the dict of the
+   __main__ module is written to it.  Returns NULL on error. */
+static PyObject *get_baseclass(const char *baseclassname,
+                               PyObject **main_dict)
+{
+  char initcode[96];
+  PyObject *main_module, *dict, *baseclass;
+  if (!(main_module = PyImport_AddModule("__main__")))
+    return dlite_err(1, "cannot load the embedded Python __main__ module"),
+      NULL;
+  if (!(dict = PyModule_GetDict(main_module)))
+    return dlite_err(1, "cannot access __dict__ of the embedded Python "
+                     "__main__ module"), NULL;
+  if (!(baseclass = PyDict_GetItemString(dict, baseclassname))) {
+    snprintf(initcode, sizeof(initcode), "class %s: pass\n", baseclassname);
+    if (PyRun_SimpleString(initcode) ||
+        !(baseclass = PyDict_GetItemString(dict, baseclassname)))
+      return dlite_err(1, "cannot create base class '%s'", baseclassname),
+        NULL;
+  }
+  if (main_dict) *main_dict = dict;
+  return baseclass;
+}
+
+/* Returns a new reference to a list of the current subclasses of
+   `baseclass` or NULL on error. */
+static PyObject *get_subclasses(PyObject *baseclass)
+{
+  PyObject *lst = PyObject_CallMethod(baseclass, "__subclasses__", NULL);
+  if (!lst || !PyList_Check(lst)) {
+    Py_XDECREF(lst);
+    return dlite_pyembed_err(1, "cannot get subclasses of plugin base class"),
+      NULL;
+  }
+  return lst;
+}
+
+/* Adds a manifest entry to `m` for plugin class `cls` defined in
+   `path`.  Returns non-zero on error. */
+static int add_class_entry(Manifest *m, const char *hash, const char *path,
+                           PyObject *cls)
+{
+  int retval=1;
+  Py_ssize_t i;
+  const char *classname, *name, *attrs;
+  PyObject *pclassname=NULL, *pname=NULL, *names=NULL, *lst=NULL;
+  PyObject *sep=NULL, *pattrs=NULL;
+
+  if (!(pclassname = PyObject_GetAttrString(cls, "__name__")) ||
+      !(classname = PyUnicode_AsUTF8(pclassname)))
+    FAIL("cannot get name of plugin class");
+  if (!(pname = PyObject_GetAttrString(cls, "name")) ||
+      !PyUnicode_Check(pname)) {
+    PyErr_Clear();
+    Py_XDECREF(pname);
+    pname = pclassname;
+    Py_INCREF(pname);
+  }
+  if (!(name = PyUnicode_AsUTF8(pname)))
+    FAIL1("cannot get name of plugin class %s", classname);
+
+  /* Callable public attributes of the class */
+  if (!(names = PyObject_Dir(cls)) || !(lst = PyList_New(0)))
+    FAIL1("cannot list attributes of plugin class %s", classname);
+  for (i=0; i < PyList_Size(names); i++) {
+    PyObject *attr, *item = PyList_GetItem(names, i);
+    const char *s = PyUnicode_AsUTF8(item);
+    if (!s || s[0] == '_') continue;
+    if (!(attr = PyObject_GetAttr(cls, item))) {
+      PyErr_Clear();
+      continue;
+    }
+    if (PyCallable_Check(attr) && PyList_Append(lst, item))
+      FAIL("cannot append to list");
+    Py_DECREF(attr);
+  }
+  if (!(sep = PyUnicode_FromString(" ")) ||
+      !(pattrs = PyUnicode_Join(sep, lst)) ||
+      !(attrs = PyUnicode_AsUTF8(pattrs)))
+    FAIL1("cannot join attribute names of plugin class %s", classname);
+
+  retval = manifest_add(m, hash, path, classname, name, attrs);
+ fail:
+  if (retval) PyErr_Clear();
+  Py_XDECREF(pattrs);
+  Py_XDECREF(sep);
+  Py_XDECREF(lst);
+  Py_XDECREF(names);
+  Py_XDECREF(pname);
+  Py_XDECREF(pclassname);
+  return retval;
+}
+
+/* Executes the Python source file `path` and adds an entry to `m` for
+   each new subclass of `baseclass`.  If no subclasses are defined, an
+   entry without classname is added, such that the file isn't executed
+   again until it is changed.  Returns non-zero on error. */
+static int discover_plugins(Manifest *m, PyObject *main_dict,
+                            PyObject *baseclass, const char *path,
+                            const char *hash)
+{
+  int retval=1;
+  size_t n = m->n;
+  Py_ssize_t i;
+  PyObject *before=NULL, *after=NULL;
+
+  if (!(before = get_subclasses(baseclass))) goto fail;
+  if (run_plugin_file(main_dict, path)) goto fail;
+  if (!(after = get_subclasses(baseclass))) goto fail;
+  for (i=0; i < PyList_Size(after); i++) {
+    PyObject *cls = PyList_GetItem(after, i);
+    int stat = PySequence_Contains(before, cls);
+    if (stat < 0) FAIL("cannot check for subclass");
+    if (!stat && add_class_entry(m, hash, path, cls)) goto fail;
+  }
+  if (m->n == n && manifest_add(m, hash, path, NULL, NULL, NULL)) goto fail;
+  retval = 0;
+ fail:
+  Py_XDECREF(after);
+  Py_XDECREF(before);
+  return retval;
+}
+
+
+/*
+  Returns a newly allocated array with the manifest of the Python
+  plugins in `paths` that are subclasses of `baseclassname`.  The
+  number of entries is written to `*nentries`.
+
+  Returns NULL on error.
+ */
+DLitePyembedPluginEntry *dlite_pyembed_plugin_manifest(FUPaths *paths,
+                                                       const char *baseclassname,
+                                                       size_t *nentries)
+{
+  Manifest m, cached;
+  DLitePyembedPluginEntry *retval=NULL;
+  PyObject *baseclass=NULL, *main_dict=NULL;
+  char *filename=NULL, hash[65];
+  const char *path;
+  FUIter *iter;
+  size_t i, j;
+  int modified=0;
+  PyGILState_STATE gstate;
+
+  memset(&m, 0, sizeof(Manifest));
+  memset(&cached, 0, sizeof(Manifest));
+  dlite_errclr();
+  gstate = dlite_pyembed_gil_ensure();
+
+  if ((filename = manifest_path(baseclassname)))
+    manifest_read(&cached, filename);
+
+  if (!(iter = fu_pathsiter_init(paths, "*.py"))) goto fail;
+  while ((path = fu_pathsiter_next(iter))) {
+    size_t n = m.n;
+    if (hash_file(path, hash)) continue;
+
+    /* Reuse cached entries if the source file is unchanged */
+    for (i=0; i < cached.n; i++) {
+      DLitePyembedPluginEntry *e = cached.entries + i;
+      if (strcmp(e->hash, hash) == 0 && strcmp(e->path, path) == 0 &&
+          manifest_add(&m, e->hash, e->path, e->classname, e->name, e->attrs))
+        break;
+    }
+    if (m.n > n) continue;
+
+    if (!baseclass && !(baseclass = get_baseclass(baseclassname, &main_dict)))
+      break;
+    if (discover_plugins(&m, main_dict, baseclass, path, hash) == 0)
+      modified = 1;
+  }
+  if (fu_pathsiter_deinit(iter)) goto fail;
+
+  /* Update the manifest cache */
+  if (filename && modified)
+    manifest_write(&m, &cached, filename);
+
+  /* Remove entries for source files without plugins */
+  for (i=0, j=0; i < m.n; i++) {
+    if (m.entries[i].classname)
+      m.entries[j++] = m.entries[i];
+    else
+      dlite_pyembed_plugin_manifest_free(m.entries + i, 1);
+  }
+  m.n = j;
+
+  if (!m.entries && !(m.entries = calloc(1, sizeof(DLitePyembedPluginEntry))))
+    FAIL("allocation failure");
+  *nentries = m.n;
+  retval = m.entries;
+  memset(&m, 0, sizeof(Manifest));
+ fail:
+  manifest_clear(&m);
+  manifest_clear(&cached);
+  if (filename) free(filename);
+  dlite_pyembed_gil_release(gstate);
+  return retval;
+}
+
+/*
+  Frees the `n` manifest entries in `entries`.
+ */
+void dlite_pyembed_plugin_manifest_free(DLitePyembedPluginEntry *entries,
+                                        size_t n)
+{
+  size_t i;
+  if (!entries) return;
+  for (i=0; i < n; i++) {
+    DLitePyembedPluginEntry *e = entries + i;
+    free(e->path);
+    free(e->classname);
+    free(e->name);
+    free(e->attrs);
+  }
+  free(entries);
+}
+
+/*
+  Returns non-zero if plugin `entry` has a callable attribute `attr`.
+ */
+int dlite_pyembed_plugin_has_attr(const DLitePyembedPluginEntry *entry,
+                                  const char *attr)
+{
+  size_t len = strlen(attr);
+  const char *p = entry->attrs;
+  while (p && *p) {
+    if (strncmp(p, attr, len) == 0 && (p[len] == ' ' || p[len] == '\0'))
+      return 1;
+    if ((p = strchr(p, ' '))) p++;
+  }
+  return 0;
+}
+
+/* Returns non-zero if class `cls` is defined in the Python source file
+   `path`.  Plugins are executed in the __main__ module, so neither the
+   `__module__` attribute of the class nor the `__file__` attribute of
+   its module tell where it is defined.  Instead, `path` is compared to
+   the file name of the code of the functions in the class body.  If
+   the class has no such functions, it is assumed to be defined in
+   `path`. */
+static int class_defined_in(PyObject *cls, const char *path)
+{
+  PyObject *key, *value;
+  Py_ssize_t pos=0;
+  int found=-1;
+  if (!PyType_Check(cls) || !((PyTypeObject *)cls)->tp_dict) return 1;
+  while (found < 0 && PyDict_Next(((PyTypeObject *)cls)->tp_dict, &pos,
+                                  &key, &value)) {
+    PyObject *func=NULL, *code=NULL, *filename=NULL;
+    const char *s;
+    if (!(func = PyObject_GetAttrString(value, "__func__"))) {
+      PyErr_Clear();
+      func = value;
+      Py_INCREF(func);
+    }
+    if ((code = PyObject_GetAttrString(func, "__code__")) &&
+        (filename = PyObject_GetAttrString(code, "co_filename")) &&
+        (s = PyUnicode_AsUTF8(filename)))
+      found = (strcmp(s, path) == 0);
+    PyErr_Clear();
+    Py_XDECREF(filename);
+    Py_XDECREF(code);
+    Py_DECREF(func);
+  }
+  return found != 0;
+}
+
+/*
+  Returns a new reference to the plugin class `classname` defined in
+  the Python source file `path`.  The file is only executed if the
+  class has not already been loaded.
+
+  Returns NULL on error.
+ */
+PyObject *dlite_pyembed_load_plugin_class(const char *path,
+                                          const char *classname,
+                                          const char *baseclassname)
+{
+  PyObject *baseclass, *main_dict, *lst=NULL, *cls=NULL;
+  Py_ssize_t i;
+  int pass;
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
+
+  if (!(baseclass = get_baseclass(baseclassname, &main_dict))) goto fail;
+  for (pass=0; pass < 2 && !cls; pass++) {
+    if (pass && run_plugin_file(main_dict, path)) goto fail;
+    Py_XDECREF(lst);
+    if (!(lst = get_subclasses(baseclass))) goto fail;
+    for (i=PyList_Size(lst)-1; i >= 0; i--) {
+      PyObject *item = PyList_GetItem(lst, i);
+      PyObject *name = PyObject_GetAttrString(item, "__name__");
+      const char *s = (name) ? PyUnicode_AsUTF8(name) : NULL;
+      if (s && strcmp(s, classname) == 0 && class_defined_in(item, path)) {
+        cls = item;
+        Py_INCREF(cls);
+      }
+      Py_XDECREF(name);
+      if (cls) break;
+    }
+  }
+  if (!cls)
+    dlite_err(1, "no plugin class '%s' in '%s'", classname, path);
+ fail:
+  Py_XDECREF(lst);
+  dlite_pyembed_gil_release(gstate);
+  return cls;
+}
@@ -5,6 +5,14 @@
   @file
   @brief Shared code between plugins that embed Python
 
+  When dlite initialises the embedded interpreter, the initialising
+  thread releases the Python global interpreter lock (GIL), such that
+  plugins may be called from any thread.  C code calling into Python
+  must therefore hold the GIL, either by wrapping the calls in
+  dlite_pyembed_gil_ensure() and dlite_pyembed_gil_release(), or
+  because it is called from Python.  Unless otherwise stated, the
+  functions below that take or return Python objects expect the
+  caller to hold the GIL.
  */
 
 #include <Python.h>
@@ -41,6 +49,20 @@ void dlite_pyembed_initialise(void);
 */
 int dlite_pyembed_finalise(void);
 
+/**
+  Ensures that the calling thread holds the Python GIL and returns the
+  previous GIL state, which should be passed to
+  dlite_pyembed_gil_release().  The embedded Python environment is
+  initialised if needed.  Calls may be nested.
+*/
+PyGILState_STATE dlite_pyembed_gil_ensure(void);
+
+/**
+  Restores the GIL state to `state`, as returned by
+  dlite_pyembed_gil_ensure().
+*/
+void dlite_pyembed_gil_release(PyGILState_STATE state);
+
 /**
   Returns a static pointer to the class name of python object cls or
   NULL on error.
@@ -90,6 +112,16 @@ void *dlite_pyembed_get_address(const char *symbol);
 */
 PyObject *dlite_pyembed_from_instance(const char *id);
 
+/**
+  Returns a Python representation of dlite instance `inst` or NULL on
+  error.
+
+  Unlike dlite_pyembed_from_instance(), the instance is wrapped
+  directly from its pointer, without looking it up in the instance
+  store.
+*/
+PyObject *dlite_pyembed_from_instance_ptr(const DLiteInstance *inst);
+
 /**
   Returns a new reference to DLite instance from Python representation
   or NULL on error.
@@ -104,9 +136,87 @@ DLiteInstance *dlite_pyembed_get_instance(PyObject *pyinst);
   A Python plugin is a subclass of `baseclassname` that implements the
   expected functionality.
 
+  The GIL is acquired by this function.
+
   Returns NULL on error.
  */
 PyObject *dlite_pyembed_load_plugins(FUPaths *paths, const char *baseclassname);
 
 
+/**
+  @name Plugin manifest
+
+  Executing all Python plugins at startup is expensive, since plugins
+  may import heavy modules (like pandas).  The plugin manifest records
+  the plugin classes defined in each source file together with the
+  sha3 hash of the file.  It is cached on disk, such that a source
+  file is only executed for building the manifest when it has changed.
+  The plugin classes can then be loaded on demand with
+  dlite_pyembed_load_plugin_class().
+
+  The manifest cache is stored in the directory given by the
+  `DLITE_PYTHON_PLUGIN_CACHE_DIR` environment variable.  If it is
+  unset, the user cache directory is used (`$XDG_CACHE_HOME/dlite`,
+  `%LOCALAPPDATA%\dlite` or `$HOME/.cache/dlite`).  Setting it to an
+  empty string disables the cache.
+
+  Plugin source files are compiled with the importlib machinery, such
+  that their bytecode is cached in `__pycache__`.
+ */
+/** @{ */
+
+/** Manifest entry describing a Python plugin class */
+typedef struct {
+  char hash[65];    /*!< Hex-encoded sha3-256 hash of the source file */
+  char *path;       /*!< Path to the source file */
+  char *classname;  /*!< Name of the plugin class */
+  char *name;       /*!< Plugin name: class attribute `name` or classname */
+  char *attrs;      /*!< Space-separated callable public class attributes */
+} DLitePyembedPluginEntry;
+
+/**
+  Returns a newly allocated array with the manifest of the Python
+  plugins in `paths` that are subclasses of `baseclassname`.  The
+  number of entries is written to `*nentries`.
+
+  Only source files that are not in the manifest cache, or have
+  changed since they were cached, are executed.
+
+  The GIL is acquired by this function.
+
+  Returns NULL on error.  The returned array should be free'ed with
+  dlite_pyembed_plugin_manifest_free().
+ */
+DLitePyembedPluginEntry *dlite_pyembed_plugin_manifest(FUPaths *paths,
+                                                       const char *baseclassname,
+                                                       size_t *nentries);
+
+/**
+  Frees the `n` manifest entries in `entries`.
+ */
+void dlite_pyembed_plugin_manifest_free(DLitePyembedPluginEntry *entries,
+                                        size_t n);
+
+/**
+  Returns non-zero if plugin `entry` has a callable attribute `attr`.
+ */
+int dlite_pyembed_plugin_has_attr(const DLitePyembedPluginEntry *entry,
+                                  const char *attr);
+
+/**
+  Returns a new reference to the plugin class `classname` defined in
+  the Python source file `path`.  The file is only executed if the
+  class has not already been loaded.
+
+  The GIL is acquired by this function.
+
+  Returns NULL on error.
+ */
+PyObject *dlite_pyembed_load_plugin_class(const char *path,
+                                          const char *classname,
+                                          const char *baseclassname);
+
+/** @} */
+
+
 #endif /* _DLITE_PYEMBED_H */
@@ -105,7 +105,7 @@ int dlite_python_mapping_paths_delete(int n)
 {
   const FUPaths *paths;
   if (!(paths = dlite_python_mapping_paths())) return -1;
-  return fu_paths_delete((FUPaths *)paths, n);
+  return fu_paths_delete_index((FUPaths *)paths, n);
 }
 
 /*
@@ -154,8 +154,10 @@ void *dlite_python_mapping_load(void)
 void dlite_python_mapping_unload(void)
 {
   if (loaded_mappings) {
+    PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
     Py_DECREF(loaded_mappings);
     loaded_mappings = NULL;
+    dlite_pyembed_gil_release(gstate);
   }
 }
 
@@ -171,15 +173,17 @@ static DLiteInstance *mapper(const DLiteMappingPlugin *api,
   DLiteInstance *inst=NULL;
   PyObject *map=NULL, *insts=NULL, *outinst=NULL, *pyuuid=NULL;
   PyObject *plugin = (PyObject *)api->data;
+  PyGILState_STATE gstate;
   assert(plugin);
   dlite_errclr();
+  gstate = dlite_pyembed_gil_ensure();
 
   /* Creates Python list of input instances */
   if (!(insts = PyList_New(n)))
     FAIL("failed to create list");
   for (i=0; i<n; i++) {
     PyObject *pyinst;
-    if (!(pyinst = dlite_pyembed_from_instance(instances[i]->uuid))) goto fail;
+    if (!(pyinst = dlite_pyembed_from_instance_ptr(instances[i]))) goto fail;
     PyList_SetItem(insts, i, pyinst);
   }
 
@@ -211,6 +215,7 @@ static DLiteInstance *mapper(const DLiteMappingPlugin *api,
   Py_XDECREF(map);
   for (i=0; i<n; i++) dlite_instance_decref((DLiteInstance *)instances[i]);
   if (inst) dlite_meta_decref((DLiteMeta *)inst->meta);  // @todo - correct?
+  dlite_pyembed_gil_release(gstate);
   return inst;
 }
 
@@ -223,7 +228,11 @@ static void freeapi(PluginAPI *api)
   free(p->name);
   free((char *)p->output_uri);
   free((char **)p->input_uris);
-  Py_XDECREF(p->data);
+  if (Py_IsInitialized()) {
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Py_XDECREF(p->data);
+    PyGILState_Release(gstate);
+  }
   free(p);
 }
 
@@ -281,8 +290,10 @@ const DLiteMappingPlugin *get_dlite_mapping_api(void *state, int *iter)
   PyObject *name=NULL, *out_uri=NULL, *in_uris=NULL, *map=NULL, *pcost=NULL;
   const char *output_uri=NULL, **input_uris=NULL, *classname=NULL;
   char *apiname=NULL;
+  PyGILState_STATE gstate;
 
   dlite_globals_set(state);
+  gstate = dlite_pyembed_gil_ensure();
 
   if (!(mappings = dlite_python_mapping_load())) goto fail;
   assert(PyList_Check(mappings));
@@ -365,5 +376,6 @@ const DLiteMappingPlugin *get_dlite_mapping_api(void *state, int *iter)
     if (input_uris) free((char **)input_uris);
     if (api) free(api);
   }
+  dlite_pyembed_gil_release(gstate);
   return retval;
 }
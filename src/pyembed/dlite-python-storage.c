@@ -4,11 +4,13 @@
 #include <Python.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* Python pulls in a lot of defines that conflicts with utils/config.h */
 #define SKIP_UTILS_CONFIG_H
 
 #include "config-paths.h"
+#include "pathshash.h"
 
 #include "dlite.h"
 #include "dlite-macros.h"
@@ -30,6 +32,9 @@ typedef struct {
   int initialised;            /* Whether `paths` is initiated */
   int modified;               /* Whether `paths` is modified */
   PyObject *loaded_storages;  /* Cache with all loaded python storage plugins */
+  DLitePyembedPluginEntry *manifest;  /* Manifest of storage plugins */
+  size_t nmanifest;           /* Number of entries in `manifest` */
+  unsigned char manifest_paths_hash[32];  /* Hash of paths in `manifest` */
 } PythonStorageGlobals;
 
 
@@ -38,9 +43,14 @@ static void free_globals(void *globals)
 {
   PythonStorageGlobals *g = (PythonStorageGlobals *)globals;
   if (g->initialised) fu_paths_deinit(&g->paths);
+  dlite_pyembed_plugin_manifest_free(g->manifest, g->nmanifest);
 
   /* Do not call Py_DECREF if we are in an atexit handler */
-  if (!dlite_globals_in_atexit()) Py_XDECREF(g->loaded_storages);
+  if (!dlite_globals_in_atexit() && g->loaded_storages && Py_IsInitialized()) {
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Py_DECREF(g->loaded_storages);
+    PyGILState_Release(gstate);
+  }
 
   free(g);
 }
@@ -145,7 +155,7 @@ int dlite_python_storage_paths_delete(int n)
   int stat;
   const FUPaths *paths;
   if (!(paths = dlite_python_storage_paths())) return -1;
-  if ((stat = fu_paths_delete((FUPaths *)paths, n))) {
+  if ((stat = fu_paths_delete_index((FUPaths *)paths, n))) {
     PythonStorageGlobals *g = get_globals();
     g->modified = 1;
   }
@@ -188,7 +198,42 @@ void dlite_python_storage_unload(void)
 {
   PythonStorageGlobals *g = get_globals();
   if (g->loaded_storages) {
+    PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
     Py_DECREF(g->loaded_storages);
     g->loaded_storages = NULL;
+    dlite_pyembed_gil_release(gstate);
+  }
+  if (g->manifest) {
+    dlite_pyembed_plugin_manifest_free(g->manifest, g->nmanifest);
+    g->manifest = NULL;
+    g->nmanifest = 0;
+  }
+}
+
+
+/*
+  Returns the manifest of the Python storage plugins (building it if
+  needed) and writes the number of entries to `*n`.
+
+  Returns NULL on error.
+*/
+const DLitePyembedPluginEntry *dlite_python_storage_manifest(size_t *n)
+{
+  PythonStorageGlobals *g = get_globals();
+  const FUPaths *paths;
+  unsigned char hash[32];
+  if (!(paths = dlite_python_storage_paths())) return NULL;
+  if (pathshash(hash, sizeof(hash), paths)) return NULL;
+  if (!g->manifest ||
+      memcmp(g->manifest_paths_hash, hash, sizeof(hash)) != 0) {
+    dlite_pyembed_plugin_manifest_free(g->manifest, g->nmanifest);
+    g->nmanifest = 0;
+    if (!(g->manifest = dlite_pyembed_plugin_manifest((FUPaths *)paths,
+                                                      "DLiteStorageBase",
+                                                      &g->nmanifest)))
+      return NULL;
+    memcpy(g->manifest_paths_hash, hash, sizeof(hash));
   }
+  *n = g->nmanifest;
+  return g->manifest;
 }
@@ -61,6 +61,16 @@ void *dlite_python_storage_load(void);
 */
 void dlite_python_storage_unload(void);
 
+/**
+  Returns the manifest of the Python storage plugins (building it if
+  needed) and writes the number of entries to `*n`.  Unlike
+  dlite_python_storage_load(), this does not import plugins whose
+  source files are in the manifest cache.
+
+  Returns NULL on error.
+*/
+const DLitePyembedPluginEntry *dlite_python_storage_manifest(size_t *n);
+
 
 
 #endif /* _DLITE_PYTHON_STORAGE_H */
@@ -0,0 +1,53 @@
+/* Benchmark comparing summing an array with the element iterator and
+   with dlite_array_sum().
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_arrays
+
+   and run it manually, optionally with the number of rows as argument.
+   Each row has 10000 elements. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "config.h"
+
+#include "utils/floats.h"
+#include "dlite.h"
+#include "dlite-arrays.h"
+
+
+int main(int argc, char *argv[])
+{
+  size_t i, N, dims[] = {1000, 10000};
+  float64_t *data, *p;
+  double v, sum=0;
+  DLiteArray *a;
+  DLiteArrayIter iter;
+  clock_t t0, t1, t2;
+
+  if (argc > 1) dims[0] = strtoul(argv[1], NULL, 10);
+  N = dims[0] * dims[1];
+  if (!(data = malloc(N*sizeof(float64_t))))
+    return dlite_err(1, "allocation failure");
+  for (i=0; i<N; i++) data[i] = 1.0;
+  if (!(a = dlite_array_create(data, dliteFloat, 8, 2, dims))) {
+    free(data);
+    return 1;
+  }
+
+  t0 = clock();
+  dlite_array_iter_init(&iter, a);
+  while ((p = dlite_array_iter_next(&iter))) sum += *p;
+  dlite_array_iter_deinit(&iter);
+  t1 = clock();
+  dlite_array_sum(a, &v);
+  t2 = clock();
+  printf("sum of %lu float64: iterator %.3f s, kernel %.3f s\n",
+         (unsigned long)N, (double)(t1 - t0) / CLOCKS_PER_SEC,
+         (double)(t2 - t1) / CLOCKS_PER_SEC);
+  dlite_array_free(a);
+  free(data);
+  return (v == sum) ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/* Benchmark comparing the fast path for scanning numeric json arrays
+   with dlite_property_scan().
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_json_arrays
+
+   and run it manually with the same environment as the tests,
+   optionally with the number of doubles as argument. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlite.h"
+#include "dlite-macros.h"
+
+
+int main(int argc, char *argv[])
+{
+  char *dims[] = {"N"};
+  DLiteDimension dimensions[] = {{"N", "Number of elements."}};
+  DLiteProperty properties[] = {
+    {"f64", dliteFloat, 8, 1, dims, NULL, NULL, ""},
+  };
+  size_t i, n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  DLiteMeta *meta;
+  DLiteInstance *inst=NULL, *ref=NULL;
+  char *json=NULL, *arrstart, *arr=NULL;
+  double *v, tfast;
+  clock_t t0;
+  int retval=1;
+
+  if (!(meta = dlite_meta_create("http://onto-ns.com/meta/0.1/Doubles",
+                                 "Entity with a double array.",
+                                 NULL, 1, dimensions, 1, properties)))
+    return 1;
+  if (!(inst = dlite_instance_create(meta, &n, NULL))) goto fail;
+  v = dlite_instance_get_property(inst, "f64");
+  for (i=0; i<n; i++) v[i] = (i % 7 - 3) * 1.37 * i / (i % 1000 + 1);
+  if (!(json = dlite_json_aprint(inst, 0, 0))) goto fail;
+  dlite_instance_decref(inst);
+
+  t0 = clock();
+  if (!(inst = dlite_json_sscan(json, NULL, NULL))) goto fail;
+  tfast = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+  if (!(ref = dlite_instance_create(meta, &n, NULL))) goto fail;
+  arrstart = strchr(strstr(json, "\"f64\""), '[');
+  arr = strndup(arrstart, strchr(arrstart, ']') - arrstart + 1);
+  t0 = clock();
+  if (dlite_property_scan(arr, *(void **)DLITE_PROP(ref, 0),
+                          meta->_properties, DLITE_PROP_DIMS(ref, 0),
+                          0) < 0) goto fail;
+  printf("scan %lu doubles, direct: %g s, dlite_property_scan: %g s\n",
+         (unsigned long)n, tfast, (double)(clock() - t0) / CLOCKS_PER_SEC);
+  retval = 0;
+ fail:
+  if (ref) dlite_instance_decref(ref);
+  if (inst) dlite_instance_decref(inst);
+  if (arr) free(arr);
+  if (json) free(json);
+  dlite_meta_decref(meta);
+  return retval;
+}
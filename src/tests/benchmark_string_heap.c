@@ -0,0 +1,81 @@
+/* Benchmark comparing scanning and freeing of a string array property
+   stored in a string heap with individually allocated strings.
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_string_heap
+
+   and run it manually with the same environment as the tests,
+   optionally with the number of strings as argument. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlite.h"
+#include "dlite-macros.h"
+
+
+int main(int argc, char *argv[])
+{
+  char *dims[] = {"N"};
+  DLiteDimension dimensions[] = {{"N", "Number of words."}};
+  DLiteProperty properties[] = {
+    {"words", dliteStringPtr, sizeof(char *), 1, dims, NULL, NULL, "Words."}
+  };
+  size_t i, n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 200000;
+  DLiteMeta *meta;
+  DLiteInstance *inst=NULL, *inst2=NULL;
+  char **words, *json=NULL, *arrstart, *arr=NULL;
+  double tscan, tfree;
+  clock_t t0;
+  int retval=1;
+
+  if (!(meta = dlite_meta_create("http://onto-ns.com/meta/0.1/Words",
+                                 "Entity with a string array.",
+                                 NULL, 1, dimensions, 1, properties)))
+    return 1;
+  if (!(inst = dlite_instance_create(meta, &n, NULL))) goto fail;
+  words = dlite_instance_get_property(inst, "words");
+  for (i=0; i<n; i++) {
+    if (!(words[i] = malloc(32))) FAIL("allocation failure");
+    snprintf(words[i], 32, "word%lu", (unsigned long)i);
+  }
+  if (!(json = dlite_json_aprint(inst, 0, 0))) goto fail;
+  dlite_instance_decref(inst);
+  inst = NULL;
+  arrstart = strchr(strstr(json, "\"words\""), '[');
+  arr = strndup(arrstart, strrchr(json, ']') - arrstart + 1);
+
+  /* scanning a string array uses a string heap */
+  t0 = clock();
+  if (!(inst = dlite_json_sscan(json, NULL, NULL))) goto fail;
+  tscan = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+  /* compare with scanning to individually allocated strings */
+  if (!(inst2 = dlite_instance_create(meta, &n, NULL))) goto fail;
+  t0 = clock();
+  if (dlite_property_scan(arr, *(void **)DLITE_PROP(inst2, 0),
+                          meta->_properties, DLITE_PROP_DIMS(inst2, 0),
+                          0) < 0) goto fail;
+  printf("scan %lu strings, string heap: %g s, individual: %g s\n",
+         (unsigned long)n, tscan, (double)(clock() - t0) / CLOCKS_PER_SEC);
+
+  t0 = clock();
+  dlite_instance_decref(inst2);
+  inst2 = NULL;
+  tfree = (double)(clock() - t0) / CLOCKS_PER_SEC;
+  t0 = clock();
+  dlite_instance_decref(inst);
+  inst = NULL;
+  printf("free %lu strings, string heap: %g s, individual: %g s\n",
+         (unsigned long)n, (double)(clock() - t0) / CLOCKS_PER_SEC, tfree);
+  retval = 0;
+ fail:
+  if (inst2) dlite_instance_decref(inst2);
+  if (inst) dlite_instance_decref(inst);
+  if (arr) free(arr);
+  if (json) free(json);
+  dlite_meta_decref(meta);
+  return retval;
+}
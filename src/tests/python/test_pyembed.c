@@ -1,5 +1,7 @@
 #include <Python.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "minunit/minunit.h"
 
@@ -11,6 +13,39 @@
 typedef DLiteInstance *(*fun_t)(const char *id);
 
 
+/* Writes a plugin file `filename` defining class `classname` with
+   method `method`.  Each time the file is executed, it appends a line
+   to the file "pyembed-manifest-marker". */
+static void write_plugin(const char *filename, const char *classname,
+                         const char *method)
+{
+  FILE *fp = fopen(filename, "w");
+  if (!fp) return;
+  fprintf(fp,
+          "with open('pyembed-manifest-marker', 'a') as f:\n"
+          "    f.write('executed\\n')\n"
+          "\n"
+          "class %s(DLiteMappingBase):\n"
+          "    name = '%s'\n"
+          "    def %s(self, instances):\n"
+          "        pass\n", classname, classname, method);
+  fclose(fp);
+}
+
+/* Returns the number of lines in file `filename` or 0 if it does not
+   exist. */
+static int count_lines(const char *filename)
+{
+  int c, n=0;
+  FILE *fp = fopen(filename, "r");
+  if (!fp) return 0;
+  while ((c = fgetc(fp)) != EOF)
+    if (c == '\n') n++;
+  fclose(fp);
+  return n;
+}
+
+
 MU_TEST(test_add_dll_path)
 {
   dlite_add_dll_path();
@@ -22,12 +57,15 @@ MU_TEST(test_load_modules)
   int i;
   FUPaths paths;
   PyObject *plugins;
+  PyGILState_STATE gstate;
 
   fu_paths_init(&paths, "DLITE_PYTHON_MAPPING_PLUGIN_DIRS");
   fu_paths_insert(&paths, STRINGIFY(TESTDIR), 0);
 
   plugins = dlite_pyembed_load_plugins(&paths, "DLiteMappingBase");
   mu_check(plugins);
+
+  gstate = dlite_pyembed_gil_ensure();
   mu_check(PyList_Check(plugins));
 
   printf("\nLoaded plugins:\n");
@@ -38,8 +76,115 @@ MU_TEST(test_load_modules)
     //PyObject_Print(name, stdout, 1);
   }
 
-  fu_paths_deinit(&paths);
   Py_DECREF(plugins);
+  dlite_pyembed_gil_release(gstate);
+  fu_paths_deinit(&paths);
+}
+
+
+MU_TEST(test_plugin_manifest)
+{
+  int pass;
+  size_t i, n;
+  FUPaths paths;
+  FILE *fp;
+  DLitePyembedPluginEntry *manifest;
+
+  setenv("DLITE_PYTHON_PLUGIN_CACHE_DIR", "pyembed-manifest-cache", 1);
+  remove("pyembed-manifest-cache/DLiteMappingBase.manifest");
+
+  fu_paths_init(&paths, NULL);
+  fu_paths_insert(&paths, STRINGIFY(TESTDIR), 0);
+
+  /* First pass builds the manifest cache, second pass reads it */
+  for (pass=0; pass < 2; pass++) {
+    manifest = dlite_pyembed_plugin_manifest(&paths, "DLiteMappingBase", &n);
+    mu_check(manifest);
+    mu_assert_int_eq(2, n);
+    for (i=0; i < n; i++) {
+      mu_check(strlen(manifest[i].hash) == 64);
+      mu_check(strstr(manifest[i].path, "plugin1.py"));
+      mu_check(dlite_pyembed_plugin_has_attr(manifest + i, "map"));
+      mu_check(!dlite_pyembed_plugin_has_attr(manifest + i, "ma"));
+    }
+    mu_assert_string_eq("plugin1", manifest[0].name);
+    mu_assert_string_eq("plugin2", manifest[1].name);
+    dlite_pyembed_plugin_manifest_free(manifest, n);
+
+    fp = fopen("pyembed-manifest-cache/DLiteMappingBase.manifest", "r");
+    mu_check(fp);
+    if (fp) fclose(fp);
+  }
+  fu_paths_deinit(&paths);
+
+  /* Unchanged files are not executed again, while modified files are */
+  remove("pyembed-manifest-marker");
+  write_plugin("pyembed-manifest-plugin.py", "plugin3", "map");
+  fu_paths_init(&paths, NULL);
+  fu_paths_insert(&paths, "pyembed-manifest-plugin.py", 0);
+  for (pass=0; pass < 2; pass++) {
+    manifest = dlite_pyembed_plugin_manifest(&paths, "DLiteMappingBase", &n);
+    mu_check(manifest);
+    mu_assert_int_eq(1, n);
+    mu_assert_string_eq("plugin3", manifest[0].name);
+    mu_check(dlite_pyembed_plugin_has_attr(manifest, "map"));
+    dlite_pyembed_plugin_manifest_free(manifest, n);
+    mu_assert_int_eq(1, count_lines("pyembed-manifest-marker"));
+  }
+
+  write_plugin("pyembed-manifest-plugin.py", "plugin4", "mapall");
+  manifest = dlite_pyembed_plugin_manifest(&paths, "DLiteMappingBase", &n);
+  mu_check(manifest);
+  mu_assert_int_eq(1, n);
+  mu_assert_string_eq("plugin4", manifest[0].name);
+  mu_check(dlite_pyembed_plugin_has_attr(manifest, "mapall"));
+  mu_check(!dlite_pyembed_plugin_has_attr(manifest, "map"));
+  dlite_pyembed_plugin_manifest_free(manifest, n);
+  mu_assert_int_eq(2, count_lines("pyembed-manifest-marker"));
+  fu_paths_deinit(&paths);
+}
+
+
+MU_TEST(test_load_plugin_class)
+{
+  PyObject *cls, *name;
+  PyGILState_STATE gstate;
+  FILE *fp;
+  cls = dlite_pyembed_load_plugin_class(STRINGIFY(TESTDIR) "/plugin1.py",
+                                        "plugin2", "DLiteMappingBase");
+  mu_check(cls);
+
+  gstate = dlite_pyembed_gil_ensure();
+  name = PyObject_GetAttrString(cls, "name");
+  mu_check(name);
+  mu_assert_string_eq("plugin2", PyUnicode_AsUTF8(name));
+  Py_XDECREF(name);
+  Py_XDECREF(cls);
+  dlite_pyembed_gil_release(gstate);
+
+  mu_check(!dlite_pyembed_load_plugin_class(STRINGIFY(TESTDIR) "/plugin1.py",
+                                            "noplugin", "DLiteMappingBase"));
+  dlite_errclr();
+
+  /* A class with the same name in another file is another plugin */
+  mu_check((fp = fopen("pyembed-other-plugin.py", "w")));
+  fprintf(fp,
+          "class plugin2(DLiteMappingBase):\n"
+          "    name = 'other'\n"
+          "    def map(self, instances):\n"
+          "        pass\n");
+  fclose(fp);
+  cls = dlite_pyembed_load_plugin_class("pyembed-other-plugin.py",
+                                        "plugin2", "DLiteMappingBase");
+  mu_check(cls);
+
+  gstate = dlite_pyembed_gil_ensure();
+  name = PyObject_GetAttrString(cls, "name");
+  mu_check(name);
+  mu_assert_string_eq("other", PyUnicode_AsUTF8(name));
+  Py_XDECREF(name);
+  Py_XDECREF(cls);
+  dlite_pyembed_gil_release(gstate);
 }
 
 
@@ -51,8 +196,11 @@ MU_TEST(test_get_address)
   void *addr;
   fun_t fun;
   DLiteInstance *inst;
+  PyGILState_STATE gstate;
 
+  gstate = dlite_pyembed_gil_ensure();
   addr = dlite_pyembed_get_address("dlite_instance_get");
+  dlite_pyembed_gil_release(gstate);
   mu_check(addr);
 
 #ifdef __GNUC__
@@ -77,12 +225,40 @@ MU_TEST(test_get_address)
 MU_TEST(test_get_instance)
 {
   const char *id = "http://onto-ns.com/meta/0.3/EntitySchema";
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
   PyObject *instance = dlite_pyembed_from_instance(id);
+  if (instance) {
+    printf("\nPython instance: ");
+    PyObject_Print(instance, stdout, 0);
+    printf("\n");
+    Py_DECREF(instance);
+  }
+  dlite_pyembed_gil_release(gstate);
   mu_check(instance);
-  printf("\nPython instance: ");
-  PyObject_Print(instance, stdout, 0);
-  printf("\n");
+}
+
+
+MU_TEST(test_from_instance_ptr)
+{
+  const char *id = "http://onto-ns.com/meta/0.3/EntitySchema";
+  DLiteInstance *inst = dlite_instance_get(id);
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
+  PyObject *instance = NULL, *uri = NULL;
+  int i, refcount = inst->_refcount;
+
+  /* Repeated calls reuse the cached Python function */
+  for (i=0; i<10 && inst; i++) {
+    Py_XDECREF(instance);
+    instance = dlite_pyembed_from_instance_ptr(inst);
+  }
+  if (instance) uri = PyObject_GetAttrString(instance, "uri");
+  if (uri) mu_assert_string_eq(id, PyUnicode_AsUTF8(uri));
+  Py_XDECREF(uri);
   Py_XDECREF(instance);
+  dlite_pyembed_gil_release(gstate);
+  mu_check(uri);
+  mu_assert_int_eq(refcount, inst->_refcount);
+  dlite_instance_decref(inst);
 }
 
 
@@ -99,8 +275,11 @@ MU_TEST_SUITE(test_suite)
 {
   MU_RUN_TEST(test_add_dll_path);
   MU_RUN_TEST(test_load_modules);
+  MU_RUN_TEST(test_plugin_manifest);
+  MU_RUN_TEST(test_load_plugin_class);
   MU_RUN_TEST(test_get_address);
   MU_RUN_TEST(test_get_instance);
+  MU_RUN_TEST(test_from_instance_ptr);
   MU_RUN_TEST(test_finalize);
 }
 
@@ -0,0 +1,136 @@
+#include <Python.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "minunit/minunit.h"
+
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-storage-plugins.h"
+#include "dlite-pyembed.h"
+
+#define NTHREADS 4
+#define NLOADS 10
+#define BLOBFILE "test_pyembed_threads.bin"
+
+static const char content[] = "Content loaded by the blob storage plugin";
+
+/* The dlite core is not thread safe, so calls into it are serialised
+   like in the Python bindings.  Python code run by other threads
+   proceeds while a thread holds this lock. */
+static pthread_mutex_t dlite_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Thread function loading the blob file NLOADS times through the
+   Python blob storage plugin.  `arg` points to an int that on input
+   is the thread number and on output is the number of successful
+   loads. */
+static void *loader(void *arg)
+{
+  int *n = arg, thread = *n, i;
+  char id[32], options[40];
+  *n = 0;
+  for (i=0; i<NLOADS; i++) {
+    DLiteStorage *s;
+    DLiteInstance *inst=NULL;
+    unsigned char *p;
+    snprintf(id, sizeof(id), "blob-%d-%d", thread, i);
+    snprintf(options, sizeof(options), "id=%s", id);
+    pthread_mutex_lock(&dlite_lock);
+    if ((s = dlite_storage_open("blob", BLOBFILE, options))) {
+      inst = dlite_instance_load(s, id);
+      dlite_storage_close(s);
+    }
+    if (inst && (p = dlite_instance_get_property(inst, "content")) &&
+        memcmp(p, content, sizeof(content)) == 0)
+      (*n)++;
+    if (inst) dlite_instance_decref(inst);
+    pthread_mutex_unlock(&dlite_lock);
+  }
+  return NULL;
+}
+
+/* Thread function computing a sum in Python */
+static void *summer(void *arg)
+{
+  long *result = arg;
+  PyObject *main_module, *main_dict, *v;
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
+  if ((main_module = PyImport_AddModule("__main__")) &&
+      (main_dict = PyModule_GetDict(main_module)) &&
+      (v = PyRun_String("sum(range(10000))", Py_eval_input,
+                        main_dict, main_dict))) {
+    *result = PyLong_AsLong(v);
+    Py_DECREF(v);
+  }
+  dlite_pyembed_gil_release(gstate);
+  return NULL;
+}
+
+
+MU_TEST(test_initialise)
+{
+  FILE *fp;
+  dlite_pyembed_initialise();
+  mu_check(Py_IsInitialized());
+
+  /* The initialising thread should not hold the GIL */
+  mu_check(!PyGILState_Check());
+
+  mu_check((fp = fopen(BLOBFILE, "wb")));
+  mu_assert_int_eq(1, fwrite(content, sizeof(content), 1, fp));
+  fclose(fp);
+}
+
+
+MU_TEST(test_storage)
+{
+  int i, nloads[NTHREADS];
+  long result[NTHREADS];
+  pthread_t loaders[NTHREADS], summers[NTHREADS];
+
+  /* Load through the Python storage plugin from several threads, while
+     other threads run Python code */
+  for (i=0; i<NTHREADS; i++) {
+    nloads[i] = i;
+    result[i] = 0;
+    mu_assert_int_eq(0, pthread_create(loaders+i, NULL, loader, nloads+i));
+    mu_assert_int_eq(0, pthread_create(summers+i, NULL, summer, result+i));
+  }
+  for (i=0; i<NTHREADS; i++) {
+    pthread_join(loaders[i], NULL);
+    pthread_join(summers[i], NULL);
+  }
+  for (i=0; i<NTHREADS; i++) {
+    mu_assert_int_eq(NLOADS, nloads[i]);
+    mu_assert_int_eq(49995000, result[i]);
+  }
+}
+
+
+MU_TEST(test_finalize)
+{
+  remove(BLOBFILE);
+  dlite_storage_plugin_unload_all();
+  mu_assert_int_eq(0, dlite_pyembed_finalise());
+}
+
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_initialise);
+  MU_RUN_TEST(test_storage);
+  MU_RUN_TEST(test_finalize);
+}
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
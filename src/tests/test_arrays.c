@@ -1,8 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "config.h"
 
 #include "minunit/minunit.h"
+#include "utils/floats.h"
 #include "dlite.h"
 #include "dlite-macros.h"
 #include "dlite-arrays.h"
@@ -219,6 +221,204 @@ MU_TEST(test_array_transpose)
 }
 
 
+MU_TEST(test_array_blockiter)
+{
+  DLiteArrayBlockIter iter;
+  DLiteArrayIter it;
+  DLiteArray *a;
+  int *p, start[] = {0, 1}, step[] = {2, 1};
+  size_t n, nblocks=0, dims[] = {12};
+
+  /* contiguous array is a single block */
+  mu_assert_int_eq(0, dlite_array_blockiter_init(&iter, arr));
+  while ((p = dlite_array_blockiter_next(&iter, &n))) {
+    mu_assert_int_eq(12, n);
+    nblocks++;
+  }
+  mu_assert_int_eq(1, nblocks);
+
+  /* every second row: blocks are rows */
+  mu_check((a = dlite_array_slice(arr, NULL, NULL, step)));
+  mu_assert_int_eq(0, dlite_array_blockiter_init(&iter, a));
+  mu_check((p = dlite_array_blockiter_next(&iter, &n)));
+  mu_assert_int_eq(4, n);
+  mu_assert_int_eq(0, *p);
+  mu_check((p = dlite_array_blockiter_next(&iter, &n)));
+  mu_assert_int_eq(8, *p);
+  mu_check(!dlite_array_blockiter_next(&iter, &n));
+  dlite_array_free(a);
+
+  /* partial rows */
+  mu_check((a = dlite_array_slice(arr, start, NULL, NULL)));
+  mu_check((p = dlite_array_make_continuous(a)));
+  mu_assert_int_eq(1, p[0]);
+  mu_assert_int_eq(3, p[2]);
+  mu_assert_int_eq(5, p[3]);
+  mu_assert_int_eq(11, p[8]);
+  free(p);
+  dlite_array_free(a);
+
+  /* transposed array: single element blocks */
+  mu_check((a = dlite_array_transpose(arr)));
+  mu_assert_int_eq(0, dlite_array_blockiter_init(&iter, a));
+  nblocks = 0;
+  while ((p = dlite_array_blockiter_next(&iter, &n))) {
+    mu_assert_int_eq(1, n);
+    nblocks++;
+  }
+  mu_assert_int_eq(12, nblocks);
+  mu_assert_int_eq(0, dlite_array_compare(a, arr));
+  dlite_array_free(a);
+
+  /* one-dimensional element iteration */
+  mu_check((a = dlite_array_create(data, dliteInt, sizeof(int), 1, dims)));
+  mu_assert_int_eq(0, dlite_array_iter_init(&it, a));
+  n = 0;
+  while ((p = dlite_array_iter_next(&it))) mu_assert_int_eq(n++, *p);
+  mu_assert_int_eq(12, n);
+  dlite_array_iter_deinit(&it);
+  dlite_array_free(a);
+}
+
+
+/* Returns a newly malloc'ed string with the output of
+   dlite_array_printf() for array `a`. */
+static char *array_sprintf(const DLiteArray *a)
+{
+  char *buf;
+  long n;
+  FILE *fp = tmpfile();
+  if (!fp) return NULL;
+  dlite_array_printf(fp, a, 2, 0);
+  n = ftell(fp);
+  rewind(fp);
+  if ((buf = calloc(n + 1, 1))) fread(buf, 1, n, fp);
+  fclose(fp);
+  return buf;
+}
+
+MU_TEST(test_array_printf)
+{
+  DLiteArray *a, *r;
+  char *buf;
+  int step[] = {2, 1}, step3[] = {2, 1, 1};
+  size_t dims[] = {3, 2, 2};
+
+  mu_check((buf = array_sprintf(arr)));
+  mu_assert_string_eq("[[ 0  1  2  3]\n"
+                      " [ 4  5  6  7]\n"
+                      " [ 8  9 10 11]]\n", buf);
+  free(buf);
+
+  /* single element blocks */
+  mu_check((a = dlite_array_transpose(arr)));
+  mu_check((buf = array_sprintf(a)));
+  mu_assert_string_eq("[[ 0  4  8]\n"
+                      " [ 1  5  9]\n"
+                      " [ 2  6 10]\n"
+                      " [ 3  7 11]]\n", buf);
+  free(buf);
+  dlite_array_free(a);
+
+  /* blocks are rows */
+  mu_check((a = dlite_array_slice(arr, NULL, NULL, step)));
+  mu_check((buf = array_sprintf(a)));
+  mu_assert_string_eq("[[ 0  1  2  3]\n"
+                      " [ 8  9 10 11]]\n", buf);
+  free(buf);
+  dlite_array_free(a);
+
+  /* blocks spanning two dimensions */
+  mu_check((r = dlite_array_reshape(arr, 3, dims)));
+  mu_check((a = dlite_array_slice(r, NULL, NULL, step3)));
+  mu_check((buf = array_sprintf(a)));
+  mu_assert_string_eq("[[[ 0  1]\n"
+                      "  [ 2  3]]\n"
+                      " [[ 8  9]\n"
+                      "  [10 11]]]\n", buf);
+  free(buf);
+  dlite_array_free(a);
+  dlite_array_free(r);
+}
+
+
+MU_TEST(test_array_reductions)
+{
+  double v;
+  int step[] = {1, 2};
+  DLiteArray *t, *a;
+
+  mu_assert_int_eq(0, dlite_array_sum(arr, &v));
+  mu_assert_double_eq(66.0, v);
+  mu_assert_int_eq(0, dlite_array_mean(arr, &v));
+  mu_assert_double_eq(5.5, v);
+  mu_assert_int_eq(0, dlite_array_min(arr, &v));
+  mu_assert_double_eq(0.0, v);
+  mu_assert_int_eq(0, dlite_array_max(arr, &v));
+  mu_assert_double_eq(11.0, v);
+
+  /* strided views */
+  mu_check((t = dlite_array_transpose(arr)));
+  mu_assert_int_eq(0, dlite_array_sum(t, &v));
+  mu_assert_double_eq(66.0, v);
+  dlite_array_free(t);
+
+  mu_check((a = dlite_array_slice(arr, NULL, NULL, step)));  /* 0, 2, 4,... */
+  mu_assert_int_eq(0, dlite_array_sum(a, &v));
+  mu_assert_double_eq(0+2+4+6+8+10, v);
+  mu_assert_int_eq(0, dlite_array_min(a, &v));
+  mu_assert_double_eq(0.0, v);
+  mu_assert_int_eq(0, dlite_array_max(a, &v));
+  mu_assert_double_eq(10.0, v);
+  dlite_array_free(a);
+}
+
+
+MU_TEST(test_array_elementwise)
+{
+  size_t i, dims[] = {3, 4};
+  double x[12], y[12], v;
+  float64_t z[12];
+  DLiteArray *ax, *ay, *az, *t;
+  for (i=0; i<12; i++) {
+    x[i] = i;
+    y[i] = 1.0;
+  }
+  mu_check((ax = dlite_array_create(x, dliteFloat, 8, 2, dims)));
+  mu_check((ay = dlite_array_create(y, dliteFloat, 8, 2, dims)));
+  mu_check((az = dlite_array_create(z, dliteFloat, 8, 2, dims)));
+
+  mu_assert_int_eq(0, dlite_array_scale(ax, 2.0, 1.0));  /* x = 2*i + 1 */
+  mu_assert_double_eq(23.0, x[11]);
+  mu_assert_int_eq(0, dlite_array_axpy(ay, 0.5, ax));    /* y = i + 1.5 */
+  mu_assert_double_eq(12.5, y[11]);
+  mu_assert_int_eq(0, dlite_array_sum(ay, &v));
+  mu_assert_double_eq(84.0, v);
+
+  /* type-converting copy from a transposed view */
+  mu_check((t = dlite_array_transpose(arr)));
+  az->dims[0] = 4;
+  az->dims[1] = 3;
+  az->strides[0] = 24;
+  mu_assert_int_eq(0, dlite_array_copy_cast(az, t));
+  mu_assert_double_eq(0.0, z[0]);
+  mu_assert_double_eq(4.0, z[1]);
+  mu_assert_double_eq(1.0, z[3]);
+  mu_assert_double_eq(11.0, z[11]);
+
+  /* incompatible arrays */
+  mu_check(dlite_array_axpy(ay, 1.0, t));
+  mu_check(dlite_array_copy_cast(ay, t));
+  dlite_array_free(t);
+  mu_check((t = dlite_array_create(x, dliteBlob, 8, 2, dims)));
+  mu_check(dlite_array_sum(t, &v));
+  dlite_array_free(t);
+  dlite_array_free(ax);
+  dlite_array_free(ay);
+  dlite_array_free(az);
+}
+
+
 MU_TEST(test_array_free)
 {
   dlite_array_free(arr);
@@ -237,6 +437,10 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_array_slice);
   MU_RUN_TEST(test_array_reshape);
   MU_RUN_TEST(test_array_transpose);
+  MU_RUN_TEST(test_array_blockiter);
+  MU_RUN_TEST(test_array_printf);
+  MU_RUN_TEST(test_array_reductions);
+  MU_RUN_TEST(test_array_elementwise);
   MU_RUN_TEST(test_array_free);      /* tear down */
 }
 
@@ -0,0 +1,251 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/integers.h"
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-binary.h"
+
+#include "minunit/minunit.h"
+
+
+DLiteInstance *inst=NULL;
+DLiteMeta *meta=NULL;
+
+
+MU_TEST(test_load)
+{
+  char *url;
+  url="json://"STRINGIFY(dlite_SOURCE_DIR)"/src/tests/test-entity.json?mode=r";
+  meta = dlite_meta_load_url(url);
+  mu_check(meta);
+
+  url="json://" STRINGIFY(dlite_SOURCE_DIR) "/src/tests/test-data.json?mode=r"
+    "#e076a856-e36e-5335-967e-2f2fd153c17d";
+  inst = dlite_instance_load_url(url);
+  mu_check(inst);
+}
+
+
+MU_TEST(test_type_encode)
+{
+  int32_t v[] = {1, -2, 0x01020304}, w[3];
+  unsigned char buf[16];
+  char *s[] = {"abc", NULL}, *t[] = {NULL, NULL};
+  bool b[] = {1, 0, 1}, c[3];
+  unsigned char expected[] = {1, 0, 0, 0,  0xfe, 0xff, 0xff, 0xff,
+                              4, 3, 2, 1};
+
+  /* fixed little endian wire format */
+  mu_assert_int_eq(12, dlite_type_encode(buf, sizeof(buf), v, dliteInt,
+                                         4, 3));
+  mu_check(memcmp(buf, expected, 12) == 0);
+  mu_assert_int_eq(12, dlite_type_decode(buf, 12, w, dliteInt, 4, 3));
+  mu_check(memcmp(v, w, sizeof(v)) == 0);
+
+  /* size query and truncated input */
+  mu_assert_int_eq(12, dlite_type_encode(NULL, 0, v, dliteInt, 4, 3));
+  mu_assert_int_eq(-1, dlite_type_decode(buf, 11, w, dliteInt, 4, 3));
+
+  /* strings, including NULL */
+  mu_assert_int_eq(19, dlite_type_encode(buf, sizeof(buf), s,
+                                         dliteStringPtr, sizeof(char *), 2));
+  mu_assert_int_eq(-1, dlite_type_decode(buf, sizeof(buf), t,
+                                         dliteStringPtr, sizeof(char *), 2));
+  mu_assert_int_eq(11, dlite_type_encode(buf, sizeof(buf), s,
+                                         dliteStringPtr, sizeof(char *), 1));
+  mu_assert_int_eq(11, dlite_type_decode(buf, 11, t,
+                                         dliteStringPtr, sizeof(char *), 1));
+  mu_assert_string_eq("abc", t[0]);
+  free(t[0]);
+
+  mu_assert_int_eq(3, dlite_type_encode(buf, sizeof(buf), b, dliteBool,
+                                        sizeof(bool), 3));
+  mu_assert_int_eq(3, dlite_type_decode(buf, 3, c, dliteBool,
+                                        sizeof(bool), 3));
+  mu_check(c[0] && !c[1] && c[2]);
+}
+
+
+MU_TEST(test_meta_encode)
+{
+  DLiteProperty *props;
+  unsigned char *buf;
+  ptrdiff_t n;
+  size_t i;
+
+  /* Encode the property descriptions of the entity and decode them
+     into a new array */
+  n = dlite_type_encode(NULL, 0, meta->_properties, dliteProperty,
+                        sizeof(DLiteProperty), meta->_nproperties);
+  mu_check(n > 0);
+  buf = malloc(n);
+  mu_assert_int_eq(n, dlite_type_encode(buf, n, meta->_properties,
+                                        dliteProperty, sizeof(DLiteProperty),
+                                        meta->_nproperties));
+  props = calloc(meta->_nproperties, sizeof(DLiteProperty));
+  mu_assert_int_eq(n, dlite_type_decode(buf, n, props, dliteProperty,
+                                        sizeof(DLiteProperty),
+                                        meta->_nproperties));
+  for (i=0; i < meta->_nproperties; i++) {
+    DLiteProperty *p = meta->_properties + i;
+    mu_assert_string_eq(p->name, props[i].name);
+    mu_assert_int_eq(p->type, props[i].type);
+    mu_assert_int_eq(p->size, props[i].size);
+    mu_assert_int_eq(p->ndims, props[i].ndims);
+    dlite_type_clear(props + i, dliteProperty, sizeof(DLiteProperty));
+  }
+  mu_assert_string_eq("N", meta->_properties[5].dims[2]);
+  free(props);
+  free(buf);
+}
+
+
+MU_TEST(test_instance_roundtrip)
+{
+  DLiteInstance *inst2;
+  unsigned char *buf, *buf2;
+  size_t len, len2, consumed;
+  int *arr, *arr2;
+  char uuid[DLITE_UUID_LENGTH+1];
+
+  mu_check((buf = dlite_binary_aencode(inst, &len)));
+  mu_check(memcmp(buf, DLITE_BINARY_MAGIC, 4) == 0);
+  mu_assert_int_eq(len, dlite_binary_encode(NULL, 0, inst));
+  strcpy(uuid, inst->uuid);
+
+  /* Truncated input should fail */
+  mu_check(!dlite_binary_decode(buf, len-1, NULL));
+  dlite_errclr();
+
+  /* Decode while the original instance is still alive returns the
+     existing instance */
+  mu_check((inst2 = dlite_binary_decode(buf, len, &consumed)));
+  mu_check(inst2 == inst);
+  mu_assert_int_eq(len, consumed);
+  dlite_instance_decref(inst2);
+
+  /* Decode after the original instance has been free'ed */
+  arr = dlite_instance_get_property(inst, "myarray");
+  arr2 = malloc(6*sizeof(int));
+  memcpy(arr2, arr, 6*sizeof(int));
+  dlite_instance_decref(inst);
+  mu_check((inst = dlite_binary_decode(buf, len, NULL)));
+  mu_assert_string_eq(uuid, inst->uuid);
+  mu_assert_string_eq("allocated string...",
+                      *(char **)dlite_instance_get_property(inst, "mystring"));
+  mu_assert_int_eq(17, *(uint16_t *)dlite_instance_get_property(inst,
+                                                                "myshort"));
+  arr = dlite_instance_get_property(inst, "myarray");
+  mu_check(memcmp(arr, arr2, 6*sizeof(int)) == 0);
+  free(arr2);
+
+  mu_check((buf2 = dlite_binary_aencode(inst, &len2)));
+  mu_assert_int_eq(len, len2);
+  mu_check(memcmp(buf, buf2, len) == 0);
+  free(buf);
+  free(buf2);
+}
+
+
+MU_TEST(test_instance_patch)
+{
+  DLiteInstance *a, *b;
+  unsigned char *patch, *empty;
+  size_t len, emptylen, fulllen;
+  int *arr, newdims[] = {3, -1, -1};
+  char *s = "new string";
+  double d;
+
+  mu_check((a = dlite_instance_copy(inst, NULL)));
+  mu_check((b = dlite_instance_copy(inst, NULL)));
+
+  /* identical instances give a patch without changes */
+  mu_check((empty = dlite_instance_adiff(a, b, &emptylen)));
+  mu_check(memcmp(empty, DLITE_PATCH_MAGIC, 4) == 0);
+  mu_assert_int_eq(emptylen, dlite_instance_apply_patch(a, empty, emptylen));
+
+  /* change a single array element and a string */
+  arr = dlite_instance_get_property(b, "myarray");
+  arr[4] = 42;
+  mu_check(dlite_instance_set_property(b, "mystring", &s) == 0);
+  mu_check((patch = dlite_instance_adiff(a, b, &len)));
+  mu_assert_int_eq(len, dlite_instance_diff(NULL, 0, a, b));
+  fulllen = dlite_binary_encode(NULL, 0, b);
+  mu_check(len < fulllen);
+
+  /* truncated patches are rejected */
+  mu_assert_int_eq(-1, dlite_instance_apply_patch(a, patch, len-1));
+  dlite_errclr();
+
+  mu_assert_int_eq(len, dlite_instance_apply_patch(a, patch, len));
+  arr = dlite_instance_get_property(a, "myarray");
+  mu_assert_int_eq(42, arr[4]);
+  mu_assert_int_eq(4, arr[3]);
+  mu_assert_string_eq("new string",
+                      *(char **)dlite_instance_get_property(a, "mystring"));
+  free(patch);
+
+  /* now `a` and `b` are equal */
+  mu_check((patch = dlite_instance_adiff(a, b, &len)));
+  mu_assert_int_eq(emptylen, len);
+  free(patch);
+
+  /* change dimensions and a scalar */
+  mu_check(dlite_instance_set_dimension_sizes(b, newdims) == 0);
+  arr = dlite_instance_get_property(b, "myarray");
+  arr[8] = 9;
+  d = 2.72;
+  mu_check(dlite_instance_set_property(b, "mydouble", &d) == 0);
+  mu_check((patch = dlite_instance_adiff(a, b, &len)));
+  mu_assert_int_eq(len, dlite_instance_apply_patch(a, patch, len));
+  mu_assert_int_eq(3, dlite_instance_get_dimension_size(a, "L"));
+  arr = dlite_instance_get_property(a, "myarray");
+  mu_assert_int_eq(42, arr[4]);
+  mu_assert_int_eq(9, arr[8]);
+  mu_assert_double_eq(2.72, *(double *)dlite_instance_get_property(a, "mydouble"));
+  free(patch);
+
+  mu_check((patch = dlite_instance_adiff(a, b, &len)));
+  mu_assert_int_eq(emptylen, len);
+  free(patch);
+
+  /* the empty patch cannot be applied to other metadata */
+  mu_assert_int_eq(-1, dlite_instance_apply_patch((DLiteInstance *)meta,
+                                                  empty, emptylen));
+  dlite_errclr();
+  free(empty);
+
+  dlite_instance_decref(a);
+  dlite_instance_decref(b);
+}
+
+
+MU_TEST(test_free)
+{
+  dlite_instance_decref(inst);
+  dlite_meta_decref(meta);
+}
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_load);
+  MU_RUN_TEST(test_type_encode);
+  MU_RUN_TEST(test_meta_encode);
+  MU_RUN_TEST(test_instance_roundtrip);
+  MU_RUN_TEST(test_instance_patch);
+  MU_RUN_TEST(test_free);
+}
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
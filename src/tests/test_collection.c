@@ -194,6 +194,78 @@ MU_TEST(test_collection_load)
 }
 
 
+MU_TEST(test_collection_binary)
+{
+  DLiteCollection *coll2;
+  const DLiteRelation *r;
+  unsigned char *buf;
+  size_t size;
+  char *uuid = "2b10c236-eb00-541a-901c-046c202e52fa";
+
+  mu_check(!dlite_collection_add_relation(coll, "inst", "_has-uuid", uuid));
+  mu_check(!dlite_collection_add_relation(coll, "inst", "label", "dog"));
+  mu_check((buf = dlite_collection_to_binary(coll, &size)));
+
+  mu_check((coll2 = dlite_collection_create(NULL)));
+  mu_check(!dlite_collection_from_binary(coll2, buf, size));
+  mu_assert_int_eq(triplestore_length(coll->rstore),
+                   triplestore_length(coll2->rstore));
+  mu_check((r = dlite_collection_find_first(coll2, "inst", "_has-uuid",
+                                            NULL)));
+  mu_assert_string_eq(uuid, r->o);
+  mu_check((r = dlite_collection_find_first(coll2, "dog", "is_a", NULL)));
+  mu_assert_string_eq("animal", r->o);
+  mu_check(triplestore_get(coll2->rstore, r->id));
+
+  /* corrupted input */
+  buf[size-1] = 0xff;
+  mu_check(dlite_collection_from_binary(coll2, buf, size));
+  mu_check(dlite_collection_from_binary(coll2, buf, size-1));
+
+  free(buf);
+  dlite_collection_decref(coll2);
+  dlite_collection_remove_relations(coll, "inst", NULL, NULL);
+}
+
+
+MU_TEST(test_collection_query)
+{
+  TripleResult *r;
+  size_t i, n;
+  int x, stat=0;
+  TriplePattern patterns[] = {
+    {"?x", "is_a", "?y"},
+    {"?y", "is_a", "animal"},
+  };
+  mu_check((r = dlite_collection_query(coll, patterns, 2)));
+  mu_assert_int_eq(1, triplestore_result_nrows(r));
+  x = triplestore_result_varindex(r, "?x");
+  mu_assert_string_eq("terrier", triplestore_result_value(r, 0, x));
+  triplestore_result_free(r);
+
+  /* larger graph: chain of n labeled nodes */
+  n = 20000;
+  for (i=0; i<n; i++) {
+    char s[32], o[32];
+    snprintf(s, sizeof(s), "node%zu", i);
+    snprintf(o, sizeof(o), "node%zu", i+1);
+    stat |= dlite_collection_add_relation(coll, s, "next", o);
+    stat |= dlite_collection_add_relation(coll, s, "label", "node");
+  }
+  mu_assert_int_eq(0, stat);
+  TriplePattern chain[] = {
+    {"?a", "next", "?b"},
+    {"?b", "next", "?c"},
+    {"?c", "label", "node"},
+  };
+  mu_check((r = dlite_collection_query(coll, chain, 3)));
+  mu_assert_int_eq(n-2, triplestore_result_nrows(r));
+  triplestore_result_free(r);
+  dlite_collection_remove_relations(coll, NULL, "next", NULL);
+  dlite_collection_remove_relations(coll, NULL, "label", "node");
+}
+
+
 MU_TEST(test_collection_free)
 {
   dlite_collection_decref(coll);
@@ -222,6 +294,8 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_collection_remove);
   MU_RUN_TEST(test_collection_save);
   MU_RUN_TEST(test_collection_load);
+  MU_RUN_TEST(test_collection_binary);
+  MU_RUN_TEST(test_collection_query);
 #endif
 
   MU_RUN_TEST(test_collection_free);       /* tear down */
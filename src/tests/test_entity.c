@@ -155,6 +155,118 @@ MU_TEST(test_instance_copy)
   mu_assert_int_eq(3, entity->_refcount);  /* refs: global+store+mydata */
 }
 
+MU_TEST(test_instance_copy_cow)
+{
+  DLiteInstance *inst, *inst2;
+  const int *src, *cpy;
+  int *ptr, newarr[2] = {10, 11};
+  size_t nbytes = sizeof(int) * dlite_instance_get_dimension_size(mydata, "N")
+    * dlite_instance_get_dimension_size(mydata, "M");
+  int orig[2];
+
+  mu_assert_int_eq(2, nbytes / sizeof(int));
+  mu_check((src = dlite_instance_peek_property(mydata, "an-int-arr")));
+  memcpy(orig, src, nbytes);
+
+  /* the copy shares the array buffer with the source */
+  mu_check((inst = dlite_instance_copy_cow(mydata, NULL)));
+  mu_check((cpy = dlite_instance_peek_property(inst, "an-int-arr")));
+  mu_check(cpy == src);
+
+  /* assigning to the copy unshares it, leaving the source unchanged */
+  mu_check(dlite_instance_set_property(inst, "an-int-arr", newarr) == 0);
+  mu_check((cpy = dlite_instance_peek_property(inst, "an-int-arr")));
+  mu_check(cpy != src);
+  mu_assert_int_eq(10, cpy[0]);
+  mu_assert_int_eq(11, cpy[1]);
+  mu_check(src == dlite_instance_peek_property(mydata, "an-int-arr"));
+  mu_check(memcmp(src, orig, nbytes) == 0);
+
+  /* requesting a writable pointer from the source unshares the source */
+  mu_check((inst2 = dlite_instance_copy_cow(mydata, NULL)));
+  mu_check(src == dlite_instance_peek_property(inst2, "an-int-arr"));
+  mu_check((ptr = dlite_instance_get_property(mydata, "an-int-arr")));
+  mu_check((const int *)ptr != src);
+  mu_check(memcmp(ptr, orig, nbytes) == 0);
+  ptr[0] = -1;
+  mu_check(memcmp(src, orig, nbytes) == 0);
+  ptr[0] = orig[0];
+
+  /* copies may be free'ed in any order */
+  dlite_instance_decref(inst2);
+  dlite_instance_decref(inst);
+  mu_assert_int_eq(1, mydata->_refcount);
+  mu_assert_int_eq(3, entity->_refcount);  /* refs: global+store+mydata */
+}
+
+static int nreleased = 0;
+static void release_buffer(void *owner)
+{
+  mu_check(owner == (void *)&nreleased);
+  nreleased++;
+}
+
+MU_TEST(test_instance_adopt_property)
+{
+  DLiteInstance *inst, *inst2;
+  int i, buf[2] = {7, 8}, newarr[2] = {10, 11}, *ptr;
+  const int *cpy;
+  size_t i_arr = dlite_meta_get_property_index(entity, "an-int-arr");
+  size_t i_str = dlite_meta_get_property_index(entity, "a-string-arr");
+
+  mu_check((inst = dlite_instance_copy(mydata, NULL)));
+
+  /* adopt external buffer */
+  mu_check(dlite_instance_adopt_property(inst, i_arr, buf, release_buffer,
+                                         &nreleased) == 0);
+  mu_check(dlite_instance_has_external_buffer(inst, i_arr));
+  mu_check(dlite_instance_peek_property(inst, "an-int-arr") == buf);
+  mu_check(dlite_instance_adopt_property(inst, i_arr, buf, release_buffer,
+                                         &nreleased));
+
+  /* writes go to the external buffer */
+  mu_check(dlite_instance_set_property(inst, "an-int-arr", newarr) == 0);
+  mu_assert_int_eq(10, buf[0]);
+  mu_assert_int_eq(11, buf[1]);
+  mu_check(dlite_instance_get_property(inst, "an-int-arr") == buf);
+
+  /* copy-on-write copies keep the buffer alive */
+  mu_check((inst2 = dlite_instance_copy_cow(inst, NULL)));
+  mu_check(dlite_instance_peek_property(inst2, "an-int-arr") == buf);
+  dlite_instance_decref(inst);
+  mu_assert_int_eq(0, nreleased);
+  mu_check((cpy = dlite_instance_peek_property(inst2, "an-int-arr")));
+  mu_check(cpy == buf);
+
+  /* resizing replaces the external buffer with a private copy */
+  mu_check(dlite_instance_set_dimension_size(inst2, "N", 2) == 0);
+  mu_assert_int_eq(1, nreleased);
+  mu_check(!dlite_instance_has_external_buffer(inst2, i_arr));
+  mu_check((ptr = dlite_instance_get_property(inst2, "an-int-arr")));
+  mu_check(ptr != buf);
+  mu_assert_int_eq(10, ptr[0]);
+  mu_assert_int_eq(11, ptr[1]);
+
+  /* take over the ownership of a malloc'ed buffer */
+  mu_check((ptr = malloc(4 * sizeof(int))));
+  for (i=0; i<4; i++) ptr[i] = i;
+  mu_check(dlite_instance_adopt_property(inst2, i_arr, ptr, NULL, NULL) == 0);
+  mu_check(!dlite_instance_has_external_buffer(inst2, i_arr));
+  mu_check(dlite_instance_peek_property(inst2, "an-int-arr") == ptr);
+
+  /* free'ing the instance releases the external buffer */
+  mu_check(dlite_instance_adopt_property(inst2, i_arr, buf, release_buffer,
+                                         &nreleased) == 0);
+  dlite_instance_decref(inst2);
+  mu_assert_int_eq(2, nreleased);
+
+  /* strings cannot be adopted */
+  mu_check(dlite_instance_adopt_property(mydata, i_str, buf, release_buffer,
+                                         &nreleased));
+  mu_assert_int_eq(2, nreleased);
+  mu_assert_int_eq(1, mydata->_refcount);
+}
+
 MU_TEST(test_instance_save)
 {
   DLiteStorage *s;
@@ -303,6 +415,8 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_instance_get_dimension_size);
   MU_RUN_TEST(test_instance_set_dimension_sizes);
   MU_RUN_TEST(test_instance_copy);
+  MU_RUN_TEST(test_instance_copy_cow);
+  MU_RUN_TEST(test_instance_adopt_property);
   MU_RUN_TEST(test_instance_save);
   MU_RUN_TEST(test_instance_hdf5);
   MU_RUN_TEST(test_instance_json);
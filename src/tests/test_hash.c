@@ -0,0 +1,122 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/integers.h"
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-hash.h"
+
+#include "minunit/minunit.h"
+
+
+DLiteInstance *inst=NULL;
+DLiteMeta *meta=NULL;
+
+
+MU_TEST(test_load)
+{
+  char *url;
+  url="json://"STRINGIFY(dlite_SOURCE_DIR)"/src/tests/test-entity.json?mode=r";
+  meta = dlite_meta_load_url(url);
+  mu_check(meta);
+
+  url="json://" STRINGIFY(dlite_SOURCE_DIR) "/src/tests/test-data.json?mode=r"
+    "#e076a856-e36e-5335-967e-2f2fd153c17d";
+  inst = dlite_instance_load_url(url);
+  mu_check(inst);
+}
+
+
+MU_TEST(test_hash)
+{
+  DLiteInstance *copy;
+  uint64_t h1, h2, p1, p2;
+  char *s = "new string";
+  uint16_t v = 18;
+  int *arr;
+
+  mu_assert_int_eq(0, dlite_instance_hash(inst, &h1));
+  mu_assert_int_eq(0, dlite_instance_hash(inst, &h2));
+  mu_check(h1 == h2);
+
+  /* A copy has the same payload, but a different identity */
+  mu_check((copy = dlite_instance_copy(inst, NULL)));
+  mu_assert_int_eq(0, dlite_instance_hash(copy, &h2));
+  mu_check(h1 != h2);
+  mu_assert_int_eq(0, dlite_instance_payload_hash(inst, &p1));
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 == p2);
+  mu_check(p1 != h1);
+
+  /* Assigning a property changes the hash */
+  mu_assert_int_eq(0, dlite_instance_set_property(copy, "mystring", &s));
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 != p2);
+  s = "allocated string...";
+  mu_assert_int_eq(0, dlite_instance_set_property(copy, "mystring", &s));
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 == p2);
+
+  /* Writing through a retained pointer changes the hash */
+  arr = dlite_instance_get_property(copy, "myarray");
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 == p2);
+  arr[5]++;
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 != p2);
+  arr[5]--;
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 == p2);
+
+  /* So does writing directly to the property memory */
+  *(uint16_t *)DLITE_PROP(copy, 4) = v;
+  mu_assert_int_eq(0, dlite_instance_payload_hash(copy, &p2));
+  mu_check(p1 != p2);
+
+  dlite_instance_decref(copy);
+}
+
+
+MU_TEST(test_sha3)
+{
+  unsigned char d1[64], d2[64];
+  uint16_t *v;
+  mu_assert_int_eq(0, dlite_instance_sha3(inst, 256, d1));
+  mu_assert_int_eq(0, dlite_instance_sha3(inst, 256, d2));
+  mu_check(memcmp(d1, d2, 32) == 0);
+  v = dlite_instance_get_property(inst, "myshort");
+  (*v)++;
+  mu_assert_int_eq(0, dlite_instance_sha3(inst, 512, d2));
+  mu_check(memcmp(d1, d2, 32) != 0);
+  (*v)--;
+  mu_check(dlite_instance_sha3(inst, 100, d2));
+  dlite_errclr();
+}
+
+
+MU_TEST(test_free)
+{
+  dlite_instance_decref(inst);
+  dlite_meta_decref(meta);
+}
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_load);
+  MU_RUN_TEST(test_hash);
+  MU_RUN_TEST(test_sha3);
+  MU_RUN_TEST(test_free);
+}
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
@@ -6,6 +6,7 @@
 #include "utils/integers.h"
 #include "dlite.h"
 #include "dlite-macros.h"
+#include "dlite-binary.h"
 
 #include "minunit/minunit.h"
 
@@ -117,6 +118,182 @@ MU_TEST(test_sscan)
 
 
 
+MU_TEST(test_string_heap)
+{
+  char *dims[] = {"N"};
+  DLiteDimension dimensions[] = {{"N", "Number of words."}};
+  DLiteProperty properties[] = {
+    {"words", dliteStringPtr, sizeof(char *), 1, dims, NULL, NULL, "Words."}
+  };
+  DLiteMeta *wmeta;
+  DLiteInstance *src, *inst, *inst2;
+  size_t i, n=1000, len, nerr=0;
+  char **words, **w, *json, *arr;
+  const char *arrstart;
+  const DLiteProperty *p;
+  unsigned char *buf;
+
+  mu_check((wmeta = dlite_meta_create("http://onto-ns.com/meta/0.1/Words",
+                                      "Test entity with a string array.",
+                                      NULL, 1, dimensions, 1, properties)));
+  mu_check((src = dlite_instance_create(wmeta, &n, "words-source")));
+  words = calloc(n, sizeof(char *));
+  for (i=0; i<n; i++) {
+    words[i] = malloc(32);
+    snprintf(words[i], 32, "word%lu", (unsigned long)i);
+  }
+  mu_check(dlite_instance_set_property(src, "words", words) == 0);
+  mu_check(!dlite_instance_has_string_heap(src, 0));
+  mu_check((json = dlite_json_aprint(src, 0, 0)));
+  mu_check((arrstart = strchr(strstr(json, "\"words\""), '[')));
+  arr = strndup(arrstart, strrchr(json, ']') - arrstart + 1);
+  dlite_instance_decref(src);
+
+  /* scanning a string array uses a string heap */
+  mu_check((inst = dlite_json_sscan(json, NULL, NULL)));
+  mu_check(dlite_instance_has_string_heap(inst, 0));
+  w = (char **)dlite_instance_peek_property(inst, "words");
+  for (i=0; i<n; i++) if (strcmp(words[i], w[i])) nerr++;
+  mu_assert_int_eq(0, nerr);
+
+  /* the binary decoder also creates a string heap */
+  mu_check((buf = dlite_binary_aencode(inst, &len)));
+  dlite_instance_decref(inst);
+  mu_check((inst = dlite_binary_decode(buf, len, NULL)));
+  free(buf);
+  mu_check(dlite_instance_has_string_heap(inst, 0));
+  w = (char **)dlite_instance_peek_property(inst, "words");
+  mu_assert_string_eq(words[n-1], w[n-1]);
+
+  /* scanning to individually allocated strings gives the same result */
+  mu_check((inst2 = dlite_instance_create(wmeta, &n, NULL)));
+  p = wmeta->_properties;
+  mu_check(dlite_property_scan(arr, *(void **)DLITE_PROP(inst2, 0), p,
+                               DLITE_PROP_DIMS(inst2, 0), 0) > 0);
+  w = (char **)dlite_instance_peek_property(inst2, "words");
+  mu_assert_string_eq(words[n-1], w[n-1]);
+  dlite_instance_decref(inst2);
+
+  /* writing unpacks the heap */
+  mu_check(dlite_instance_pack_strings(inst) == 0);
+  w = dlite_instance_get_property(inst, "words");
+  mu_check(!dlite_instance_has_string_heap(inst, 0));
+  free(w[0]);
+  w[0] = strdup("changed");
+  mu_assert_string_eq(words[1], w[1]);
+
+  /* ...and packing packs it again */
+  mu_check(dlite_instance_pack_strings(inst) == 0);
+  mu_check(dlite_instance_has_string_heap(inst, 0));
+  w = (char **)dlite_instance_peek_property(inst, "words");
+  mu_assert_string_eq("changed", w[0]);
+  mu_assert_string_eq(words[n-1], w[n-1]);
+  dlite_instance_decref(inst);
+
+  for (i=0; i<n; i++) free(words[i]);
+  free(words);
+  free(arr);
+  free(json);
+  dlite_meta_decref(wmeta);
+}
+
+
+MU_TEST(test_numeric_arrays)
+{
+  char *dims[] = {"N"};
+  DLiteDimension dimensions[] = {{"N", "Number of elements."}};
+  DLiteProperty properties[] = {
+    {"f64", dliteFloat, 8, 1, dims, NULL, NULL, ""},
+    {"f32", dliteFloat, 4, 1, dims, NULL, NULL, ""},
+    {"i32", dliteInt,   4, 1, dims, NULL, NULL, ""},
+    {"i8",  dliteInt,   1, 1, dims, NULL, NULL, ""},
+    {"u16", dliteUInt,  2, 1, dims, NULL, NULL, ""},
+    {"b",   dliteBool,  sizeof(bool), 1, dims, NULL, NULL, ""}
+  };
+  char *src =
+    "{\"meta\": \"http://onto-ns.com/meta/0.1/Numbers\", "
+    "\"dimensions\": {\"N\": 6}, \"properties\": {"
+    "\"f64\": [0.1, -2.5e-3, 123456789012345678901234, 1e300, "
+    "0.2500000000000000000000000000000000000000000000000000000000000000000001, "
+    "7], "
+    "\"f32\": [0.1, 3.4028235e38, 1e-3, -1.5, 16777217, 2], "
+    "\"i32\": [0, -2147483648, 2147483647, 12345678, -1, 1], "
+    "\"i8\": [127, -128, 0, 1, -1, 42], "
+    "\"u16\": [0, 65535, 1, 2, 3, 4], "
+    "\"b\": [true, false, true, 1, 0, false]}}";
+  DLiteMeta *nmeta;
+  DLiteInstance *inst, *ref;
+  const double *f64;
+  const float *f32;
+  const int32_t *i32;
+  const int8_t *i8;
+  const uint16_t *u16;
+  const bool *b;
+  char *json, *arrstart, *arr;
+  double *v;
+  size_t i, nbig=10000;
+
+  mu_check((nmeta = dlite_meta_create("http://onto-ns.com/meta/0.1/Numbers",
+                                      "Test entity with numeric arrays.",
+                                      NULL, 1, dimensions, 6, properties)));
+
+  mu_check((inst = dlite_json_sscan(src, NULL, NULL)));
+
+  f64 = dlite_instance_peek_property(inst, "f64");
+  mu_assert_double_eq(0.1, f64[0]);
+  mu_assert_double_eq(-2.5e-3, f64[1]);
+  mu_assert_double_eq(123456789012345678901234.0, f64[2]);
+  mu_assert_double_eq(1e300, f64[3]);
+  mu_assert_double_eq(0.25, f64[4]);
+  mu_assert_double_eq(7.0, f64[5]);
+  f32 = dlite_instance_peek_property(inst, "f32");
+  mu_check(f32[0] == 0.1f);
+  mu_check(f32[1] == 3.4028235e38f);
+  mu_check(f32[2] == 1e-3f);
+  mu_check(f32[4] == 16777216.0f);
+  i32 = dlite_instance_peek_property(inst, "i32");
+  mu_assert_int_eq(INT32_MIN, i32[1]);
+  mu_assert_int_eq(INT32_MAX, i32[2]);
+  mu_assert_int_eq(12345678, i32[3]);
+  mu_assert_int_eq(1, i32[5]);
+  i8 = dlite_instance_peek_property(inst, "i8");
+  mu_assert_int_eq(-128, i8[1]);
+  u16 = dlite_instance_peek_property(inst, "u16");
+  mu_assert_int_eq(65535, u16[1]);
+  b = dlite_instance_peek_property(inst, "b");
+  mu_check(b[0] && !b[1] && b[2] && b[3] && !b[4] && !b[5]);
+  dlite_instance_decref(inst);
+  dlite_meta_decref(nmeta);
+
+  /* the fast path must give the same result as dlite_property_scan() */
+  properties[0].dims = dims;
+  mu_check((nmeta = dlite_meta_create("http://onto-ns.com/meta/0.1/Doubles",
+                                      "Test entity with a double array.",
+                                      NULL, 1, dimensions, 1, properties)));
+  mu_check((inst = dlite_instance_create(nmeta, &nbig, "doubles")));
+  v = dlite_instance_get_property(inst, "f64");
+  for (i=0; i<nbig; i++) v[i] = (i % 7 - 3) * 1.37 * i / (i % 1000 + 1);
+  mu_check((json = dlite_json_aprint(inst, 0, 0)));
+  dlite_instance_decref(inst);
+
+  mu_check((inst = dlite_json_sscan(json, NULL, NULL)));
+  mu_check((ref = dlite_instance_create(nmeta, &nbig, NULL)));
+  mu_check((arrstart = strchr(strstr(json, "\"f64\""), '[')));
+  arr = strndup(arrstart, strchr(arrstart, ']') - arrstart + 1);
+  mu_check(dlite_property_scan(arr, *(void **)DLITE_PROP(ref, 0),
+                               nmeta->_properties, DLITE_PROP_DIMS(ref, 0),
+                               0) > 0);
+  mu_check(memcmp(dlite_instance_peek_property(inst, "f64"),
+                  dlite_instance_peek_property(ref, "f64"),
+                  nbig*sizeof(double)) == 0);
+  dlite_instance_decref(ref);
+  dlite_instance_decref(inst);
+  dlite_meta_decref(nmeta);
+  free(arr);
+  free(json);
+}
+
+
 
 /***********************************************************************/
 
@@ -127,6 +304,8 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_append);
   MU_RUN_TEST(test_decref);
   MU_RUN_TEST(test_sscan);
+  MU_RUN_TEST(test_string_heap);
+  MU_RUN_TEST(test_numeric_arrays);
 }
 
 
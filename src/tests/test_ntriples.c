@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "utils/session.h"
+#include "minunit/minunit.h"
+#include "ntriples.h"
+#include "triplestore.h"
+
+
+/* Collects parsed statements in a buffer */
+typedef struct {
+  int n;
+  char buf[4096];
+  size_t len;
+} Result;
+
+static int handler(void *data, const char *s, const char *p, const char *o,
+                   const TripleObjType *type, const char *g)
+{
+  Result *r = data;
+  r->len += snprintf(r->buf + r->len, sizeof(r->buf) - r->len,
+                     "%s|%s|%s|%d|%s|%s|%s\n", s, p, o, type->literal,
+                     (type->lang) ? type->lang : "",
+                     (type->datatype_uri) ? type->datatype_uri : "",
+                     (g) ? g : "");
+  r->n++;
+  return 0;
+}
+
+
+static const char *doc =
+  "# a comment\n"
+  "<http://ex.org/a> <http://ex.org/p> <http://ex.org/b> .\n"
+  "\n"
+  "_:b1 <http://ex.org/name> \"Alice \\\"A\\\"\\n\"@en-GB .\n"
+  "<http://ex.org/a> <http://ex.org/n> \"42\"^^<http://www.w3.org/2001/"
+  "XMLSchema#integer> .  # trailing comment\r\n"
+  "<http://ex.org/\\u00e5> <http://ex.org/p> _:b1.\n"
+  "<http://ex.org/a> <http://ex.org/p> \"x\" <http://ex.org/graph> .";
+
+static const char *expected =
+  "http://ex.org/a|http://ex.org/p|http://ex.org/b|0|||\n"
+  "_:b1|http://ex.org/name|Alice \"A\"\n|1|en-GB||\n"
+  "http://ex.org/a|http://ex.org/n|42|1||"
+  "http://www.w3.org/2001/XMLSchema#integer|\n"
+  "http://ex.org/\xc3\xa5|http://ex.org/p|_:b1|0|||\n"
+  "http://ex.org/a|http://ex.org/p|x|1|||http://ex.org/graph\n";
+
+
+MU_TEST(test_parse_chunked)
+{
+  size_t chunksize, len = strlen(doc);
+
+  /* Parse with all chunk sizes, to test lines split between chunks */
+  for (chunksize=1; chunksize <= len; chunksize++) {
+    Result r;
+    NTriplesParser *parser;
+    size_t pos;
+    memset(&r, 0, sizeof(r));
+    mu_check((parser = ntriples_parser_create(handler, &r)));
+    for (pos=0; pos < len; pos += chunksize) {
+      size_t n = (pos + chunksize < len) ? chunksize : len - pos;
+      mu_assert_int_eq(0, ntriples_parser_feed(parser, doc + pos, n));
+    }
+    mu_assert_int_eq(0, ntriples_parser_finish(parser));
+    mu_assert_int_eq(5, ntriples_parser_count(parser));
+    ntriples_parser_free(parser);
+    mu_assert_int_eq(5, r.n);
+    mu_check(strcmp(expected, r.buf) == 0);
+  }
+}
+
+
+MU_TEST(test_parse_error)
+{
+  Result r;
+  NTriplesParser *parser;
+  const char *bad = "<http://ex.org/a> <http://ex.org/p> \"unterminated .\n";
+  memset(&r, 0, sizeof(r));
+  mu_check((parser = ntriples_parser_create(handler, &r)));
+  mu_check(ntriples_parser_feed(parser, bad, strlen(bad)));
+  ntriples_parser_free(parser);
+  mu_assert_int_eq(0, r.n);
+}
+
+
+MU_TEST(test_write_roundtrip)
+{
+  Result r;
+  FILE *fp;
+  TripleObjType uri = {0, NULL, NULL};
+  TripleObjType en = {1, "en-GB", NULL};
+  TripleObjType integer = {1, NULL, "http://www.w3.org/2001/XMLSchema#integer"};
+
+  mu_check((fp = tmpfile()));
+  mu_assert_int_eq(0, ntriples_write(fp, "http://ex.org/a", "http://ex.org/p",
+                                     "http://ex.org/b", &uri, NULL));
+  mu_assert_int_eq(0, ntriples_write(fp, "_:b1", "http://ex.org/name",
+                                     "Alice \"A\"\n", &en, NULL));
+  mu_assert_int_eq(0, ntriples_write(fp, "http://ex.org/a", "http://ex.org/n",
+                                     "42", &integer, NULL));
+  mu_assert_int_eq(0, ntriples_write(fp, "http://ex.org/\xc3\xa5",
+                                     "http://ex.org/p", "_:b1", &uri, NULL));
+  mu_assert_int_eq(0, ntriples_write(fp, "http://ex.org/a", "http://ex.org/p",
+                                     "x", NULL, "http://ex.org/graph"));
+  rewind(fp);
+  memset(&r, 0, sizeof(r));
+  mu_assert_int_eq(5, ntriples_parse_file(fp, handler, &r));
+  fclose(fp);
+  mu_check(strcmp(expected, r.buf) == 0);
+}
+
+
+#ifndef HAVE_REDLAND
+MU_TEST(test_triplestore_roundtrip)
+{
+  TripleStore *ts, *ts2;
+  TripleState state;
+  const Triple *t;
+  FILE *fp;
+  int n=0;
+
+  mu_check((ts = triplestore_create()));
+  triplestore_set_namespace(ts, "ex");
+  mu_assert_int_eq(0, triplestore_add_uri(ts, "a", "rdf:type", "owl:Thing"));
+  mu_assert_int_eq(0, triplestore_add_en(ts, "a", "hasLabel", "A"));
+  mu_assert_int_eq(0, triplestore_add2(ts, "a", "hasSize", "3", 1, NULL,
+                                       "xsd:integer"));
+  mu_assert_int_eq(3, triplestore_length(ts));
+
+  mu_check((fp = tmpfile()));
+  mu_assert_int_eq(0, triplestore_save_ntriples(ts, fp));
+  rewind(fp);
+  mu_check((ts2 = triplestore_create()));
+  mu_assert_int_eq(0, triplestore_load_ntriples(ts2, fp));
+  fclose(fp);
+  mu_assert_int_eq(3, triplestore_length(ts2));
+
+  t = triplestore_find_first(ts2, "ex:a", "ex:hasLabel", NULL);
+  mu_check(t);
+  mu_assert_string_eq("A", t->o);
+  t = triplestore_find_first(ts2, "ex:a", "rdf:type", NULL);
+  mu_check(t);
+  mu_assert_string_eq("owl:Thing", t->o);
+
+  /* triplestore_get() should find triples by id also after removal */
+  triplestore_init_state(ts2, &state);
+  while ((t = triplestore_next(&state))) n++;
+  triplestore_deinit_state(&state);
+  mu_assert_int_eq(3, n);
+  mu_assert_int_eq(1, triplestore_remove(ts2, "ex:a", "rdf:type", NULL));
+  t = triplestore_find_first(ts2, "ex:a", "ex:hasSize", NULL);
+  mu_check(t);
+  mu_check(triplestore_get(ts2, t->id) == t);
+
+  triplestore_free(ts);
+  triplestore_free(ts2);
+}
+#endif
+
+
+MU_TEST(test_free)
+{
+  Session *s = session_get_default();
+  session_free(s);
+}
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_parse_chunked);
+  MU_RUN_TEST(test_parse_error);
+  MU_RUN_TEST(test_write_roundtrip);
+#ifndef HAVE_REDLAND
+  MU_RUN_TEST(test_triplestore_roundtrip);
+#endif
+  MU_RUN_TEST(test_free);
+}
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
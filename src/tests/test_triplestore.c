@@ -1,10 +1,15 @@
+#include "config.h"
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <time.h>
 
 #include "utils/session.h"
 #include "minunit/minunit.h"
 #include "triplestore.h"
+#include "triplestore-query.h"
 
 
 TripleStore *ts;
@@ -92,6 +97,71 @@ MU_TEST(test_find)
 }
 
 
+MU_TEST(test_query)
+{
+  TripleResult *r;
+  int x, y;
+
+  /* single pattern with wildcard */
+  TriplePattern p1[] = {{"?x", "is-a", NULL}};
+  mu_check((r = triplestore_query(ts, p1, 1)));
+  mu_assert_int_eq(1, triplestore_result_nvars(r));
+  mu_assert_int_eq(5, triplestore_result_nrows(r));
+  mu_assert_string_eq("?x", triplestore_result_var(r, 0));
+  triplestore_result_free(r);
+
+  /* join on shared variables */
+  TriplePattern p2[] = {
+    {"?x", "is-ontop-of", "?y"},
+    {"?x", "is-a", "thing"},
+    {"?y", "is-a", "thing"},
+  };
+  mu_check((r = triplestore_query(ts, p2, 3)));
+  mu_assert_int_eq(2, triplestore_result_nvars(r));
+  mu_assert_int_eq(1, triplestore_result_nrows(r));
+  x = triplestore_result_varindex(r, "?x");
+  y = triplestore_result_varindex(r, "?y");
+  mu_assert_string_eq("book", triplestore_result_value(r, 0, x));
+  mu_assert_string_eq("table", triplestore_result_value(r, 0, y));
+  mu_check(triplestore_result_value(r, 1, x) == NULL);
+  mu_assert_int_eq(-1, triplestore_result_varindex(r, "?z"));
+  triplestore_result_free(r);
+
+  /* cross product of unconnected patterns */
+  TriplePattern p3[] = {
+    {"?x", "is-a", "thing"},
+    {"?y", "is-a", "action"},
+  };
+  mu_check((r = triplestore_query(ts, p3, 2)));
+  mu_assert_int_eq(6, triplestore_result_nrows(r));
+  triplestore_result_free(r);
+
+  /* repeated variable within a pattern */
+  mu_assert_int_eq(0, triplestore_add(ts, "self", "is-a", "self"));
+  TriplePattern p4[] = {{"?x", "is-a", "?x"}};
+  mu_check((r = triplestore_query(ts, p4, 1)));
+  mu_assert_int_eq(1, triplestore_result_nrows(r));
+  mu_assert_string_eq("self", triplestore_result_value(r, 0, 0));
+  triplestore_result_free(r);
+  mu_assert_int_eq(1, triplestore_remove(ts, "self", NULL, NULL));
+
+  /* no solutions */
+  TriplePattern p5[] = {
+    {"?x", "is-ontop-of", "?y"},
+    {"?y", "is-a", "action"},
+  };
+  mu_check((r = triplestore_query(ts, p5, 2)));
+  mu_assert_int_eq(0, triplestore_result_nrows(r));
+  triplestore_result_free(r);
+
+  /* empty pattern has a single empty solution */
+  mu_check((r = triplestore_query(ts, NULL, 0)));
+  mu_assert_int_eq(0, triplestore_result_nvars(r));
+  mu_assert_int_eq(1, triplestore_result_nrows(r));
+  triplestore_result_free(r);
+}
+
+
 MU_TEST(test_remove)
 {
   mu_check(6 == triplestore_length(ts));
@@ -104,6 +174,70 @@ MU_TEST(test_remove)
 }
 
 
+#ifndef HAVE_REDLAND
+MU_TEST(test_snapshot)
+{
+  TripleStore *ts2;
+  TripleState state, state2;
+  const Triple *t;
+  int i, n=0, m=0;
+  clock_t t0;
+
+  mu_check((ts2 = triplestore_create()));
+  mu_assert_int_eq(0, triplestore_add(ts2, "a", "is-a", "letter"));
+  mu_assert_int_eq(0, triplestore_add(ts2, "b", "is-a", "letter"));
+  mu_assert_int_eq(0, triplestore_add(ts2, "c", "is-a", "letter"));
+
+  /* mutations while iterating do not affect the snapshot */
+  triplestore_init_state(ts2, &state);
+  mu_check((t = triplestore_next(&state)));
+  n++;
+  mu_assert_int_eq(1, triplestore_remove(ts2, "b", NULL, NULL));
+  mu_assert_int_eq(1, triplestore_remove(ts2, "c", NULL, NULL));
+  mu_assert_int_eq(0, triplestore_add(ts2, "d", "is-a", "letter"));
+  mu_assert_int_eq(2, triplestore_length(ts2));
+  mu_check(!triplestore_find_first(ts2, "b", NULL, NULL));
+
+  /* a new iterator sees the current state */
+  triplestore_init_state(ts2, &state2);
+  while ((t = triplestore_next(&state2))) {
+    mu_check(strcmp(t->s, "b") && strcmp(t->s, "c"));
+    m++;
+  }
+  triplestore_deinit_state(&state2);
+  mu_assert_int_eq(2, m);
+
+  while ((t = triplestore_next(&state))) {
+    mu_check(strcmp(t->s, "d"));
+    n++;
+  }
+  triplestore_deinit_state(&state);
+  mu_assert_int_eq(3, n);
+
+  /* alternating iteration and mutation */
+  for (i=0; i<20000; i++) {
+    char s[32];
+    snprintf(s, sizeof(s), "x%d", i);
+    mu_assert_int_eq(0, triplestore_add(ts2, s, "is-a", "letter"));
+  }
+  t0 = clock();
+  for (i=0; i<20000; i++) {
+    triplestore_init_state(ts2, &state);
+    while ((t = triplestore_next(&state)) && t->s[0] != 'x') ;
+    if (!t || triplestore_remove_by_id(ts2, t->id)) break;
+    triplestore_deinit_state(&state);
+  }
+  printf("\n  20000 alternating iterations and removals: %.3f s\n",
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  mu_assert_int_eq(20000, i);
+  mu_assert_int_eq(2, triplestore_length(ts2));
+  mu_check(triplestore_find_first(ts2, "d", NULL, NULL));
+
+  triplestore_free(ts2);
+}
+#endif
+
+
 MU_TEST(test_free)
 {
   triplestore_free(ts);
@@ -123,7 +257,11 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_add);
   MU_RUN_TEST(test_next);
   MU_RUN_TEST(test_find);
+  MU_RUN_TEST(test_query);
   MU_RUN_TEST(test_remove);
+#ifndef HAVE_REDLAND
+  MU_RUN_TEST(test_snapshot);
+#endif
   MU_RUN_TEST(test_free);
 }
 
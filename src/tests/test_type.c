@@ -2,11 +2,13 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "config.h"
 
 #include "minunit/minunit.h"
 #include "utils/integers.h"
+#include "utils/floats.h"
 #include "utils/boolean.h"
 #include "utils/err.h"
 #include "dlite.h"
@@ -522,6 +524,121 @@ MU_TEST(test_type_ndcast)
 }
 
 
+/* Cast function that prevents dlite_type_ndcast() from using kernels */
+static int percast(void *dest, DLiteType dest_type, size_t dest_size,
+                   const void *src, DLiteType src_type, size_t src_size)
+{
+  return dlite_type_copy_cast(dest, dest_type, dest_size,
+                              src, src_type, src_size);
+}
+
+MU_TEST(test_type_ndcast_kernels)
+{
+  size_t i, N=4000000;
+  size_t dims[] = {2000, 2000};
+  int32_t *s = malloc(N*sizeof(int32_t));
+  float64_t *d = malloc(N*sizeof(float64_t));
+  uint16_t u[4];
+  int8_t neg[] = {1, 2, -3, 4};
+  size_t ndims[] = {4};
+  clock_t t0, t1, t2;
+  mu_check(s && d);
+
+  for (i=0; i<N; i++) s[i] = (int32_t)i - 1000;
+  t0 = clock();
+  mu_assert_int_eq(0, dlite_type_ndcast(2, d, dliteFloat, 8, dims, NULL,
+                                        s, dliteInt, 4, dims, NULL, NULL));
+  t1 = clock();
+  mu_assert_double_eq(-1000.0, d[0]);
+  mu_assert_double_eq((double)N - 1001.0, d[N-1]);
+  mu_assert_int_eq(0, dlite_type_ndcast(2, d, dliteFloat, 8, dims, NULL,
+                                        s, dliteInt, 4, dims, NULL, percast));
+  t2 = clock();
+  mu_assert_double_eq((double)N - 1001.0, d[N-1]);
+  printf("\n  ndcast int32 -> float64 of %lu elements: kernel %.3f s, "
+         "per element %.3f s\n", (unsigned long)N,
+         (double)(t1 - t0) / CLOCKS_PER_SEC,
+         (double)(t2 - t1) / CLOCKS_PER_SEC);
+
+  /* all numerical combinations have kernels */
+  mu_check(dlite_type_get_cast_kernel(dliteUInt, 1, dliteFloat, 8));
+  mu_check(dlite_type_get_cast_kernel(dliteInt, 8, dliteUInt, 2));
+  mu_check(!dlite_type_get_cast_kernel(dliteStringPtr, sizeof(char *),
+                                       dliteInt, 4));
+
+  /* negative values cannot be casted to unsigned */
+  mu_check(dlite_type_ndcast(1, u, dliteUInt, 2, ndims, NULL,
+                             neg, dliteInt, 1, ndims, NULL, NULL));
+  neg[2] = 3;
+  mu_assert_int_eq(0, dlite_type_ndcast(1, u, dliteUInt, 2, ndims, NULL,
+                                        neg, dliteInt, 1, ndims, NULL, NULL));
+  mu_assert_int_eq(3, u[2]);
+
+  free(s);
+  free(d);
+}
+
+
+MU_TEST(test_type_ndcast_reorder)
+{
+  size_t i, j, k, n0=2000, n1=1600, N=n0*n1;
+  size_t dims[] = {n0, n1};
+  int fstrides[] = {8, 8*n0};
+  size_t dims3[] = {120, 150, 170};
+  int fstrides3[] = {8, 8*120, 8*120*150};
+  size_t sdims[] = {2, 3}, ddims[] = {3, 2};
+  int sstrides[] = {4, 8}, dstrides[] = {4, 12};
+  int32_t a[] = {0, 3, 1, 4, 2, 5}, b[6];
+  float64_t *s = malloc(N*sizeof(float64_t));
+  float64_t *d = malloc(N*sizeof(float64_t));
+  int32_t *s3 = malloc(120*150*170*sizeof(int32_t));
+  clock_t t0;
+  int ok=1;
+  mu_check(s && d && s3);
+
+  /* 2D, C to Fortran order */
+  for (i=0; i<N; i++) s[i] = (float64_t)i;
+  t0 = clock();
+  mu_assert_int_eq(0, dlite_type_ndcast(2, d, dliteFloat, 8, dims, fstrides,
+                                        s, dliteFloat, 8, dims, NULL, NULL));
+  printf("\n  ndcast C -> F of %lux%lu float64: %.3f s\n",
+         (unsigned long)n0, (unsigned long)n1,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  for (i=0; i<n0; i++)
+    for (j=0; j<n1; j++)
+      if (d[j*n0 + i] != s[i*n1 + j]) ok = 0;
+  mu_check(ok);
+
+  /* 3D, C to Fortran order with cast from int32 to float64 */
+  for (i=0; i<120*150*170; i++) s3[i] = (int32_t)i;
+  t0 = clock();
+  mu_assert_int_eq(0, dlite_type_ndcast(3, d, dliteFloat, 8, dims3, fstrides3,
+                                        s3, dliteInt, 4, dims3, NULL, NULL));
+  printf("  ndcast C -> F of 120x150x170 int32 -> float64: %.3f s\n",
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  for (i=0; i<120; i++)
+    for (j=0; j<150; j++)
+      for (k=0; k<170; k++)
+        if (d[(k*150 + j)*120 + i] != s3[(i*150 + j)*170 + k]) ok = 0;
+  mu_check(ok);
+
+  /* Fortran ordered source and dest with different shapes */
+  mu_assert_int_eq(0, dlite_type_ndcast(2, b, dliteInt, 4, ddims, dstrides,
+                                        a, dliteInt, 4, sdims, sstrides,
+                                        NULL));
+  mu_assert_int_eq(0, b[0]);
+  mu_assert_int_eq(2, b[1]);
+  mu_assert_int_eq(4, b[2]);
+  mu_assert_int_eq(1, b[3]);
+  mu_assert_int_eq(3, b[4]);
+  mu_assert_int_eq(5, b[5]);
+
+  free(s);
+  free(d);
+  free(s3);
+}
+
+
 /***********************************************************************/
 
 MU_TEST_SUITE(test_suite)
@@ -543,6 +660,8 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_get_member_offset);
   MU_RUN_TEST(test_copy_cast);
   MU_RUN_TEST(test_type_ndcast);
+  MU_RUN_TEST(test_type_ndcast_kernels);
+  MU_RUN_TEST(test_type_ndcast_reorder);
 }
 
 
@@ -22,12 +22,14 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "utils/err.h"
 #include "utils/sha1.h"
 #include "utils/map.h"
 #include "triplestore.h"
+#include "ntriples.h"
 
 #define UNUSED(x) (void)(x)
 
@@ -40,9 +42,36 @@
 /* Prototype for cleanup-function */
 typedef void (*Freer)(void *ptr);
 
-/* Triple store. */
+/* Compact representation of the type of an object.  The language and
+   datatype are indices into the `strings` array of the triplestore
+   or -1 if not given. */
+typedef struct {
+  int literal;        /*!< non-zero if object is a literal */
+  int lang;           /*!< index of language or -1 */
+  int datatype;       /*!< index of datatype uri or -1 */
+} ObjType;
+
+/* Lifetime of a triple, expressed in epochs.  An iterator started in
+   epoch `e` sees the triple if `added <= e` and the triple is not
+   removed or was removed after `e`. */
+typedef struct {
+  size_t added;       /*!< epoch in which the triple was added */
+  size_t removed;     /*!< epoch in which the triple was removed or 0 */
+} Lifetime;
+
+/* Triple store.
+
+   Each iterator works on a snapshot of the store, identified by the
+   epoch in which it was started.  Triples removed while iterators are
+   running are not moved or freed, but are only marked as removed.
+   These tombstones are reclaimed by compact() once there are no
+   running iterators and they make up a significant fraction of the
+   store, such that the cost of compaction is amortised over the
+   removals. */
 struct _TripleStore {
   Triple *triples;  /*!< array of triples */
+  ObjType *types;     /*!< array of object types, one for each triple */
+  Lifetime *lifetimes; /*!< array of lifetimes, one for each triple */
   size_t length;      /*!< logically number of triples (excluding pending
                            removes */
   size_t true_length; /*!< number of triples (including pending removes) */
@@ -51,8 +80,14 @@ struct _TripleStore {
   map_int_t map;      /*!< a mapping from triple id to its corresponding
                            index in `triples` */
   size_t niter;       /*!< counter for number of running iterators */
+  size_t epoch;       /*!< current epoch, incremented for each iterator */
   int freed;          /*!< set to non-zero when this store is supposed to
                            be freed, but kept alive due to existing iterators */
+
+  char *ns;           /*!< default namespace */
+  char **strings;     /*!< interned language and datatype strings */
+  size_t nstrings;    /*!< number of interned strings */
+  map_int_t strmap;   /*!< maps interned strings to their index */
 };
 
 
@@ -62,21 +97,57 @@ struct _TripleStore {
 TripleStore *triplestore_create()
 {
   TripleStore *ts = calloc(1, sizeof(TripleStore));
+  if (ts) ts->epoch = 1;
   return ts;
 }
 
 /*
   Returns a new empty triplestore or NULL on error.
+
+  The builtin triplestore is kept in memory.  The following storages
+  are supported:
+    - "memory", "hashes" or NULL: an empty in-memory triplestore
+    - "file": the triplestore is populated from the N-Triples (or
+      N-Quads) file `name` if it exists
+
+  Other storage names are accepted with a warning, and treated as "memory".
+  `options` are ignored.
  */
 TripleStore *triplestore_create_with_storage(const char *storage_name,
                                              const char *name,
                                              const char *options)
 {
-  UNUSED(storage_name);
-  UNUSED(name);
+  TripleStore *ts;
   UNUSED(options);
-  warn("builtin triplestore does not support a storage");
-  return triplestore_create();
+  if (!(ts = triplestore_create())) return NULL;
+  if (storage_name && strcmp(storage_name, "file") == 0) {
+    FILE *fp;
+    if (name && (fp = fopen(name, "rb"))) {
+      int stat = triplestore_load_ntriples(ts, fp);
+      fclose(fp);
+      if (stat) {
+        triplestore_free(ts);
+        return NULL;
+      }
+    }
+  } else if (storage_name && strcmp(storage_name, "memory") &&
+             strcmp(storage_name, "hashes")) {
+    warn("builtin triplestore does not support storage \"%s\", "
+         "using \"memory\"", storage_name);
+  }
+  return ts;
+}
+
+
+/* Frees interned strings. */
+static void free_strings(TripleStore *ts)
+{
+  size_t i;
+  for (i=0; i<ts->nstrings; i++) free(ts->strings[i]);
+  if (ts->strings) free(ts->strings);
+  map_deinit(&ts->strmap);
+  ts->strings = NULL;
+  ts->nstrings = 0;
 }
 
 
@@ -87,6 +158,8 @@ void triplestore_free(TripleStore *ts)
 {
   assert(ts->freed == 0 || ts->niter == 0);
   triplestore_clear(ts);
+  if (ts->ns) free(ts->ns);
+  ts->ns = NULL;
   if (ts->niter > 0)
     ts->freed = 1;
   else
@@ -94,6 +167,25 @@ void triplestore_free(TripleStore *ts)
 }
 
 
+/*
+  Set default namespace
+*/
+void triplestore_set_namespace(TripleStore *ts, const char *ns)
+{
+  if (ts->ns) free(ts->ns);
+  ts->ns = (ns) ? strdup(ns) : NULL;
+}
+
+/*
+  Returns a pointer to default namespace.
+  It may be NULL if it hasn't been set.
+*/
+const char *triplestore_get_namespace(TripleStore *ts)
+{
+  return ts->ns;
+}
+
+
 /*
   Returns the number of triples in the store.
 */
@@ -115,30 +207,47 @@ size_t triplestore_length(TripleStore *ts)
 //}
 
 
-/*
-  Adds a single triple to store.  Returns non-zero on error.
- */
-int triplestore_add(TripleStore *ts, const char *s, const char *p,
-                    const char *o)
+/* Returns index of interned copy of `str` or -1 if `str` is NULL.
+   Returns -2 on error. */
+static int intern(TripleStore *ts, const char *str)
 {
-  Triple t;
-  t.s = (char *)s;
-  t.p = (char *)p;
-  t.o = (char *)o;
-  t.id = NULL;
-  return triplestore_add_triples(ts, &t, 1);
+  int *n;
+  void *ptr;
+  if (!str) return -1;
+  if ((n = map_get(&ts->strmap, str))) return *n;
+  if (!(ptr = realloc(ts->strings, (ts->nstrings+1)*sizeof(char *))))
+    return err(-2, "allocation failure");
+  ts->strings = ptr;
+  if (!(ts->strings[ts->nstrings] = strdup(str)))
+    return err(-2, "allocation failure");
+  map_set(&ts->strmap, str, ts->nstrings);
+  return ts->nstrings++;
 }
 
-
-/*
-  Adds `n` triples to store.  Returns non-zero on error.
- */
-int triplestore_add_triples(TripleStore *ts, const Triple *triples,
-                             size_t n)
+/* Returns a newly allocated copy of `uri`.  If `uri` has no namespace,
+   the default namespace is prepended, like for the redland backend. */
+static char *expand_uri(TripleStore *ts, const char *uri)
 {
-  size_t i;
+  char *s;
+  if (ts->ns && !strchr(uri, ':')) {
+    size_t len_ns = strlen(ts->ns);
+    size_t len_uri = strlen(uri);
+    if (!(s = malloc(len_ns + len_uri + 2))) return NULL;
+    memcpy(s, ts->ns, len_ns);
+    s[len_ns] = ':';
+    memcpy(s + len_ns + 1, uri, len_uri + 1);
+    return s;
+  }
+  return strdup(uri);
+}
 
-  /* make space for new triples */
+/* Forward declaration */
+static void maybe_compact(TripleStore *ts);
+
+/* Makes space for `n` more triples.  Returns non-zero on error. */
+static int reserve(TripleStore *ts, size_t n)
+{
+  if (ts->size < ts->true_length + n) maybe_compact(ts);
   if (ts->size < ts->true_length + n) {
     size_t m = (ts->true_length + n - ts->size) / TRIPLESTORE_BUFFSIZE;
     size_t size = ts->size + (m + 1) * TRIPLESTORE_BUFFSIZE;
@@ -147,62 +256,232 @@ int triplestore_add_triples(TripleStore *ts, const Triple *triples,
     if (!(ptr = realloc(ts->triples, size * sizeof(Triple))))
       return err(1, "allocation failure");
     ts->triples = ptr;
+    if (!(ptr = realloc(ts->types, size * sizeof(ObjType))))
+      return err(1, "allocation failure");
+    ts->types = ptr;
+    if (!(ptr = realloc(ts->lifetimes, size * sizeof(Lifetime))))
+      return err(1, "allocation failure");
+    ts->lifetimes = ptr;
     ts->size = size;
     memset(ts->triples + ts->true_length, 0,
            (ts->size - ts->true_length)*sizeof(Triple));
   }
+  return 0;
+}
 
-  /* append triples (avoid duplicates) */
-  for (i=0; i<n; i++) {
-    Triple *t = ts->triples + ts->true_length;
-    char *id;
-    if (triples[i].id) {
-      if (!(id = strdup(triples[i].id))) return err(1, "allocation error");
-    } else {
-      if (!(id = triple_get_id(NULL, triples[i].s,
-                                triples[i].p, triples[i].o)))
-        return 1;
-    }
-    if (!map_get(&ts->map, id)) {
-      if (!(t->s = strdup(triples[i].s))) return err(1, "allocation error");
-      if (!(t->p = strdup(triples[i].p))) return err(1, "allocation error");
-      if (!(t->o = strdup(triples[i].o))) return err(1, "allocation error");
-      t->id = id;
-      ts->length++;
-      ts->true_length++;
-      map_set(&ts->map, id, i);
-    } else {
-      free(id);
-    }
+/* Appends a single triple to the store, avoiding duplicates.  Space
+   must have been reserved with reserve().  If `id` is NULL, it will be
+   generated from `s`, `p` and `o`.  Returns non-zero on error. */
+static int add_triple(TripleStore *ts, const char *s, const char *p,
+                      const char *o, const char *id, const TripleObjType *type)
+{
+  Triple *t = ts->triples + ts->true_length;
+  ObjType *ot = ts->types + ts->true_length;
+  char *ss=NULL, *pp=NULL, *oo=NULL;
+  int literal = (type) ? type->literal : 1;
+
+  assert(ts->true_length < ts->size);
+  if (!s || !p || !o) return err(1, "cannot add triple with NULL element");
+  if (ts->ns) {
+    if (!(ss = expand_uri(ts, s)) || !(pp = expand_uri(ts, p)) ||
+        (!literal && !(oo = expand_uri(ts, o)))) goto fail;
+    s = ss;
+    p = pp;
+    if (oo) o = oo;
+  }
+  if (id) {
+    if (!(t->id = strdup(id))) goto fail;
+  } else {
+    if (!(t->id = triple_get_id(NULL, s, p, o))) goto fail;
   }
+  if (map_get(&ts->map, t->id)) {
+    free(t->id);
+    t->id = NULL;
+  } else {
+    if (!(t->s = (ss) ? ss : strdup(s))) goto fail;
+    ss = NULL;
+    if (!(t->p = (pp) ? pp : strdup(p))) goto fail;
+    pp = NULL;
+    if (!(t->o = (oo) ? oo : strdup(o))) goto fail;
+    oo = NULL;
+    ot->literal = literal;
+    ts->lifetimes[ts->true_length].added = ts->epoch;
+    ts->lifetimes[ts->true_length].removed = 0;
+    if ((ot->lang = intern(ts, (type) ? type->lang : NULL)) < -1 ||
+        (ot->datatype = intern(ts, (type) ? type->datatype_uri : NULL)) < -1)
+      goto fail;
+    map_set(&ts->map, t->id, ts->true_length);
+    ts->length++;
+    ts->true_length++;
+  }
+  if (ss) free(ss);
+  if (pp) free(pp);
+  if (oo) free(oo);
+  return 0;
+ fail:
+  if (ss) free(ss);
+  if (pp) free(pp);
+  if (oo) free(oo);
+  triple_clean(t);
+  return err(1, "allocation failure");
+}
+
+
+/*
+  Adds a single (s,p,o) triple to store.
+
+  If `literal` is non-zero the object will be considered to be a
+  literal, otherwise it is considered to be an URI.
+
+  If `lang` is not NULL, it must be a valid XML language abbreviation,
+  like "en". Only used if `literal` is non-zero.
+
+  If `datatype_uri` is not NULL, it should be an uri for the literal
+  datatype. Ex: "xsd:integer".
+
+  Returns non-zero on error.
+ */
+int triplestore_add2(TripleStore *ts, const char *s, const char *p,
+                     const char *o, int literal, const char *lang,
+                     const char *datatype_uri)
+{
+  TripleObjType type;
+  type.literal = literal;
+  type.lang = (literal) ? lang : NULL;
+  type.datatype_uri = (literal) ? datatype_uri : NULL;
+  if (reserve(ts, 1)) return 1;
+  return add_triple(ts, s, p, o, NULL, &type);
+}
+
+
+/*
+  Adds a single triple to store.  The object is considered to be a
+  literal with no language.  Returns non-zero on error.
+ */
+int triplestore_add(TripleStore *ts, const char *s, const char *p,
+                    const char *o)
+{
+  return triplestore_add2(ts, s, p, o, 1, NULL, NULL);
+}
 
+/*
+  Adds a single triple to store.  The object is considered to be an
+  english literal.  Returns non-zero on error.
+ */
+int triplestore_add_en(TripleStore *ts, const char *s, const char *p,
+                       const char *o)
+{
+  return triplestore_add2(ts, s, p, o, 1, "en", NULL);
+}
+
+/*
+  Adds a single triple to store.  The object is considered to be an URI.
+  Returns non-zero on error.
+ */
+int triplestore_add_uri(TripleStore *ts, const char *s, const char *p,
+                        const char *o)
+{
+  return triplestore_add2(ts, s, p, o, 0, NULL, NULL);
+}
+
+
+/*
+  Adds `n` triples to store.  Returns non-zero on error.
+ */
+int triplestore_add_triples(TripleStore *ts, const Triple *triples,
+                             size_t n)
+{
+  return triplestore_add_triples2(ts, triples, NULL, n);
+}
+
+
+/*
+  Like triplestore_add_triples(), but with an additional array of
+  object types.  If `types` is NULL, all objects are considered to be
+  literals with no language.
+ */
+int triplestore_add_triples2(TripleStore *ts, const Triple *triples,
+                             const TripleObjType *types, size_t n)
+{
+  size_t i;
+  if (reserve(ts, n)) return 1;
+  for (i=0; i<n; i++) {
+    const Triple *t = triples + i;
+    if (add_triple(ts, t->s, t->p, t->o, t->id, (types) ? types + i : NULL))
+      return 1;
+  }
   return 0;
 }
 
 
+/* Moves triple number `src` to position `dst` and updates the id map.
+   The triple at position `dst` must have been cleaned. */
+static void move_triple(TripleStore *ts, size_t dst, size_t src)
+{
+  Triple *t = ts->triples + dst;
+  assert(dst != src);
+  memcpy(t, ts->triples + src, sizeof(Triple));
+  memcpy(ts->types + dst, ts->types + src, sizeof(ObjType));
+  memcpy(ts->lifetimes + dst, ts->lifetimes + src, sizeof(Lifetime));
+  memset(ts->triples + src, 0, sizeof(Triple));
+  if (t->id && !ts->lifetimes[dst].removed) map_set(&ts->map, t->id, dst);
+}
+
+/* Removes all triples marked as removed and releases excess memory.
+   Must not be called while there are running iterators. */
+static void compact(TripleStore *ts)
+{
+  size_t i = ts->true_length;
+  assert(ts->niter == 0);
+  while (i-- > 0) {
+    if (!ts->lifetimes[i].removed) continue;
+    triple_clean(ts->triples + i);
+    if (i < --ts->true_length) move_triple(ts, i, ts->true_length);
+  }
+  assert(ts->true_length == ts->length);
+
+  if (ts->size > 2*ts->length + TRIPLESTORE_BUFFSIZE) {
+    size_t size = (ts->length / TRIPLESTORE_BUFFSIZE + 1) *
+      TRIPLESTORE_BUFFSIZE;
+    void *ptr;
+    if ((ptr = realloc(ts->triples, size*sizeof(Triple)))) ts->triples = ptr;
+    if ((ptr = realloc(ts->types, size*sizeof(ObjType)))) ts->types = ptr;
+    if ((ptr = realloc(ts->lifetimes, size*sizeof(Lifetime))))
+      ts->lifetimes = ptr;
+    if (ptr) ts->size = size;
+  }
+}
+
+/* Compacts the store if there are no running iterators and at least a
+   quarter of the stored triples are removed.  Since each compaction
+   is paid for by a proportional number of removals, the cost per
+   removal is constant. */
+static void maybe_compact(TripleStore *ts)
+{
+  size_t nremoved = ts->true_length - ts->length;
+  if (ts->niter == 0 && nremoved && 4*nremoved >= ts->true_length)
+    compact(ts);
+}
+
 /* Removes triple number n.  Returns non-zero on error. */
 static int _remove_by_index(TripleStore *ts, size_t n)
 {
   Triple *t = ts->triples + n;
   if (n >= ts->true_length)
     return err(1, "triple index out of range: %lu", (unsigned long)n);
-  if (!t->id)
+  if (ts->lifetimes[n].removed)
     return err(1, "triple %lu is already removed", (unsigned long)n);
   map_remove(&ts->map, t->id);
+  ts->length--;
 
   if (ts->niter) {
-    /* running iterator, mark triple for deletion by setting id to NULL */
-    free(t->id);
-    t->id = NULL;
-    ts->length--;
+    /* running iterators may still see the triple, mark it as removed
+       in the current epoch and leave it to compact() */
+    ts->lifetimes[n].removed = ts->epoch;
   } else {
     /* no running iterators, remove triple */
-    assert(ts->length == ts->true_length);
     triple_clean(t);
-    ts->length--;
-    if (t < ts->triples + ts->length)
-      memcpy(t, &ts->triples[ts->length], sizeof(Triple));
-    ts->true_length = ts->length;
+    if (n < --ts->true_length) move_triple(ts, n, ts->true_length);
   }
   return 0;
 }
@@ -230,7 +509,7 @@ int triplestore_remove(TripleStore *ts, const char *s,
   int i=ts->true_length, n=0;
   while (--i >= 0) {
     const Triple *t = ts->triples + i;
-    if (!t->id) continue;
+    if (ts->lifetimes[i].removed) continue;
     if ((!s || strcmp(s, t->s) == 0) &&
         (!p || strcmp(p, t->p) == 0) &&
         (!o || strcmp(o, t->o) == 0)) {
@@ -247,14 +526,19 @@ int triplestore_remove(TripleStore *ts, const char *s,
  */
 void triplestore_clear(TripleStore *ts)
 {
-  int n=ts->true_length;
-  int niter=ts->niter;
-  while (--n >= 0)
-    if (ts->triples[n].id) _remove_by_index(ts, n);
+  size_t i;
+  size_t niter=ts->niter, epoch=ts->epoch;
+  char *ns=ts->ns;
+  for (i=0; i<ts->true_length; i++) triple_clean(ts->triples + i);
   if (ts->triples) free(ts->triples);
+  if (ts->types) free(ts->types);
+  if (ts->lifetimes) free(ts->lifetimes);
   map_deinit(&ts->map);
+  free_strings(ts);
   memset(ts, 0, sizeof(TripleStore));
   ts->niter = niter;
+  ts->epoch = epoch;
+  ts->ns = ns;
 }
 
 
@@ -266,7 +550,7 @@ const Triple *triplestore_get(const TripleStore *ts, const char *id)
   int *n = map_get(&((TripleStore *)ts)->map, id);
   if (!n)
     return errx(1, "no triple with id \"%s\"", id), NULL;
-  if (!ts->triples[*n].id)
+  if (ts->lifetimes[*n].removed)
     return errx(1, "triple \"%s\" has been removed", id), NULL;
   return ts->triples + *n;
 }
@@ -282,7 +566,7 @@ const Triple *triplestore_find_first(const TripleStore *ts, const char *s,
   size_t i;
   for (i=0; i<ts->true_length; i++) {
     const Triple *t = ts->triples + i;
-    if (t->id &&
+    if (!ts->lifetimes[i].removed &&
         (!s || strcmp(s, t->s) == 0) &&
         (!p || strcmp(p, t->p) == 0) &&
         (!o || strcmp(o, t->o) == 0))
@@ -292,15 +576,29 @@ const Triple *triplestore_find_first(const TripleStore *ts, const char *s,
 }
 
 
+/* Returns non-zero if triple number `n` is visible to an iterator
+   started in `epoch`. */
+static int visible(const TripleStore *ts, size_t n, size_t epoch)
+{
+  const Lifetime *lt = ts->lifetimes + n;
+  return lt->added <= epoch && (!lt->removed || lt->removed > epoch);
+}
+
+
 /*
   Initiates a TripleState for triplestore_find().  The state must be
   deinitialised with triplestore_deinit_state().
+
+  The iterator works on a snapshot of the store.  Triples added after
+  this call are not visited and triples removed after this call are
+  still visited.
 */
 void triplestore_init_state(TripleStore *ts, TripleState *state)
 {
   state->ts = ts;
   ts->niter++;
   state->pos = 0;
+  state->epoch = ts->epoch++;
 }
 
 
@@ -310,7 +608,6 @@ void triplestore_init_state(TripleStore *ts, TripleState *state)
 void triplestore_deinit_state(TripleState *state)
 {
   TripleStore *ts = state->ts;
-  int i;
   assert(ts->niter > 0 /* must match triplestore_init_state() */);
   ts->niter--;
 
@@ -320,24 +617,7 @@ void triplestore_deinit_state(TripleState *state)
     return;
   }
 
-  if (ts->niter == 0 && ts->true_length > ts->length) {
-    for (i=ts->true_length-1; i>=0 && !ts->triples[i].id; i--)
-      ts->true_length--;
-    for (i=ts->true_length-1; i>=0; i--) {
-      Triple *t = ts->triples + i;
-      if (!t->id) {
-        Triple *tt = ts->triples + (--ts->true_length);
-        assert(t < tt);
-        triple_clean(t);
-        memcpy(t, tt, sizeof(Triple));
-      }
-    }
-    assert(ts->true_length == ts->length);
-    if (ts->size > ts->length + TRIPLESTORE_BUFFSIZE) {
-      ts->size = ts->length + ts->length % TRIPLESTORE_BUFFSIZE;
-      ts->triples = realloc(ts->triples, ts->size*sizeof(Triple));
-    }
-  }
+  maybe_compact(ts);
 }
 
 
@@ -359,7 +639,7 @@ const Triple *triplestore_next(TripleState *state)
   TripleStore *ts = state->ts;
   while (state->pos < ts->true_length) {
     const Triple *t = ts->triples + state->pos++;
-    if (t->id) return t;
+    if (visible(ts, state->pos - 1, state->epoch)) return t;
   }
   return NULL;
 }
@@ -373,7 +653,7 @@ const Triple *triplestore_poll(TripleState *state)
   TripleStore *ts = state->ts;
   while (state->pos < ts->true_length) {
     const Triple *t = ts->triples + state->pos;
-    if (t->id) return t;
+    if (visible(ts, state->pos, state->epoch)) return t;
     state->pos++;
   }
   return NULL;
@@ -394,7 +674,7 @@ const Triple *triplestore_find(TripleState *state,
   TripleStore *ts = state->ts;
   while (state->pos < ts->true_length) {
     const Triple *t = ts->triples + state->pos++;
-    if (t->id &&
+    if (visible(ts, state->pos - 1, state->epoch) &&
         (!s || strcmp(s, t->s) == 0) &&
         (!p || strcmp(p, t->p) == 0) &&
         (!o || strcmp(o, t->o) == 0))
@@ -414,3 +694,56 @@ const Triple *triplestore_find2(TripleState *state,
   UNUSED(lang);
   return triplestore_find(state, s, p, o);
 }
+
+
+/* Handler for ntriples_parse_file() adding each statement to the
+   triplestore passed as `data`.  Graph labels are ignored. */
+static int ntriples_handler(void *data, const char *s, const char *p,
+                            const char *o, const TripleObjType *type,
+                            const char *g)
+{
+  TripleStore *ts = data;
+  UNUSED(g);
+  if (reserve(ts, 1)) return 1;
+  return add_triple(ts, s, p, o, NULL, type);
+}
+
+/*
+  Adds all statements in N-Triples (or N-Quads) stream `fp` to the
+  triplestore.  The stream is parsed in chunks, so the whole document
+  is never kept in memory.  Graph labels of N-Quads are ignored.
+
+  Returns non-zero on error.
+ */
+int triplestore_load_ntriples(TripleStore *ts, FILE *fp)
+{
+  /* The namespace is only used for expanding URIs provided by the user */
+  char *ns = ts->ns;
+  int n;
+  ts->ns = NULL;
+  n = ntriples_parse_file(fp, ntriples_handler, ts);
+  ts->ns = ns;
+  return (n < 0) ? 1 : 0;
+}
+
+/*
+  Writes all triples in the triplestore as N-Triples to stream `fp`,
+  one statement at a time.
+
+  Returns non-zero on error.
+ */
+int triplestore_save_ntriples(TripleStore *ts, FILE *fp)
+{
+  size_t i;
+  for (i=0; i<ts->true_length; i++) {
+    const Triple *t = ts->triples + i;
+    const ObjType *ot = ts->types + i;
+    TripleObjType type;
+    if (ts->lifetimes[i].removed) continue;
+    type.literal = ot->literal;
+    type.lang = (ot->lang >= 0) ? ts->strings[ot->lang] : NULL;
+    type.datatype_uri = (ot->datatype >= 0) ? ts->strings[ot->datatype] : NULL;
+    if (ntriples_write(fp, t->s, t->p, t->o, &type, NULL)) return 1;
+  }
+  return 0;
+}
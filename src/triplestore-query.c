@@ -0,0 +1,382 @@
+/* triplestore-query.c -- basic graph pattern queries over a triplestore */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/err.h"
+#include "utils/map.h"
+#include "triplestore-query.h"
+
+/** Convenient macro for failing */
+#define FAIL(msg) do { \
+    err(1, msg); goto fail; } while (0)
+
+
+/* A table of solutions.  Each row has one value index per variable in
+   the query, with -1 for unbound variables. */
+typedef struct {
+  int *data;        /* nrows x nvars value indices */
+  size_t nrows;     /* number of rows */
+  size_t size;      /* allocated number of rows */
+} Table;
+
+/* A compiled triple pattern */
+typedef struct {
+  const char *term[3];  /* constant s, p, o or NULL */
+  int var[3];           /* variable index of s, p, o or -1 */
+  Table table;          /* rows matching this pattern */
+  int used;             /* whether the pattern has been joined */
+} Pattern;
+
+struct _TripleResult {
+  int nvars;            /* number of variables */
+  char **vars;          /* variable names */
+  Table table;          /* solutions */
+  char **strings;       /* interned values */
+  size_t nstrings;      /* number of interned values */
+  size_t stringsize;    /* allocated size of `strings` */
+  map_int_t map;        /* maps value to index in `strings` */
+};
+
+
+/* Appends `row` to table.  Returns non-zero on error. */
+static int table_append(Table *t, int nvars, const int *row)
+{
+  if (t->nrows >= t->size) {
+    size_t size = (t->size) ? 2*t->size : 64;
+    int *data = realloc(t->data, size * (nvars ? nvars : 1) * sizeof(int));
+    if (!data) return err(1, "allocation failure");
+    t->data = data;
+    t->size = size;
+  }
+  if (nvars) memcpy(t->data + t->nrows*nvars, row, nvars*sizeof(int));
+  t->nrows++;
+  return 0;
+}
+
+/* Frees memory used by table. */
+static void table_deinit(Table *t)
+{
+  if (t->data) free(t->data);
+  memset(t, 0, sizeof(Table));
+}
+
+/* Returns index of interned value `s` or -1 on error. */
+static int intern(TripleResult *r, const char *s)
+{
+  int *p;
+  if ((p = map_get(&r->map, s))) return *p;
+  if (r->nstrings >= INT32_MAX) return err(-1, "too many values in query");
+  if (r->nstrings >= r->stringsize) {
+    size_t size = (r->stringsize) ? 2*r->stringsize : 64;
+    char **strings = realloc(r->strings, size*sizeof(char *));
+    if (!strings) return err(-1, "allocation failure");
+    r->strings = strings;
+    r->stringsize = size;
+  }
+  if (!(r->strings[r->nstrings] = strdup(s)))
+    return err(-1, "allocation failure");
+  if (map_set(&r->map, s, (int)r->nstrings))
+    return err(-1, "allocation failure");
+  return (int)r->nstrings++;
+}
+
+/* Returns index of variable `name`.  A new variable is added if it
+   doesn't already exists.  Returns -1 on error. */
+static int getvar(TripleResult *r, const char *name)
+{
+  int j;
+  char **vars;
+  for (j=0; j<r->nvars; j++)
+    if (strcmp(r->vars[j], name) == 0) return j;
+  if (!(vars = realloc(r->vars, (r->nvars+1)*sizeof(char *))))
+    return err(-1, "allocation failure");
+  r->vars = vars;
+  if (!(r->vars[r->nvars] = strdup(name)))
+    return err(-1, "allocation failure");
+  return r->nvars++;
+}
+
+/* Returns hash of the values of the `nkeys` variables in `keys`. */
+static size_t hashrow(const int *row, const int *keys, int nkeys)
+{
+  size_t h = 0;
+  int k;
+  for (k=0; k<nkeys; k++)
+    h ^= (size_t)row[keys[k]] + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+/* Returns non-zero if rows `a` and `b` have equal values of `keys`. */
+static int rowequal(const int *a, const int *b, const int *keys, int nkeys)
+{
+  int k;
+  for (k=0; k<nkeys; k++)
+    if (a[keys[k]] != b[keys[k]]) return 0;
+  return 1;
+}
+
+/* Appends the combination of rows `a` and `b` to `out`.
+   Returns non-zero on error. */
+static int emit(Table *out, int nvars, const int *a, const int *b, int *row)
+{
+  int j;
+  for (j=0; j<nvars; j++) row[j] = (a[j] >= 0) ? a[j] : b[j];
+  return table_append(out, nvars, row);
+}
+
+/*
+  Joins tables `x` and `y` on the `nkeys` variables in `keys` and
+  writes the result to `out`.  A hash table is built over the smaller
+  table and probed with the rows of the larger.  If `nkeys` is zero,
+  the cross product is returned.
+
+  Returns non-zero on error.
+ */
+static int join(Table *out, const Table *x, const Table *y, int nvars,
+                const int *keys, int nkeys)
+{
+  const Table *build = (x->nrows <= y->nrows) ? x : y;
+  const Table *probe = (build == x) ? y : x;
+  size_t i, j, nbuckets=1, *head=NULL, *next=NULL;
+  int *row=NULL, retval=1;
+
+  memset(out, 0, sizeof(Table));
+  if (!(row = malloc((nvars ? nvars : 1) * sizeof(int))))
+    FAIL("allocation failure");
+
+  if (nkeys == 0) {
+    for (i=0; i<x->nrows; i++)
+      for (j=0; j<y->nrows; j++)
+        if (emit(out, nvars, x->data + i*nvars, y->data + j*nvars, row))
+          goto fail;
+    retval = 0;
+    goto fail;
+  }
+
+  while (nbuckets < 2*build->nrows) nbuckets *= 2;
+  if (!(head = malloc(nbuckets*sizeof(size_t))) ||
+      !(next = malloc((build->nrows ? build->nrows : 1)*sizeof(size_t))))
+    FAIL("allocation failure");
+  for (i=0; i<nbuckets; i++) head[i] = SIZE_MAX;
+  for (i=0; i<build->nrows; i++) {
+    size_t h = hashrow(build->data + i*nvars, keys, nkeys) & (nbuckets-1);
+    next[i] = head[h];
+    head[h] = i;
+  }
+
+  for (i=0; i<probe->nrows; i++) {
+    const int *a = probe->data + i*nvars;
+    size_t h = hashrow(a, keys, nkeys) & (nbuckets-1);
+    for (j=head[h]; j != SIZE_MAX; j=next[j]) {
+      const int *b = build->data + j*nvars;
+      if (rowequal(a, b, keys, nkeys) && emit(out, nvars, a, b, row))
+        goto fail;
+    }
+  }
+  retval = 0;
+ fail:
+  if (row) free(row);
+  if (head) free(head);
+  if (next) free(next);
+  if (retval) table_deinit(out);
+  return retval;
+}
+
+
+/*
+  Evaluates the basic graph pattern consisting of the `n` triple
+  patterns in `patterns` against triplestore `ts`.
+
+  Returns a new result object that should be free'ed with
+  triplestore_result_free(), or NULL on error.
+ */
+TripleResult *triplestore_query(TripleStore *ts, const TriplePattern *patterns,
+                                size_t n)
+{
+  TripleResult *r=NULL, *retval=NULL;
+  Pattern *pat=NULL;
+  TripleState state;
+  const Triple *t;
+  int *row=NULL, *keys=NULL, *bound=NULL;
+  size_t i, k, step;
+  int j, nvars, stat=0;
+
+  if (!(r = calloc(1, sizeof(TripleResult)))) FAIL("allocation failure");
+  map_init(&r->map);
+  if (n && !(pat = calloc(n, sizeof(Pattern)))) FAIL("allocation failure");
+
+  /* compile patterns */
+  for (i=0; i<n; i++) {
+    const char *terms[3] = {patterns[i].s, patterns[i].p, patterns[i].o};
+    for (k=0; k<3; k++) {
+      pat[i].var[k] = -1;
+      if (terms[k] && terms[k][0] == '?') {
+        if ((pat[i].var[k] = getvar(r, terms[k])) < 0) goto fail;
+      } else {
+        pat[i].term[k] = terms[k];
+      }
+    }
+  }
+  nvars = r->nvars;
+  if (!(row = malloc((nvars ? nvars : 1) * sizeof(int))) ||
+      !(keys = malloc((nvars ? nvars : 1) * sizeof(int))) ||
+      !(bound = calloc((nvars ? nvars : 1), sizeof(int))))
+    FAIL("allocation failure");
+
+  /* an empty pattern has exactly one (empty) solution */
+  if (n == 0) {
+    if (table_append(&r->table, 0, row)) goto fail;
+    retval = r;
+    goto fail;
+  }
+
+  /* scan the store once, collecting the matches of all patterns */
+  triplestore_init_state(ts, &state);
+  while (!stat && (t = triplestore_next(&state))) {
+    const char *v[3] = {t->s, t->p, t->o};
+    int ids[3] = {-1, -1, -1};
+    for (i=0; i<n && !stat; i++) {
+      Pattern *p = pat + i;
+      for (k=0; k<3; k++)
+        if (p->term[k] && strcmp(p->term[k], v[k]) != 0) break;
+      if (k < 3) continue;
+      for (j=0; j<nvars; j++) row[j] = -1;
+      for (k=0; k<3; k++) {
+        if (p->var[k] < 0) continue;
+        if (ids[k] < 0 && (ids[k] = intern(r, v[k])) < 0) {
+          stat = 1;
+          break;
+        }
+        if (row[p->var[k]] >= 0 && row[p->var[k]] != ids[k]) break;
+        row[p->var[k]] = ids[k];
+      }
+      if (!stat && k == 3 && table_append(&p->table, nvars, row)) stat = 1;
+    }
+  }
+  triplestore_deinit_state(&state);
+  if (stat) goto fail;
+
+  /* join, starting with the most selective pattern and then always
+     choosing the most selective pattern sharing variables with the
+     already joined patterns */
+  for (step=0; step<n; step++) {
+    Pattern *best=NULL;
+    int bestconnected=0, nkeys=0;
+    for (i=0; i<n; i++) {
+      int connected=0;
+      if (pat[i].used) continue;
+      for (k=0; k<3; k++)
+        if (pat[i].var[k] >= 0 && bound[pat[i].var[k]]) connected = 1;
+      if (!best || (connected && !bestconnected) ||
+          (connected == bestconnected &&
+           pat[i].table.nrows < best->table.nrows)) {
+        best = pat + i;
+        bestconnected = connected;
+      }
+    }
+    assert(best);
+    best->used = 1;
+
+    if (step == 0) {
+      r->table = best->table;
+      memset(&best->table, 0, sizeof(Table));
+    } else {
+      Table out;
+      for (k=0; k<3; k++) {
+        int v = best->var[k], m;
+        if (v < 0 || !bound[v]) continue;
+        for (m=0; m<nkeys; m++) if (keys[m] == v) break;
+        if (m == nkeys) keys[nkeys++] = v;
+      }
+      if (join(&out, &r->table, &best->table, nvars, keys, nkeys)) goto fail;
+      table_deinit(&r->table);
+      table_deinit(&best->table);
+      r->table = out;
+    }
+    for (k=0; k<3; k++)
+      if (best->var[k] >= 0) bound[best->var[k]] = 1;
+    if (r->table.nrows == 0) break;
+  }
+
+  retval = r;
+ fail:
+  if (pat) {
+    for (i=0; i<n; i++) table_deinit(&pat[i].table);
+    free(pat);
+  }
+  if (row) free(row);
+  if (keys) free(keys);
+  if (bound) free(bound);
+  if (!retval && r) triplestore_result_free(r);
+  return retval;
+}
+
+
+/*
+  Frees result returned by triplestore_query().
+ */
+void triplestore_result_free(TripleResult *r)
+{
+  size_t i;
+  int j;
+  for (j=0; j<r->nvars; j++) free(r->vars[j]);
+  if (r->vars) free(r->vars);
+  for (i=0; i<r->nstrings; i++) free(r->strings[i]);
+  if (r->strings) free(r->strings);
+  table_deinit(&r->table);
+  map_deinit(&r->map);
+  free(r);
+}
+
+/*
+  Returns the number of solutions (rows) in the result.
+ */
+size_t triplestore_result_nrows(const TripleResult *r)
+{
+  return r->table.nrows;
+}
+
+/*
+  Returns the number of variables (columns) in the result.
+ */
+int triplestore_result_nvars(const TripleResult *r)
+{
+  return r->nvars;
+}
+
+/*
+  Returns the name of variable number `j`, including the leading
+  question mark.  Returns NULL if `j` is out of range.
+ */
+const char *triplestore_result_var(const TripleResult *r, int j)
+{
+  if (j < 0 || j >= r->nvars) return NULL;
+  return r->vars[j];
+}
+
+/*
+  Returns the index of variable `var` or -1 if `var` is not a variable
+  in the query.
+ */
+int triplestore_result_varindex(const TripleResult *r, const char *var)
+{
+  int j;
+  for (j=0; j<r->nvars; j++)
+    if (strcmp(r->vars[j], var) == 0) return j;
+  return -1;
+}
+
+/*
+  Returns the value of variable `j` in solution `row`, or NULL if
+  `row` or `j` is out of range.
+ */
+const char *triplestore_result_value(const TripleResult *r, size_t row,
+                                     int j)
+{
+  int idx;
+  if (row >= r->table.nrows || j < 0 || j >= r->nvars) return NULL;
+  idx = r->table.data[row*r->nvars + j];
+  return (idx >= 0) ? r->strings[idx] : NULL;
+}
@@ -0,0 +1,96 @@
+/**
+  @file
+  @brief Basic graph pattern queries over a triplestore
+
+  A basic graph pattern is a set of triple patterns, whos subject,
+  predicate and object may be constants, variables or wildcards.
+  Variables are strings starting with a question mark (e.g. "?x") and
+  wildcards are NULL.  A solution is an assignment of values to all
+  variables, such that each pattern matches a triple in the store.
+
+  Example: find the label and metadata of all instances in a collection
+
+  ```C
+  TriplePattern patterns[] = {
+    {"?label", "_is-a",     "Instance"},
+    {"?label", "_has-meta", "?meta"},
+  };
+  TripleResult *r = triplestore_query(ts, patterns, 2);
+  int meta = triplestore_result_varindex(r, "?meta");
+  for (i=0; i<triplestore_result_nrows(r); i++)
+    printf("%s\n", triplestore_result_value(r, i, meta));
+  triplestore_result_free(r);
+  ```
+
+  The store is scanned once, collecting the matches of all patterns.
+  The matches are then combined with hash joins on the shared
+  variables, starting with the most selective pattern.  The total cost
+  is therefore roughly linear in the size of the store plus the size
+  of the result.
+ */
+#ifndef _TRIPLESTORE_QUERY_H
+#define _TRIPLESTORE_QUERY_H
+
+#include "triplestore.h"
+
+
+/** A triple pattern.  Terms starting with "?" are variables and NULL
+    terms are wildcards. */
+typedef struct _TriplePattern {
+  const char *s;   /*!< subject */
+  const char *p;   /*!< predicate */
+  const char *o;   /*!< object */
+} TriplePattern;
+
+/** Opaque type holding the solutions of a query. */
+typedef struct _TripleResult TripleResult;
+
+
+/**
+  Evaluates the basic graph pattern consisting of the `n` triple
+  patterns in `patterns` against triplestore `ts`.
+
+  Returns a new result object that should be free'ed with
+  triplestore_result_free(), or NULL on error.
+ */
+TripleResult *triplestore_query(TripleStore *ts, const TriplePattern *patterns,
+                                size_t n);
+
+/**
+  Frees result returned by triplestore_query().
+ */
+void triplestore_result_free(TripleResult *r);
+
+/**
+  Returns the number of solutions (rows) in the result.
+ */
+size_t triplestore_result_nrows(const TripleResult *r);
+
+/**
+  Returns the number of variables (columns) in the result.
+ */
+int triplestore_result_nvars(const TripleResult *r);
+
+/**
+  Returns the name of variable number `j`, including the leading
+  question mark.  Variables are numbered in order of first appearance
+  in the patterns.  Returns NULL if `j` is out of range.
+ */
+const char *triplestore_result_var(const TripleResult *r, int j);
+
+/**
+  Returns the index of variable `var` or -1 if `var` is not a variable
+  in the query.
+ */
+int triplestore_result_varindex(const TripleResult *r, const char *var);
+
+/**
+  Returns the value of variable `j` in solution `row`, or NULL if
+  `row` or `j` is out of range.  The returned string is owned by the
+  result.
+ */
+const char *triplestore_result_value(const TripleResult *r, size_t row,
+                                     int j);
+
+
+#endif /* _TRIPLESTORE_QUERY_H */
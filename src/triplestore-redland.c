@@ -540,6 +540,74 @@ int triplestore_add_triples(TripleStore *ts, const Triple *triples, size_t n)
 }
 
 
+/*
+  Adds `n` triples to store.  `types` is an array of `n` object types.
+  If `types` is NULL, all objects are considered to be literals with no
+  language.
+
+  Subject nodes and datatype uris are reused between consecutive
+  triples sharing the same subject or datatype.
+
+  Returns non-zero on error.
+ */
+int triplestore_add_triples2(TripleStore *ts, const Triple *triples,
+                             const TripleObjType *types, size_t n)
+{
+  static const TripleObjType literal_type = {1, NULL, NULL};
+  librdf_node *subject=NULL, *ns=NULL, *np=NULL, *no=NULL;
+  librdf_uri *uri=NULL;
+  const char *prev_s=NULL, *prev_datatype=NULL;
+  size_t i;
+  int retval=1, stat;
+
+  for (i=0; i<n; i++) {
+    const Triple *t = triples + i;
+    const TripleObjType *type = (types) ? types + i : &literal_type;
+
+    if (!prev_s || strcmp(t->s, prev_s)) {
+      if (subject) librdf_free_node(subject);
+      if (!(subject = new_uri_node(ts, t->s)))
+        FAIL1("error creating node for subject: '%s'", t->s);
+      prev_s = t->s;
+    }
+    if (!(ns = librdf_new_node_from_node(subject)))
+      FAIL1("error copying node for subject: '%s'", t->s);
+    if (!(np = new_uri_node(ts, t->p)))
+      FAIL1("error creating node for predicate: '%s'", t->p);
+    if (type->literal) {
+      if (type->datatype_uri != prev_datatype) {
+        if (uri) librdf_free_uri(uri);
+        uri = NULL;
+        if (type->datatype_uri &&
+            !(uri = librdf_new_uri(ts->world,
+                                   (unsigned char *)type->datatype_uri)))
+          FAIL1("error creating uri from '%s'", type->datatype_uri);
+        prev_datatype = type->datatype_uri;
+      }
+      if (!(no = librdf_new_node_from_typed_literal(ts->world,
+                                                    (unsigned char *)t->o,
+                                                    type->lang, uri)))
+        FAIL1("error creating node for object: '%s'", t->o);
+    } else {
+      if (!(no = new_uri_node(ts, t->o)))
+        FAIL1("error creating node for object: '%s'", t->o);
+    }
+    /* librdf_model_add() takes ownership of the nodes, also on failure */
+    stat = librdf_model_add(ts->model, ns, np, no);
+    ns = np = no = NULL;
+    if (stat) FAIL("error adding triple");
+  }
+  retval = 0;
+ fail:
+  if (subject) librdf_free_node(subject);
+  if (uri) librdf_free_uri(uri);
+  if (ns) librdf_free_node(ns);
+  if (np) librdf_free_node(np);
+  if (no) librdf_free_node(no);
+  return retval;
+}
+
+
 /*
   Removes a triple identified by `s`, `p` and `o`.  Any of these may
   be NULL, allowing for multiple matches.
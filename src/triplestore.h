@@ -35,10 +35,20 @@ typedef struct _TripleStore TripleStore;
 typedef struct _TripleState {
   TripleStore *ts;    /*!< reference to corresponding TripleStore */
   size_t pos;         /*!< current position */
+  size_t epoch;       /*!< snapshot epoch (builtin store only) */
   void *data;         /*!< internal data depending on the implementation */
 } TripleState;
 
 
+/** Type of the object of a triple.  Used by triplestore_add_triples2(). */
+typedef struct _TripleObjType {
+  int literal;               /*!< non-zero if the object is a literal,
+                                  otherwise it is an URI */
+  const char *lang;          /*!< language of literal or NULL */
+  const char *datatype_uri;  /*!< datatype uri of literal or NULL */
+} TripleObjType;
+
+
 /* ================================== */
 /* Functions specific to librdf       */
 /* ================================== */
@@ -58,6 +68,31 @@ librdf_model *triplestore_get_model(TripleStore *ts);
 #endif
 
 
+/* ======================================= */
+/* Functions specific to builtin store     */
+/* ======================================= */
+#ifndef HAVE_REDLAND
+#include <stdio.h>
+
+/**
+  Adds all statements in N-Triples (or N-Quads) stream `fp` to the
+  triplestore.  The stream is parsed in chunks, so the whole document
+  is never kept in memory.  Graph labels of N-Quads are ignored.
+
+  Returns non-zero on error.
+ */
+int triplestore_load_ntriples(TripleStore *ts, FILE *fp);
+
+/**
+  Writes all triples in the triplestore as N-Triples to stream `fp`.
+
+  Returns non-zero on error.
+ */
+int triplestore_save_ntriples(TripleStore *ts, FILE *fp);
+
+#endif
+
+
 
 /* ================================== */
 /* Generic functions                  */
@@ -159,6 +194,22 @@ int triplestore_add_uri(TripleStore *ts, const char *s, const char *p,
 int triplestore_add_triples(TripleStore *ts, const Triple *triples, size_t n);
 
 
+/**
+  Like triplestore_add_triples(), but `types` is an array of `n`
+  object types describing how the object of the corresponding triple
+  should be interpreted (see triplestore_add2()).  If `types` is NULL,
+  all objects are considered to be literals with no language.
+
+  This is the preferred way to add many triples at once, since
+  backends may reuse resources between consecutive triples (e.g. when
+  they share subject).
+
+  Returns non-zero on error.
+ */
+int triplestore_add_triples2(TripleStore *ts, const Triple *triples,
+                             const TripleObjType *types, size_t n);
+
+
 /**
   Removes a triple identified by it's `id`.  Returns non-zero if no such
   triple can be found.
@@ -197,6 +248,11 @@ const Triple *triplestore_find_first(const TripleStore *ts, const char *s,
 
 /**
   Initiates a TripleState for triplestore_find().
+
+  With the builtin store, the iterator visits a snapshot of the store
+  taken by this call.  Triples may be added and removed while
+  iterating, without affecting the triples visited.  Removed triples
+  are kept alive until the last running iterator is deinitialised.
 */
 void triplestore_init_state(TripleStore *ts, TripleState *state);
 
@@ -231,8 +287,9 @@ const Triple *triplestore_poll(TripleState *state);
   and `o`.  Any of `s`, `p` or `o` may be NULL.  When no more matches
   can be found, NULL is returned.
 
-  No other calls to triplestore_add() or triplestore_find() should be
-  done while searching.
+  With the builtin store, triples may be added or removed while
+  searching (see triplestore_init_state()).  Note however, that adding
+  triples may invalidate the pointers to previously returned triples.
 
   NULL is also returned on error.
  */
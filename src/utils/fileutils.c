@@ -393,7 +393,7 @@ const char *fu_nextpath(const char *paths, char **endptr, const char *pathsep)
     p = *endptr + 1;
 
   /* ignore repeated path separators */
-  while (strchr((pathsep) ? pathsep : ";:", *p)) p++;
+  while (*p && strchr((pathsep) ? pathsep : ";:", *p)) p++;
 
   if (pathsep) {
     *endptr = p + strcspn(p, pathsep);
@@ -894,7 +894,7 @@ int fu_paths_insertn(FUPaths *paths, const char *path, size_t len, int n)
       if (tmp) free(tmp);
       return index;  // path already at expected position
     }
-    if (fu_paths_delete(paths, index)) goto fail;
+    if (fu_paths_delete_index(paths, index)) goto fail;
     if (n > index) n--;
   }
 
@@ -996,14 +996,14 @@ int fu_paths_extend_prefix(FUPaths *paths, const char *prefix,
  */
 int fu_paths_delete_index(FUPaths *paths, int index)
 {
-  if (index < -(int)(paths->index) || index >= (int)paths->index+1)
+  if (index < -(int)(paths->n) || index >= (int)paths->n)
     return err(-1, "path index out of range: %d", index);
-  if (index < 0) index += paths->index;
+  if (index < 0) index += paths->n;
   assert(paths->paths[index]);
   free((char *)paths->paths[index]);
   memmove((char **)paths->paths+index, paths->paths+index+1,
-          (paths->index-index)*sizeof(char **));
-  paths->index--;
+          (paths->n-index)*sizeof(char **));
+  paths->n--;
   return 0;
 }
 
@@ -5,6 +5,7 @@
  * Distributed under terms of the MIT license.
  */
 #include <stdlib.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
@@ -226,3 +227,96 @@ int strhex(char *hex, size_t hexsize, const unsigned char *data, size_t size)
   }
   return m;
 }
+
+
+/* Base64 alphabet */
+static const char base64chars[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Returns the 6-bit value of base64 character `c` or -1 if `c` is not
+   a valid base64 character. */
+static int base64val(int c)
+{
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+/*
+  Writes binary data base64-encoded (RFC 4648, with padding) and
+  nul-terminated to `dest`.
+
+  `destsize` is the size of memory poined to by `dest`.
+  `data` points to the first byte of binary data of size `size`.
+
+  Returns number of bytes written to `dest` (excluding the terminating
+  nul), assuming `destsize` is sufficiently large, or -1 on error.
+  The required size is `4*((size+2)/3) + 1`.
+*/
+int strbase64(char *dest, size_t destsize, const unsigned char *data,
+              size_t size)
+{
+  size_t i, m=0, n = 4*((size+2)/3);
+  char buf[4];
+  if (n > INT_MAX) return -1;
+  for (i=0; i<size; i+=3) {
+    unsigned long v = (unsigned long)data[i] << 16;
+    int j;
+    if (i+1 < size) v |= (unsigned long)data[i+1] << 8;
+    if (i+2 < size) v |= data[i+2];
+    buf[0] = base64chars[(v >> 18) & 0x3f];
+    buf[1] = base64chars[(v >> 12) & 0x3f];
+    buf[2] = (i+1 < size) ? base64chars[(v >> 6) & 0x3f] : '=';
+    buf[3] = (i+2 < size) ? base64chars[v & 0x3f] : '=';
+    for (j=0; j<4; j++, m++)
+      if (m+1 < destsize) dest[m] = buf[j];
+  }
+  if (destsize) dest[(m < destsize) ? m : destsize-1] = '\0';
+  return (int)n;
+}
+
+/*
+  Decodes base64-encoded string `src` to `dest`.  If `len` is
+  non-negative, at most `len` bytes are read from `src`.
+
+  `destsize` is the size of memory poined to by `dest`.  At most
+  `destsize` bytes are written.
+
+  Returns number of decoded bytes, assuming `destsize` is sufficiently
+  large, or -1 if `src` is not valid base64.  The required size is at
+  most `3*(len/4)`.
+*/
+int strbase64_decode(unsigned char *dest, size_t destsize, const char *src,
+                     int len)
+{
+  size_t i, m=0, n=0;
+  if (len < 0)
+    n = strlen(src);
+  else
+    while ((int)n < len && src[n]) n++;
+  if (n % 4) return -1;
+  for (i=0; i<n; i+=4) {
+    int a = base64val(src[i]), b = base64val(src[i+1]);
+    int c = base64val(src[i+2]), d = base64val(src[i+3]);
+    unsigned long v;
+    int k = 3;
+    if (a < 0 || b < 0) return -1;
+    if (i+4 == n && src[i+3] == '=') {
+      k = (src[i+2] == '=') ? 1 : 2;
+      if (k == 2 && c < 0) return -1;
+    } else if (c < 0 || d < 0) {
+      return -1;
+    }
+    v = ((unsigned long)a << 18) | ((unsigned long)b << 12) |
+      ((unsigned long)((c < 0) ? 0 : c) << 6) | ((d < 0) ? 0 : d);
+    if (m < destsize) dest[m] = (v >> 16) & 0xff;
+    m++;
+    if (k > 1) { if (m < destsize) dest[m] = (v >> 8) & 0xff; m++; }
+    if (k > 2) { if (m < destsize) dest[m] = v & 0xff; m++; }
+  }
+  if (m > INT_MAX) return -1;
+  return (int)m;
+}
@@ -120,4 +120,33 @@ int strnunquote(char *dest, size_t size, const char *s, int n,
 int strhex(char *hex, size_t hexsize, const unsigned char *data, size_t size);
 
 
+/**
+  Writes binary data base64-encoded (RFC 4648, with padding) and
+  nul-terminated to `dest`.
+
+  `destsize` is the size of memory poined to by `dest`.
+  `data` points to the first byte of binary data of size `size`.
+
+  Returns number of bytes written to `dest` (excluding the terminating
+  nul), assuming `destsize` is sufficiently large, or -1 on error.
+  The required size is `4*((size+2)/3) + 1`.
+*/
+int strbase64(char *dest, size_t destsize, const unsigned char *data,
+              size_t size);
+
+/**
+  Decodes base64-encoded string `src` to `dest`.  If `len` is
+  non-negative, at most `len` bytes are read from `src`.
+
+  `destsize` is the size of memory poined to by `dest`.  At most
+  `destsize` bytes are written.
+
+  Returns number of decoded bytes, assuming `destsize` is sufficiently
+  large, or -1 if `src` is not valid base64.  The required size is at
+  most `3*(len/4)`.
+*/
+int strbase64_decode(unsigned char *dest, size_t destsize, const char *src,
+                     int len);
+
+
 #endif  /* _STRUTILS_H */
@@ -121,6 +121,43 @@ MU_TEST(test_strunquote)
 }
 
 
+MU_TEST(test_strbase64)
+{
+  char buf[16];
+  unsigned char data[16];
+  int n;
+
+  n = strbase64(buf, sizeof(buf), (unsigned char *)"foobar", 6);
+  mu_assert_int_eq(8, n);
+  mu_assert_string_eq("Zm9vYmFy", buf);
+
+  n = strbase64(buf, sizeof(buf), (unsigned char *)"fooba", 5);
+  mu_assert_int_eq(8, n);
+  mu_assert_string_eq("Zm9vYmE=", buf);
+
+  n = strbase64(buf, sizeof(buf), (unsigned char *)"foob", 4);
+  mu_assert_int_eq(8, n);
+  mu_assert_string_eq("Zm9vYg==", buf);
+
+  n = strbase64(buf, 5, (unsigned char *)"foobar", 6);
+  mu_assert_int_eq(8, n);
+  mu_assert_string_eq("Zm9v", buf);
+
+  n = strbase64_decode(data, sizeof(data), "Zm9vYmFy", -1);
+  mu_assert_int_eq(6, n);
+  mu_check(memcmp(data, "foobar", 6) == 0);
+
+  n = strbase64_decode(data, sizeof(data), "Zm9vYg==xx", 8);
+  mu_assert_int_eq(4, n);
+  mu_check(memcmp(data, "foob", 4) == 0);
+
+  n = strbase64_decode(data, sizeof(data), "Zm9vYg=", -1);
+  mu_assert_int_eq(-1, n);
+
+  n = strbase64_decode(data, sizeof(data), "Zm9v*mFy", -1);
+  mu_assert_int_eq(-1, n);
+}
+
 
 /***********************************************************************/
 
@@ -130,6 +167,7 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_strquote);
   MU_RUN_TEST(test_strnquote);
   MU_RUN_TEST(test_strunquote);
+  MU_RUN_TEST(test_strbase64);
 }
 
 
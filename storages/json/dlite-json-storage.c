@@ -9,6 +9,8 @@
 
 #include "utils/err.h"
 #include "utils/strtob.h"
+#include "utils/strutils.h"
+#include "utils/jsmnx.h"
 #include "utils/jstore.h"
 #include "utils/map.h"
 #include "dlite.h"
@@ -17,14 +19,17 @@
 
 typedef struct { char uuid[DLITE_UUID_LENGTH+1]; } uuid_t;
 typedef map_t(uuid_t) map_uuid_t;
+typedef map_t(uint64_t) map_hash_t;
 
 /** Storage for json backend. */
 typedef struct {
   DLiteStorage_HEAD
   JStore *jstore;       /* json storage */
   DLiteJsonFlag flags;  /* output flags */
+  int bincoll;          /* whether to save collection relations as binary */
   int changed;          /* whether the storage is changed */
   map_uuid_t ids;       /* maps uuids to ids */
+  map_hash_t hashes;    /* maps uuids to content hash of stored instances */
 } DLiteJsonStorage;
 
 
@@ -65,6 +70,11 @@ static int default_mode(const char *uri)
       Whether to write output in compact format. Alias for `as-data`
   - useid: translate | require | keep (deprecated)
       How to use the ID.
+  - collection-format : json | binary
+      How to save the relations of collections.  With "binary", the
+      relations are stored in a compact base64-encoded binary format
+      (see dlite_collection_to_binary()), which is much faster to load
+      for large collections.  Both formats are recognised when loading.
  */
 DLiteStorage *json_open(const DLiteStoragePlugin *api, const char *uri,
                         const char *options)
@@ -82,6 +92,8 @@ DLiteStorage *json_open(const DLiteStoragePlugin *api, const char *uri,
     {'c', "compact",   "false", "Aliad for `as-data=false` (deprecated)"},
     {'M', "meta",      "false", "Alias for `with-uuid` (deprecated)"},
     {'U', "useid",     "",      "Unused (deprecated)"},
+    {'C', "collection-format", "json",
+     "How to save collection relations: \"json\" or \"binary\""},
     {0, NULL, NULL, NULL}
   };
   int load;  // whether to load uri
@@ -96,6 +108,7 @@ DLiteStorage *json_open(const DLiteStoragePlugin *api, const char *uri,
 
   if (!(s = calloc(1, sizeof(DLiteJsonStorage)))) FAIL("allocation failure");
   s->api = api;
+  map_init(&s->hashes);
 
   if (!(s->jstore = jstore_open())) goto fail;
 
@@ -135,6 +148,12 @@ DLiteStorage *json_open(const DLiteStoragePlugin *api, const char *uri,
   if (withuuid) s->flags |= dliteJsonWithUuid;
   if (asdata) s->flags |= dliteJsonMetaAsData;
 
+  if (strcmp(opts[6].value, "binary") == 0)
+    s->bincoll = 1;
+  else if (strcmp(opts[6].value, "json") != 0)
+    FAIL1("invalid \"collection-format\" value: '%s'. Must be \"json\" "
+          "or \"binary\"", opts[6].value);
+
   retval = (DLiteStorage *)s;
 
  fail:
@@ -155,10 +174,179 @@ int json_close(DLiteStorage *s)
   if (js->writable && js->changed)
     stat = jstore_to_file(js->jstore, js->location);
   stat |= jstore_close(js->jstore);
+  map_deinit(&js->hashes);
   return stat;
 }
 
 
+/* Returns a malloc'ed json string literal, including the surrounding
+   double quotes, with the special characters in `s` escaped.  Returns
+   NULL on allocation error. */
+static char *json_quote(const char *s)
+{
+  const char *p;
+  char *buf, *q;
+  if (!(buf = malloc(6*strlen(s) + 3))) return NULL;
+  q = buf;
+  *q++ = '"';
+  for (p=s; *p; p++) {
+    switch (*p) {
+    case '"':  *q++ = '\\'; *q++ = '"';  break;
+    case '\\': *q++ = '\\'; *q++ = '\\'; break;
+    case '\n': *q++ = '\\'; *q++ = 'n';  break;
+    case '\r': *q++ = '\\'; *q++ = 'r';  break;
+    case '\t': *q++ = '\\'; *q++ = 't';  break;
+    default:
+      if ((unsigned char)*p < 0x20)
+        q += sprintf(q, "\\u%04x", (unsigned char)*p);
+      else
+        *q++ = *p;
+    }
+  }
+  *q++ = '"';
+  *q = '\0';
+  return buf;
+}
+
+/* Returns a malloc'ed copy of the `n` first bytes of the content of a
+   json string literal with escape sequences resolved, or NULL on
+   error. */
+static char *json_unquote(const char *s, size_t n)
+{
+  const char *p=s, *end=s+n;
+  char *buf, *q;
+  unsigned long c;
+  if (!(buf = malloc(n + 1))) return err(1, "allocation failure"), NULL;
+  q = buf;
+  while (p < end) {
+    if (*p != '\\') {
+      *q++ = *p++;
+      continue;
+    }
+    if (++p >= end) break;
+    switch (*p++) {
+    case 'b': *q++ = '\b'; break;
+    case 'f': *q++ = '\f'; break;
+    case 'n': *q++ = '\n'; break;
+    case 'r': *q++ = '\r'; break;
+    case 't': *q++ = '\t'; break;
+    case 'u':
+      if (end - p < 4 || sscanf(p, "%4lx", &c) != 1) goto fail;
+      p += 4;
+      if (c >= 0xd800 && c < 0xdc00 && end - p >= 6 && p[0] == '\\' &&
+          p[1] == 'u') {
+        unsigned long c2;
+        if (sscanf(p+2, "%4lx", &c2) != 1) goto fail;
+        c = 0x10000 + ((c - 0xd800) << 10) + (c2 - 0xdc00);
+        p += 6;
+      }
+      /* Encode as UTF-8.  Never longer than the escape sequence. */
+      if (c < 0x80) {
+        *q++ = c;
+      } else if (c < 0x800) {
+        *q++ = 0xc0 | (c >> 6);
+        *q++ = 0x80 | (c & 0x3f);
+      } else if (c < 0x10000) {
+        *q++ = 0xe0 | (c >> 12);
+        *q++ = 0x80 | ((c >> 6) & 0x3f);
+        *q++ = 0x80 | (c & 0x3f);
+      } else {
+        *q++ = 0xf0 | (c >> 18);
+        *q++ = 0x80 | ((c >> 12) & 0x3f);
+        *q++ = 0x80 | ((c >> 6) & 0x3f);
+        *q++ = 0x80 | (c & 0x3f);
+      }
+      break;
+    default: *q++ = p[-1]; break;
+    }
+  }
+  *q = '\0';
+  return buf;
+ fail:
+  free(buf);
+  return err(1, "invalid escape sequence in json string: \"%.*s\"",
+             (int)n, s), NULL;
+}
+
+
+/* Returns a new instance created from json string `buf` stored under
+   `key`.  Collections saved with their relations in binary format are
+   decoded directly into the collection.  Returns NULL on error. */
+static DLiteInstance *load_json(const char *buf, const char *key,
+                                const char *id)
+{
+  jsmn_parser parser;
+  jsmntok_t *tokens=NULL;
+  unsigned int ntokens=0;
+  const jsmntok_t *t, *u;
+  DLiteCollection *coll=NULL;
+  unsigned char *bin=NULL;
+  char *uri=NULL;
+  int n;
+
+  if (!strstr(buf, "\"relations-binary\""))
+    return dlite_json_sscan(buf, id, NULL);
+
+  jsmn_init(&parser);
+  if (jsmn_parse_alloc(&parser, buf, strlen(buf), &tokens, &ntokens) < 0)
+    FAIL1("invalid json input: \"%.30s...\"", buf);
+  if (!(t = jsmn_item(buf, tokens, "relations-binary"))) {
+    free(tokens);
+    return dlite_json_sscan(buf, id, NULL);
+  }
+  if ((u = jsmn_item(buf, tokens, "uri")) &&
+      !(uri = json_unquote(buf + u->start, u->end - u->start)))
+    goto fail;
+  if (!(coll = dlite_collection_create((uri) ? uri : key))) goto fail;
+
+  n = t->end - t->start;
+  if (!(bin = malloc(3*(n/4) + 1))) FAIL("allocation failure");
+  if ((n = strbase64_decode(bin, 3*(n/4) + 1, buf + t->start, n)) < 0)
+    FAIL1("invalid base64-encoded relations in collection: %s", key);
+  if (dlite_collection_from_binary(coll, bin, n)) goto fail;
+
+  free(bin);
+  free(tokens);
+  if (uri) free(uri);
+  return (DLiteInstance *)coll;
+ fail:
+  if (coll) dlite_collection_decref(coll);
+  if (bin) free(bin);
+  if (tokens) free(tokens);
+  if (uri) free(uri);
+  return NULL;
+}
+
+
+/* Returns non-zero if `buf` has the format that json_save() would
+   write `inst` in with the current settings of `js`.  Metadata is
+   never considered to match, since its format also depends on the
+   `as-data` option. */
+static int same_format(const DLiteJsonStorage *js, const DLiteInstance *inst,
+                       const char *buf)
+{
+  jsmn_parser parser;
+  jsmntok_t *tokens=NULL;
+  unsigned int ntokens=0;
+  int binary, withuuid, retval=0;
+
+  if (!dlite_instance_is_data(inst)) return 0;
+  jsmn_init(&parser);
+  if (jsmn_parse_alloc(&parser, buf, strlen(buf), &tokens, &ntokens) < 0 ||
+      tokens->type != JSMN_OBJECT)
+    goto fail;
+  binary = (jsmn_item(buf, tokens, "relations-binary")) ? 1 : 0;
+  withuuid = (jsmn_item(buf, tokens, "uuid")) ? 1 : 0;
+  if (binary != (js->bincoll && inst->meta == dlite_get_collection_entity()))
+    goto fail;
+  if (withuuid != ((js->flags & dliteJsonWithUuid) ? 1 : 0)) goto fail;
+  retval = 1;
+ fail:
+  if (tokens) free(tokens);
+  return retval;
+}
+
+
 /**
   Load instance `id` from storage `s` and return it.
   NULL is returned on error.
@@ -166,13 +354,15 @@ int json_close(DLiteStorage *s)
 DLiteInstance *json_load(const DLiteStorage *s, const char *id)
 {
   DLiteJsonStorage *js = (DLiteJsonStorage *)s;
-  const char *buf=NULL;
+  const char *buf=NULL, *key=id;
   char uuid[DLITE_UUID_LENGTH+1];
+  DLiteInstance *inst;
+  uint64_t hash;
 
   if (!id || !*id) {
     JStoreIter iter;
     if (jstore_iter_init(js->jstore, &iter)) goto fail;
-    if (!(id = jstore_iter_next(&iter)))
+    if (!(id = key = jstore_iter_next(&iter)))
       FAIL1("cannot load instance from empty storage \"%s\"", s->location);
     if (jstore_iter_next(&iter)) {
       FAIL1("id is required when loading from storage with more "
@@ -180,25 +370,90 @@ DLiteInstance *json_load(const DLiteStorage *s, const char *id)
     }
     if (jstore_iter_deinit(&iter)) goto fail;
   } else if (dlite_get_uuid(uuid, id) == 5) {
-    buf = jstore_get(js->jstore, uuid);
+    if ((buf = jstore_get(js->jstore, uuid))) key = uuid;
   }
   if (!buf && !(buf = jstore_get(js->jstore, id)))
     FAIL2("no instance with id \"%s\" in storage \"%s\"", id, s->location);
-  return dlite_json_sscan(buf, id, NULL);
+  if (!(inst = load_json(buf, key, id))) goto fail;
+
+  /* Remember content hash, such that saving the instance unchanged
+     back to the storage doesn't rewrite it.  Only do that if the stored
+     entry is in the format this storage writes, such that e.g. opening
+     with `collection-format=binary` converts unchanged collections. */
+  if (s->writable && same_format(js, inst, buf) &&
+      dlite_instance_hash(inst, &hash) == 0)
+    map_set(&js->hashes, inst->uuid, hash);
+  return inst;
  fail:
   return NULL;
 }
 
 
+/* Adds collection `coll` to json store with its relations in binary
+   format.  The uuid is included if the `with-uuid` option is set.  The
+   `as-data` option has no effect, since collections are data instances.
+   Returns non-zero on error. */
+static int save_binary_collection(DLiteJsonStorage *js,
+                                  const DLiteCollection *coll)
+{
+  unsigned char *bin=NULL;
+  char *b64=NULL, *json=NULL, *uri=NULL, *metauri=NULL;
+  char uuid[DLITE_UUID_LENGTH+16]="";
+  size_t size, n;
+  int retval=1;
+
+  if (!(bin = dlite_collection_to_binary(coll, &size))) goto fail;
+  n = 4*((size+2)/3) + 1;
+  if (!(b64 = malloc(n))) FAIL("allocation failure");
+  if (strbase64(b64, n, bin, size) < 0)
+    FAIL1("cannot base64-encode relations of collection: %s", coll->uuid);
+  if (!(metauri = json_quote(coll->meta->uri)) ||
+      (coll->uri && !(uri = json_quote(coll->uri))))
+    FAIL("allocation failure");
+  if (js->flags & dliteJsonWithUuid)
+    snprintf(uuid, sizeof(uuid), "\"uuid\": \"%s\", ", coll->uuid);
+  if (uri)
+    json = aprintf("{%s\"uri\": %s, \"meta\": %s, "
+                   "\"relations-binary\": \"%s\"}", uuid, uri, metauri, b64);
+  else
+    json = aprintf("{%s\"meta\": %s, \"relations-binary\": \"%s\"}",
+                   uuid, metauri, b64);
+  if (!json) FAIL("allocation failure");
+  if (jstore_addstolen(js->jstore, coll->uuid, json)) goto fail;
+  retval = 0;
+ fail:
+  if (bin) free(bin);
+  if (b64) free(b64);
+  if (uri) free(uri);
+  if (metauri) free(metauri);
+  return retval;
+}
+
+
 /**
   Saves instance `inst` to storage `s`.  Returns non-zero on error.
 */
 int json_save(DLiteStorage *s, const DLiteInstance *inst)
 {
   DLiteJsonStorage *js = (DLiteJsonStorage *)s;
+  uint64_t hash, *h;
   if (!s->writable)
     return errx(1, "storage \"%s\" is not writable", s->location);
-  if (dlite_jstore_add(js->jstore, inst, js->flags)) return 1;
+
+  /* Skip instances that are unchanged since they were last loaded
+     from or saved to this storage in the same format.  The hash is computed from the
+     current content, so writes through any pointer are detected. */
+  if (dlite_instance_hash(inst, &hash)) return 1;
+  if ((h = map_get(&js->hashes, inst->uuid)) && *h == hash &&
+      jstore_get(js->jstore, inst->uuid))
+    return 0;
+
+  if (js->bincoll && inst->meta == dlite_get_collection_entity()) {
+    if (save_binary_collection(js, (const DLiteCollection *)inst)) return 1;
+  } else {
+    if (dlite_jstore_add(js->jstore, inst, js->flags)) return 1;
+  }
+  map_set(&js->hashes, inst->uuid, hash);
   js->changed = 1;
   return 0;
 }
@@ -0,0 +1,75 @@
+/* Benchmark of saving and loading a large collection with the json
+   storage plugin, with the relations stored as json and in binary
+   format.
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_json_collection
+
+   and run it manually with the same environment as the tests,
+   optionally with the number of relations as argument. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlite.h"
+#include "dlite-macros.h"
+
+
+/* Saves collection `*coll` with the given collection format, frees it
+   and loads it again into `*coll`.  Returns non-zero on error. */
+static int saveload(DLiteCollection **coll, const char *format)
+{
+  char options[64];
+  DLiteStorage *s;
+  clock_t t0;
+  int stat;
+
+  snprintf(options, sizeof(options), "mode=w;collection-format=%s", format);
+  t0 = clock();
+  if (!(s = dlite_storage_open("json", "benchmark-coll.json", options)))
+    return 1;
+  stat = dlite_instance_save(s, (DLiteInstance *)*coll);
+  stat |= dlite_storage_close(s);
+  if (stat) return 1;
+  printf("%-6s: saved in %.3f s", format,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+
+  dlite_collection_decref(*coll);
+  *coll = NULL;
+
+  t0 = clock();
+  if (!(s = dlite_storage_open("json", "benchmark-coll.json", "mode=r")))
+    return 1;
+  *coll = (DLiteCollection *)dlite_instance_load(s, "benchmark-coll");
+  stat = dlite_storage_close(s);
+  if (!*coll || stat) return 1;
+  printf(", loaded in %.3f s\n", (double)(clock() - t0) / CLOCKS_PER_SEC);
+  return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  char s[32], o[32];
+  int i, n = (argc > 1) ? atoi(argv[1]) : 1000000;
+  DLiteCollection *coll;
+  clock_t t0 = clock();
+  int retval=1;
+
+  if (!(coll = dlite_collection_create("benchmark-coll"))) return 1;
+  for (i=0; i<n; i++) {
+    snprintf(s, sizeof(s), "node%d", i / 10);
+    snprintf(o, sizeof(o), "value%d", i);
+    if (dlite_collection_add_relation(coll, s, "hasValue", o)) goto fail;
+  }
+  printf("created collection with %d relations in %.3f s\n", n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+
+  if (saveload(&coll, "json") || saveload(&coll, "binary")) goto fail;
+  retval = 0;
+ fail:
+  if (coll) dlite_collection_decref(coll);
+  return retval;
+}
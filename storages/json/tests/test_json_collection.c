@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "minunit/minunit.h"
+#include "utils/jstore.h"
+#include "dlite.h"
+#include "dlite-macros.h"
+
+#include "config.h"
+
+/* Number of relations in the saved and loaded collection */
+#define NRELATIONS 1000
+
+
+DLiteCollection *coll=NULL;
+
+
+MU_TEST(test_create)
+{
+  char s[32], o[32];
+  int i;
+  mu_check((coll = dlite_collection_create("bigcoll")));
+  for (i=0; i<NRELATIONS; i++) {
+    snprintf(s, sizeof(s), "node%d", i / 10);
+    snprintf(o, sizeof(o), "value%d", i);
+    mu_assert_int_eq(0, dlite_collection_add_relation(coll, s, "hasValue", o));
+  }
+}
+
+
+/* Saves the collection with the given collection format, frees it and
+   loads it again. */
+static void saveload(const char *format)
+{
+  char options[64], uuid[DLITE_UUID_LENGTH+1];
+  DLiteStorage *s;
+  const DLiteRelation *r;
+
+  snprintf(options, sizeof(options), "mode=w;collection-format=%s", format);
+  s = dlite_storage_open("json", "bigcoll.json", options);
+  mu_check(s);
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)coll));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  strcpy(uuid, coll->uuid);
+  dlite_collection_decref(coll);
+
+  s = dlite_storage_open("json", "bigcoll.json", "mode=r");
+  mu_check(s);
+  coll = (DLiteCollection *)dlite_instance_load(s, "bigcoll");
+  mu_check(coll);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  mu_assert_string_eq(uuid, coll->uuid);
+  mu_assert_int_eq(NRELATIONS, triplestore_length(coll->rstore));
+  r = dlite_collection_find_first(coll, "node7", "hasValue", "value79");
+  mu_check(r);
+}
+
+
+MU_TEST(test_json)
+{
+  saveload("json");
+}
+
+
+MU_TEST(test_binary)
+{
+  saveload("binary");
+}
+
+
+MU_TEST(test_binary_uri)
+{
+  const char *uri = "coll \"with\" \\special\\ chars";
+  DLiteCollection *c;
+  DLiteStorage *s;
+
+  mu_check((c = dlite_collection_create(uri)));
+  mu_assert_int_eq(0, dlite_collection_add_relation(c, "a", "b", "c"));
+  s = dlite_storage_open("json", "specialcoll.json",
+                         "mode=w;collection-format=binary");
+  mu_check(s);
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)c));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_collection_decref(c);
+
+  mu_check((s = dlite_storage_open("json", "specialcoll.json", "mode=r")));
+  mu_check((c = (DLiteCollection *)dlite_instance_load(s, uri)));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  mu_check(strcmp(c->uri, uri) == 0);
+  mu_assert_int_eq(1, triplestore_length(c->rstore));
+  dlite_collection_decref(c);
+}
+
+
+MU_TEST(test_binary_members)
+{
+  const char *uuid = "2b10c236-eb00-541a-901c-046c202e52fa";
+  DLiteCollection *c;
+  DLiteStorage *s;
+  char *buf;
+
+  mu_check((c = dlite_collection_create("membercoll")));
+  mu_assert_int_eq(0, dlite_collection_add_relation(c, "inst", "_has-uuid",
+                                                    uuid));
+  s = dlite_storage_open("json", "membercoll.json",
+                         "mode=w;collection-format=binary;with-uuid=true");
+  mu_check(s);
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)c));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_collection_decref(c);
+
+  mu_check((buf = jstore_readfile("membercoll.json")));
+  mu_check(strstr(buf, "\"uuid\""));
+  free(buf);
+
+  /* Loading should fail, since the member instance cannot be found */
+  mu_check((s = dlite_storage_open("json", "membercoll.json", "mode=r")));
+  mu_check(!dlite_instance_load(s, "membercoll"));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_errclr();
+}
+
+
+MU_TEST(test_convert)
+{
+  DLiteCollection *c;
+  DLiteStorage *s;
+  char *buf;
+
+  mu_check((c = dlite_collection_create("convertcoll")));
+  mu_assert_int_eq(0, dlite_collection_add_relation(c, "a", "b", "c"));
+  s = dlite_storage_open("json", "convertcoll.json", "mode=w");
+  mu_check(s);
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)c));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_collection_decref(c);
+
+  /* Saving an unchanged collection to a storage opened with another
+     collection format should convert it */
+  s = dlite_storage_open("json", "convertcoll.json",
+                         "mode=a;collection-format=binary");
+  mu_check(s);
+  mu_check((c = (DLiteCollection *)dlite_instance_load(s, "convertcoll")));
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)c));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_collection_decref(c);
+
+  mu_check((buf = jstore_readfile("convertcoll.json")));
+  mu_check(strstr(buf, "\"relations-binary\""));
+  free(buf);
+}
+
+
+MU_TEST(test_free)
+{
+  dlite_collection_decref(coll);
+}
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_create);
+  MU_RUN_TEST(test_json);
+  MU_RUN_TEST(test_binary);
+  MU_RUN_TEST(test_binary_uri);
+  MU_RUN_TEST(test_binary_members);
+  MU_RUN_TEST(test_convert);
+  MU_RUN_TEST(test_free);
+}
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
@@ -125,6 +125,60 @@ MU_TEST(test_append)
 }
 
 
+/* Returns non-zero if file `path` exists */
+static int file_exists(const char *path)
+{
+  FILE *fp = fopen(path, "r");
+  if (fp) fclose(fp);
+  return (fp) ? 1 : 0;
+}
+
+MU_TEST(test_skip_unchanged)
+{
+  DLiteStorage *s;
+  DLiteInstance *inst2, *inst3;
+  int value=3, *p;
+  char *buf;
+
+  /* Saving an unchanged instance should not rewrite the storage */
+  s = dlite_storage_open("json", "test-json-write.json", "mode=a");
+  mu_check(s);
+  mu_check((inst2 = json_load(s, "data3")));
+  mu_assert_int_eq(0, remove("test-json-write.json"));
+  mu_assert_int_eq(0, json_save(s, inst2));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  mu_check(!file_exists("test-json-write.json"));
+
+  /* ...but a changed instance should */
+  mu_assert_int_eq(0, json_save((s = dlite_storage_open(
+    "json", "test-json-write.json", "mode=w")), inst2));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  s = dlite_storage_open("json", "test-json-write.json", "mode=a");
+  mu_check(s);
+  mu_check((inst3 = json_load(s, "data3")) == inst2);
+  dlite_instance_decref(inst3);
+  mu_assert_int_eq(0, remove("test-json-write.json"));
+  mu_assert_int_eq(0, dlite_instance_set_property(inst2, "P1", &value));
+  mu_assert_int_eq(0, json_save(s, inst2));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  mu_check(file_exists("test-json-write.json"));
+
+  /* Writes through a pointer obtained before the last save are seen */
+  mu_check((p = dlite_instance_get_property(inst2, "P1")));
+  s = dlite_storage_open("json", "test-json-write.json", "mode=w");
+  mu_check(s);
+  mu_assert_int_eq(0, json_save(s, inst2));
+  *p = 42;
+  mu_assert_int_eq(0, json_save(s, inst2));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  mu_check((buf = jstore_readfile("test-json-write.json")));
+  mu_check(strstr(buf, "\"P1\": 42"));
+  free(buf);
+
+  dlite_instance_decref(inst2);
+}
+
+
 MU_TEST(test_iter)
 {
   char *filename = STRINGIFY(DLITE_ROOT) "/src/tests/test-read-data.json";
@@ -171,6 +225,7 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_load_data3);
   MU_RUN_TEST(test_write);
   MU_RUN_TEST(test_append);
+  MU_RUN_TEST(test_skip_unchanged);
   MU_RUN_TEST(test_iter);
 }
 
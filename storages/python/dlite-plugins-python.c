@@ -21,6 +21,29 @@ typedef struct {
   PyObject *obj;      /* Python instance of storage class */
 } DLitePythonStorage;
 
+/* Storage plugin API extended with the manifest entry of the Python
+   class implementing it.  The class is loaded on first use and stored
+   in `api.data`. */
+typedef struct {
+  DLiteStoragePlugin api;
+  char *path;         /* Python source file defining the class */
+  char *classname;    /* name of the class */
+} DLitePythonStoragePlugin;
+
+
+/*
+  Returns a borrowed reference to the Python class implementing `api`.
+  The class is imported on first use.  Returns NULL on error.
+ */
+static PyObject *get_class(const DLiteStoragePlugin *api)
+{
+  DLitePythonStoragePlugin *p = (DLitePythonStoragePlugin *)api;
+  if (!api->data)
+    p->api.data = dlite_pyembed_load_plugin_class(p->path, p->classname,
+                                                  "DLiteStorageBase");
+  return (PyObject *)api->data;
+}
+
 
 
 /*
@@ -38,9 +61,11 @@ opener(const DLiteStoragePlugin *api, const char *location,
   DLitePythonStorage *s=NULL;
   DLiteStorage *retval=NULL;
   PyObject *obj=NULL, *v=NULL, *writable=NULL;
-  PyObject *cls = (PyObject *)api->data;
+  PyObject *cls;
   const char *classname;
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
 
+  if (!(cls = get_class(api))) goto fail;
   if (!(classname = dlite_pyembed_classname(cls)))
     dlite_warnx("cannot get class name for storage plugin %s", api->name);
 
@@ -73,6 +98,7 @@ opener(const DLiteStoragePlugin *api, const char *location,
   }
   Py_XDECREF(v);
   Py_XDECREF(writable);
+  dlite_pyembed_gil_release(gstate);
 
   return retval;
 }
@@ -88,8 +114,10 @@ int closer(DLiteStorage *s)
   PyObject *v = NULL;
   PyObject *class = (PyObject *)s->api->data;
   const char *classname;
+  PyGILState_STATE gstate;
 
   dlite_errclr();
+  gstate = dlite_pyembed_gil_ensure();
   if (!(classname = dlite_pyembed_classname(class)))
     dlite_warnx("cannot get class name for storage plugin %s",
 		*((char **)s->api));
@@ -99,6 +127,7 @@ int closer(DLiteStorage *s)
   Py_XDECREF(v);
   //Py_XDECREF(v);  // why do we have to call this twice?
   Py_DECREF(sp->obj);
+  dlite_pyembed_gil_release(gstate);
   return retval;
 }
 
@@ -110,10 +139,11 @@ int closer(DLiteStorage *s)
 DLiteInstance *loader(const DLiteStorage *s, const char *id)
 {
   DLitePythonStorage *sp = (DLitePythonStorage *)s;
-  PyObject *pyuuid;
+  PyObject *pyuuid, *v;
   DLiteInstance *inst = NULL;
   PyObject *class = (PyObject *)s->api->data;
   const char *classname;
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
 
   pyuuid = PyUnicode_FromString(id);
 
@@ -121,7 +151,7 @@ DLiteInstance *loader(const DLiteStorage *s, const char *id)
   if (!(classname = dlite_pyembed_classname(class)))
     dlite_warnx("cannot get class name for storage plugin %s",
 		*((char **)s->api));
-  PyObject *v = PyObject_CallMethod(sp->obj, "load", "O", pyuuid);
+  v = PyObject_CallMethod(sp->obj, "load", "O", pyuuid);
   if (dlite_pyembed_err_check("error calling %s.load()", classname))
     goto fail;
   assert(v);
@@ -129,6 +159,7 @@ DLiteInstance *loader(const DLiteStorage *s, const char *id)
  fail:
   Py_XDECREF(pyuuid);
   Py_XDECREF(v);
+  dlite_pyembed_gil_release(gstate);
   return inst;
 }
 
@@ -139,7 +170,8 @@ DLiteInstance *loader(const DLiteStorage *s, const char *id)
 int saver(DLiteStorage *s, const DLiteInstance *inst)
 {
   DLitePythonStorage *sp = (DLitePythonStorage *)s;
-  PyObject *pyinst = dlite_pyembed_from_instance(inst->uuid);
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
+  PyObject *pyinst = NULL;
   PyObject *v = NULL;
   int retval = 1;
   PyObject *class = (PyObject *)s->api->data;
@@ -148,6 +180,7 @@ int saver(DLiteStorage *s, const DLiteInstance *inst)
   if (!(classname = dlite_pyembed_classname(class)))
     dlite_warnx("cannot get class name for storage plugin %s",
 		*((char **)s->api));
+  if (!(pyinst = dlite_pyembed_from_instance_ptr(inst))) goto fail;
   v = PyObject_CallMethod(sp->obj, "save", "O", pyinst);
   if (dlite_pyembed_err_check("error calling %s.save()", classname)) goto fail;
   retval = 0;
@@ -155,6 +188,7 @@ int saver(DLiteStorage *s, const DLiteInstance *inst)
   Py_XDECREF(pyinst);
   //Py_XDECREF(pyinst);  // why do we have to call this twice?
   Py_XDECREF(v);
+  dlite_pyembed_gil_release(gstate);
   return retval;
 }
 
@@ -164,11 +198,17 @@ int saver(DLiteStorage *s, const DLiteInstance *inst)
 */
 static void freeapi(PluginAPI *api)
 {
-  DLiteStoragePlugin *a = (DLiteStoragePlugin *)api;
-
-  free((char *)a->name);
-  Py_XDECREF(a->data);
-  free(a);
+  DLitePythonStoragePlugin *p = (DLitePythonStoragePlugin *)api;
+
+  free((char *)p->api.name);
+  free(p->path);
+  free(p->classname);
+  if (p->api.data && Py_IsInitialized()) {
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Py_DECREF(p->api.data);
+    PyGILState_Release(gstate);
+  }
+  free(p);
 }
 
 
@@ -185,7 +225,9 @@ typedef struct {
 void iterFree(void *iter)
 {
   Iter *i = (Iter *)iter;
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
   Py_XDECREF(i->v);
+  dlite_pyembed_gil_release(gstate);
   //if (i->pattern) free((char *)i->pattern);
   free(i);
 }
@@ -202,7 +244,9 @@ void *iterCreate(const DLiteStorage *s, const char *pattern)
   PyObject *class = (PyObject *)s->api->data;
   PyObject *patt = NULL;
   const char *classname;
+  PyGILState_STATE gstate;
   dlite_errclr();
+  gstate = dlite_pyembed_gil_ensure();
   if (!(classname = dlite_pyembed_classname(class)))
     dlite_warnx("cannot get class name for storage plugin %s",
 		*((char **)s->api));
@@ -224,6 +268,7 @@ void *iterCreate(const DLiteStorage *s, const char *pattern)
   retval = (void *)iter;
  fail:
   if (!retval && iter) iterFree(iter);
+  dlite_pyembed_gil_release(gstate);
   return retval;
 }
 
@@ -239,6 +284,7 @@ int iterNext(void *iter, char *buf)
   const char *uuid;
   int retval = -1;
   Iter *i = (Iter *)iter;
+  PyGILState_STATE gstate = dlite_pyembed_gil_ensure();
   PyObject *next = PyIter_Next((PyObject *)i->v);
   if (dlite_pyembed_err_check("error iteratine over %s.queue()",
                               i->classname)) goto fail;
@@ -254,106 +300,68 @@ int iterNext(void *iter, char *buf)
   }
  fail:
   Py_XDECREF(next);
+  dlite_pyembed_gil_release(gstate);
   return retval;
 }
 
 
 /*
   Returns API provided by storage plugin `name` implemented in Python.
+
+  The API is created from the plugin manifest, such that the Python
+  class implementing it is only imported when the storage is opened.
 */
 DSL_EXPORT const DLiteStoragePlugin *
 get_dlite_storage_plugin_api(void *state, int *iter)
 {
   int n;
-  DLiteStoragePlugin *api=NULL, *retval=NULL;
-  PyObject *storages=NULL, *cls=NULL, *name=NULL;
-  PyObject *open=NULL, *close=NULL, *queue=NULL, *load=NULL, *save=NULL;
-  const char *classname=NULL;
+  size_t nentries;
+  const DLitePyembedPluginEntry *manifest, *entry;
+  DLitePythonStoragePlugin *p=NULL;
+  DLiteStoragePlugin *api=NULL;
 
   dlite_globals_set(state);
 
-  if (!(storages = dlite_python_storage_load())) goto fail;
-  assert(PyList_Check(storages));
-  n = (int)PyList_Size(storages);
+  if (!(manifest = dlite_python_storage_manifest(&nentries))) return NULL;
+  n = (int)nentries;
 
-  /* get class implementing the plugin API */
+  /* get manifest entry of the class implementing the plugin API */
   dlite_errclr();
   if (*iter < 0 || *iter >= n)
-    FAIL1("API iterator index is out of range: %d", *iter);
-  cls = PyList_GetItem(storages, *iter);
-  assert(cls);
+    return dlite_err(1, "API iterator index is out of range: %d", *iter),
+      NULL;
+  entry = manifest + *iter;
   if (*iter < n - 1) (*iter)++;
 
-  /* get classname for error messages */
-  if (!(classname = dlite_pyembed_classname(cls)))
-    dlite_warnx("cannot get class name for storage plugin");
-
-  /* get attributes to fill into the api */
-  if (PyObject_HasAttrString(cls, "name"))
-    name = PyObject_GetAttrString(cls, "name");
-  else
-    name = PyUnicode_FromString(classname);
-  if (!PyUnicode_Check(name))
-    FAIL1("attribute 'name' (or '__name__') of '%s' is not a string",
-          (char *)PyUnicode_AsUTF8(name));
-
-  if (!(open = PyObject_GetAttrString(cls, "open")))
-    FAIL1("'%s' has no method: 'open'", classname);
-  if (!PyCallable_Check(open))
-    FAIL1("attribute 'open' of '%s' is not callable", classname);
-
-  if (!(close = PyObject_GetAttrString(cls, "close")))
-    FAIL1("'%s' has no method: 'close'", classname);
-  if (!PyCallable_Check(close))
-    FAIL1("attribute 'close' of '%s' is not callable", classname);
-
-  if (PyObject_HasAttrString(cls, "queue")) {
-    queue = PyObject_GetAttrString(cls, "queue");
-    if (!PyCallable_Check(queue))
-      FAIL1("attribute 'queue' of '%s' is not callable", classname);
-  }
-
-  if (PyObject_HasAttrString(cls, "load")) {
-    load = PyObject_GetAttrString(cls, "load");
-    if (!PyCallable_Check(load))
-      FAIL1("attribute 'load' of '%s' is not callable", classname);
+  if (!dlite_pyembed_plugin_has_attr(entry, "open"))
+    return dlite_err(1, "'%s' has no method: 'open'", entry->classname),
+      NULL;
+  if (!dlite_pyembed_plugin_has_attr(entry, "close"))
+    return dlite_err(1, "'%s' has no method: 'close'", entry->classname),
+      NULL;
+  if (!dlite_pyembed_plugin_has_attr(entry, "load") &&
+      !dlite_pyembed_plugin_has_attr(entry, "save"))
+    return dlite_err(1, "expect either method 'load()' or 'save()' to be "
+                     "defined in '%s'", entry->classname), NULL;
+
+  if (!(p = calloc(1, sizeof(DLitePythonStoragePlugin))) ||
+      !(p->path = strdup(entry->path)) ||
+      !(p->classname = strdup(entry->classname)) ||
+      !(p->api.name = strdup(entry->name))) {
+    if (p) freeapi((PluginAPI *)p);
+    return dlite_err(1, "allocation failure"), NULL;
   }
 
-  if (PyObject_HasAttrString(cls, "save")) {
-    save = PyObject_GetAttrString(cls, "save");
-    if (!PyCallable_Check(save))
-      FAIL1("attribute 'save' of '%s' is not callable", classname);
-  }
-
-  if (!load && !save)
-    FAIL1("expect either method 'load()' or 'save()' to be defined in '%s'",
-	  classname);
-
-  if (!(api = calloc(1, sizeof(DLiteStoragePlugin))))
-    FAIL("allocation failure");
-
-  api->name = strdup(PyUnicode_AsUTF8(name));
+  api = &p->api;
   api->freeapi = freeapi;
   api->open = opener;
   api->close = closer;
-  if (queue) {
+  if (dlite_pyembed_plugin_has_attr(entry, "queue")) {
     api->iterCreate = iterCreate;
     api->iterNext = iterNext;
     api->iterFree = iterFree;
   }
   api->loadInstance = loader;
   api->saveInstance = saver;
-  api->data = (void *)cls;
-  Py_INCREF(cls);
-
-  retval = api;
- fail:
-  if (!retval && api) free(api);
-  Py_XDECREF(name);
-  Py_XDECREF(open);
-  Py_XDECREF(close);
-  Py_XDECREF(load);
-  Py_XDECREF(save);
-
-  return retval;
+  return api;
 }
@@ -1,4 +1,7 @@
-"""A simple demonstrage of a DLite storage plugin written in Python."""
+"""A DLite storage plugin for YAML written in Python.
+
+Only installed if DLite is built without libyaml, in which case it
+replaces the native yaml plugin.  Requires PyYAML."""
 import os
 import sys
 
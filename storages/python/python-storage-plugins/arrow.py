@@ -0,0 +1,348 @@
+"""Storage plugins for reading/writing tabular instances as Apache Arrow
+IPC or Parquet files."""
+import ast
+import hashlib
+import json
+import mmap
+
+import numpy as np
+import pyarrow as pa
+import pyarrow.ipc
+import pyarrow.parquet as pq
+
+import dlite
+from dlite.options import Options
+
+
+class ArrowStorage:
+    """Common implementation of the arrow and parquet storage plugins.
+
+    Only tabular instances can be stored, i.e. instances with a single
+    dimension and only one-dimensional properties.  Each property is
+    stored as a column and each element as a row.
+
+    The uri, uuid and metadata of the instance are stored in the
+    schema metadata, such that the instance can be loaded back without
+    knowing its metadata in advance.  Files not written by DLite are
+    loaded with metadata inferred from their schema.
+
+    Numerical columns without nulls that are stored in a single record
+    batch or row group are not copied when they are loaded.  The
+    properties of the instance refer directly to the arrow buffers,
+    which for arrow IPC files are mapped copy-on-write from the file.
+    Arrow IPC files are therefore written as a single record batch
+    unless `row_group_size` is given.  Columns spanning several record
+    batches or row groups are copied.
+
+    Integer and boolean properties cannot represent missing values.
+    Loading a column with nulls into such a property is an error.
+    """
+    format = None
+
+    def open(self, uri, options=None):
+        """Opens `uri`, which should be a path to a local file.
+
+        Options
+        -------
+        mode: "r" | "w"
+            Whether to read or write data.  Defaults to "r"
+        meta: URI
+            URI to metadata of the loaded instance.  Only the columns
+            corresponding to its properties are read.  Defaults to the
+            metadata the file was saved with or metadata inferred from
+            the schema.
+        id: string
+            Explicit id of the loaded instance.  Optional
+        columns: names
+            Comma-separated list of columns to read.  The loaded
+            instance gets metadata inferred from these columns.  Optional
+        rows: start:stop
+            Range of rows to read.  Only row groups (record batches)
+            overlapping with the range are read.  Optional
+        filters: expression
+            Parquet only.  Row filter in the disjunctive normal form
+            used by pyarrow.parquet.read_table(), like `[("x", ">", 0)]`.
+            Row groups whos statistics do not match are skipped.
+        row_group_size: int
+            Maximum number of rows in each row group (record batch)
+            when writing.  Smaller groups allow `rows` and `filters` to
+            skip more data, but columns spanning several groups are
+            copied when loaded.  Defaults to 65536 for parquet and to a
+            single record batch for arrow IPC
+        compression: string
+            Parquet only.  Compression codec used when writing.
+            Defaults to "snappy"
+        """
+        self.options = Options(options, defaults='mode=r;compression=snappy')
+        if self.options.mode not in ('r', 'w'):
+            raise ValueError('%s option `mode` must be "r" or "w"' %
+                             self.__class__.__name__)
+        self.writable = self.options.mode == 'w'
+        self.uri = uri
+
+    def close(self):
+        """Closes this storage."""
+        pass
+
+    def load(self, uuid=None):
+        """Loads `uuid` from current storage and return it as a new
+        instance."""
+        opts = self.options
+        if self.format == 'parquet':
+            source = pq.ParquetFile(self.uri, memory_map=True)
+            schema = source.schema_arrow
+            sizes = [source.metadata.row_group(i).num_rows
+                     for i in range(source.num_row_groups)]
+            base = None
+        else:
+            base = map_file(self.uri)
+            source = pa.ipc.open_file(pa.py_buffer(base))
+            schema = source.schema
+            sizes = [source.get_batch(i).num_rows
+                     for i in range(source.num_record_batches)]
+
+        saved = schema.metadata or {}
+        if 'meta' in opts:
+            Meta = dlite.get_instance(opts.meta)
+        elif 'columns' in opts:
+            Meta = infer_meta(schema, opts.columns.split(','), self.uri)
+        else:
+            Meta = saved_meta(saved) or infer_meta(schema, schema.names,
+                                                   self.uri)
+        props = Meta['properties']
+        columns = [p.name for p in props]
+
+        if 'filters' in opts:
+            if self.format != 'parquet':
+                raise ValueError('option `filters` is only supported for '
+                                 'parquet')
+            table = pq.read_table(self.uri, columns=columns, memory_map=True,
+                                  filters=ast.literal_eval(opts.filters))
+            start, stop = parse_rows(opts.get('rows'), table.num_rows)
+            table = table.slice(start, stop - start)
+        else:
+            start, stop = parse_rows(opts.get('rows'), sum(sizes))
+            groups, offset = select_groups(sizes, start, stop)
+            if not groups:
+                table = schema.empty_table().select(columns)
+            elif self.format == 'parquet':
+                table = source.read_row_groups(groups, columns=columns)
+            else:
+                table = pa.Table.from_batches(
+                    [source.get_batch(i) for i in groups],
+                    schema=schema).select(columns)
+            table = table.slice(start - offset, stop - start)
+
+        id = opts.get('id')
+        if id is None and not set(opts).intersection(
+                ('meta', 'columns', 'rows', 'filters')):
+            id = saved.get(b'dlite.uri', saved.get(b'dlite.uuid'))
+            id = id.decode() if id else None
+        for p in props:
+            nulls = table.column(p.name).null_count
+            if nulls and p.type.rstrip('0123456789') in ('int', 'uint',
+                                                         'bool'):
+                raise ValueError(
+                    'column "%s" has %d missing values, which cannot be '
+                    'represented by a property of type %s' % (
+                        p.name, nulls, p.type))
+        inst = Meta(dims=[table.num_rows], id=id)
+        inst.assign_columns({name: column_array(table.column(name), base)
+                             for name in columns})
+        return inst
+
+    def save(self, inst):
+        """Stores `inst` in current storage."""
+        props = inst.meta['properties']
+        if len(inst.dimensions) != 1 or any(p.ndims != 1 for p in props):
+            raise TypeError(
+                'only instances with one dimension and one-dimensional '
+                'properties can be stored in %s format: %s' % (
+                    self.__class__.__name__, inst.uuid))
+        fields, arrays = [], []
+        for p in props:
+            arr = property_array(inst, p)
+            fieldmeta = {}
+            if p.unit:
+                fieldmeta['unit'] = p.unit
+            if p.description:
+                fieldmeta['description'] = p.description
+            fields.append(pa.field(p.name, arr.type, metadata=fieldmeta))
+            arrays.append(arr)
+        metadata = {
+            'dlite.uuid': inst.uuid,
+            'dlite.meta': inst.meta.uri,
+            'dlite.metadata': inst.meta.asjson(),
+        }
+        if inst.uri:
+            metadata['dlite.uri'] = inst.uri
+        table = pa.Table.from_arrays(
+            arrays, schema=pa.schema(fields, metadata=metadata))
+
+        size = self.options.get('row_group_size')
+        size = int(size) if size else None
+        if self.format == 'parquet':
+            pq.write_table(table, self.uri, row_group_size=size or 65536,
+                           compression=self.options.compression)
+        else:
+            with pa.OSFile(self.uri, 'wb') as sink:
+                with pa.ipc.new_file(sink, table.schema) as writer:
+                    writer.write_table(table, max_chunksize=size)
+
+
+class arrow(ArrowStorage, DLiteStorageBase):  # noqa: F821
+    """DLite storage plugin for Apache Arrow IPC files (Feather v2)."""
+    format = 'ipc'
+
+
+class parquet(ArrowStorage, DLiteStorageBase):  # noqa: F821
+    """DLite storage plugin for Apache Parquet files."""
+    format = 'parquet'
+
+
+def map_file(path):
+    """Returns a private copy-on-write memory map of file `path`.
+
+    Writes to the map are not written back to the file."""
+    with open(path, 'rb') as f:
+        return mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_COPY)
+
+
+def parse_rows(rows, nrows):
+    """Returns a `(start, stop)` tuple from range string `rows` of the
+    form "start:stop", clipped to `nrows` rows.  Both start and stop
+    may be omitted."""
+    if not rows:
+        return 0, nrows
+    start, sep, stop = rows.partition(':')
+    if not sep:
+        raise ValueError('option `rows` must be of the form "start:stop"')
+    start, stop, _ = slice(int(start) if start else None,
+                           int(stop) if stop else None).indices(nrows)
+    return start, max(start, stop)
+
+
+def select_groups(sizes, start, stop):
+    """Returns a tuple with the indices of the row groups overlapping
+    with rows `start` to `stop` and the index of the first row in the
+    first selected group.  `sizes` is the number of rows in each group."""
+    groups, offset, pos = [], 0, 0
+    for i, n in enumerate(sizes):
+        if pos + n > start and pos < stop:
+            if not groups:
+                offset = pos
+            groups.append(i)
+        pos += n
+    return groups, offset
+
+
+def saved_meta(saved):
+    """Returns the metadata stored in schema metadata `saved` or None if
+    the file was not written by DLite."""
+    if b'dlite.meta' not in saved:
+        return None
+    uri = saved[b'dlite.meta'].decode()
+    if dlite.has_instance(uri, True):
+        return dlite.get_instance(uri)
+    if b'dlite.metadata' not in saved:
+        return None
+    d = json.loads(saved[b'dlite.metadata'])
+    dims = [dlite.Dimension(dim['name'], dim.get('description'))
+            for dim in d['dimensions']]
+    props = [dlite.Property(p['name'], p['type'], p.get('dims'),
+                            p.get('unit'), p.get('iri'), p.get('description'))
+             for p in d['properties']]
+    return dlite.Instance(uri, dims, props, None, d.get('description', ''))
+
+
+def numpy_dtype(typ):
+    """Returns the numpy dtype corresponding to numerical arrow type
+    `typ`."""
+    return pa.array([], type=typ).to_numpy().dtype
+
+
+def infer_type(typ):
+    """Returns dlite type name corresponding to arrow type `typ`."""
+    if pa.types.is_boolean(typ):
+        return 'bool'
+    if pa.types.is_float16(typ):
+        return 'float32'
+    if pa.types.is_integer(typ) or pa.types.is_floating(typ):
+        return numpy_dtype(typ).name
+    return 'string'
+
+
+def infer_meta(schema, columns, uri):
+    """Infer dlite metadata for `columns` in arrow schema `schema`.
+    `uri` is the location of the input storage."""
+    hash = hashlib.sha256(('%s\n%s' % (schema.remove_metadata(), columns)
+                           ).encode()).hexdigest()
+    metauri = f'onto-ns.com/meta/1.0/generated_from_arrow_{hash}'
+    if dlite.has_instance(metauri, False):
+        return dlite.get_instance(metauri)
+    dims = [dlite.Dimension('rows', 'Number of rows.')]
+    props = []
+    for name in columns:
+        field = schema.field(name)
+        fieldmeta = field.metadata or {}
+        unit = fieldmeta.get(b'unit')
+        descr = fieldmeta.get(b'description')
+        props.append(dlite.Property(
+            name, infer_type(field.type), ['rows'],
+            unit.decode() if unit else None, None,
+            descr.decode() if descr else None))
+    return dlite.Instance(metauri, dims, props, None,
+                          f'Inferred metadata for {uri}')
+
+
+def column_array(column, base=None):
+    """Returns arrow ChunkedArray `column` as a numpy array.
+
+    Numerical columns consisting of a single chunk without nulls are
+    returned as a writable view into the arrow data buffer without
+    copying.  `base` is the memory map the arrow buffers refer to, or
+    None if they are allocated by arrow.  Other columns are copied."""
+    typ = column.type
+    if (column.num_chunks == 1 and column.null_count == 0 and
+            (pa.types.is_integer(typ) or pa.types.is_floating(typ))):
+        view = buffer_view(column.chunk(0), base)
+        if view is not None:
+            return view
+    if not (pa.types.is_boolean(typ) or pa.types.is_integer(typ) or
+            pa.types.is_floating(typ)):
+        if not (pa.types.is_string(typ) or pa.types.is_large_string(typ)):
+            column = column.cast(pa.string())
+        return np.array(column.to_pylist(), dtype=object)
+    return column.to_numpy()
+
+
+def buffer_view(chunk, base=None):
+    """Returns a writable numpy view of the data buffer of numerical arrow
+    array `chunk` or None if no writable view can be created."""
+    dtype = numpy_dtype(chunk.type)
+    data = chunk.buffers()[1]
+    offset = chunk.offset * dtype.itemsize
+    nbytes = len(chunk) * dtype.itemsize
+    if base is not None:
+        mapped = np.frombuffer(base, dtype=np.uint8)
+        pos = data.address - mapped.ctypes.data + offset
+        if 0 <= pos and pos + nbytes <= len(mapped):
+            return mapped[pos:pos + nbytes].view(dtype)
+    if data.is_mutable:
+        return np.frombuffer(data, dtype=dtype, count=len(chunk),
+                             offset=offset)
+    return None
+
+
+def property_array(inst, prop):
+    """Returns property `prop` of `inst` as an arrow array.  Numerical
+    properties are not copied."""
+    basetype = prop.type.rstrip('0123456789')
+    if basetype in ('int', 'uint', 'float', 'double'):
+        return pa.array(np.asarray(inst.get_property_buffer(prop.name)))
+    elif basetype == 'bool':
+        return pa.array(np.asarray(inst[prop.name]), type=pa.bool_())
+    elif basetype == 'string':
+        return pa.array(list(inst[prop.name]), type=pa.string())
+    raise TypeError('cannot store property "%s" of type %s in arrow format' %
+                    (prop.name, prop.type))
@@ -68,8 +68,9 @@ class csv(DLiteStorageBase):  # noqa: F821
                 'csv option `meta` must be provided if `infer` if false')
 
         inst = Meta(dims=(rows, ), id=self.options.get('id'))
-        for i, name in enumerate(inst.properties):
-            inst[i] = data.iloc[:, i]
+        inst.assign_columns({
+            prop.name: data.iloc[:, i].to_numpy()
+            for i, prop in enumerate(inst.meta['properties'])})
 
         return inst
 
@@ -133,6 +134,8 @@ def infer_meta(data, metauri, uri):
     for i, col in enumerate(data.columns):
         name = infer_prop_name(col)
         type = data.dtypes[i].name
+        if type == 'object':
+            type = 'string'
         dims = ['rows']
         unit = infer_prop_unit(col)
         props.append(dlite.Property(name, type, dims, unit, None, None))
@@ -1,8 +1,8 @@
-import os
-import sys
-import warnings
-import fnmatch
+import io
+import itertools
+import struct
 
+import numpy as np
 import psycopg2
 from psycopg2 import sql
 
@@ -37,9 +37,124 @@ def to_pgtype(typename):
         t = typename.rstrip('0123456789')
         return pgtypes[t]
 
+# Binary COPY format of postgresql types: (type oid, element format)
+# Types without an element format are encoded as raw bytes.
+pgbinary = {
+    'bool': (16, '?'),
+    'bytea': (17, None),
+    'smallint': (21, 'i2'),
+    'integer': (23, 'i4'),
+    'bigint': (20, 'i8'),
+    'real': (700, 'f4'),
+    'float8': (701, 'f8'),
+    'varchar': (1043, None),
+}
+
+PGCOPY_HEADER = b'PGCOPY\n\xff\r\n\x00' + struct.pack('!ii', 0, 0)
+PGCOPY_TRAILER = struct.pack('!h', -1)
+
+# Counter for naming server-side cursors
+cursor_counter = itertools.count()
+
+
+def encode_bytes(value):
+    """Returns `value` as bytes for a text or bytea field."""
+    if isinstance(value, str):
+        return value.encode()
+    elif isinstance(value, (bytes, bytearray)):
+        return bytes(value)
+    return np.asarray(value).tobytes()
+
+
+def encode_scalar(value, pgtype):
+    """Returns `value` encoded in the binary COPY format of `pgtype`."""
+    if value is None:
+        return None
+    oid, fmt = pgbinary[pgtype]
+    if fmt:
+        return np.asarray(value, dtype='>' + fmt).tobytes()
+    return encode_bytes(value)
+
+
+def encode_array(value, pgtype):
+    """Returns array `value` encoded in the binary COPY format of an
+    array of `pgtype`.  Numerical arrays are encoded without looping
+    over the elements in Python."""
+    oid, fmt = pgbinary[pgtype]
+    if fmt:
+        arr = np.asarray(value)
+    else:
+        arr = np.array(dlite.standardise(value, asdict=False), dtype=object)
+    if arr.size == 0:
+        return struct.pack('!iii', 0, 0, oid)
+
+    hasnull = 0
+    if fmt:
+        buf = np.empty(arr.size, dtype=[('len', '>i4'), ('val', '>' + fmt)])
+        buf['len'] = buf.dtype['val'].itemsize
+        buf['val'] = arr.ravel()
+        data = buf.tobytes()
+    else:
+        parts = []
+        for x in arr.flat:
+            if x is None:
+                hasnull = 1
+                parts.append(struct.pack('!i', -1))
+            else:
+                b = encode_bytes(x)
+                parts.append(struct.pack('!i', len(b)))
+                parts.append(b)
+        data = b''.join(parts)
+    header = struct.pack('!iii', arr.ndim, hasnull, oid) + b''.join(
+        struct.pack('!ii', n, 1) for n in arr.shape)
+    return header + data
+
+
+def column_encoder(pgtype):
+    """Returns a function encoding values of a column of type `pgtype`
+    (like "float8" or "varchar[2][]") in the binary COPY format."""
+    base = pgtype.split('[', 1)[0]
+    if '[' in pgtype:
+        return lambda value: encode_array(value, base)
+    return lambda value: encode_scalar(value, base)
+
+
+def copy_data(rows):
+    """Returns a binary COPY stream with the rows of encoded fields in
+    `rows`.  None fields are NULL."""
+    parts = [PGCOPY_HEADER]
+    for fields in rows:
+        parts.append(struct.pack('!h', len(fields)))
+        for field in fields:
+            if field is None:
+                parts.append(struct.pack('!i', -1))
+            else:
+                parts.append(struct.pack('!i', len(field)))
+                parts.append(field)
+    parts.append(PGCOPY_TRAILER)
+    return b''.join(parts)
+
+
+def glob_to_like(pattern):
+    """Converts glob pattern `pattern` to a SQL LIKE pattern."""
+    like = pattern.replace('\\', '\\\\').replace('%', '\\%').replace(
+        '_', '\\_')
+    return like.replace('*', '%').replace('?', '_')
+
 
 class postgresql(DLiteStorageBase):
-    """DLite storage plugin for PostgreSQL."""
+    """DLite storage plugin for PostgreSQL.
+
+    Saved instances are buffered and written in batches with binary
+    `COPY ... FROM STDIN`.  The buffer is flushed when it reaches
+    `batch_size` instances, before loading or iterating and when the
+    storage is closed.
+
+    Iteration uses a server-side cursor.  The rows of each batch of
+    iterated uuids are prefetched with one query per metadata, such
+    that loading the iterated instances does not need any further
+    queries.
+    """
     def open(self, uri, options=None):
         """Opens `uri`.
 
@@ -55,50 +170,99 @@ class postgresql(DLiteStorageBase):
         - database : Name of database to connect to (default: dlite)
         - user : User name.
         - password : Password.
+        - port : Port number of the server.
         - mode : append | r
             Valid values are:
             - append   Append to existing file or create new file (default)
             - r        Open existing file for read-only
+        - batch_size : Number of instances to save or fetch in each
+            query (default: 1000)
+        - prefetch : Whether to prefetch the instances of each batch of
+            uuids when iterating (default: true)
 
         After the options are passed, this method may set attribute
         `writable` to true if it is writable and to false otherwise.
         If `writable` is not set, it is assumed to be true.
         """
-        self.options = Options(options, defaults='database=dlite;mode=append')
+        self.options = Options(
+            options, defaults='database=dlite;mode=append;batch_size=1000;'
+            'prefetch=true')
         opts = self.options
         opts.setdefault('password', None)
+        opts.setdefault('port', None)
         self.writable = False if opts.mode == 'r' else True
+        self.batch_size = int(opts.batch_size)
+        self.prefetch = dlite.asbool(opts.prefetch)
 
         # Connect to existing database
         print('  host:', uri)
         print('  user:', opts.user)
         print('  database:', opts.database)
         #print('  password:', opts.password)
-        self.conn = psycopg2.connect(host=uri, database=opts.database,
+        self.conn = psycopg2.connect(host=uri, port=opts.port,
+                                     database=opts.database,
                                      user=opts.user, password=opts.password)
 
         # Open a cursor to perform database operations
         self.cur = self.conn.cursor()
 
+        self.tables = set()      # names of tables known to exist
+        self.encoders = {}       # column encoders for each metadata table
+        self.pending = {}        # maps metadata uri to {uuid: row} to save
+        self.npending = 0        # number of pending rows
+        self.prefetched = {}     # maps uuid to prefetched row
+
     def close(self):
         """Closes this storage."""
-        self.cur.close()
-        self.conn.close()
+        try:
+            if self.npending:
+                self.flush()
+        finally:
+            self.cur.close()
+            self.conn.close()
 
     def load(self, uuid):
         """Loads `uuid` from current storage and return it as a new instance."""
         uuid = dlite.get_uuid(uuid)
-        q = sql.SQL('SELECT meta FROM uuidtable WHERE uuid = %s')
-        self.cur.execute(q, [uuid])
-        metaid, = self.cur.fetchone()
-        q = sql.SQL('SELECT * FROM {} WHERE uuid = %s').format(
-            sql.Identifier(metaid))
-        self.cur.execute(q, [uuid])
-        tokens = self.cur.fetchone()
-        uuid_, uri, metaid_, dims = tokens[:4]
-        values = tokens[4:]
-        assert uuid_ == uuid
-        assert metaid_ == metaid
+        if self.npending:
+            self.flush()
+        row = self.prefetched.pop(uuid, None)
+        if row is None:
+            row = self.fetch_rows([uuid]).get(uuid)
+        if row is None:
+            raise KeyError('no such instance in storage: %s' % uuid)
+        return self.instance_from_row(row)
+
+    def load_many(self, uuids):
+        """Returns a list of instances loaded from `uuids`, using one query
+        per metadata."""
+        uuids = [dlite.get_uuid(uuid) for uuid in uuids]
+        if self.npending:
+            self.flush()
+        rows = self.fetch_rows(uuids)
+        return [self.instance_from_row(rows[uuid]) for uuid in uuids]
+
+    def fetch_rows(self, uuids):
+        """Returns a dict mapping each uuid in `uuids` that exists in the
+        storage to its table row."""
+        q = sql.SQL('SELECT uuid, meta FROM uuidtable WHERE uuid = ANY(%s);')
+        self.cur.execute(q, [list(uuids)])
+        bymeta = {}
+        for uuid, metaid in self.cur.fetchall():
+            bymeta.setdefault(metaid, []).append(uuid)
+        rows = {}
+        for metaid, ids in bymeta.items():
+            q = sql.SQL('SELECT * FROM {} WHERE uuid = ANY(%s);').format(
+                sql.Identifier(metaid))
+            self.cur.execute(q, [ids])
+            for row in self.cur.fetchall():
+                rows[row[0]] = row
+        return rows
+
+    def instance_from_row(self, row):
+        """Returns a new instance created from table row `row`."""
+        uuid, uri, metaid, dims = row[:4]
+        values = row[4:]
 
         # Make sure we have metadata object correcponding to metaid
         try:
@@ -115,42 +279,79 @@ class postgresql(DLiteStorageBase):
         return inst
 
     def save(self, inst):
-        """Stores `inst` in current storage."""
-
-        # Save to metadata table
-        if not self.table_exists(inst.meta.uri):
-            self.table_create(inst.meta, inst.dimensions.values())
-        colnames = ['uuid', 'uri', 'meta', 'dims'] +  [
-            p.name for p in inst.meta['properties']]
-        q = sql.SQL('INSERT INTO {0} ({1}) VALUES ({2});').format(
-            sql.Identifier(inst.meta.uri),
-            sql.SQL(', ').join(map(sql.Identifier, colnames)),
-            (sql.Placeholder() * len(colnames)).join(', '))
-        values = [inst.uuid,
-                  inst.uri,
-                  inst.meta.uri,
-                  list(inst.dimensions.values()),
-        ] + [dlite.standardise(v, asdict=False)
-             for v in inst.properties.values()]
+        """Stores `inst` in current storage.
+
+        The instance is buffered and written to the database by flush().
+        """
+        metaid = inst.meta.uri
+        if metaid not in self.encoders:
+            if not self.table_exists(metaid):
+                self.table_create(inst.meta, inst.dimensions.values())
+            self.encoders[metaid] = [
+                column_encoder(to_pgtype(p.type) + '[]' * len(p.dims))
+                for p in inst.meta['properties']]
+        row = [encode_bytes(inst.uuid),
+               None if inst.uri is None else encode_bytes(inst.uri),
+               encode_bytes(metaid),
+               encode_array(list(inst.dimensions.values()), 'integer')]
+        row.extend(encode(inst.get_property(p.name)) for encode, p in zip(
+            self.encoders[metaid], inst.meta['properties']))
+        pending = self.pending.setdefault(metaid, {})
+        if inst.uuid not in pending:
+            self.npending += 1
+        pending[inst.uuid] = row
+        if self.npending >= self.batch_size:
+            self.flush()
+
+    def flush(self):
+        """Writes all buffered instances to the database with binary COPY.
+        Instances that already are in the database are left unchanged.
+
+        On failure the transaction is rolled back and the buffered
+        instances are discarded, such that the connection can still be
+        used."""
         try:
-            self.cur.execute(q, values)
-        except psycopg2.IntegrityError:
-            self.conn.rollback()  # Instance already in database
-            return
-
-        # Save to uuidtable
-        if not self.table_exists('uuidtable'):
-            self.uuidtable_create()
-        q = sql.SQL('INSERT INTO uuidtable (uuid, meta) VALUES (%s, %s);')
-        self.cur.execute(q, [inst.uuid, inst.meta.uri])
-        self.conn.commit()
+            if not self.table_exists('uuidtable'):
+                self.uuidtable_create()
+            uuidrows = []
+            for metaid, pending in self.pending.items():
+                self.copy_rows(metaid, pending.values())
+                uuidrows.extend([row[0], row[2]] for row in pending.values())
+            self.copy_rows('uuidtable', uuidrows)
+            self.conn.commit()
+        except Exception:
+            self.conn.rollback()
+            raise
+        finally:
+            self.pending.clear()
+            self.npending = 0
+
+    def copy_rows(self, table_name, rows):
+        """Copies encoded `rows` into table `table_name`, skipping rows
+        whos uuid already is in the table."""
+        tmp = sql.Identifier('_dlite_copy')
+        table = sql.Identifier(table_name)
+        self.cur.execute(sql.SQL(
+            'CREATE TEMP TABLE {} (LIKE {}) ON COMMIT DROP;').format(
+                tmp, table))
+        q = sql.SQL('COPY {} FROM STDIN WITH (FORMAT binary);').format(tmp)
+        self.cur.copy_expert(q.as_string(self.conn),
+                             io.BytesIO(copy_data(rows)))
+        self.cur.execute(sql.SQL(
+            'INSERT INTO {} SELECT * FROM {} ON CONFLICT (uuid) DO NOTHING; '
+            'DROP TABLE {};').format(table, tmp, tmp))
 
     def table_exists(self, table_name):
         """Returns true if a table named `table_name` exists."""
+        if table_name in self.tables:
+            return True
         self.cur.execute(
             'select exists(select * from information_schema.tables '
             'where table_name=%s);', (table_name, ))
-        return self.cur.fetchone()[0]
+        exists = self.cur.fetchone()[0]
+        if exists:
+            self.tables.add(table_name)
+        return exists
 
     def table_create(self, meta, dims=None):
         """Creates a table for storing instances of `meta`."""
@@ -174,6 +375,7 @@ class postgresql(DLiteStorageBase):
                     ', '.join(cols)).format(sql.Identifier(meta.uri))
         self.cur.execute(q)
         self.conn.commit()
+        self.tables.add(table_name)
 
     def uuidtable_create(self):
         """Creates the uuidtable - a table mapping all uuid's to their
@@ -184,21 +386,32 @@ class postgresql(DLiteStorageBase):
                     ');')
         self.cur.execute(q)
         self.conn.commit()
+        self.tables.add('uuidtable')
 
     def queue(self, pattern):
         """Generator method that iterates over all UUIDs in the storage
-        who's metadata URI matches glob pattern `pattern`."""
-        if pattern:
-            # Convert glob patter to PostgreSQL regular expression
-            regex = '^{}'.format(fnmatch.translate(globex).replace(
-                '\\Z(?ms)', '$'))
-            q = sql.SQL('SELECT uuid from uuidtable WHERE uuid ~ %s;')
-            self.cur.execute(q, (regex, ))
-        else:
-            q = sql.SQL('SELECT uuid from uuidtable;')
-            self.cur.execute(q)
-        tokens = self.cur.fetchone()
-        while tokens:
-            uuid, = tokens
-            yield uuid
-            tokens = self.cur.fetchone()
+        who's metadata URI matches glob pattern `pattern`.
+
+        The UUIDs are fetched in batches from a server-side cursor."""
+        if self.npending:
+            self.flush()
+        cur = self.conn.cursor(
+            name='dlite_queue_%d' % next(cursor_counter), withhold=True)
+        cur.itersize = self.batch_size
+        try:
+            if pattern:
+                q = sql.SQL('SELECT uuid FROM uuidtable WHERE meta LIKE %s;')
+                cur.execute(q, (glob_to_like(pattern), ))
+            else:
+                q = sql.SQL('SELECT uuid FROM uuidtable;')
+                cur.execute(q)
+            while True:
+                uuids = [uuid for uuid, in cur.fetchmany(self.batch_size)]
+                if not uuids:
+                    break
+                if self.prefetch:
+                    self.prefetched = self.fetch_rows(uuids)
+                yield from uuids
+        finally:
+            self.prefetched = {}
+            cur.close()
@@ -0,0 +1,83 @@
+/* Benchmark of bulk saving, iterating over and loading instances with
+   the postgresql storage plugin.
+
+   Not run by ctest.  It uses the throw-away server of the
+   test_postgresql_bulk test.  Build it with
+
+       cmake --build . --target benchmark_postgresql_bulk
+
+   and run it manually from storages/python/tests in the build
+   directory with the same environment as the tests, optionally with
+   the number of instances as argument, while the server is running:
+
+       ctest -R pgserver_start
+       ./benchmark_postgresql_bulk 2000
+       ctest -R pgserver_stop
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlite.h"
+#include "dlite-macros.h"
+
+/* PGHOST (socket directory) and PGPORT of the throw-away server started
+   by pgserver.cmake are provided by cmake */
+#define OPTIONS "database=dlite;user=dlite;port=" STRINGIFY(PGPORT)
+
+
+int main(int argc, char *argv[])
+{
+  size_t dims[] = {2};
+  const char *skills[] = {"jumping", "hopping"};
+  char name[32], uuid[DLITE_UUID_LENGTH+1];
+  char *namep = name;
+  int i, stat, n = (argc > 1) ? atoi(argv[1]) : 2000;
+  float age;
+  DLiteInstance *meta, *inst;
+  DLiteStorage *db=NULL;
+  void *si=NULL;
+  clock_t t0;
+  int retval=1;
+
+  if (!(meta = dlite_instance_load_url("json://Person.json?mode=r")))
+    return 1;
+
+  if (!(db = dlite_storage_open("postgresql", PGHOST, OPTIONS))) goto fail;
+  t0 = clock();
+  for (i=0; i<n; i++) {
+    snprintf(name, sizeof(name), "person%d", i);
+    age = (float)(i % 100);
+    if (!(inst = dlite_instance_create((DLiteMeta *)meta, dims, NULL)))
+      goto fail;
+    dlite_instance_set_property(inst, "name", &namep);
+    dlite_instance_set_property(inst, "age", &age);
+    dlite_instance_set_property(inst, "skills", skills);
+    stat = dlite_instance_save(db, inst);
+    dlite_instance_decref(inst);
+    if (stat) goto fail;
+  }
+  stat = dlite_storage_close(db);
+  db = NULL;
+  if (stat) goto fail;
+  printf("saved %d instances in %.3f s\n", n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+
+  if (!(db = dlite_storage_open("postgresql", PGHOST, OPTIONS ";mode=r")))
+    goto fail;
+  t0 = clock();
+  if (!(si = dlite_storage_iter_create(db, "*/Person"))) goto fail;
+  for (i=0; dlite_storage_iter_next(db, si, uuid) == 0; i++) {
+    if (!(inst = dlite_instance_load(db, uuid))) goto fail;
+    dlite_instance_decref(inst);
+  }
+  printf("iterated over and loaded %d instances in %.3f s\n", i,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  retval = 0;
+ fail:
+  if (si) dlite_storage_iter_free(db, si);
+  if (db) dlite_storage_close(db);
+  dlite_instance_decref(meta);
+  return retval;
+}
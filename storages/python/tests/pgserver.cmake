@@ -0,0 +1,56 @@
+# -*- Mode: cmake -*-
+#
+# Script for starting and stopping a throw-away PostgreSQL server used by
+# the PostgreSQL tests.  Run it as
+#
+#     cmake -DACTION=<start|stop> -DPGDATA=<dir> -DPGSOCKDIR=<dir>
+#           -DPGPORT=<port> -DINITDB=<path> -DPG_CTL=<path>
+#           -DCREATEDB=<path> -P pgserver.cmake
+#
+# The server only listens on a unix socket in PGSOCKDIR and uses trust
+# authentication for the current user.  PGSOCKDIR should be short,
+# since unix socket paths are limited to 107 bytes.  A database named
+# "dlite" is created when the server is started.
+
+if(ACTION STREQUAL "start")
+  file(REMOVE_RECURSE ${PGDATA} ${PGSOCKDIR})
+  file(MAKE_DIRECTORY ${PGSOCKDIR})
+  execute_process(
+    COMMAND ${INITDB} -D ${PGDATA} -A trust -U dlite --no-sync
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+    )
+  if(result)
+    message(FATAL_ERROR "initdb failed: ${result}")
+  endif()
+  execute_process(
+    COMMAND ${PG_CTL} -D ${PGDATA} -l ${PGDATA}/server.log -w
+      -o "-k ${PGSOCKDIR} -p ${PGPORT} -c listen_addresses=''" start
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+    )
+  if(result)
+    message(FATAL_ERROR "cannot start PostgreSQL server: ${result}")
+  endif()
+  execute_process(
+    COMMAND ${CREATEDB} -h ${PGSOCKDIR} -p ${PGPORT} -U dlite dlite
+    RESULT_VARIABLE result
+    )
+  if(result)
+    message(FATAL_ERROR "createdb failed: ${result}")
+  endif()
+
+elseif(ACTION STREQUAL "stop")
+  execute_process(
+    COMMAND ${PG_CTL} -D ${PGDATA} -m fast -w stop
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+    )
+  file(REMOVE_RECURSE ${PGDATA} ${PGSOCKDIR})
+  if(result)
+    message(FATAL_ERROR "cannot stop PostgreSQL server: ${result}")
+  endif()
+
+else()
+  message(FATAL_ERROR "ACTION must be either \"start\" or \"stop\"")
+endif()
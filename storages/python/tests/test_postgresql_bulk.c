@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "minunit/minunit.h"
+
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-storage-plugins.h"
+
+/* PGHOST (socket directory) and PGPORT of the throw-away server started
+   by pgserver.cmake are provided by cmake */
+#define OPTIONS "database=dlite;user=dlite;port=" STRINGIFY(PGPORT)
+
+/* Number of saved instances, chosen to give more than one batch */
+#define NINST 120
+
+DLiteStorage *db=NULL;
+DLiteInstance *meta=NULL;
+char *uuids[NINST];
+
+
+MU_TEST(test_save)
+{
+  size_t dims[] = {2};
+  const char *skills[] = {"jumping", "hopping"};
+  char name[32];
+  char *namep = name;
+  float age;
+  int i;
+
+  mu_check((meta = dlite_instance_load_url("json://Person.json?mode=r")));
+  mu_check((db = dlite_storage_open("postgresql", PGHOST,
+                                    OPTIONS ";batch_size=50")));
+  for (i=0; i<NINST; i++) {
+    DLiteInstance *inst;
+    snprintf(name, sizeof(name), "person%d", i);
+    age = (float)(i % 100);
+    mu_check((inst = dlite_instance_create((DLiteMeta *)meta, dims, NULL)));
+    mu_assert_int_eq(0, dlite_instance_set_property(inst, "name", &namep));
+    mu_assert_int_eq(0, dlite_instance_set_property(inst, "age", &age));
+    mu_assert_int_eq(0, dlite_instance_set_property(inst, "skills", skills));
+    mu_assert_int_eq(0, dlite_instance_save(db, inst));
+    uuids[i] = strdup(inst->uuid);
+    dlite_instance_decref(inst);
+  }
+  mu_assert_int_eq(0, dlite_storage_close(db));
+}
+
+
+MU_TEST(test_iter_load)
+{
+  char uuid[DLITE_UUID_LENGTH+1];
+  int n=0;
+  void *si;
+
+  mu_check((db = dlite_storage_open("postgresql", PGHOST,
+                                    OPTIONS ";mode=r")));
+  mu_check((si = dlite_storage_iter_create(db, "*/Person")));
+  while (dlite_storage_iter_next(db, si, uuid) == 0) {
+    DLiteInstance *inst;
+    float *age;
+    mu_check((inst = dlite_instance_load(db, uuid)));
+    mu_check((age = dlite_instance_get_property(inst, "age")));
+    mu_check(*age >= 0.0 && *age < 100.0);
+    mu_assert_int_eq(2, (int)dlite_instance_get_dimension_size(inst, "N"));
+    dlite_instance_decref(inst);
+    n++;
+  }
+  dlite_storage_iter_free(db, si);
+  mu_assert_int_eq(NINST, n);
+}
+
+
+MU_TEST(test_load)
+{
+  char **name;
+  DLiteInstance *inst;
+  mu_check((inst = dlite_instance_load(db, uuids[42])));
+  mu_check((name = dlite_instance_get_property(inst, "name")));
+  mu_assert_string_eq("person42", *name);
+  dlite_instance_decref(inst);
+}
+
+
+MU_TEST(test_close)
+{
+  int i;
+  mu_assert_int_eq(0, dlite_storage_close(db));
+  for (i=0; i<NINST; i++) free(uuids[i]);
+  dlite_instance_decref(meta);
+}
+
+
+MU_TEST(test_unload_plugins)
+{
+  dlite_storage_plugin_unload_all();
+}
+
+
+/***********************************************************************/
+
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_save);
+  MU_RUN_TEST(test_iter_load);
+  MU_RUN_TEST(test_load);
+  MU_RUN_TEST(test_close);
+  MU_RUN_TEST(test_unload_plugins);
+}
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
@@ -5,7 +5,9 @@
 #include <string.h>
 #include <errno.h>
 
+#ifdef HAVE_REDLAND
 #include <redland.h>
+#endif
 
 #include "config.h"
 
@@ -44,6 +46,35 @@ typedef enum {
 } FmtFlags;
 
 
+/** A batch of triples to be added to the triplestore in one call.
+
+    The s-p-o strings are stored in a common string pool and referred
+    to by their offsets until the batch is flushed. */
+typedef struct {
+  Triple *triples;       /*!< array of triples, assigned when flushed */
+  TripleObjType *types;  /*!< array of object types */
+  size_t *offsets;       /*!< s-p-o offsets into `pool`, 3 per triple */
+  size_t n;              /*!< number of triples */
+  size_t size;           /*!< allocated number of triples */
+  char *pool;            /*!< string pool */
+  size_t poollen;        /*!< used length of string pool */
+  size_t poolsize;       /*!< allocated size of string pool */
+} TripleBatch;
+
+/** Predicate-object pairs of a single subject. */
+typedef struct {
+  size_t *offsets;       /*!< p-o offsets into `pool`, 2 per pair */
+  size_t n;              /*!< number of pairs */
+  size_t size;           /*!< allocated number of pairs */
+  char *pool;            /*!< string pool */
+  size_t poollen;        /*!< used length of string pool */
+  size_t poolsize;       /*!< allocated size of string pool */
+} SubjectRel;
+
+/* Forward declarations */
+static void batch_deinit(TripleBatch *b);
+
+
 /** Storage for librdf backend. */
 typedef struct {
   DLiteStorage_HEAD
@@ -55,6 +86,7 @@ typedef struct {
   char *mime_type;  /*!< Mime time of optional input/output file. */
   char *type_uri;   /*!< Type uri of optional input/output file. */
   FmtFlags flags;   /*!< Formatting flags. */
+  TripleBatch batch; /*!< Batch of triples, reused between saved instances. */
 } RdfStorage;
 
 /** Data model for librdf backend. */
@@ -94,7 +126,8 @@ typedef struct {
             "tstore" | "uri" | "virtuoso"
       Name of librdf storage module to use. The default is "hashes".
       See https://librdf.org/docs/api/redland-storage-modules.html
-      for more info.
+      for more info.  Without librdf, only "hashes", "memory" and "file"
+      are supported.  The "file" store is then persisted as N-Triples.
   - base-uri : string
       Base uri to use in serialisation.
   - filename : string
@@ -103,6 +136,7 @@ typedef struct {
              "rdfxml-xmp" | "turtle" | "rss-1.0" | "dot"
       Format of optional input/output file. See also
       https://librdf.org/raptor/api-1.4/raptor-serializers.html
+      Without librdf, only "ntriples" and "nquads" are supported.
   - mime-type : string
       Mime type for format of optional input/output file.
   - type-uri : string
@@ -220,14 +254,34 @@ DLiteStorage *rdf_open(const DLiteStoragePlugin *api, const char *uri,
 }
 
 
+#ifndef HAVE_REDLAND
+/* Writes all triples in `ts` as N-Triples to `filename`.  If `filename`
+   is "-", the triples are written to stdout.  Returns non-zero on error. */
+static int save_ntriples(TripleStore *ts, const char *filename)
+{
+  FILE *fp;
+  int retval;
+  if (strcmp(filename, "-") == 0)
+    return triplestore_save_ntriples(ts, stdout);
+  if (!(fp = fopen(filename, "w")))
+    return err(1, "cannot write rdf file: %s", filename);
+  retval = triplestore_save_ntriples(ts, fp);
+  fclose(fp);
+  return retval;
+}
+#endif
+
+
 /**
   Closes data handle json. Returns non-zero on error.
  */
 int rdf_close(DLiteStorage *storage)
 {
   RdfStorage *s = (RdfStorage *)storage;
+  int retval=0;
 
   if (s->writable) {
+#ifdef HAVE_REDLAND
     librdf_world *world = triplestore_get_world(s->ts);
     librdf_model *model = triplestore_get_model(s->ts);
     assert(world);
@@ -261,49 +315,222 @@ int rdf_close(DLiteStorage *storage)
       if (type_uri) librdf_free_uri(type_uri);
       free(buf);
     }
+#else
+    /* Sync file storage */
+    if (strcmp(s->store, "file") == 0 &&
+        save_ntriples(s->ts, s->location)) retval = 1;
+
+    /* Store to file */
+    if (s->filename) {
+      if (strcmp(s->format, "ntriples") != 0 &&
+          strcmp(s->format, "nquads") != 0)
+        retval = err(1, "unsupported format without librdf: '%s'. "
+                     "Must be \"ntriples\" or \"nquads\"", s->format);
+      else if (save_ntriples(s->ts, s->filename))
+        retval = 1;
+    }
+#endif
   }
 
   triplestore_free(s->ts);
+  batch_deinit(&s->batch);
   if (s->store) free(s->store);
   if (s->base_uri) free(s->base_uri);
   if (s->filename) free(s->filename);
   if (s->format) free(s->format);
   if (s->mime_type) free(s->mime_type);
   if (s->type_uri) free(s->type_uri);
+  return retval;
+}
+
+
+/* Initial number of triples and pool size of a TripleBatch */
+#define BATCH_INIT_TRIPLES 64
+#define BATCH_INIT_POOLSIZE 4096
+
+
+/* Returns offset of a copy of `str` appended to the string pool
+   `*pool` of allocated size `*size` and current length `*len`.
+   Returns -1 on error. */
+static long pool_add(char **pool, size_t *size, size_t *len, const char *str)
+{
+  size_t n = strlen(str) + 1;
+  long offset = *len;
+  if (*len + n > *size) {
+    size_t newsize = (*size) ? *size : BATCH_INIT_POOLSIZE;
+    void *ptr;
+    while (newsize < *len + n) newsize *= 2;
+    if (!(ptr = realloc(*pool, newsize))) return err(-1, "allocation failure");
+    *pool = ptr;
+    *size = newsize;
+  }
+  memcpy(*pool + *len, str, n);
+  *len += n;
+  return offset;
+}
+
+
+/* Adds triple (s, p, o) to batch.  The object type is given by
+   `literal`, `lang` and `datatype_uri` (see triplestore_add2()).  The
+   `lang` and `datatype_uri` strings are not copied and must be string
+   literals.  Returns non-zero on error. */
+static int batch_add(TripleBatch *b, const char *s, const char *p,
+                     const char *o, int literal, const char *lang,
+                     const char *datatype_uri)
+{
+  long offs[3];
+  TripleObjType *type;
+  if (b->n >= b->size) {
+    size_t size = (b->size) ? 2*b->size : BATCH_INIT_TRIPLES;
+    void *ptr;
+    if (!(ptr = realloc(b->triples, size*sizeof(Triple))))
+      return err(1, "allocation failure");
+    b->triples = ptr;
+    if (!(ptr = realloc(b->types, size*sizeof(TripleObjType))))
+      return err(1, "allocation failure");
+    b->types = ptr;
+    if (!(ptr = realloc(b->offsets, 3*size*sizeof(size_t))))
+      return err(1, "allocation failure");
+    b->offsets = ptr;
+    b->size = size;
+  }
+  /* Store offsets, since the pool may be reallocated */
+  if ((offs[0] = pool_add(&b->pool, &b->poolsize, &b->poollen, s)) < 0 ||
+      (offs[1] = pool_add(&b->pool, &b->poolsize, &b->poollen, p)) < 0 ||
+      (offs[2] = pool_add(&b->pool, &b->poolsize, &b->poollen, o)) < 0)
+    return 1;
+  b->offsets[3*b->n]   = offs[0];
+  b->offsets[3*b->n+1] = offs[1];
+  b->offsets[3*b->n+2] = offs[2];
+  type = b->types + b->n;
+  type->literal = literal;
+  type->lang = lang;
+  type->datatype_uri = datatype_uri;
+  b->n++;
   return 0;
 }
 
+/* Convenient shortcuts for batch_add(), corresponding to
+   triplestore_add(), triplestore_add_en() and triplestore_add_uri(). */
+#define batch_add_lit(b, s, p, o) batch_add(b, s, p, o, 1, NULL, NULL)
+#define batch_add_en(b, s, p, o)  batch_add(b, s, p, o, 1, "en", NULL)
+#define batch_add_uri(b, s, p, o) batch_add(b, s, p, o, 0, NULL, NULL)
 
-/* Returns pointer to object corresponding to subject `s` and predicate `p`
-   or NULL on error.
 
-   If `verbose` is non-zero, error messages will be printed. */
-static const char *getobj(RdfStorage *rdf, const char *s, const char *p,
-                          int verbose)
+/* Adds all triples in batch `b` to triplestore `ts` in one call and
+   empties the batch.  Memory is kept for reuse.  Returns non-zero on
+   error. */
+static int batch_flush(TripleBatch *b, TripleStore *ts)
 {
-  TripleStore *ts = rdf->ts;
-  const Triple *t;
-  if (!(t = triplestore_find_first(ts, s, p, NULL))) {
-    if (verbose) err(1, "missing s='%s' p='%s': %s", s, p, rdf->location);
-    return NULL;
+  size_t i;
+  int stat;
+  for (i=0; i<b->n; i++) {
+    Triple *t = b->triples + i;
+    t->s = b->pool + b->offsets[3*i];
+    t->p = b->pool + b->offsets[3*i+1];
+    t->o = b->pool + b->offsets[3*i+2];
+    t->id = NULL;
   }
-  return t->o;
+  stat = triplestore_add_triples2(ts, b->triples, b->types, b->n);
+  b->n = 0;
+  b->poollen = 0;
+  return stat;
+}
+
+/* Frees all memory allocated by batch `b`. */
+static void batch_deinit(TripleBatch *b)
+{
+  if (b->triples) free(b->triples);
+  if (b->types) free(b->types);
+  if (b->offsets) free(b->offsets);
+  if (b->pool) free(b->pool);
+  memset(b, 0, sizeof(TripleBatch));
 }
 
-/* Returns number of triples matching (s, p, o) or -1 on error. */
-static int count(TripleStore *ts, const char *s, const char *p, const char *o)
+
+/* Loads all predicate-object pairs with subject `s` into `rel` in a
+   single pass over the triplestore.  Previous content of `rel` is
+   discarded, but its memory is reused.  Returns non-zero on error. */
+static int subject_load(RdfStorage *rdf, SubjectRel *rel, const char *s)
 {
   TripleState state;
-  int n=0;
-  triplestore_init_state(ts, &state);
-  while (triplestore_find(&state, s, p, o)) n++;
+  const Triple *t;
+  int retval=0;
+  rel->n = 0;
+  rel->poollen = 0;
+  triplestore_init_state(rdf->ts, &state);
+  while ((t = triplestore_find(&state, s, NULL, NULL))) {
+    long op, oo;
+    if (rel->n >= rel->size) {
+      size_t size = (rel->size) ? 2*rel->size : BATCH_INIT_TRIPLES;
+      void *ptr;
+      if (!(ptr = realloc(rel->offsets, 2*size*sizeof(size_t)))) {
+        retval = err(1, "allocation failure");
+        break;
+      }
+      rel->offsets = ptr;
+      rel->size = size;
+    }
+    if ((op = pool_add(&rel->pool, &rel->poolsize, &rel->poollen, t->p)) < 0 ||
+        (oo = pool_add(&rel->pool, &rel->poolsize, &rel->poollen, t->o)) < 0) {
+      retval = 1;
+      break;
+    }
+    rel->offsets[2*rel->n] = op;
+    rel->offsets[2*rel->n+1] = oo;
+    rel->n++;
+  }
   triplestore_deinit_state(&state);
+  return retval;
+}
+
+/* Returns the object of the first relation in `rel` with predicate `p`
+   starting from position `*pos`.  If `pos` is NULL, the search starts
+   from the beginning.  On return `*pos` is updated to the position
+   after the match.  Returns NULL if there are no more matches.
+
+   If `verbose` is non-zero, an error message is printed if there is no
+   match. */
+static const char *subject_get(const SubjectRel *rel, const char *p,
+                               size_t *pos, int verbose)
+{
+  size_t i = (pos) ? *pos : 0;
+  for (; i<rel->n; i++) {
+    if (strcmp(rel->pool + rel->offsets[2*i], p) == 0) {
+      if (pos) *pos = i + 1;
+      return rel->pool + rel->offsets[2*i+1];
+    }
+  }
+  if (pos) *pos = rel->n;
+  if (verbose) err(1, "missing p='%s'", p);
+  return NULL;
+}
+
+/* Returns number of relations in `rel` with predicate `p`. */
+static int subject_count(const SubjectRel *rel, const char *p)
+{
+  size_t i;
+  int n=0;
+  for (i=0; i<rel->n; i++)
+    if (strcmp(rel->pool + rel->offsets[2*i], p) == 0) n++;
   return n;
 }
 
+/* Frees all memory allocated by `rel`. */
+static void subject_deinit(SubjectRel *rel)
+{
+  if (rel->offsets) free(rel->offsets);
+  if (rel->pool) free(rel->pool);
+  memset(rel, 0, sizeof(SubjectRel));
+}
+
 
 /*
   Loads instance from storage `s`.  Returns non-zero on error.
+
+  All relations of the instance subject are read in a single pass,
+  followed by a single pass for each of the dimension value, property
+  value, dimension and property nodes it refers to.
  */
 DLiteInstance *rdf_load_instance(const DLiteStorage *storage, const char *id)
 {
@@ -311,73 +538,100 @@ DLiteInstance *rdf_load_instance(const DLiteStorage *storage, const char *id)
   TripleStore *ts = s->ts;
   TripleState state;
   const Triple *t=NULL, *t2;
+  SubjectRel rel, sub, shp;
   DLiteInstance *inst=NULL;
   DLiteMeta *meta;
-  size_t i, *dims=NULL;
-  int ok=0, n, j;
+  size_t i, pos, *dims=NULL;
+  int ok=0, n, j, is_entity=0;
   char uuid[DLITE_UUID_LENGTH+1], muuid[DLITE_UUID_LENGTH+1];
-  char *pid=NULL, *mid=NULL, *propiri=NULL;
+  const char *str;
+  char *pid=NULL;
+
+  memset(&rel, 0, sizeof(SubjectRel));
+  memset(&sub, 0, sizeof(SubjectRel));
+  memset(&shp, 0, sizeof(SubjectRel));
 
   errno = 0;
   dlite_get_uuid(uuid, id);
   pid = (s->base_uri) ? aprintf("%s:%s", s->base_uri, uuid) : NULL;
 
-  /* find instance and metadata UUIDs */
-  triplestore_init_state(ts, &state);
-  while ((t2 = triplestore_find(&state, pid, _P ":hasMeta", NULL))) {
-    if (t) FAIL1("ID must be provided if storage holds "
-                 "more than one instance: %s", s->location);
-    t = t2;
-  }
-  triplestore_deinit_state(&state);
-  if (t) {
-    dlite_get_uuid(muuid, t->o);
-  } else {
+  /* find instance subject if no base uri is given */
+  if (!pid) {
     triplestore_init_state(ts, &state);
-    while ((t2 = triplestore_find(&state, pid, _P ":hasURI", NULL))) {
-      if (t) FAIL1("ID must be provided if storage holds "
-                   "more than one instance: %s", s->location);
+    while ((t2 = triplestore_find(&state, NULL, _P ":hasMeta", NULL))) {
+      if (t) {
+        triplestore_deinit_state(&state);
+        FAIL1("ID must be provided if storage holds "
+              "more than one instance: %s", s->location);
+      }
       t = t2;
+      pid = strdup(t->s);
     }
     triplestore_deinit_state(&state);
+    if (!pid) {
+      triplestore_init_state(ts, &state);
+      while ((t2 = triplestore_find(&state, NULL, _P ":hasURI", NULL))) {
+        if (t) {
+          triplestore_deinit_state(&state);
+          FAIL1("ID must be provided if storage holds "
+                "more than one instance: %s", s->location);
+        }
+        t = t2;
+        pid = strdup(t->s);
+      }
+      triplestore_deinit_state(&state);
+    }
+    if (!pid) FAIL2("no instance with id '%s' in store: %s", id, s->location);
+  }
+
+  /* read all relations of the instance */
+  if (subject_load(s, &rel, pid)) goto fail;
+
+  /* find metadata UUID */
+  pos = 0;
+  if ((str = subject_get(&rel, _P ":hasMeta", &pos, 0))) {
+    if (subject_get(&rel, _P ":hasMeta", &pos, 0))
+      FAIL1("ID must be provided if storage holds "
+            "more than one instance: %s", s->location);
+    dlite_get_uuid(muuid, str);
+  } else if (subject_get(&rel, _P ":hasURI", NULL, 0)) {
     dlite_get_uuid(muuid, DLITE_ENTITY_SCHEMA);
+  } else {
+    FAIL2("no instance with id '%s' in store: %s", id, s->location);
   }
-  if (!t) FAIL2("no instance with id '%s' in store: %s", id, s->location);
 
   /* get/load metadata */
-  mid = (s->base_uri) ? aprintf("%s:%s", s->base_uri, muuid) : NULL;
   if (!(meta = dlite_meta_get(muuid)) &&
       !(meta = dlite_meta_load(storage, muuid)))
-    FAIL1("cannot load metadata: '%s'", t->o);
+    FAIL1("cannot load metadata: '%s'", muuid);
+  is_entity = (strcmp(meta->uri, DLITE_ENTITY_SCHEMA) == 0);
 
   /* allocate and read dimension values */
   if (meta->_ndimensions) {
     const char *name, *val;
     if (!(dims = calloc(meta->_ndimensions, sizeof(size_t))))
       FAIL("allocation failure");
-    if (triplestore_find_first(ts, pid, _P ":hasDimensionValue", NULL)) {
+    if (subject_get(&rel, _P ":hasDimensionValue", NULL, 0)) {
       /* -- read dimension values */
       n = 0;
-      triplestore_init_state(ts, &state);
-      while ((t = triplestore_find(&state, pid, _P ":hasDimensionValue",
-                                   NULL))) {
-        char *dimval = strdup(t->o);
-        if (!(name = getobj(s, dimval, _P ":hasLabel", 1))) goto fail;
-        j = dlite_meta_get_dimension_index(meta, name);
-        if (!(val = getobj(s, dimval, _P ":hasDimensionSize", 1))) goto fail;
+      pos = 0;
+      while ((str = subject_get(&rel, _P ":hasDimensionValue", &pos, 0))) {
+        if (subject_load(s, &sub, str)) goto fail;
+        if (!(name = subject_get(&sub, _P ":hasLabel", NULL, 1))) goto fail;
+        if ((j = dlite_meta_get_dimension_index(meta, name)) < 0) goto fail;
+        if (!(val = subject_get(&sub, _P ":hasDimensionSize", NULL, 1)))
+          goto fail;
         dims[j] = atoi(val);
         n++;
-        free(dimval);
       }
-      triplestore_deinit_state(&state);
       if (n != (int)meta->_ndimensions)
         FAIL4("entity %s expect %d dimension values, but got %d: %s",
               id, (int)meta->_ndimensions, n, s->location);
-    } else if (strcmp(meta->uri, DLITE_ENTITY_SCHEMA) == 0) {
+    } else if (is_entity) {
       /* -- infer dimension values */
       assert(meta->_ndimensions == 2);
-      dims[0] = count(ts, pid, _P ":hasDimension", NULL);
-      dims[1] = count(ts, pid, _P ":hasProperty", NULL);
+      dims[0] = subject_count(&rel, _P ":hasDimension");
+      dims[1] = subject_count(&rel, _P ":hasProperty");
     } else {
       FAIL2("missing dimension values for instance '%s' in storage '%s'",
             id, s->location);
@@ -385,38 +639,34 @@ DLiteInstance *rdf_load_instance(const DLiteStorage *storage, const char *id)
   }
 
   if (!(inst = dlite_instance_create(meta, dims, (id) ? id : uuid))) goto fail;
-  if (!inst->uri && (t = triplestore_find_first(ts, pid, _P ":hasURI", NULL)))
-    inst->uri = strdup(t->o);
+  if (!inst->uri && (str = subject_get(&rel, _P ":hasURI", NULL, 0)))
+    inst->uri = strdup(str);
 
   /* FIXME - should have been called by dlite_instance_create() */
   if (dlite_instance_is_meta(inst)) dlite_meta_init((DLiteMeta *)inst);
 
+  /* -- read property values */
   n = 0;
-  while ((t = triplestore_find(&state, pid, _P ":hasPropertyValue", NULL))) {
-    /* -- read property values */
+  pos = 0;
+  while ((str = subject_get(&rel, _P ":hasPropertyValue", &pos, 0))) {
     DLiteProperty *p;
     const char *name, *val;
     size_t *pdims;
     void *ptr;
-    char *prop=strdup(t->o);
-    if (!(name = getobj(s, prop, _P ":hasLabel", 1))) goto fail;
-    j = dlite_meta_get_property_index(meta, name);
-    if (!(name = getobj(s, prop, _P ":hasLabel", 1))) goto fail;
+    if (subject_load(s, &sub, str)) goto fail;
+    if (!(name = subject_get(&sub, _P ":hasLabel", NULL, 1))) goto fail;
     if ((j = dlite_meta_get_property_index(meta, name)) < 0) goto fail;
-    if (!(val = getobj(s, prop, _P ":hasValue", 1))) goto fail;
+    if (!(val = subject_get(&sub, _P ":hasValue", NULL, 1))) goto fail;
     p = meta->_properties + j;
     pdims = DLITE_PROP_DIMS(inst, j);
     ptr = dlite_instance_get_property_by_index(inst, j);
     if (dlite_property_scan(val, ptr, p, pdims, dliteFlagRaw) < 0) goto fail;
     n++;
-    free(prop);
   }
-  triplestore_deinit_state(&state);
 
   /* Metadata is normally stored with dedicated relations according to the
      datamodel ontology. */
-  if (n == 0 && strcmp(meta->uri, DLITE_ENTITY_SCHEMA) == 0) {
-    const char *str;
+  if (n == 0 && is_entity) {
     char **namep, **verp, **nsp, **descrp;
     DLiteDimension *d;
     DLiteProperty *p;
@@ -428,74 +678,61 @@ DLiteInstance *rdf_load_instance(const DLiteStorage *storage, const char *id)
     if (!(namep && verp && nsp))
       fatal(1, "%s should have name, version and namespace properties",
             DLITE_ENTITY_SCHEMA);
-    if (!(str = getobj(s, pid, _P ":hasURI", 1))) goto fail;
+    if (!(str = subject_get(&rel, _P ":hasURI", NULL, 1))) goto fail;
     dlite_split_meta_uri(str, namep, verp, nsp);
 
     descrp = dlite_instance_get_property(inst, "description");
-    if ((str = getobj(s, pid, _P ":hasDescription", 0)))
+    if ((str = subject_get(&rel, _P ":hasDescription", NULL, 0)))
       *descrp = strdup(str);
 
     /* -- read dimensions */
     d = dlite_instance_get_property(inst, "dimensions");
-    triplestore_init_state(ts, &state);
-    while ((t = triplestore_find(&state, pid, _P ":hasDimension", NULL))) {
-      propiri = strdup(t->o);
-      if (!(str = getobj(s, propiri, _P ":hasLabel", 1))) goto fail;
+    pos = 0;
+    while ((str = subject_get(&rel, _P ":hasDimension", &pos, 0))) {
+      if (subject_load(s, &sub, str)) goto fail;
+      if (!(str = subject_get(&sub, _P ":hasLabel", NULL, 1))) goto fail;
       d->name = strdup(str);
-      if ((str = getobj(s, propiri, _P ":hasDescription", 0)))
+      if ((str = subject_get(&sub, _P ":hasDescription", NULL, 0)))
         d->description = strdup(str);
       d++;
-      free(propiri);
-      propiri = NULL;
     }
-    triplestore_deinit_state(&state);
-
 
     /* -- read properties */
     p = dlite_instance_get_property(inst, "properties");
-    triplestore_init_state(ts, &state);
-    while ((t = triplestore_find(&state, pid, _P ":hasProperty", NULL))) {
+    pos = 0;
+    while ((str = subject_get(&rel, _P ":hasProperty", &pos, 0))) {
       const char *name, *typename, *shape, *unit, *descr;
 
-      /* save propiri so it is not overwritten by getobj() */
-      propiri = strdup(t->o);
-
-      if (!(name = getobj(s, propiri, _P ":hasLabel", 1))) goto fail;
+      if (subject_load(s, &sub, str)) goto fail;
+      if (!(name = subject_get(&sub, _P ":hasLabel", NULL, 1))) goto fail;
       p->name = strdup(name);
-      if (!(typename = getobj(s, propiri, _P ":hasType", 1))) goto fail;
+      if (!(typename = subject_get(&sub, _P ":hasType", NULL, 1))) goto fail;
       if (dlite_type_set_dtype_and_size(typename, &p->type, &p->size))
         goto fail;
-      if ((unit = getobj(s, propiri, _P ":hasUnit", 0)))
+      if ((unit = subject_get(&sub, _P ":hasUnit", NULL, 0)))
         p->unit = strdup(unit);
-      if ((descr = getobj(s, propiri, _P ":hasDescription", 0)))
+      if ((descr = subject_get(&sub, _P ":hasDescription", NULL, 0)))
         p->description = strdup(descr);
 
-      /* count and allocate property dimensions */
-      shape = getobj(s, propiri, _P ":hasFirstShape", 0);
-      while (shape) {
-        p->ndims++;
-        shape = getobj(s, shape, _P ":hasNextShape", 0);
-      }
-      p->dims = calloc(p->ndims, sizeof(char *));
-
-      /* assign property dimensions */
+      /* follow the shape list and assign property dimensions */
       i = 0;
-      shape = getobj(s, propiri, _P ":hasFirstShape", 0);
+      shape = subject_get(&sub, _P ":hasFirstShape", NULL, 0);
       while (shape) {
         const char *expr;
-        char buf[64];
-        strncpy(buf, shape, sizeof(buf));
-        if (!(expr = getobj(s, buf, _P ":hasDimensionExpression", 1)))
-          FAIL2("%s has no dimension expression: %s", t2->s, s->location);
+        void *ptr;
+        if (subject_load(s, &shp, shape)) goto fail;
+        if (!(expr = subject_get(&shp, _P ":hasDimensionExpression", NULL, 1)))
+          FAIL2("%s has no dimension expression: %s", shape, s->location);
+        if (!(ptr = realloc(p->dims, (i+1)*sizeof(char *))))
+          FAIL("allocation failure");
+        p->dims = ptr;
         p->dims[i++] = strdup(expr);
-        shape = getobj(s, buf, _P ":hasNextShape", 0);
+        p->ndims = i;
+        shape = subject_get(&shp, _P ":hasNextShape", NULL, 0);
       }
       p++;
       n++;
-      free(propiri);
-      propiri = NULL;
     }
-    triplestore_deinit_state(&state);
 
     /* reinitialise metadata after property dimensions have been set */
     dlite_meta_init((DLiteMeta *)inst);
@@ -507,106 +744,96 @@ DLiteInstance *rdf_load_instance(const DLiteStorage *storage, const char *id)
   ok = 1;
  fail:
   if (pid) free(pid);
-  if (mid) free(mid);
-  if (propiri) free(propiri);
   if (dims) free(dims);
+  subject_deinit(&rel);
+  subject_deinit(&sub);
+  subject_deinit(&shp);
   if (!ok && inst) dlite_instance_decref(inst);
-  triplestore_deinit_state(&state);
   return (ok) ? inst : NULL;
 }
 
-/**
-  Returns a UTF-8 encoded string for a new blank node, based on `id`.
-  If `id` is NULL, an internally generated node is created.
-  Returns NULL on error.
- */
-static char *get_blank_node(TripleStore *ts, const char *id)
-{
-  char *str;
-  librdf_world *world = triplestore_get_world(ts);
-  librdf_node *node =
-    librdf_new_node_from_blank_identifier(world, (unsigned char *)id);
-  if (!node) return err(1, "cannot create blank node: %s", id), NULL;
-  str = (char *)librdf_node_get_blank_identifier(node);
-  if (str) str = strdup(str);
-  librdf_free_node(node);
-  return str;
-}
-
 
 /**
   Stores instance `inst` to `storage`.  Returns non-zero on error.
+
+  All triples describing the instance are collected in a batch and
+  added to the triplestore with a single call.
  */
 int rdf_save_instance(DLiteStorage *storage, const DLiteInstance *inst)
 {
   RdfStorage *s = (RdfStorage *)storage;
-  TripleStore *ts = s->ts;
+  TripleBatch *b = &s->batch;
   DLiteMeta *meta = (dlite_instance_is_meta(inst)) ? (DLiteMeta *)inst : NULL;
-  size_t i, bufsize=0, buf2size=0;
+  size_t i, bufsize=0, b1size=0, b2size=0, bsize=0;
   int j, retval=1;
-  char *buf=NULL, *buf2=NULL, *b1, *b2;
-  triplestore_add_uri(ts, inst->uuid, "rdf:type", "owl:NamedIndividual");
-  if (meta)
-    triplestore_add_uri(ts, inst->uuid, "rdf:type", _P ":Entity");
-  else
-    triplestore_add_uri(ts, inst->uuid, "rdf:type", _P ":Object");
-  triplestore_add(ts, inst->uuid, _P ":hasUUID", inst->uuid);
-  triplestore_add(ts, inst->uuid, _P ":hasMeta", inst->meta->uri);
-  if (inst->uri)
-    triplestore_add(ts, inst->uuid, _P ":hasURI", inst->uri);
-
-  /* Describe metadata with spesialised properties */
+  char *buf=NULL, *b1=NULL, *b2=NULL, *bn=NULL;
+  const char *id = inst->uuid;
+
+  b->n = 0;
+  b->poollen = 0;
+
+  if (batch_add_uri(b, id, "rdf:type", "owl:NamedIndividual")) goto fail;
+  if (batch_add_uri(b, id, "rdf:type", (meta) ? _P ":Entity" : _P ":Object"))
+    goto fail;
+  if (batch_add_lit(b, id, _P ":hasUUID", inst->uuid)) goto fail;
+  if (batch_add_lit(b, id, _P ":hasMeta", inst->meta->uri)) goto fail;
+  if (inst->uri && batch_add_lit(b, id, _P ":hasURI", inst->uri)) goto fail;
+
+  /* Describe metadata with spesialised properties.
+
+     The "blank nodes" are identified by strings derived from the
+     instance UUID and the dimension/property name. */
   if (meta && s->flags & fmtMetaAnnot) {
     const char **descr = dlite_instance_get_property(inst, "description");
-    if (descr)
-      triplestore_add_en(ts, inst->uuid, _P ":hasDescription", *descr);
+    if (descr && *descr &&
+        batch_add_en(b, id, _P ":hasDescription", *descr)) goto fail;
 
     for (i=0; i < meta->_ndimensions; i++) {
       DLiteDimension *d = meta->_dimensions + i;
-      asnprintf(&buf, &bufsize, "%s/%s", inst->uuid, d->name);
-      if (!(b1 = get_blank_node(ts, buf))) goto fail;
-      triplestore_add_uri(ts, inst->uuid, _P ":hasDimension", b1);
-      triplestore_add_uri(ts, b1, "rdf:type", _P ":Dimension");
-      triplestore_add(ts, b1, _P ":hasLabel", d->name);
-      triplestore_add_en(ts, b1, _P ":hasDescription", d->description);
-      free(b1);
+      asnprintf(&b1, &b1size, "%s/%s", id, d->name);
+      if (batch_add_uri(b, id, _P ":hasDimension", b1) ||
+          batch_add_uri(b, b1, "rdf:type", _P ":Dimension") ||
+          batch_add_lit(b, b1, _P ":hasLabel", d->name)) goto fail;
+      if (d->description &&
+          batch_add_en(b, b1, _P ":hasDescription", d->description))
+        goto fail;
     }
 
     for (i=0; i < meta->_nproperties; i++) {
       DLiteProperty *p = meta->_properties + i;
       char typename[32];
       dlite_type_set_typename(p->type, p->size, typename, sizeof(typename));
-      asnprintf(&buf, &bufsize, "%s/%s", inst->uuid, p->name);
-      if (!(b1 = get_blank_node(ts, buf))) goto fail;
-      asnprintf(&buf2, &buf2size, "%s/shape0", buf);
-      if (!(b2 = get_blank_node(ts, buf2))) goto fail;
-      triplestore_add_uri(ts, inst->uuid, _P ":hasProperty", b1);
-      triplestore_add_uri(ts, b1, "rdf:type", _P ":Property");
-      triplestore_add(ts, b1, _P ":hasLabel", p->name);
-      triplestore_add(ts, b1, _P ":hasType", typename);
-      if (p->ndims)
-        triplestore_add_uri(ts, b1, _P ":hasFirstShape", b2);
-      if (p->unit)
-        triplestore_add(ts, b1, _P ":hasUnit", p->unit);
-      if (p->description)
-        triplestore_add_en(ts, b1, _P ":hasDescription", p->description);
+      asnprintf(&b1, &b1size, "%s/%s", id, p->name);
+      asnprintf(&b2, &b2size, "%s/shape0", b1);
+      if (batch_add_uri(b, id, _P ":hasProperty", b1) ||
+          batch_add_uri(b, b1, "rdf:type", _P ":Property") ||
+          batch_add_lit(b, b1, _P ":hasLabel", p->name) ||
+          batch_add_lit(b, b1, _P ":hasType", typename)) goto fail;
+      if (p->ndims &&
+          batch_add_uri(b, b1, _P ":hasFirstShape", b2)) goto fail;
+      if (p->unit &&
+          batch_add_lit(b, b1, _P ":hasUnit", p->unit)) goto fail;
+      if (p->description &&
+          batch_add_en(b, b1, _P ":hasDescription", p->description))
+        goto fail;
 
       if (p->dims) {
-        triplestore_add_uri(ts, b2, "rdf:type", _P ":Shape");
-        triplestore_add(ts, b2, _P ":hasDimensionExpression", p->dims[0]);
+        if (batch_add_uri(b, b2, "rdf:type", _P ":Shape") ||
+            batch_add_lit(b, b2, _P ":hasDimensionExpression", p->dims[0]))
+          goto fail;
       }
       for (j=1; j < p->ndims; j++) {
-        char *b;
-        asnprintf(&buf2, &buf2size, "%s/shape%d", buf, j);
-        if (!(b = get_blank_node(ts, buf2))) goto fail;
-        triplestore_add_uri(ts, b2, _P ":hasNextShape", b);
-        triplestore_add_uri(ts, b, "rdf:type", _P ":Shape");
-        triplestore_add(ts, b, _P ":hasDimensionExpression", p->dims[j]);
-        free(b2);
-        b2 = b;
+        char *tmp;
+        size_t tmpsize;
+        asnprintf(&bn, &bsize, "%s/shape%d", b1, j);
+        if (batch_add_uri(b, b2, _P ":hasNextShape", bn) ||
+            batch_add_uri(b, bn, "rdf:type", _P ":Shape") ||
+            batch_add_lit(b, bn, _P ":hasDimensionExpression", p->dims[j]))
+          goto fail;
+        /* swap buffers, such that `b2` refers to the current shape */
+        tmp = b2; b2 = bn; bn = tmp;
+        tmpsize = b2size; b2size = bsize; bsize = tmpsize;
       }
-      free(b1);
-      free(b2);
     }
   }
 
@@ -614,15 +841,13 @@ int rdf_save_instance(DLiteStorage *storage, const DLiteInstance *inst)
     /* Dimension values */
     for (i=0; i < inst->meta->_ndimensions; i++) {
       const char *name = inst->meta->_dimensions[i].name;
-      asnprintf(&buf, &bufsize, "%s/dim_%s", inst->uuid, name);
-      if (!(b1 = get_blank_node(ts, buf))) goto fail;
+      asnprintf(&b1, &b1size, "%s/dim_%s", id, name);
       asnprintf(&buf, &bufsize, "%d",
                 (int)dlite_instance_get_dimension_size_by_index(inst, i));
-      triplestore_add_uri(ts, inst->uuid, _P ":hasDimensionValue", b1);
-      triplestore_add(ts, b1, _P ":hasLabel", name);
-      triplestore_add2(ts, b1, _P ":hasDimensionSize", buf,
-                       1, NULL, "xsd:integer");
-      free(b1);
+      if (batch_add_uri(b, id, _P ":hasDimensionValue", b1) ||
+          batch_add_lit(b, b1, _P ":hasLabel", name) ||
+          batch_add(b, b1, _P ":hasDimensionSize", buf,
+                    1, NULL, "xsd:integer")) goto fail;
     }
 
     /* Property values */
@@ -631,24 +856,28 @@ int rdf_save_instance(DLiteStorage *storage, const DLiteInstance *inst)
       const void *ptr = dlite_instance_get_property_by_index(inst, i);
       const char *name = inst->meta->_properties[i].name;
       const size_t *dims = DLITE_PROP_DIMS(inst, i);
-      asnprintf(&buf, &bufsize, "%s/val_%s", inst->uuid, name);
-      if (!(b1 = get_blank_node(ts, buf))) goto fail;
-      triplestore_add_uri(ts, inst->uuid, _P ":hasPropertyValue", b1);
-      triplestore_add_uri(ts, b1, "rdf:type", "owl:NamedIndividual");
-      triplestore_add_uri(ts, b1, "rdf:type", _P ":PropertyValue");
-      triplestore_add(ts, b1, _P ":hasLabel", name);
-      dlite_property_aprint(&buf, &bufsize, 0, ptr, p, dims, 0, -2,
-                            dliteFlagRaw | dliteFlagStrip);
-      triplestore_add2(ts, b1, _P ":hasValue", buf, 1, NULL,
-                       "rdf:PlainLiteral");
-      free(b1);
+      asnprintf(&b1, &b1size, "%s/val_%s", id, name);
+      if (dlite_property_aprint(&buf, &bufsize, 0, ptr, p, dims, 0, -2,
+                                dliteFlagRaw | dliteFlagStrip) < 0) goto fail;
+      if (batch_add_uri(b, id, _P ":hasPropertyValue", b1) ||
+          batch_add_uri(b, b1, "rdf:type", "owl:NamedIndividual") ||
+          batch_add_uri(b, b1, "rdf:type", _P ":PropertyValue") ||
+          batch_add_lit(b, b1, _P ":hasLabel", name) ||
+          batch_add(b, b1, _P ":hasValue", buf, 1, NULL, "rdf:PlainLiteral"))
+        goto fail;
     }
   }
 
+  if (batch_flush(b, s->ts)) goto fail;
+
   retval = 0;
  fail:
+  b->n = 0;
+  b->poollen = 0;
   if (buf) free(buf);
-  if (buf2) free(buf2);
+  if (b1) free(b1);
+  if (b2) free(b2);
+  if (bn) free(bn);
   return retval;
 }
 
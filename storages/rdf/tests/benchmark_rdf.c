@@ -0,0 +1,88 @@
+/* Benchmark of saving and loading small instances to ntriples with the
+   rdf storage plugin.
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_rdf
+
+   and run it manually with the same environment as the tests,
+   optionally with the number of instances as argument. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/strutils.h"
+#include "dlite.h"
+#include "dlite-macros.h"
+
+
+int main(int argc, char *argv[])
+{
+  char *dims0[] = {"N"};
+  DLiteDimension dimensions[] = {
+    {"N", "Number of points."}
+  };
+  DLiteProperty properties[] = {
+    /* name   type         size            ndims dims   unit iri   descr */
+    {"name",  dliteStringPtr, sizeof(char *), 0, NULL,  "",  NULL, "Name."},
+    {"temp",  dliteFloat,  sizeof(double),   0, NULL,  "K", NULL, "Temp."},
+    {"pos",   dliteFloat,  sizeof(double),   1, dims0, "m", NULL, "Pos."}
+  };
+  int i, stat, n = (argc > 1) ? atoi(argv[1]) : 10000;
+  char **uuids = calloc(n, sizeof(char *));
+  size_t dims[] = {3};
+  clock_t t0;
+  DLiteStorage *s=NULL;
+  DLiteInstance *in;
+  DLiteMeta *m;
+  int retval=1;
+
+  if (!uuids) return dlite_err(1, "allocation failure");
+  if (!(m = dlite_meta_create("http://onto-ns.com/meta/0.1/BenchPoint",
+                              NULL, "Small entity for benchmarking.",
+                              1, dimensions, 3, properties))) goto fail;
+
+  /* save */
+  if (!(s = dlite_storage_open("rdf", "benchmark.db",
+                               "mode=w;store=hashes;options=new='yes',"
+                               "hash-type='memory';"
+                               "filename=benchmark.nt;format=ntriples")))
+    goto fail;
+  if (dlite_instance_save(s, (DLiteInstance *)m)) goto fail;
+  t0 = clock();
+  for (i=0; i<n; i++) {
+    char **name;
+    double *temp, *pos;
+    if (!(in = dlite_instance_create(m, dims, NULL))) goto fail;
+    name = dlite_instance_get_property(in, "name");
+    temp = dlite_instance_get_property(in, "temp");
+    pos = dlite_instance_get_property(in, "pos");
+    *name = aprintf("point-%d", i);
+    *temp = 273.15 + i;
+    pos[0] = i; pos[1] = 2*i; pos[2] = 3*i;
+    uuids[i] = strdup(in->uuid);
+    stat = dlite_instance_save(s, in);
+    dlite_instance_decref(in);
+    if (stat) goto fail;
+  }
+  printf("saved %d instances in %.3f s\n", n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+
+  /* load from the same storage */
+  t0 = clock();
+  for (i=0; i<n; i++) {
+    if (!(in = dlite_instance_load(s, uuids[i]))) goto fail;
+    dlite_instance_decref(in);
+  }
+  printf("loaded %d instances in %.3f s\n", n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  retval = 0;
+ fail:
+  if (s) dlite_storage_close(s);
+  for (i=0; i<n; i++)
+    if (uuids[i]) free(uuids[i]);
+  free(uuids);
+  if (m) dlite_meta_decref(m);
+  return retval;
+}
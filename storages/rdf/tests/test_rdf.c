@@ -1,8 +1,14 @@
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/strutils.h"
 #include "minunit/minunit.h"
 #include "dlite.h"
 #include "dlite-macros.h"
 
+/* Number of instances in test_save_load_many */
+#define NINST 20
 
 DLiteInstance *inst=NULL;
 DLiteMeta *meta=NULL;
@@ -95,6 +101,67 @@ MU_TEST(test_iter)
 }
 
 
+/* Save and load several small instances to ntriples. */
+MU_TEST(test_save_load_many)
+{
+  char *dims0[] = {"N"};
+  DLiteDimension dimensions[] = {
+    {"N", "Number of points."}
+  };
+  DLiteProperty properties[] = {
+    /* name   type         size            ndims dims   unit iri   descr */
+    {"name",  dliteStringPtr, sizeof(char *), 0, NULL,  "",  NULL, "Name."},
+    {"temp",  dliteFloat,  sizeof(double),   0, NULL,  "K", NULL, "Temp."},
+    {"pos",   dliteFloat,  sizeof(double),   1, dims0, "m", NULL, "Pos."}
+  };
+  char *uuids[NINST];
+  size_t dims[] = {3};
+  int i;
+  DLiteStorage *s;
+  DLiteMeta *m = dlite_meta_create("http://onto-ns.com/meta/0.1/ManyPoint",
+                                   NULL, "Small entity with many instances.",
+                                   1, dimensions, 3, properties);
+  mu_check(m);
+
+  /* save */
+  s = dlite_storage_open("rdf", "many.db",
+                         "mode=w;store=hashes;options=new='yes',"
+                         "hash-type='memory';"
+                         "filename=many.nt;format=ntriples");
+  mu_check(s);
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)m));
+  for (i=0; i<NINST; i++) {
+    DLiteInstance *in = dlite_instance_create(m, dims, NULL);
+    char **name = dlite_instance_get_property(in, "name");
+    double *temp = dlite_instance_get_property(in, "temp");
+    double *pos = dlite_instance_get_property(in, "pos");
+    *name = aprintf("point-%d", i);
+    *temp = 273.15 + i;
+    pos[0] = i; pos[1] = 2*i; pos[2] = 3*i;
+    mu_assert_int_eq(0, dlite_instance_save(s, in));
+    uuids[i] = strdup(in->uuid);
+    dlite_instance_decref(in);
+  }
+
+  /* load from the same storage */
+  for (i=0; i<NINST; i++) {
+    DLiteInstance *in = dlite_instance_load(s, uuids[i]);
+    char **name;
+    double *pos;
+    mu_check(in);
+    name = dlite_instance_get_property(in, "name");
+    pos = dlite_instance_get_property(in, "pos");
+    mu_check(strncmp(*name, "point-", 6) == 0 && atoi(*name + 6) == i);
+    mu_assert_double_eq(3.0*i, pos[2]);
+    dlite_instance_decref(in);
+  }
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  for (i=0; i<NINST; i++) free(uuids[i]);
+  dlite_meta_decref(m);
+}
+
+
 MU_TEST(test_freedata)
 {
   int nref;
@@ -115,6 +182,7 @@ MU_TEST_SUITE(test_suite)
   MU_RUN_TEST(test_write);
   MU_RUN_TEST(test_load);
   MU_RUN_TEST(test_iter);
+  MU_RUN_TEST(test_save_load_many);
   MU_RUN_TEST(test_freedata);
 }
 
@@ -0,0 +1,107 @@
+/* Tests the rdf plugin with the builtin triplestore (no librdf), where
+   the "file" store is persisted as N-Triples. */
+#include <string.h>
+
+#include "minunit/minunit.h"
+#include "dlite.h"
+#include "dlite-macros.h"
+
+#define UUID "e076a856-e36e-5335-967e-2f2fd153c17d"
+
+DLiteInstance *inst=NULL;
+DLiteMeta *meta=NULL;
+
+
+MU_TEST(test_load_inst)
+{
+  char *url;
+  url="json://"STRINGIFY(dlite_SOURCE_DIR)"/src/tests/test-entity.json?mode=r";
+  meta = dlite_meta_load_url(url);
+  mu_check(meta);
+
+  url="json://" STRINGIFY(dlite_SOURCE_DIR) "/src/tests/test-data.json?mode=r"
+    "#" UUID;
+  inst = dlite_instance_load_url(url);
+  mu_check(inst);
+}
+
+
+MU_TEST(test_write)
+{
+  DLiteStorage *s = dlite_storage_open("rdf", "db-builtin.nt",
+                                       "mode=w;"
+                                       "store=file;"
+                                       "filename=data-builtin.nt;"
+                                       "format=ntriples");
+  mu_check(s);
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)meta));
+  mu_assert_int_eq(0, dlite_instance_save(s, inst));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_write_badformat)
+{
+  DLiteStorage *s = dlite_storage_open("rdf", "db-builtin2.nt",
+                                       "mode=w;"
+                                       "store=memory;"
+                                       "filename=data-builtin.ttl;"
+                                       "format=turtle");
+  mu_check(s);
+  mu_check(dlite_storage_close(s));
+}
+
+
+MU_TEST(test_load)
+{
+  char buf1[4096], buf2[4096];
+  DLiteInstance *inst2;
+  DLiteStorage *s;
+
+  dlite_json_sprint(buf1, sizeof(buf1), inst, 0, 0);
+
+  /* both the store and the separate output file should be loadable */
+  s = dlite_storage_open("rdf", "db-builtin.nt", "mode=r;store=file");
+  mu_check(s);
+  inst2 = dlite_instance_load(s, UUID);
+  mu_check(inst2);
+  dlite_json_sprint(buf2, sizeof(buf2), inst2, 0, 0);
+  mu_check(strcmp(buf1, buf2) == 0);
+  dlite_instance_decref(inst2);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  s = dlite_storage_open("rdf", "data-builtin.nt", "mode=r;store=file");
+  mu_check(s);
+  inst2 = dlite_instance_load(s, UUID);
+  mu_check(inst2);
+  dlite_instance_decref(inst2);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_freedata)
+{
+  dlite_instance_decref(inst);
+  dlite_meta_decref(meta);
+}
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_load_inst);
+  MU_RUN_TEST(test_write);
+  MU_RUN_TEST(test_write_badformat);
+  MU_RUN_TEST(test_load);
+  MU_RUN_TEST(test_freedata);
+}
+
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
@@ -0,0 +1,759 @@
+/* dlite-sqlite-storage.c -- DLite plugin for SQLite */
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <sqlite3.h>
+
+#include "config.h"
+
+#include "utils/err.h"
+#include "utils/compat.h"
+#include "utils/strutils.h"
+#include "utils/map.h"
+#include "dlite.h"
+#include "dlite-binary.h"
+#include "dlite-type-cast.h"
+#include "dlite-storage-plugins.h"
+#include "dlite-macros.h"
+
+/*
+  Storage layout
+  --------------
+  All instances are registered in the table
+
+      dlite_instances(uuid TEXT PRIMARY KEY, meta TEXT, uri TEXT)
+
+  with an index on `meta`, which is used when iterating over instances
+  of a given metadata.
+
+  The instances of each metadata are stored in a table named by the
+  metadata uri.  It has the columns:
+
+      _uuid         TEXT PRIMARY KEY
+      _dim_<name>   INTEGER, one column for each dimension
+      <name>        one column for each property
+
+  Scalar booleans and integers are stored as INTEGER, scalar floats
+  as REAL and scalar strings as TEXT.  All other properties (including
+  all dimensional properties) are stored as BLOBs in the portable
+  format of dlite_binary_encode_property().
+*/
+
+typedef map_t(sqlite3_stmt *) map_stmt_t;
+
+/** Storage for sqlite backend. */
+typedef struct {
+  DLiteStorage_HEAD
+  sqlite3 *db;                /* database connection */
+  int intransaction;          /* whether a transaction is open */
+  sqlite3_stmt *insert_uuid;  /* inserts into dlite_instances */
+  sqlite3_stmt *select_uuid;  /* selects meta and uri from dlite_instances */
+  map_stmt_t inserts;         /* maps metadata uri to insert statement */
+  map_stmt_t selects;         /* maps metadata uri to select statement */
+} DLiteSqliteStorage;
+
+/** Iterator over uuids. */
+typedef struct {
+  sqlite3_stmt *stmt;
+} DLiteSqliteIter;
+
+/* Kind of column used for a property */
+typedef enum {
+  colInteger,
+  colReal,
+  colText,
+  colBlob
+} ColumnKind;
+
+
+/* Returns the kind of column used for storing property `p`. */
+static ColumnKind column_kind(const DLiteProperty *p)
+{
+  if (p->ndims > 0) return colBlob;
+  switch (p->type) {
+  case dliteBool:
+  case dliteInt:
+  case dliteUInt:
+    return colInteger;
+  case dliteFloat:
+    return (p->size <= sizeof(double)) ? colReal : colBlob;
+  case dliteFixString:
+  case dliteStringPtr:
+    return colText;
+  default:
+    return colBlob;
+  }
+}
+
+/* Returns the SQL type name of column kind `kind`. */
+static const char *column_type(ColumnKind kind)
+{
+  switch (kind) {
+  case colInteger: return "INTEGER";
+  case colReal:    return "REAL";
+  case colText:    return "TEXT";
+  case colBlob:    return "BLOB";
+  }
+  abort();  /* should never be reached */
+}
+
+/* Writes `name` as a quoted SQL identifier, prefixed with `prefix`, to
+   position `pos` in the allocated buffer `*buf` of size `*size`.
+
+   Returns number of characters written or -1 on error. */
+static int print_ident(char **buf, size_t *size, size_t pos,
+                       const char *prefix, const char *name)
+{
+  const char *p;
+  int n, m=0;
+  if ((n = asnpprintf(buf, size, pos, "\"%s", prefix)) < 0) return -1;
+  m += n;
+  for (p=name; *p; p++) {
+    if (*p == '"' && (n = asnpprintf(buf, size, pos+m, "\"")) < 0) return -1;
+    if (*p == '"') m += n;
+    if ((n = asnpprintf(buf, size, pos+m, "%c", *p)) < 0) return -1;
+    m += n;
+  }
+  if ((n = asnpprintf(buf, size, pos+m, "\"")) < 0) return -1;
+  return m + n;
+}
+
+/* Executes `sql` in storage `s`.  Returns non-zero on error. */
+static int exec(DLiteSqliteStorage *s, const char *sql)
+{
+  char *errmsg=NULL;
+  if (sqlite3_exec(s->db, sql, NULL, NULL, &errmsg) != SQLITE_OK) {
+    err(1, "sqlite error in %s: %s", sqlite3_db_filename(s->db, NULL),
+        errmsg);
+    sqlite3_free(errmsg);
+    return 1;
+  }
+  return 0;
+}
+
+/* Removes sqlite database `path` together with its write-ahead log
+   and shared-memory files.  Returns non-zero on error. */
+static int remove_database(const char *path)
+{
+  const char *suffixes[] = {"", "-wal", "-shm", NULL}, **suffix;
+  char *filename;
+  int stat=0;
+  for (suffix=suffixes; *suffix; suffix++) {
+    if (!(filename = aprintf("%s%s", path, *suffix)))
+      return err(1, "allocation failure");
+    if (remove(filename) && errno != ENOENT)
+      stat = err(1, "cannot remove %s", filename);
+    free(filename);
+  }
+  errno = 0;
+  return stat;
+}
+
+/* Returns a new prepared statement for `sql` or NULL on error. */
+static sqlite3_stmt *prepare(DLiteSqliteStorage *s, const char *sql)
+{
+  sqlite3_stmt *stmt=NULL;
+  if (sqlite3_prepare_v3(s->db, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                         &stmt, NULL) != SQLITE_OK)
+    return errx(1, "cannot prepare \"%s\" in %s: %s", sql,
+                sqlite3_db_filename(s->db, NULL), sqlite3_errmsg(s->db)), NULL;
+  return stmt;
+}
+
+
+/* Returns a borrowed reference to the cached insert statement for
+   instances of `meta`.  The table is created if it doesn't exist.
+   Returns NULL on error. */
+static sqlite3_stmt *get_insert(DLiteSqliteStorage *s, const DLiteMeta *meta)
+{
+  sqlite3_stmt **ptr, *stmt=NULL;
+  char *sql=NULL;
+  size_t size=0, i;
+  int n, m=0;
+
+  if ((ptr = map_get(&s->inserts, meta->uri))) return *ptr;
+
+  /* Create table */
+  if ((n = asnpprintf(&sql, &size, m, "CREATE TABLE IF NOT EXISTS ")) < 0 ||
+      (m += n, n = print_ident(&sql, &size, m, "", meta->uri)) < 0 ||
+      (m += n, n = asnpprintf(&sql, &size, m, " (_uuid TEXT PRIMARY KEY"))<0)
+    FAIL("allocation failure");
+  m += n;
+  for (i=0; i < meta->_ndimensions; i++) {
+    if ((n = asnpprintf(&sql, &size, m, ", ")) < 0 ||
+        (m += n, n = print_ident(&sql, &size, m, "_dim_",
+                                 meta->_dimensions[i].name)) < 0 ||
+        (m += n, n = asnpprintf(&sql, &size, m, " INTEGER")) < 0)
+      FAIL("allocation failure");
+    m += n;
+  }
+  for (i=0; i < meta->_nproperties; i++) {
+    DLiteProperty *p = meta->_properties + i;
+    if ((n = asnpprintf(&sql, &size, m, ", ")) < 0 ||
+        (m += n, n = print_ident(&sql, &size, m, "", p->name)) < 0 ||
+        (m += n, n = asnpprintf(&sql, &size, m, " %s",
+                                column_type(column_kind(p)))) < 0)
+      FAIL("allocation failure");
+    m += n;
+  }
+  if ((n = asnpprintf(&sql, &size, m, ")")) < 0) FAIL("allocation failure");
+  if (exec(s, sql)) goto fail;
+
+  /* Prepare insert statement */
+  m = 0;
+  if ((n = asnpprintf(&sql, &size, m, "INSERT OR REPLACE INTO ")) < 0 ||
+      (m += n, n = print_ident(&sql, &size, m, "", meta->uri)) < 0 ||
+      (m += n, n = asnpprintf(&sql, &size, m, " VALUES (?")) < 0)
+    FAIL("allocation failure");
+  m += n;
+  for (i=0; i < meta->_ndimensions + meta->_nproperties; i++) {
+    if ((n = asnpprintf(&sql, &size, m, ", ?")) < 0)
+      FAIL("allocation failure");
+    m += n;
+  }
+  if ((n = asnpprintf(&sql, &size, m, ")")) < 0) FAIL("allocation failure");
+  if (!(stmt = prepare(s, sql))) goto fail;
+  if (map_set(&s->inserts, meta->uri, stmt)) {
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    FAIL("allocation failure");
+  }
+ fail:
+  if (sql) free(sql);
+  return stmt;
+}
+
+
+/* Returns a borrowed reference to the cached select statement for
+   instances of metadata `uri`.  Returns NULL on error. */
+static sqlite3_stmt *get_select(DLiteSqliteStorage *s, const char *uri)
+{
+  sqlite3_stmt **ptr, *stmt=NULL;
+  char *sql=NULL;
+  size_t size=0;
+  int n, m=0;
+
+  if ((ptr = map_get(&s->selects, uri))) return *ptr;
+  if ((n = asnpprintf(&sql, &size, m, "SELECT * FROM ")) < 0 ||
+      (m += n, n = print_ident(&sql, &size, m, "", uri)) < 0 ||
+      (m += n, n = asnpprintf(&sql, &size, m, " WHERE _uuid=?")) < 0)
+    FAIL("allocation failure");
+  if (!(stmt = prepare(s, sql))) goto fail;
+  if (map_set(&s->selects, uri, stmt)) {
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    FAIL("allocation failure");
+  }
+ fail:
+  if (sql) free(sql);
+  return stmt;
+}
+
+
+/* Binds property `i` of `inst` to parameter `col` of `stmt`.
+   Returns non-zero on error. */
+static int bind_property(sqlite3_stmt *stmt, int col,
+                         const DLiteInstance *inst, size_t i)
+{
+  DLiteProperty *p = inst->meta->_properties + i;
+  const void *ptr = DLITE_PROP(inst, i);
+  unsigned char *buf;
+  int64_t v;
+  uint64_t u;
+  double d;
+  ptrdiff_t n;
+  int stat;
+
+  switch (column_kind(p)) {
+  case colInteger:
+    if (p->type == dliteBool) {
+      v = *(bool *)ptr;
+    } else if (p->type == dliteUInt) {
+      if (dlite_type_copy_cast(&u, dliteUInt, sizeof(u), ptr,
+                               p->type, p->size)) return -1;
+      v = (int64_t)u;
+    } else {
+      if (dlite_type_copy_cast(&v, dliteInt, sizeof(v), ptr,
+                               p->type, p->size)) return -1;
+    }
+    stat = sqlite3_bind_int64(stmt, col, v);
+    break;
+  case colReal:
+    if (dlite_type_copy_cast(&d, dliteFloat, sizeof(d), ptr,
+                             p->type, p->size)) return -1;
+    stat = sqlite3_bind_double(stmt, col, d);
+    break;
+  case colText:
+    if (p->type == dliteStringPtr) {
+      const char *str = *(char **)ptr;
+      stat = (str) ?
+        sqlite3_bind_text(stmt, col, str, -1, SQLITE_STATIC) :
+        sqlite3_bind_null(stmt, col);
+    } else {
+      stat = sqlite3_bind_text(stmt, col, ptr, strnlen(ptr, p->size),
+                               SQLITE_STATIC);
+    }
+    break;
+  case colBlob:
+    if ((n = dlite_binary_encode_property(NULL, 0, inst, i)) < 0) return -1;
+    if (!(buf = malloc(n))) return err(-1, "allocation failure");
+    if (dlite_binary_encode_property(buf, n, inst, i) != n) {
+      free(buf);
+      return err(-1, "cannot encode property '%s'", p->name);
+    }
+    stat = sqlite3_bind_blob64(stmt, col, buf, n, free);
+    break;
+  }
+  if (stat != SQLITE_OK)
+    return err(-1, "cannot bind property '%s' of %s", p->name, inst->uuid);
+  return 0;
+}
+
+
+/* Assigns property `i` of `inst` from column `col` of `stmt`.
+   Returns non-zero on error. */
+static int column_property(sqlite3_stmt *stmt, int col,
+                           DLiteInstance *inst, size_t i)
+{
+  DLiteProperty *p = inst->meta->_properties + i;
+  void *ptr = DLITE_PROP(inst, i);
+  const unsigned char *text;
+  int64_t v;
+  uint64_t u;
+  double d;
+
+  if (sqlite3_column_type(stmt, col) == SQLITE_NULL) return 0;
+
+  switch (column_kind(p)) {
+  case colInteger:
+    v = sqlite3_column_int64(stmt, col);
+    if (p->type == dliteBool) {
+      *(bool *)ptr = (v) ? 1 : 0;
+    } else if (p->type == dliteUInt) {
+      u = (uint64_t)v;
+      if (dlite_type_copy_cast(ptr, p->type, p->size, &u, dliteUInt,
+                               sizeof(u))) return -1;
+    } else {
+      if (dlite_type_copy_cast(ptr, p->type, p->size, &v, dliteInt,
+                               sizeof(v))) return -1;
+    }
+    break;
+  case colReal:
+    d = sqlite3_column_double(stmt, col);
+    if (dlite_type_copy_cast(ptr, p->type, p->size, &d, dliteFloat,
+                             sizeof(d))) return -1;
+    break;
+  case colText:
+    text = sqlite3_column_text(stmt, col);
+    if (p->type == dliteStringPtr) {
+      char **q = ptr;
+      if (*q) free(*q);
+      if (!(*q = strdup((const char *)text)))
+        return err(-1, "allocation failure");
+    } else {
+      strncpy(ptr, (const char *)text, p->size);
+      ((char *)ptr)[p->size-1] = '\0';
+    }
+    break;
+  case colBlob:
+    if (dlite_binary_decode_property(sqlite3_column_blob(stmt, col),
+                                     sqlite3_column_bytes(stmt, col),
+                                     inst, i) < 0)
+      return err(-1, "cannot decode property '%s' of %s",
+                 p->name, inst->uuid);
+    break;
+  }
+  return 0;
+}
+
+
+/********************************************************************
+ * Required api
+ ********************************************************************/
+
+int sqlite_close(DLiteStorage *s);
+
+/**
+  Opens SQLite database `uri` and returns a new storage for it.
+
+  Valid `options` are:
+
+  - mode : append | r | w
+      Valid values are:
+      - append   Append to existing file or create new file (default)
+      - r        Open existing file for read-only
+      - w        Truncate existing file or create new file
+
+  Writable databases use write-ahead logging.  All instances saved
+  between opening and closing the storage are written in a single
+  transaction, which is committed when the storage is closed.
+ */
+DLiteStorage *sqlite_open(const DLiteStoragePlugin *api, const char *uri,
+                          const char *options)
+{
+  DLiteSqliteStorage *s=NULL;
+  DLiteStorage *retval=NULL;
+  char *mode_descr = "How to open storage.  Valid values are: "
+    "\"append\" (appends to existing storage or creates a new one); "
+    "\"r\" (read-only); "
+    "\"w\" (truncate existing storage or create a new one)";
+  DLiteOpt opts[] = {
+    {'m', "mode", "append", mode_descr},
+    {0, NULL, NULL, NULL}
+  };
+  char *optcopy = (options) ? strdup(options) : NULL;
+  const char *mode;
+  int flags;
+
+  if (dlite_option_parse(optcopy, opts, 1)) goto fail;
+  mode = opts[0].value;
+
+  if (!(s = calloc(1, sizeof(DLiteSqliteStorage))))
+    FAIL("allocation failure");
+  s->api = api;
+  map_init(&s->inserts);
+  map_init(&s->selects);
+
+  if (strcmp(mode, "append") == 0) {
+    flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    s->writable = 1;
+  } else if (strcmp(mode, "r") == 0) {
+    flags = SQLITE_OPEN_READONLY;
+    s->writable = 0;
+  } else if (strcmp(mode, "w") == 0) {
+    flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    s->writable = 1;
+    if (remove_database(uri))
+      FAIL1("cannot truncate sqlite database: %s", uri);
+  } else {
+    FAIL1("invalid \"mode\" value: '%s'. Must be \"append\", \"r\" "
+          "(read-only) or \"w\" (write)", mode);
+  }
+
+  if (sqlite3_open_v2(uri, &s->db, flags, NULL) != SQLITE_OK)
+    FAIL2("cannot open sqlite database \"%s\": %s", uri,
+          (s->db) ? sqlite3_errmsg(s->db) : "allocation failure");
+
+  if (s->writable) {
+    if (exec(s, "PRAGMA journal_mode=WAL") ||
+        exec(s, "PRAGMA synchronous=NORMAL") ||
+        exec(s, "CREATE TABLE IF NOT EXISTS dlite_instances "
+             "(uuid TEXT PRIMARY KEY, meta TEXT NOT NULL, uri TEXT)") ||
+        exec(s, "CREATE INDEX IF NOT EXISTS dlite_instances_meta "
+             "ON dlite_instances (meta)") ||
+        exec(s, "BEGIN")) goto fail;
+    s->intransaction = 1;
+    if (!(s->insert_uuid = prepare(s, "INSERT OR REPLACE INTO "
+                                   "dlite_instances VALUES (?, ?, ?)")))
+      goto fail;
+  }
+  if (!(s->select_uuid = prepare(s, "SELECT meta, uri FROM dlite_instances "
+                                 "WHERE uuid=?")))
+    goto fail;
+
+  s->idflag = dliteIDTranslateToUUID;
+  retval = (DLiteStorage *)s;
+ fail:
+  if (optcopy) free(optcopy);
+  if (!retval && s) {
+    sqlite_close((DLiteStorage *)s);
+    free(s);
+  }
+  return retval;
+}
+
+
+/**
+  Commits pending changes and closes storage `s`.  Returns non-zero on
+  error.
+ */
+int sqlite_close(DLiteStorage *s)
+{
+  DLiteSqliteStorage *ss = (DLiteSqliteStorage *)s;
+  const char *key;
+  map_iter_t iter;
+  int stat=0;
+
+  if (ss->intransaction && exec(ss, "COMMIT")) stat = 1;
+  ss->intransaction = 0;
+
+  iter = map_iter(&ss->inserts);
+  while ((key = map_next(&ss->inserts, &iter)))
+    sqlite3_finalize(*map_get(&ss->inserts, key));
+  iter = map_iter(&ss->selects);
+  while ((key = map_next(&ss->selects, &iter)))
+    sqlite3_finalize(*map_get(&ss->selects, key));
+  map_deinit(&ss->inserts);
+  map_deinit(&ss->selects);
+  sqlite3_finalize(ss->insert_uuid);
+  sqlite3_finalize(ss->select_uuid);
+
+  if (ss->db && sqlite3_close(ss->db) != SQLITE_OK)
+    stat = err(1, "cannot close sqlite database %s: %s",
+               sqlite3_db_filename(ss->db, NULL), sqlite3_errmsg(ss->db));
+  return stat;
+}
+
+
+/**
+  Loads instance `id` from storage `s` and returns it.  NULL is
+  returned on error.
+ */
+DLiteInstance *sqlite_load(const DLiteStorage *s, const char *id)
+{
+  DLiteSqliteStorage *ss = (DLiteSqliteStorage *)s;
+  char uuid[DLITE_UUID_LENGTH+1], metauuid[DLITE_UUID_LENGTH+1];
+  char *metauri=NULL, *uri=NULL;
+  sqlite3_stmt *stmt, *select=NULL;
+  DLiteMeta *meta=NULL;
+  DLiteInstance *inst=NULL;
+  size_t i, *dims=NULL;
+  int stat, ok=0;
+
+  if (!id || !*id) FAIL1("id is required when loading from sqlite "
+                         "storage \"%s\"", s->location);
+  if (dlite_get_uuid(uuid, id) < 0) goto fail;
+
+  /* Look up metadata and uri */
+  stmt = ss->select_uuid;
+  if (sqlite3_bind_text(stmt, 1, uuid, -1, SQLITE_STATIC) != SQLITE_OK)
+    FAIL1("cannot bind uuid: %s", sqlite3_errmsg(ss->db));
+  if ((stat = sqlite3_step(stmt)) == SQLITE_DONE)
+    FAIL2("no instance with id \"%s\" in storage \"%s\"", id, s->location);
+  if (stat != SQLITE_ROW)
+    FAIL2("error looking up \"%s\": %s", id, sqlite3_errmsg(ss->db));
+  if (!(metauri = strdup((const char *)sqlite3_column_text(stmt, 0))))
+    FAIL("allocation failure");
+  if (sqlite3_column_type(stmt, 1) != SQLITE_NULL &&
+      !(uri = strdup((const char *)sqlite3_column_text(stmt, 1))))
+    FAIL("allocation failure");
+  sqlite3_reset(stmt);
+
+  /* Get metadata, preferably from this storage */
+  if ((meta = (DLiteMeta *)dlite_instance_has(metauri, 0))) {
+    dlite_meta_incref(meta);
+  } else {
+    if (dlite_get_uuid(metauuid, metauri) < 0) goto fail;
+    if (sqlite3_bind_text(stmt, 1, metauuid, -1, SQLITE_STATIC) != SQLITE_OK)
+      FAIL1("cannot bind uuid: %s", sqlite3_errmsg(ss->db));
+    stat = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (stat == SQLITE_ROW)
+      meta = (DLiteMeta *)sqlite_load(s, metauri);
+    else
+      meta = dlite_meta_get(metauri);
+    if (!meta) goto fail;
+  }
+
+  /* Read instance */
+  if (!(stmt = select = get_select(ss, metauri))) goto fail;
+  if (sqlite3_bind_text(stmt, 1, uuid, -1, SQLITE_STATIC) != SQLITE_OK)
+    FAIL1("cannot bind uuid: %s", sqlite3_errmsg(ss->db));
+  if ((stat = sqlite3_step(stmt)) != SQLITE_ROW)
+    FAIL3("cannot read \"%s\" from table \"%s\": %s", id, metauri,
+          (stat == SQLITE_DONE) ? "no such row" : sqlite3_errmsg(ss->db));
+  if (sqlite3_column_count(stmt) !=
+      (int)(1 + meta->_ndimensions + meta->_nproperties))
+    FAIL1("table \"%s\" does not match its metadata", metauri);
+
+  if (!(dims = calloc(meta->_ndimensions + 1, sizeof(size_t))))
+    FAIL("allocation failure");
+  for (i=0; i < meta->_ndimensions; i++)
+    dims[i] = sqlite3_column_int64(stmt, 1 + i);
+  if (!(inst = dlite_instance_create(meta, dims, (uri) ? uri : uuid)))
+    goto fail;
+  if (strcmp(inst->uuid, uuid) != 0)
+    FAIL2("instance has uuid \"%s\", expected \"%s\"", inst->uuid, uuid);
+  for (i=0; i < meta->_nproperties; i++)
+    if (column_property(stmt, 1 + meta->_ndimensions + i, inst, i))
+      goto fail;
+  if (dlite_instance_is_meta(inst)) dlite_meta_init((DLiteMeta *)inst);
+
+  ok = 1;
+ fail:
+  sqlite3_reset(ss->select_uuid);
+  sqlite3_reset(select);
+  if (metauri) free(metauri);
+  if (uri) free(uri);
+  if (dims) free(dims);
+  if (meta) dlite_meta_decref(meta);
+  if (!ok && inst) {
+    dlite_instance_decref(inst);
+    inst = NULL;
+  }
+  return inst;
+}
+
+
+/**
+  Saves instance `inst` to storage `s`.  Returns non-zero on error.
+
+  The statements for inserting instances of a given metadata are
+  prepared once and reused for all instances of that metadata.  Each
+  save is done within a savepoint, such that a failed save does not
+  leave partial changes that would be committed when the storage is
+  closed.
+*/
+int sqlite_save(DLiteStorage *s, const DLiteInstance *inst)
+{
+  DLiteSqliteStorage *ss = (DLiteSqliteStorage *)s;
+  const DLiteMeta *meta = inst->meta;
+  sqlite3_stmt *stmt, *insert;
+  size_t i;
+  int col=1, retval=1;
+
+  if (!s->writable)
+    return errx(1, "storage \"%s\" is not writable", s->location);
+
+  if (!(stmt = insert = get_insert(ss, meta))) return 1;
+  if (exec(ss, "SAVEPOINT dlite_save")) return 1;
+  if (sqlite3_bind_text(stmt, col++, inst->uuid, -1, SQLITE_STATIC))
+    FAIL1("cannot bind uuid: %s", sqlite3_errmsg(ss->db));
+  for (i=0; i < meta->_ndimensions; i++)
+    if (sqlite3_bind_int64(stmt, col++, DLITE_DIM(inst, i)))
+      FAIL1("cannot bind dimension: %s", sqlite3_errmsg(ss->db));
+  for (i=0; i < meta->_nproperties; i++)
+    if (bind_property(stmt, col++, inst, i)) goto fail;
+  if (sqlite3_step(stmt) != SQLITE_DONE)
+    FAIL2("cannot save \"%s\": %s", inst->uuid, sqlite3_errmsg(ss->db));
+
+  stmt = ss->insert_uuid;
+  if (sqlite3_bind_text(stmt, 1, inst->uuid, -1, SQLITE_STATIC) ||
+      sqlite3_bind_text(stmt, 2, meta->uri, -1, SQLITE_STATIC) ||
+      ((inst->uri) ?
+       sqlite3_bind_text(stmt, 3, inst->uri, -1, SQLITE_STATIC) :
+       sqlite3_bind_null(stmt, 3)))
+    FAIL1("cannot bind uuid: %s", sqlite3_errmsg(ss->db));
+  if (sqlite3_step(stmt) != SQLITE_DONE)
+    FAIL2("cannot save \"%s\": %s", inst->uuid, sqlite3_errmsg(ss->db));
+
+  retval = 0;
+ fail:
+  sqlite3_reset(insert);
+  sqlite3_clear_bindings(insert);
+  sqlite3_reset(ss->insert_uuid);
+  if (retval) exec(ss, "ROLLBACK TO dlite_save");
+  if (exec(ss, "RELEASE dlite_save")) retval = 1;
+  return retval;
+}
+
+
+/**
+  Creates and returns a new iterator used by sqlite_iter_next().
+
+  If `pattern` is not NULL, sqlite_iter_next() will only iterate over
+  instances whos metadata uri matches the glob pattern `pattern`.  The
+  lookup uses the index on metadata uri.
+
+  Returns new iterator or NULL on error.
+ */
+void *sqlite_iter_create(const DLiteStorage *s, const char *pattern)
+{
+  DLiteSqliteStorage *ss = (DLiteSqliteStorage *)s;
+  DLiteSqliteIter *iter;
+  if (!(iter = calloc(1, sizeof(DLiteSqliteIter))))
+    return err(1, "allocation failure"), NULL;
+  if (pattern && *pattern) {
+    if (!(iter->stmt = prepare(ss, "SELECT uuid FROM dlite_instances "
+                               "WHERE meta GLOB ?")) ||
+        sqlite3_bind_text(iter->stmt, 1, pattern, -1, SQLITE_TRANSIENT))
+      goto fail;
+  } else {
+    if (!(iter->stmt = prepare(ss, "SELECT uuid FROM dlite_instances")))
+      goto fail;
+  }
+  return iter;
+ fail:
+  sqlite3_finalize(iter->stmt);
+  free(iter);
+  return NULL;
+}
+
+/**
+  Writes the uuid of the next instance to `buf`, where `iter` is an
+  iterator returned by sqlite_iter_create().
+
+  Returns zero on success, 1 if there are no more UUIDs to iterate
+  over and a negative number on other errors.
+ */
+int sqlite_iter_next(void *iter, char *buf)
+{
+  DLiteSqliteIter *it = iter;
+  const unsigned char *uuid;
+  int stat = sqlite3_step(it->stmt);
+  if (stat == SQLITE_DONE) return 1;
+  if (stat != SQLITE_ROW)
+    return errx(-1, "error iterating over sqlite storage: %s",
+                sqlite3_errstr(stat));
+  uuid = sqlite3_column_text(it->stmt, 0);
+  strncpy(buf, (const char *)uuid, DLITE_UUID_LENGTH+1);
+  buf[DLITE_UUID_LENGTH] = '\0';
+  return 0;
+}
+
+/**
+  Free's iterator created with sqlite_iter_create().
+ */
+void sqlite_iter_free(void *iter)
+{
+  DLiteSqliteIter *it = iter;
+  sqlite3_finalize(it->stmt);
+  free(it);
+}
+
+
+static DLiteStoragePlugin dlite_sqlite_plugin = {
+  /* head */
+  "sqlite",                 /* name */
+  NULL,                     /* freeapi */
+
+  /* basic api */
+  sqlite_open,              /* open */
+  sqlite_close,             /* close */
+
+  /* queue api */
+  sqlite_iter_create,       /* iterCreate */
+  sqlite_iter_next,         /* iterNext */
+  sqlite_iter_free,         /* iterFree */
+  NULL,                     /* getUUIDs */
+
+  /* direct api */
+  sqlite_load,              /* loadInstance */
+  sqlite_save,              /* saveInstance */
+
+  /* datamodel api */
+  NULL,                     /* dataModel */
+  NULL,                     /* dataModelFree */
+
+  NULL,                     /* getMetaURI */
+  NULL,                     /* resolveDimensions */
+  NULL,                     /* getDimensionSize */
+  NULL,                     /* getProperty */
+
+  /* -- datamodel api (optional) */
+  NULL,                     /* setMetaURI */
+  NULL,                     /* setDimensionSize */
+  NULL,                     /* setProperty */
+
+  NULL,                     /* hasDimension */
+  NULL,                     /* hasProperty */
+
+  NULL,                     /* getDataName, obsolute */
+  NULL,                     /* setDataName, obsolute */
+
+  /* internal data */
+  NULL                      /* data */
+};
+
+
+DSL_EXPORT const DLiteStoragePlugin *
+get_dlite_storage_plugin_api(void *state, int *iter)
+{
+  UNUSED(iter);
+  dlite_globals_set(state);
+  return &dlite_sqlite_plugin;
+}
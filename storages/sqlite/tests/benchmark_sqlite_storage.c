@@ -0,0 +1,89 @@
+/* Benchmark of saving and loading instances with the sqlite storage
+   plugin.
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_sqlite_storage
+
+   and run it manually with the same environment as the tests,
+   optionally with the number of instances as argument. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlite.h"
+#include "dlite-macros.h"
+
+
+/* Returns a new instance of test-entity with dimensions 2, 3, 4 */
+static DLiteInstance *create_instance(DLiteMeta *meta, int k)
+{
+  DLiteInstance *inst;
+  size_t i, dims[] = {2, 3, 4};
+  unsigned char blob[3] = {1, 2, k};
+  double mydouble = 1.5 * k;
+  char fixstring[3] = "ab";
+  char *mystring = "a string";
+  uint16_t myshort = 17 + k;
+  int *arr;
+
+  if (!(inst = dlite_instance_create(meta, dims, NULL))) return NULL;
+  dlite_instance_set_property(inst, "myblob", blob);
+  dlite_instance_set_property(inst, "mydouble", &mydouble);
+  dlite_instance_set_property(inst, "myfixstring", fixstring);
+  dlite_instance_set_property(inst, "mystring", &mystring);
+  dlite_instance_set_property(inst, "myshort", &myshort);
+  arr = dlite_instance_get_property(inst, "myarray");
+  for (i=0; i<2*3*4; i++) arr[i] = k * 100 + i;
+  return inst;
+}
+
+
+int main(int argc, char *argv[])
+{
+  char *url = "json://" STRINGIFY(DLITE_ROOT) "/src/tests/test-entity.json";
+  int k, n = (argc > 1) ? atoi(argv[1]) : 5000;
+  char (*uuids)[DLITE_UUID_LENGTH+1] = calloc(n, sizeof(*uuids));
+  DLiteMeta *meta=NULL;
+  DLiteStorage *s=NULL;
+  DLiteInstance *inst;
+  clock_t t0;
+  int stat, retval=1;
+
+  if (!uuids) FAIL("allocation failure");
+  if (!(meta = (DLiteMeta *)dlite_instance_load_url(url))) goto fail;
+
+  if (!(s = dlite_storage_open("sqlite", "benchmark-sqlite.db", "mode=w")))
+    goto fail;
+  t0 = clock();
+  for (k=0; k<n; k++) {
+    if (!(inst = create_instance(meta, k))) goto fail;
+    strcpy(uuids[k], inst->uuid);
+    stat = dlite_instance_save(s, inst);
+    dlite_instance_decref(inst);
+    if (stat) goto fail;
+  }
+  stat = dlite_storage_close(s);
+  s = NULL;
+  if (stat) goto fail;
+  printf("saved %d instances in %.3f s\n", n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+
+  if (!(s = dlite_storage_open("sqlite", "benchmark-sqlite.db", "mode=r")))
+    goto fail;
+  t0 = clock();
+  for (k=0; k<n; k++) {
+    if (!(inst = dlite_instance_load(s, uuids[k]))) goto fail;
+    dlite_instance_decref(inst);
+  }
+  printf("loaded %d instances in %.3f s\n", n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  retval = dlite_storage_close(s);
+  s = NULL;
+ fail:
+  if (s) dlite_storage_close(s);
+  if (meta) dlite_meta_decref(meta);
+  if (uuids) free(uuids);
+  return retval;
+}
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sqlite3.h>
+
+#include "minunit/minunit.h"
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-storage-plugins.h"
+
+#include "config.h"
+
+
+/* Forward declarations */
+void *sqlite_iter_create(const DLiteStorage *s, const char *pattern);
+int sqlite_iter_next(void *iter, char *buf);
+void sqlite_iter_free(void *iter);
+
+#define METAURI "http://onto-ns.com/meta/0.1/test-entity"
+
+DLiteMeta *meta=NULL;
+char uuid[DLITE_UUID_LENGTH+1];
+
+
+/* Returns a new instance of test-entity with dimensions 2, 3, 4 */
+static DLiteInstance *create_instance(int k)
+{
+  DLiteInstance *inst;
+  size_t i, dims[] = {2, 3, 4};
+  unsigned char blob[3] = {1, 2, k};
+  double mydouble = 1.5 * k;
+  char fixstring[3] = "ab";
+  char *mystring = "a string";
+  uint16_t myshort = 17 + k;
+  int *arr;
+
+  if (!(inst = dlite_instance_create(meta, dims, NULL))) return NULL;
+  dlite_instance_set_property(inst, "myblob", blob);
+  dlite_instance_set_property(inst, "mydouble", &mydouble);
+  dlite_instance_set_property(inst, "myfixstring", fixstring);
+  dlite_instance_set_property(inst, "mystring", &mystring);
+  dlite_instance_set_property(inst, "myshort", &myshort);
+  arr = dlite_instance_get_property(inst, "myarray");
+  for (i=0; i<2*3*4; i++) arr[i] = k * 100 + i;
+  return inst;
+}
+
+
+MU_TEST(test_save)
+{
+  char *url = "json://" STRINGIFY(DLITE_ROOT) "/src/tests/test-entity.json";
+  DLiteStorage *s;
+  DLiteInstance *inst;
+  int k;
+
+  mu_check((meta = (DLiteMeta *)dlite_instance_load_url(url)));
+  mu_check((s = dlite_storage_open("sqlite", "test-sqlite.db", "mode=w")));
+  mu_assert_int_eq(1, dlite_storage_is_writable(s));
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)meta));
+  for (k=0; k<3; k++) {
+    mu_check((inst = create_instance(k)));
+    mu_assert_int_eq(0, dlite_instance_save(s, inst));
+    if (k == 1) strcpy(uuid, inst->uuid);
+    dlite_instance_decref(inst);
+  }
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_load)
+{
+  DLiteStorage *s;
+  DLiteInstance *inst;
+  unsigned char *blob;
+  char **mystring;
+  int *arr;
+
+  mu_check((s = dlite_storage_open("sqlite", "test-sqlite.db", "mode=r")));
+  mu_assert_int_eq(0, dlite_storage_is_writable(s));
+  mu_check((inst = dlite_instance_load(s, uuid)));
+  mu_assert_string_eq(uuid, inst->uuid);
+  mu_assert_int_eq(2, dlite_instance_get_dimension_size(inst, "L"));
+  mu_assert_int_eq(4, dlite_instance_get_dimension_size(inst, "N"));
+  blob = dlite_instance_get_property(inst, "myblob");
+  mu_assert_int_eq(1, blob[2]);
+  mu_assert_double_eq(1.5,
+                      *(double *)dlite_instance_get_property(inst, "mydouble"));
+  mu_assert_string_eq("ab", dlite_instance_get_property(inst, "myfixstring"));
+  mystring = dlite_instance_get_property(inst, "mystring");
+  mu_assert_string_eq("a string", *mystring);
+  mu_assert_int_eq(18,
+                   *(uint16_t *)dlite_instance_get_property(inst, "myshort"));
+  arr = dlite_instance_get_property(inst, "myarray");
+  mu_assert_int_eq(100, arr[0]);
+  mu_assert_int_eq(123, arr[23]);
+  dlite_instance_decref(inst);
+
+  mu_check(!dlite_instance_load(s, "no-such-instance"));
+  dlite_errclr();
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_iter)
+{
+  DLiteStorage *s;
+  void *iter;
+  char buf[DLITE_UUID_LENGTH+1];
+  int n, found=0;
+
+  mu_check((s = dlite_storage_open("sqlite", "test-sqlite.db", "mode=r")));
+
+  mu_check((iter = sqlite_iter_create(s, NULL)));
+  for (n=0; sqlite_iter_next(iter, buf) == 0; n++)
+    if (strcmp(buf, uuid) == 0) found = 1;
+  sqlite_iter_free(iter);
+  mu_assert_int_eq(4, n);
+  mu_check(found);
+
+  mu_check((iter = sqlite_iter_create(s, METAURI)));
+  for (n=0; sqlite_iter_next(iter, buf) == 0; n++) ;
+  sqlite_iter_free(iter);
+  mu_assert_int_eq(3, n);
+
+  mu_check((iter = sqlite_iter_create(s, "*/EntitySchema")));
+  for (n=0; sqlite_iter_next(iter, buf) == 0; n++) ;
+  sqlite_iter_free(iter);
+  mu_assert_int_eq(1, n);
+
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+/* Returns the number of rows in table `table` of database `path` or -1
+   on error */
+static int count_rows(const char *path, const char *table)
+{
+  sqlite3 *db;
+  sqlite3_stmt *stmt;
+  char sql[256];
+  int n=-1;
+  snprintf(sql, sizeof(sql), "SELECT count(*) FROM \"%s\"", table);
+  if (sqlite3_open(path, &db) == SQLITE_OK &&
+      sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+    if (sqlite3_step(stmt) == SQLITE_ROW) n = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+  }
+  sqlite3_close(db);
+  return n;
+}
+
+MU_TEST(test_failed_save)
+{
+  char *path = "test-sqlite-failed.db";
+  size_t dims[] = {2, 3, 4};
+  sqlite3 *db;
+  DLiteStorage *s;
+  DLiteInstance *inst;
+
+  mu_check((s = dlite_storage_open("sqlite", path, "mode=w")));
+  mu_check((inst = create_instance(0)));
+  mu_assert_int_eq(0, dlite_instance_save(s, inst));
+  dlite_instance_decref(inst);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  /* Make registration of instances with uri "fail" fail after the
+     instance itself is inserted into the table of its metadata */
+  mu_assert_int_eq(SQLITE_OK, sqlite3_open(path, &db));
+  mu_assert_int_eq(SQLITE_OK, sqlite3_exec(
+    db, "CREATE TRIGGER fail BEFORE INSERT ON dlite_instances "
+    "WHEN NEW.uri = 'fail' BEGIN SELECT RAISE(ABORT, 'failed'); END",
+    NULL, NULL, NULL));
+  sqlite3_close(db);
+
+  /* A failed save must not leave partial changes that are committed
+     when the storage is closed */
+  mu_check((s = dlite_storage_open("sqlite", path, "mode=append")));
+  mu_check((inst = dlite_instance_create(meta, dims, "fail")));
+  mu_check(dlite_instance_save(s, inst));
+  dlite_errclr();
+  dlite_instance_decref(inst);
+  mu_check((inst = create_instance(1)));
+  mu_assert_int_eq(0, dlite_instance_save(s, inst));
+  dlite_instance_decref(inst);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  mu_assert_int_eq(2, count_rows(path, METAURI));
+  mu_assert_int_eq(2, count_rows(path, "dlite_instances"));
+}
+
+
+MU_TEST(test_cleanup)
+{
+  dlite_meta_decref(meta);
+}
+
+
+/***********************************************************************/
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_save);
+  MU_RUN_TEST(test_load);
+  MU_RUN_TEST(test_iter);
+  MU_RUN_TEST(test_failed_save);
+  MU_RUN_TEST(test_cleanup);
+}
+
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}
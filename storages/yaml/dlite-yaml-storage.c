@@ -0,0 +1,1308 @@
+/* dlite-yaml-storage.c -- DLite plugin for yaml */
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <yaml.h>
+
+#include "config.h"
+
+#include "utils/err.h"
+#include "utils/floats.h"
+#include "utils/map.h"
+#include "dlite.h"
+#include "dlite-storage-plugins.h"
+#include "dlite-macros.h"
+
+/*
+  Storage layout
+  --------------
+  A yaml storage is a mapping of ids (normally uuids) to instances in
+  the same layout as written by the json plugin and Instance.asdict()
+  in Python:
+
+      <uuid>:
+        uuid: <uuid>
+        meta: <metadata uri>
+        uri: <uri>                # optional
+        dimensions:
+          <name>: <size>
+        properties:
+          <name>: <value>
+
+  Metadata are written with their dimensions and properties as
+  sequences at the top level of the instance.  A file with a single
+  instance at the root (like most metadata libraries) is also
+  accepted, but is opened read-only.
+
+  The file is read with the event-based libyaml parser into a light
+  tree of nodes, from which instances are constructed directly using
+  dlite_type_scan() for the scalar values.  Saved instances are added
+  to the same tree, which is written with the libyaml emitter when the
+  storage is closed.
+*/
+
+/* Node types in a parsed yaml document */
+typedef enum { nodeScalar, nodeSequence, nodeMapping } NodeType;
+
+/* A node in a yaml document.  Mappings store their keys and values as
+   alternating items. */
+typedef struct _Node Node;
+struct _Node {
+  NodeType type;
+  int plain;          /* whether a scalar is plain (should not be quoted) */
+  char *value;        /* NUL-terminated value of a scalar */
+  size_t len;         /* length of `value` */
+  size_t n;           /* number of items */
+  size_t size;        /* allocated number of items */
+  Node *items;        /* sequence items or mapping keys and values */
+};
+
+/** Storage for yaml backend. */
+typedef struct {
+  DLiteStorage_HEAD
+  Node root;          /* mapping of ids to instances */
+  map_int_t index;    /* maps uuids to position of their key in `root` */
+  int changed;        /* whether the storage is changed */
+} DLiteYamlStorage;
+
+/** Iterator over uuids. */
+typedef struct {
+  const DLiteYamlStorage *s;
+  size_t pos;                               /* position of next key */
+  char metauuid[DLITE_UUID_LENGTH+1];       /* uuid of metadata to match */
+} DLiteYamlIter;
+
+
+/* Forward declarations */
+static DLiteInstance *parse_instance(DLiteYamlStorage *s, const Node *obj,
+                                     const char *id);
+
+
+/* ================================================================
+ * Nodes
+ * ================================================================ */
+
+/* Frees all memory owned by `node` and resets it. */
+static void node_clear(Node *node)
+{
+  size_t i;
+  if (node->value) free(node->value);
+  for (i=0; i < node->n; i++) node_clear(node->items + i);
+  if (node->items) free(node->items);
+  memset(node, 0, sizeof(Node));
+}
+
+/* Appends a new zero-initialised item to `parent` and returns a pointer
+   to it.  The pointer is only valid until the next item is appended.
+   Returns NULL on error. */
+static Node *node_add(Node *parent)
+{
+  Node *item;
+  if (parent->n >= parent->size) {
+    size_t size = (parent->size) ? 2*parent->size : 8;
+    Node *items = realloc(parent->items, size*sizeof(Node));
+    if (!items) return err(1, "allocation failure"), NULL;
+    parent->items = items;
+    parent->size = size;
+  }
+  item = parent->items + parent->n++;
+  memset(item, 0, sizeof(Node));
+  return item;
+}
+
+/* Initialise `node` as a scalar with the first `len` bytes of `value`.
+   If `len` is negative, the full length of `value` is used.  Returns
+   non-zero on error. */
+static int node_set_scalar(Node *node, const char *value, int len, int plain)
+{
+  size_t n = (len < 0) ? strlen(value) : (size_t)len;
+  node->type = nodeScalar;
+  node->plain = plain;
+  node->len = n;
+  if (!(node->value = malloc(n + 1))) return err(1, "allocation failure");
+  memcpy(node->value, value, n);
+  node->value[n] = '\0';
+  return 0;
+}
+
+/* Adds a scalar item to sequence `parent`.  Returns non-zero on error. */
+static int node_add_scalar(Node *parent, const char *value, int plain)
+{
+  Node *item;
+  if (!(item = node_add(parent))) return 1;
+  return node_set_scalar(item, value, -1, plain);
+}
+
+/* Adds key `key` to mapping `map` and returns a pointer to a new
+   zero-initialised value for it.  Returns NULL on error. */
+static Node *node_add_key(Node *map, const char *key)
+{
+  if (node_add_scalar(map, key, 1)) return NULL;
+  return node_add(map);
+}
+
+/* Adds a scalar item `key: value` to mapping `map`.  Returns non-zero
+   on error. */
+static int node_add_item(Node *map, const char *key, const char *value,
+                         int plain)
+{
+  Node *item;
+  if (!(item = node_add_key(map, key))) return 1;
+  return node_set_scalar(item, value, -1, plain);
+}
+
+/* Returns the value of `key` in mapping `map` or NULL if `map` is not a
+   mapping or has no such key. */
+static const Node *node_get(const Node *map, const char *key)
+{
+  size_t i;
+  if (!map || map->type != nodeMapping) return NULL;
+  for (i=0; i+1 < map->n; i+=2)
+    if (strcmp(map->items[i].value, key) == 0) return map->items + i + 1;
+  return NULL;
+}
+
+/* Returns the value of scalar `key` in mapping `map` or NULL if there
+   is no such scalar. */
+static const char *node_get_scalar(const Node *map, const char *key)
+{
+  const Node *node = node_get(map, key);
+  return (node && node->type == nodeScalar) ? node->value : NULL;
+}
+
+/* Returns non-zero if `node` is a null scalar. */
+static int node_is_null(const Node *node)
+{
+  if (node->type != nodeScalar || !node->plain) return 0;
+  return (node->len == 0 || strcmp(node->value, "~") == 0 ||
+          strcmp(node->value, "null") == 0 ||
+          strcmp(node->value, "Null") == 0 ||
+          strcmp(node->value, "NULL") == 0);
+}
+
+
+/* ================================================================
+ * Parsing
+ * ================================================================ */
+
+/* Reports the current error of `parser`.  Returns non-zero. */
+static int parse_error(const yaml_parser_t *parser, const char *filename)
+{
+  if (parser->problem)
+    return err(1, "%s:%d:%d: yaml parse error: %s",
+               filename, (int)parser->problem_mark.line + 1,
+               (int)parser->problem_mark.column + 1, parser->problem);
+  return err(1, "%s: yaml parse error", filename);
+}
+
+/* Parses the node starting with `event` into `node`.  Returns non-zero
+   on error. */
+static int parse_node(yaml_parser_t *parser, const yaml_event_t *event,
+                      Node *node, const char *filename)
+{
+  yaml_event_t ev;
+  Node *item;
+  int stat;
+  memset(node, 0, sizeof(Node));
+
+  switch (event->type) {
+  case YAML_SCALAR_EVENT:
+    return node_set_scalar(node, (char *)event->data.scalar.value,
+                           (int)event->data.scalar.length,
+                           event->data.scalar.style ==
+                           YAML_PLAIN_SCALAR_STYLE);
+
+  case YAML_SEQUENCE_START_EVENT:
+  case YAML_MAPPING_START_EVENT:
+    node->type = (event->type == YAML_MAPPING_START_EVENT) ?
+      nodeMapping : nodeSequence;
+    while (1) {
+      if (!yaml_parser_parse(parser, &ev)) {
+        node_clear(node);
+        return parse_error(parser, filename);
+      }
+      if (ev.type == YAML_SEQUENCE_END_EVENT ||
+          ev.type == YAML_MAPPING_END_EVENT) {
+        yaml_event_delete(&ev);
+        return 0;
+      }
+      if (!(item = node_add(node))) {
+        stat = 1;
+      } else if ((stat = parse_node(parser, &ev, item, filename)) == 0 &&
+                 node->type == nodeMapping && node->n % 2 &&
+                 item->type != nodeScalar) {
+        stat = err(1, "%s:%d: mapping keys must be scalars", filename,
+                   (int)ev.start_mark.line + 1);
+      }
+      yaml_event_delete(&ev);
+      if (stat) {
+        node_clear(node);
+        return stat;
+      }
+    }
+
+  case YAML_ALIAS_EVENT:
+    return err(1, "%s:%d: yaml aliases are not supported", filename,
+               (int)event->start_mark.line + 1);
+
+  default:
+    return err(1, "%s:%d: unexpected yaml event", filename,
+               (int)event->start_mark.line + 1);
+  }
+}
+
+/* Returns a malloc'ed uri of instance `obj` or NULL if it has none. */
+static char *get_uri(const Node *obj)
+{
+  const char *uri, *name, *version, *namespace;
+  char *buf=NULL;
+  if ((uri = node_get_scalar(obj, "uri"))) return strdup(uri);
+  if ((name = node_get_scalar(obj, "name")) &&
+      (version = node_get_scalar(obj, "version")) &&
+      (namespace = node_get_scalar(obj, "namespace")))
+    asprintf(&buf, "%s/%s/%s", namespace, version, name);
+  return buf;
+}
+
+/* Reads yaml file `filename` into the root of storage `s` and indexes
+   its instances.  Returns non-zero on error. */
+static int load_file(DLiteYamlStorage *s, const char *filename)
+{
+  FILE *fp=NULL;
+  yaml_parser_t parser;
+  yaml_event_t event;
+  Node doc;
+  int stat, parser_initialised=0, retval=1;
+  size_t i;
+  memset(&doc, 0, sizeof(Node));
+
+  if (!(fp = fopen(filename, "rb")))
+    FAIL1("cannot open yaml file: %s", filename);
+  if (!yaml_parser_initialize(&parser))
+    FAIL("cannot initialise yaml parser");
+  parser_initialised = 1;
+  yaml_parser_set_input_file(&parser, fp);
+
+  /* Skip stream start and parse the first document.  Empty files
+     gives an empty storage. */
+  do {
+    if (!yaml_parser_parse(&parser, &event)) {
+      parse_error(&parser, filename);
+      goto fail;
+    }
+    stat = event.type;
+    if (stat != YAML_STREAM_START_EVENT && stat != YAML_DOCUMENT_START_EVENT
+        && stat != YAML_STREAM_END_EVENT) {
+      stat = parse_node(&parser, &event, &doc, filename);
+      yaml_event_delete(&event);
+      if (stat) goto fail;
+      break;
+    }
+    yaml_event_delete(&event);
+  } while (stat != YAML_STREAM_END_EVENT);
+
+  if (doc.type == nodeMapping && node_get(&doc, "properties")) {
+    /* Single instance at the root */
+    Node *item;
+    char *id;
+    if (!(id = get_uri(&doc)) &&
+        (!node_get_scalar(&doc, "uuid") ||
+         !(id = strdup(node_get_scalar(&doc, "uuid")))))
+      FAIL1("instance in yaml file has neither uri nor uuid: %s", filename);
+    stat = node_add_scalar(&s->root, id, 0);
+    free(id);
+    if (stat || !(item = node_add(&s->root))) goto fail;
+    memcpy(item, &doc, sizeof(Node));
+    memset(&doc, 0, sizeof(Node));
+    s->writable = 0;
+  } else if (doc.type == nodeMapping) {
+    memcpy(&s->root, &doc, sizeof(Node));
+    memset(&doc, 0, sizeof(Node));
+  } else if (!(doc.type == nodeScalar && node_is_null(&doc))) {
+    FAIL1("yaml storage should be a mapping of ids to instances: %s",
+          filename);
+  }
+
+  for (i=0; i+1 < s->root.n; i+=2) {
+    char uuid[DLITE_UUID_LENGTH+1];
+    if (dlite_get_uuid(uuid, s->root.items[i].value) < 0) goto fail;
+    map_set(&s->index, uuid, (int)i);
+  }
+  retval = 0;
+ fail:
+  node_clear(&doc);
+  if (parser_initialised) yaml_parser_delete(&parser);
+  if (fp) fclose(fp);
+  return retval;
+}
+
+
+/* ================================================================
+ * Scanning instances
+ * ================================================================ */
+
+/* Returns the C representation of yaml float `value` if it is one of
+   the special values .inf, -.inf or .nan.  Otherwise NULL is returned. */
+static const char *special_float(const char *value)
+{
+  const char *p = value;
+  if (*p == '-' || *p == '+') p++;
+  if (*p != '.') return NULL;
+  if (strcmp(p, ".inf") == 0 || strcmp(p, ".Inf") == 0 ||
+      strcmp(p, ".INF") == 0)
+    return (*value == '-') ? "-inf" : "inf";
+  if (p == value && (strcmp(p, ".nan") == 0 || strcmp(p, ".NaN") == 0 ||
+                     strcmp(p, ".NAN") == 0))
+    return "nan";
+  return NULL;
+}
+
+/* Scans yaml node `node` into the single element pointed to by `ptr`,
+   which is of the type of property `p`.  Returns non-zero on error. */
+static int scan_value(const Node *node, void *ptr, const DLiteProperty *p)
+{
+  const Node *t;
+  const char *src;
+  size_t i;
+
+  switch (p->type) {
+  case dliteBlob:
+  case dliteBool:
+  case dliteInt:
+  case dliteUInt:
+  case dliteFloat:
+    if (node->type != nodeScalar)
+      return errx(1, "property \"%s\" expects a scalar value", p->name);
+    src = node->value;
+    if (p->type == dliteFloat && special_float(src)) src = special_float(src);
+    if (dlite_type_scan(src, -1, ptr, p->type, p->size, dliteFlagRaw) < 0)
+      return err(1, "cannot scan value of property \"%s\"", p->name);
+    break;
+
+  case dliteFixString:
+    if (node->type != nodeScalar)
+      return errx(1, "property \"%s\" expects a string", p->name);
+    memset(ptr, 0, p->size);
+    memcpy(ptr, node->value, (node->len < p->size) ? node->len : p->size-1);
+    break;
+
+  case dliteStringPtr:
+    if (node->type != nodeScalar)
+      return errx(1, "property \"%s\" expects a string", p->name);
+    if (*(char **)ptr) free(*(char **)ptr);
+    *(char **)ptr = NULL;
+    if (!node_is_null(node) && !(*(char **)ptr = strdup(node->value)))
+      return err(1, "allocation failure");
+    break;
+
+  case dliteDimension:
+    {
+      DLiteDimension *dim = ptr;
+      const char *name, *descr;
+      if (!(name = node_get_scalar(node, "name")))
+        return errx(1, "dimension in \"%s\" has no name", p->name);
+      descr = node_get_scalar(node, "description");
+      if (dim->name) free(dim->name);
+      if (dim->description) free(dim->description);
+      dim->name = strdup(name);
+      dim->description = (descr) ? strdup(descr) : NULL;
+    }
+    break;
+
+  case dliteProperty:
+    {
+      DLiteProperty *prop = ptr;
+      const char *name, *type, *unit, *iri, *descr;
+      if (!(name = node_get_scalar(node, "name")))
+        return errx(1, "property in \"%s\" has no name", p->name);
+      if (!(type = node_get_scalar(node, "type")))
+        return errx(1, "property \"%s\" has no type", name);
+      if (prop->name) free(prop->name);
+      if (prop->dims) {
+        for (i=0; i < (size_t)prop->ndims; i++)
+          if (prop->dims[i]) free(prop->dims[i]);
+        free(prop->dims);
+      }
+      if (prop->unit) free(prop->unit);
+      if (prop->iri) free(prop->iri);
+      if (prop->description) free(prop->description);
+      memset(prop, 0, sizeof(DLiteProperty));
+
+      prop->name = strdup(name);
+      if (dlite_type_set_dtype_and_size(type, &prop->type, &prop->size))
+        return 1;
+      if ((t = node_get(node, "dims"))) {
+        if (t->type != nodeSequence)
+          return errx(1, "dims of property \"%s\" should be a sequence",
+                      name);
+        prop->ndims = (int)t->n;
+        if (!(prop->dims = calloc(t->n, sizeof(char *))))
+          return err(1, "allocation failure");
+        for (i=0; i < t->n; i++) {
+          if (t->items[i].type != nodeScalar)
+            return errx(1, "dims of property \"%s\" should be strings", name);
+          prop->dims[i] = strdup(t->items[i].value);
+        }
+      }
+      if ((unit = node_get_scalar(node, "unit"))) prop->unit = strdup(unit);
+      if ((iri = node_get_scalar(node, "iri"))) prop->iri = strdup(iri);
+      if ((descr = node_get_scalar(node, "description")))
+        prop->description = strdup(descr);
+    }
+    break;
+
+  case dliteRelation:
+    {
+      const char *spoi[4] = {NULL, NULL, NULL, NULL};
+      if (node->type == nodeSequence && (node->n == 3 || node->n == 4)) {
+        for (i=0; i < node->n; i++)
+          if (node->items[i].type == nodeScalar)
+            spoi[i] = node->items[i].value;
+      } else {
+        spoi[0] = node_get_scalar(node, "s");
+        spoi[1] = node_get_scalar(node, "p");
+        spoi[2] = node_get_scalar(node, "o");
+        spoi[3] = node_get_scalar(node, "id");
+      }
+      if (!spoi[0] || !spoi[1] || !spoi[2])
+        return errx(1, "relation in \"%s\" should be a sequence [s, p, o] "
+                    "or a mapping with keys s, p and o", p->name);
+      if (triple_reset(ptr, spoi[0], spoi[1], spoi[2], spoi[3])) return 1;
+    }
+    break;
+  }
+  return 0;
+}
+
+/* Returns non-zero if yaml node `node` is a nested sequence with shape
+   `dims[d:ndims]`.  The total length of all non-null scalar leaves
+   (including a NUL terminator for each of them) is added to `*nbytes`. */
+static int check_shape(const Node *node, int d, const size_t *dims,
+                       int ndims, size_t *nbytes)
+{
+  size_t i;
+  if (d == ndims) {
+    if (node->type == nodeScalar && !node_is_null(node))
+      *nbytes += node->len + 1;
+    return 1;
+  }
+  if (node->type != nodeSequence || node->n != dims[d]) return 0;
+  for (i=0; i < node->n; i++)
+    if (!check_shape(node->items + i, d+1, dims, ndims, nbytes)) return 0;
+  return 1;
+}
+
+/* Scans the leaves of nested sequence `node` of depth `depth` into
+   consecutive elements of property `p` starting at `*ptr`.  `*ptr` is
+   advanced past the scanned elements.  Returns non-zero on error. */
+static int scan_leaves(const Node *node, int depth, char **ptr,
+                       const DLiteProperty *p)
+{
+  size_t i;
+  if (depth == 0) {
+    if (scan_value(node, *ptr, p)) return 1;
+    *ptr += p->size;
+    return 0;
+  }
+  for (i=0; i < node->n; i++)
+    if (scan_leaves(node->items + i, depth-1, ptr, p)) return 1;
+  return 0;
+}
+
+/* Copies the string leaves of nested sequence `node` of depth `depth`
+   into `heap` at offset `*pos` and let `(*strings)++` point to them.
+   Null leaves are assigned NULL.  Returns non-zero on error. */
+static int copy_strings(const Node *node, int depth, char ***strings,
+                        char *heap, size_t *pos)
+{
+  size_t i;
+  if (depth == 0) {
+    if (node->type != nodeScalar)
+      return errx(1, "expected a string");
+    if (node_is_null(node)) {
+      *(*strings)++ = NULL;
+    } else {
+      memcpy(heap + *pos, node->value, node->len + 1);
+      *(*strings)++ = heap + *pos;
+      *pos += node->len + 1;
+    }
+    return 0;
+  }
+  for (i=0; i < node->n; i++)
+    if (copy_strings(node->items + i, depth-1, strings, heap, pos))
+      return 1;
+  return 0;
+}
+
+/* Scans yaml node `node` into property `i` of `inst`.  Returns non-zero
+   on error. */
+static int scan_property(const Node *node, DLiteInstance *inst, size_t i)
+{
+  const DLiteProperty *p = inst->meta->_properties + i;
+  const size_t *dims = DLITE_PROP_DIMS(inst, i);
+  void *ptr = DLITE_PROP(inst, i);
+  size_t nbytes=0, pos=0;
+  char *heap, **strings, *q;
+
+  if (p->ndims == 0) return scan_value(node, ptr, p);
+
+  if (!check_shape(node, 0, dims, p->ndims, &nbytes))
+    return errx(1, "value of property \"%s\" does not match its shape",
+                p->name);
+  if (!(q = *(char **)ptr)) return 0;  /* no elements */
+
+  /* Like the json plugin, string arrays of data instances are stored
+     in a single string heap */
+  if (p->type == dliteStringPtr && !dlite_instance_is_meta(inst)) {
+    if (!(heap = dlite_instance_string_heap(inst, i, nbytes))) return 1;
+    strings = *(char ***)ptr;
+    return copy_strings(node, p->ndims, &strings, heap, &pos);
+  }
+  return scan_leaves(node, p->ndims, &q, p);
+}
+
+/* Loads metadata `metaid` from storage `s` if it is stored there and is
+   not already instantiated.  Returns a new reference to the loaded
+   metadata or NULL if it is not loaded. */
+static DLiteInstance *load_meta(DLiteYamlStorage *s, const char *metaid)
+{
+  char uuid[DLITE_UUID_LENGTH+1];
+  int *pos;
+  if (dlite_instance_has(metaid, 0)) return NULL;
+  if (dlite_get_uuid(uuid, metaid) < 0) return NULL;
+  if (!(pos = map_get(&s->index, uuid))) return NULL;
+  return parse_instance(s, s->root.items + *pos + 1, metaid);
+}
+
+/*
+  Returns a new instance created from yaml mapping `obj` in storage `s`.
+  `id` is the id of the instance.  If NULL, it will be inferred.
+
+  Returns NULL on error.
+*/
+static DLiteInstance *parse_instance(DLiteYamlStorage *s, const Node *obj,
+                                     const char *id)
+{
+  int ok=0;
+  const Node *item, *base, *t;
+  const char *metauri, *iri;
+  char *uri=NULL, uuid[DLITE_UUID_LENGTH+1];
+  char *name=NULL, *version=NULL, *namespace=NULL;
+  size_t i, *dims=NULL;
+  DLiteInstance *inst=NULL, *metainst=NULL;
+  const DLiteMeta *meta=NULL;
+  NodeType dimtype=nodeScalar;
+
+  if (obj->type != nodeMapping)
+    FAIL1("yaml representation of instance should be a mapping: %s",
+          (id) ? id : "");
+
+  /* Get uri and uuid */
+  uri = get_uri(obj);
+  if (!uri && node_get_scalar(obj, "uuid")) {
+    strncpy(uuid, node_get_scalar(obj, "uuid"), DLITE_UUID_LENGTH);
+    uuid[DLITE_UUID_LENGTH] = '\0';
+  } else {
+    if (!uri && !id) FAIL("instance has neither uri nor uuid");
+    if (dlite_get_uuid(uuid, (uri) ? uri : id) < 0) goto fail;
+  }
+
+  /* Check id */
+  if (id && *id) {
+    char uuid2[DLITE_UUID_LENGTH+1];
+    if (dlite_get_uuid(uuid2, id) < 0) goto fail;
+    if (strcmp(uuid, uuid2) != 0)
+      FAIL3("instance has id \"%s\", expected \"%s\" (%s)", uuid, uuid2, id);
+  } else {
+    id = (uri) ? uri : uuid;
+  }
+
+  /* Get metadata.  If "meta" is not given, we assume it is an entity. */
+  if ((metauri = node_get_scalar(obj, "meta"))) {
+    metainst = load_meta(s, metauri);
+    if (!(meta = dlite_meta_get(metauri)))
+      FAIL2("cannot find metadata '%s' when loading '%s' - please add the "
+            "right storage to DLITE_STORAGES and try again", metauri, id);
+  } else {
+    meta = dlite_get_entity_schema();  // borrowed reference
+    dlite_meta_incref((DLiteMeta *)meta);
+  }
+
+  /* Parse dimensions */
+  if (!(dims = calloc(meta->_ndimensions + 1, sizeof(size_t))))
+    FAIL("allocation failure");
+  if (meta->_ndimensions > 0) {
+    if (!(item = node_get(obj, "dimensions")))
+      FAIL1("no \"dimensions\" in instance %s", id);
+    dimtype = item->type;
+    if (item->type == nodeMapping) {
+      if (item->n / 2 != meta->_ndimensions)
+        FAIL3("expected %d dimensions, got %d in instance %s",
+              (int)meta->_ndimensions, (int)item->n / 2, id);
+      for (i=0; i < meta->_ndimensions; i++) {
+        DLiteDimension *d = meta->_dimensions + i;
+        const char *value;
+        char *endptr;
+        if (!(value = node_get_scalar(item, d->name)))
+          FAIL2("missing dimension \"%s\" in %s", d->name, id);
+        dims[i] = strtoul(value, &endptr, 10);
+        if (*endptr || endptr == value)
+          FAIL2("value '%s' of dimension should be an integer: %s",
+                value, id);
+      }
+    } else if (item->type == nodeSequence) {
+      size_t n=0;
+      if (!dlite_meta_is_metameta(meta))
+        FAIL1("only metadata can have sequence dimensions: %s", id);
+      if (meta->_ndimensions > n)
+        dims[n++] = item->n;
+      if (meta->_ndimensions > n && (t = node_get(obj, "properties")))
+        dims[n++] = t->n;
+      if (meta->_ndimensions > n && (t = node_get(obj, "relations")))
+        dims[n++] = t->n;
+      if (n != meta->_ndimensions)
+        FAIL3("expected %d dimensions, got %d: %s",
+              (int)meta->_ndimensions, (int)n, id);
+    } else {
+      FAIL1("\"dimensions\" must be a mapping or sequence: %s", id);
+    }
+  }
+
+  /* Create instance */
+  if (!(inst = dlite_instance_create(meta, dims, id))) goto fail;
+  if ((iri = node_get_scalar(obj, "iri")) && !inst->iri)
+    inst->iri = strdup(iri);
+
+  /* Parse properties */
+  if (meta->_nproperties > 0) {
+    if (!(item = node_get(obj, "properties")))
+      FAIL1("no \"properties\" in instance %s", id);
+    if (dimtype != nodeScalar && item->type != dimtype)
+      FAIL1("\"properties\" must have same type as \"dimensions\": %s", id);
+    if (item->type == nodeMapping)
+      base = item;
+    else if (item->type == nodeSequence)
+      base = obj;
+    else
+      FAIL1("\"properties\" must be a mapping or sequence: %s", id);
+
+    /* -- infer name, version and namespace */
+    if (dlite_instance_is_meta(inst)) {
+      if (dlite_split_meta_uri((uri) ? uri : id, &name, &version, &namespace))
+        FAIL1("cannot infer name, version and namespace from id: %s", id);
+    }
+
+    /* -- assign uri */
+    if (!inst->uri) {
+      char uuid2[DLITE_UUID_LENGTH+1];
+      if (uri)
+        inst->uri = strdup(uri);
+      else if (dlite_get_uuid(uuid2, id) > 0)
+        inst->uri = strdup(id);
+    }
+
+    /* -- read properties */
+    for (i=0; i < meta->_nproperties; i++) {
+      DLiteProperty *p = meta->_properties + i;
+      void *ptr = DLITE_PROP(inst, i);
+      const char *value=NULL;
+      if ((t = node_get(base, p->name))) {
+        if (scan_property(t, inst, i)) {
+          err(1, "error loading instance %s", id);
+          goto fail;
+        }
+      } else if (dlite_instance_is_meta(inst)) {
+        /* -- if not given, use inferred name, version and namespace */
+        if (strcmp(p->name, "name") == 0)
+          value = name;
+        else if (strcmp(p->name, "version") == 0)
+          value = version;
+        else if (strcmp(p->name, "namespace") == 0)
+          value = namespace;
+        else if (strcmp(p->name, "description") != 0)
+          FAIL2("missing property \"%s\" in %s", p->name, id);
+        if (value && !(*(char **)ptr = strdup(value)))
+          FAIL("allocation failure");
+      } else
+        FAIL2("missing property \"%s\" in %s", p->name, id);
+      if (meta->_loadprop) meta->_loadprop(inst, i);
+    }
+  }
+  if (dlite_instance_is_meta(inst)) dlite_meta_init((DLiteMeta *)inst);
+
+  ok = 1;
+ fail:
+  if (name) free(name);
+  if (version) free(version);
+  if (namespace) free(namespace);
+  if (dims) free(dims);
+  if (uri) free(uri);
+  if (!ok && inst) {
+    dlite_instance_decref(inst);
+    inst = NULL;
+  }
+  if (meta) dlite_meta_decref((DLiteMeta *)meta);
+  if (metainst) dlite_instance_decref(metainst);
+  return inst;
+}
+
+
+/* ================================================================
+ * Emitting
+ * ================================================================ */
+
+/* Reports the current error of `emitter`.  Returns non-zero. */
+static int emit_error(const yaml_emitter_t *emitter, const char *filename)
+{
+  return err(1, "%s: cannot write yaml: %s", filename,
+             (emitter->problem) ? emitter->problem : "unknown error");
+}
+
+/* Returns non-zero if `node` only contains scalars and sequences. */
+static int is_flow(const Node *node)
+{
+  size_t i;
+  if (node->type == nodeMapping) return 0;
+  for (i=0; i < node->n; i++)
+    if (!is_flow(node->items + i)) return 0;
+  return 1;
+}
+
+/* Returns non-zero if string `value` may be resolved to something else
+   than a string (like null, a boolean, a number or a timestamp) by a
+   yaml 1.1 or 1.2 parser if it is written as a plain scalar.  This is
+   conservative; all values starting with a digit are included. */
+static int is_non_string(const char *value)
+{
+  static const char *words[] = {
+    "~", "null", "Null", "NULL", "y", "Y", "n", "N", "yes", "Yes", "YES",
+    "no", "No", "NO", "true", "True", "TRUE", "false", "False", "FALSE",
+    "on", "On", "ON", "off", "Off", "OFF", "<<", "=", NULL
+  };
+  const char *p = value, **w;
+  if (!*value) return 1;
+  for (w=words; *w; w++)
+    if (strcmp(value, *w) == 0) return 1;
+  if (*p == '-' || *p == '+') p++;
+  if (*p == '.') p++;
+  if (isdigit((unsigned char)*p)) return 1;
+  if (p > value && p[-1] == '.' &&
+      (strcmp(p, "inf") == 0 || strcmp(p, "Inf") == 0 ||
+       strcmp(p, "INF") == 0 || strcmp(p, "nan") == 0 ||
+       strcmp(p, "NaN") == 0 || strcmp(p, "NAN") == 0)) return 1;
+  return 0;
+}
+
+/* Emits `node`.  Sequences of scalars are written in flow style.
+   Returns non-zero on error. */
+static int emit_node(yaml_emitter_t *emitter, const Node *node)
+{
+  yaml_event_t event;
+  size_t i;
+  switch (node->type) {
+  case nodeScalar:
+    /* Quote strings that otherwise would be read as another type */
+    yaml_scalar_event_initialize(&event, NULL, NULL,
+                                 (yaml_char_t *)node->value,
+                                 (int)node->len, 1, 1,
+                                 (node->plain) ? YAML_PLAIN_SCALAR_STYLE :
+                                 (is_non_string(node->value)) ?
+                                 YAML_SINGLE_QUOTED_SCALAR_STYLE :
+                                 YAML_ANY_SCALAR_STYLE);
+    return !yaml_emitter_emit(emitter, &event);
+  case nodeSequence:
+    yaml_sequence_start_event_initialize(&event, NULL, NULL, 1,
+                                         (is_flow(node)) ?
+                                         YAML_FLOW_SEQUENCE_STYLE :
+                                         YAML_BLOCK_SEQUENCE_STYLE);
+    if (!yaml_emitter_emit(emitter, &event)) return 1;
+    for (i=0; i < node->n; i++)
+      if (emit_node(emitter, node->items + i)) return 1;
+    yaml_sequence_end_event_initialize(&event);
+    return !yaml_emitter_emit(emitter, &event);
+  case nodeMapping:
+    yaml_mapping_start_event_initialize(&event, NULL, NULL, 1,
+                                        YAML_BLOCK_MAPPING_STYLE);
+    if (!yaml_emitter_emit(emitter, &event)) return 1;
+    for (i=0; i < node->n; i++)
+      if (emit_node(emitter, node->items + i)) return 1;
+    yaml_mapping_end_event_initialize(&event);
+    return !yaml_emitter_emit(emitter, &event);
+  }
+  return 1;
+}
+
+/* Writes the root of storage `s` to yaml file `filename`.  Returns
+   non-zero on error. */
+static int write_file(const DLiteYamlStorage *s, const char *filename)
+{
+  FILE *fp;
+  yaml_emitter_t emitter;
+  yaml_event_t event;
+  int retval=1;
+
+  if (!(fp = fopen(filename, "wb")))
+    return err(1, "cannot open yaml file for writing: %s", filename);
+  if (!yaml_emitter_initialize(&emitter)) {
+    fclose(fp);
+    return err(1, "cannot initialise yaml emitter");
+  }
+  yaml_emitter_set_output_file(&emitter, fp);
+  yaml_emitter_set_unicode(&emitter, 1);
+
+  yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING);
+  if (!yaml_emitter_emit(&emitter, &event)) goto fail;
+  yaml_document_start_event_initialize(&event, NULL, NULL, NULL, 1);
+  if (!yaml_emitter_emit(&emitter, &event)) goto fail;
+  if (emit_node(&emitter, &s->root)) goto fail;
+  yaml_document_end_event_initialize(&event, 1);
+  if (!yaml_emitter_emit(&emitter, &event)) goto fail;
+  yaml_stream_end_event_initialize(&event);
+  if (!yaml_emitter_emit(&emitter, &event)) goto fail;
+  if (!yaml_emitter_flush(&emitter)) goto fail;
+  retval = 0;
+ fail:
+  if (retval) emit_error(&emitter, filename);
+  yaml_emitter_delete(&emitter);
+  if (fclose(fp) && !retval)
+    retval = err(1, "error closing yaml file: %s", filename);
+  return retval;
+}
+
+/* Initialise `node` with the value pointed to by `ptr`, which is of
+   the type of `p`.  Floats are written with the least number of digits
+   needed to read them back exactly.  Returns non-zero on error. */
+static int print_value(Node *node, const void *ptr, const DLiteProperty *p)
+{
+  char buf[64], *s=NULL;
+  size_t size=0;
+  int stat;
+
+  switch (p->type) {
+  case dliteBlob:
+    if (dlite_type_aprint(&s, &size, 0, ptr, p->type, p->size, 0, -2,
+                          dliteFlagRaw) < 0) return 1;
+    stat = node_set_scalar(node, s, -1, 0);
+    free(s);
+    return stat;
+
+  case dliteBool:
+  case dliteInt:
+  case dliteUInt:
+    if (dlite_type_print(buf, sizeof(buf), ptr, p->type, p->size, 0, -2,
+                         dliteFlagRaw) < 0) return 1;
+    return node_set_scalar(node, buf, -1, 1);
+
+  case dliteFloat:
+    if (p->size == 4 || p->size == 8) {
+      double v = (p->size == 4) ? *(float32_t *)ptr : *(float64_t *)ptr;
+      int prec = (p->size == 4) ? 6 : 15, maxprec = (p->size == 4) ? 9 : 17;
+      if (isnan(v))
+        strcpy(buf, ".nan");
+      else if (isinf(v))
+        strcpy(buf, (v < 0) ? "-.inf" : ".inf");
+      else
+        do {
+          snprintf(buf, sizeof(buf), "%.*g", prec, v);
+        } while (prec++ < maxprec &&
+                 ((p->size == 4) ? strtof(buf, NULL) != (float32_t)v :
+                  strtod(buf, NULL) != v));
+      /* Yaml requires a decimal point in floats, also with an exponent */
+      if (isfinite(v) && !strchr(buf, '.')) {
+        char *e = buf + strcspn(buf, "e");
+        memmove(e + 2, e, strlen(e) + 1);
+        memcpy(e, ".0", 2);
+      }
+      return node_set_scalar(node, buf, -1, 1);
+    }
+    if (dlite_type_print(buf, sizeof(buf), ptr, p->type, p->size, 0, 21,
+                         dliteFlagRaw) < 0) return 1;
+    return node_set_scalar(node, buf, -1, 1);
+
+  case dliteFixString:
+    return node_set_scalar(node, ptr, (int)strnlen(ptr, p->size), 0);
+
+  case dliteStringPtr:
+    if (!*(char **)ptr) return node_set_scalar(node, "null", -1, 1);
+    return node_set_scalar(node, *(char **)ptr, -1, 0);
+
+  case dliteDimension:
+    {
+      const DLiteDimension *dim = ptr;
+      node->type = nodeMapping;
+      if (node_add_item(node, "name", dim->name, 0)) return 1;
+      if (dim->description &&
+          node_add_item(node, "description", dim->description, 0))
+        return 1;
+      return 0;
+    }
+
+  case dliteProperty:
+    {
+      const DLiteProperty *prop = ptr;
+      Node *item;
+      int i;
+      node->type = nodeMapping;
+      if (node_add_item(node, "name", prop->name, 0)) return 1;
+      if (dlite_type_set_typename(prop->type, prop->size, buf, sizeof(buf)))
+        return 1;
+      if (node_add_item(node, "type", buf, 1)) return 1;
+      if (prop->ndims > 0) {
+        if (!(item = node_add_key(node, "dims"))) return 1;
+        item->type = nodeSequence;
+        for (i=0; i < prop->ndims; i++)
+          if (node_add_scalar(item, prop->dims[i], 0)) return 1;
+      }
+      if (prop->unit && node_add_item(node, "unit", prop->unit, 0))
+        return 1;
+      if (prop->iri && node_add_item(node, "iri", prop->iri, 0))
+        return 1;
+      if (prop->description &&
+          node_add_item(node, "description", prop->description, 0))
+        return 1;
+      return 0;
+    }
+
+  case dliteRelation:
+    {
+      const DLiteRelation *rel = ptr;
+      node->type = nodeSequence;
+      if (node_add_scalar(node, rel->s, 0) ||
+          node_add_scalar(node, rel->p, 0) ||
+          node_add_scalar(node, rel->o, 0)) return 1;
+      return 0;
+    }
+  }
+  return errx(1, "cannot write property \"%s\" of type %d", p->name,
+              p->type);
+}
+
+/* Initialise `node` as a nested sequence with the elements of property
+   `p` starting at `*ptr`.  `*ptr` is advanced past the printed
+   elements.  Returns non-zero on error. */
+static int print_array(Node *node, const char **ptr, const DLiteProperty *p,
+                       const size_t *dims, int ndims)
+{
+  Node *item;
+  size_t i;
+  node->type = nodeSequence;
+  for (i=0; i < dims[0]; i++) {
+    if (!(item = node_add(node))) return 1;
+    if (ndims > 1) {
+      if (print_array(item, ptr, p, dims+1, ndims-1)) return 1;
+    } else {
+      if (print_value(item, *ptr, p)) return 1;
+      *ptr += p->size;
+    }
+  }
+  return 0;
+}
+
+/* Initialise `node` as a yaml mapping representing `inst`.  Returns
+   non-zero on error. */
+static int print_instance(Node *node, const DLiteInstance *inst)
+{
+  const DLiteMeta *meta = inst->meta;
+  Node *base, *item;
+  char buf[32];
+  size_t i;
+
+  node->type = nodeMapping;
+  if (node_add_item(node, "uuid", inst->uuid, 0)) return 1;
+  if (node_add_item(node, "meta", meta->uri, 0)) return 1;
+  if (inst->uri && node_add_item(node, "uri", inst->uri, 0)) return 1;
+  if (inst->iri && node_add_item(node, "iri", inst->iri, 0)) return 1;
+
+  if (dlite_instance_is_meta(inst)) {
+    /* Metadata are written with dimensions and properties as sequences
+       at the top level */
+    base = node;
+  } else {
+    if (!(item = node_add_key(node, "dimensions"))) return 1;
+    item->type = nodeMapping;
+    for (i=0; i < meta->_ndimensions; i++) {
+      snprintf(buf, sizeof(buf), "%lu", (unsigned long)DLITE_DIM(inst, i));
+      if (node_add_item(item, meta->_dimensions[i].name, buf, 1)) return 1;
+    }
+    if (!(base = node_add_key(node, "properties"))) return 1;
+    base->type = nodeMapping;
+  }
+
+  for (i=0; i < meta->_nproperties; i++) {
+    const DLiteProperty *p = meta->_properties + i;
+    const char *ptr = DLITE_PROP(inst, i);
+    if (!(item = node_add_key(base, p->name))) return 1;
+    if (p->ndims == 0) {
+      if (print_value(item, ptr, p)) return 1;
+    } else {
+      ptr = *(const char **)ptr;
+      if (print_array(item, &ptr, p, DLITE_PROP_DIMS(inst, i), p->ndims))
+        return 1;
+    }
+  }
+  return 0;
+}
+
+
+/* ================================================================
+ * Plugin api
+ * ================================================================ */
+
+/**
+  Returns a new yaml storage.
+
+  Valid `options` are:
+
+  - mode : r | w | a
+      Valid values are:
+      - r   Open existing file for read-only
+      - w   Truncate existing file or create new file
+      - a   Append to existing file or create new file (default)
+ */
+DLiteStorage *yaml_open(const DLiteStoragePlugin *api, const char *uri,
+                        const char *options)
+{
+  DLiteYamlStorage *s=NULL;
+  DLiteStorage *retval=NULL;
+  char *mode_descr = "How to open storage.  Valid values are: "
+    "\"r\" (read-only); "
+    "\"w\" (truncate existing storage or create a new one); "
+    "\"a\" (appends to existing storage or creates a new one)";
+  DLiteOpt opts[] = {
+    {'m', "mode", "a", mode_descr},
+    {0, NULL, NULL, NULL}
+  };
+  char *optcopy = (options) ? strdup(options) : NULL;
+  FILE *fp;
+  int load;
+
+  if (dlite_option_parse(optcopy, opts, 1)) goto fail;
+
+  if (!(s = calloc(1, sizeof(DLiteYamlStorage)))) FAIL("allocation failure");
+  s->api = api;
+  s->root.type = nodeMapping;
+  map_init(&s->index);
+
+  switch (*opts[0].value) {
+  case 'r':
+    load = 1;
+    s->writable = 0;
+    break;
+  case 'a':
+    load = ((fp = fopen(uri, "rb")) != NULL);
+    if (fp) fclose(fp);
+    s->writable = 1;
+    break;
+  case 'w':
+    load = 0;
+    s->writable = 1;
+    s->changed = 1;
+    break;
+  default:
+    FAIL1("invalid \"mode\" value: '%s'. Must be \"r\" (read-only), "
+          "\"w\" (write) or \"a\" (append)", opts[0].value);
+  }
+
+  if (load) {
+    if (load_file(s, uri)) goto fail;
+    dlite_storage_paths_append(uri);
+  }
+
+  retval = (DLiteStorage *)s;
+ fail:
+  if (optcopy) free(optcopy);
+  if (!retval && s) dlite_storage_close((DLiteStorage *)s);
+  return retval;
+}
+
+
+/**
+  Closes yaml storage `s`.  Returns non-zero on error.
+ */
+int yaml_close(DLiteStorage *s)
+{
+  DLiteYamlStorage *ys = (DLiteYamlStorage *)s;
+  int stat=0;
+  if (ys->writable && ys->changed && ys->location)
+    stat = write_file(ys, ys->location);
+  node_clear(&ys->root);
+  map_deinit(&ys->index);
+  return stat;
+}
+
+
+/**
+  Load instance `id` from storage `s` and return it.
+  NULL is returned on error.
+ */
+DLiteInstance *yaml_load(const DLiteStorage *s, const char *id)
+{
+  DLiteYamlStorage *ys = (DLiteYamlStorage *)s;
+  char uuid[DLITE_UUID_LENGTH+1];
+  int *pos, i;
+
+  if (!id || !*id) {
+    if (ys->root.n != 2)
+      return errx(1, "id is required when loading from yaml storage with "
+                  "%s instance: %s", (ys->root.n) ? "more than one" : "no",
+                  s->location), NULL;
+    i = 0;
+  } else {
+    if (dlite_get_uuid(uuid, id) < 0) return NULL;
+    if (!(pos = map_get(&ys->index, uuid)))
+      return errx(1, "no instance with id \"%s\" in storage \"%s\"",
+                  id, s->location), NULL;
+    i = *pos;
+  }
+  return parse_instance(ys, ys->root.items + i + 1,
+                        (id && *id) ? id : ys->root.items[i].value);
+}
+
+
+/**
+  Saves instance `inst` to storage `s`.  Returns non-zero on error.
+*/
+int yaml_save(DLiteStorage *s, const DLiteInstance *inst)
+{
+  DLiteYamlStorage *ys = (DLiteYamlStorage *)s;
+  Node node, *item;
+  int *pos;
+
+  if (!s->writable)
+    return errx(1, "storage \"%s\" is not writable", s->location);
+
+  memset(&node, 0, sizeof(Node));
+  if (print_instance(&node, inst)) {
+    node_clear(&node);
+    return 1;
+  }
+  if ((pos = map_get(&ys->index, inst->uuid))) {
+    item = ys->root.items + *pos + 1;
+    node_clear(item);
+  } else {
+    int n = (int)ys->root.n;
+    if (node_add_scalar(&ys->root, inst->uuid, 0) ||
+        !(item = node_add(&ys->root))) {
+      node_clear(&node);
+      return 1;
+    }
+    map_set(&ys->index, inst->uuid, n);
+  }
+  memcpy(item, &node, sizeof(Node));
+  ys->changed = 1;
+  return 0;
+}
+
+
+/**
+  Returns a new iterator over all instances in storage `s` who's
+  metadata URI matches `metaid`.  If `metaid` is NULL, all instances
+  are iterated over.
+
+  Returns NULL on error.
+ */
+void *yaml_iter_create(const DLiteStorage *s, const char *metaid)
+{
+  DLiteYamlIter *iter;
+  if (!(iter = calloc(1, sizeof(DLiteYamlIter))))
+    return err(1, "allocation failure"), NULL;
+  iter->s = (const DLiteYamlStorage *)s;
+  if (metaid && dlite_get_uuid(iter->metauuid, metaid) < 0) {
+    free(iter);
+    return NULL;
+  }
+  return iter;
+}
+
+/**
+  Writes the uuid of the next instance to `buf`, where `iter` is an
+  iterator returned by yaml_iter_create().
+
+  Returns zero on success, 1 if there are no more UUIDs to iterate
+  over and a negative number on other errors.
+ */
+int yaml_iter_next(void *iter, char *buf)
+{
+  DLiteYamlIter *it = iter;
+  const Node *root = &it->s->root;
+  while (it->pos + 1 < root->n) {
+    const Node *key = root->items + it->pos;
+    const Node *val = root->items + it->pos + 1;
+    it->pos += 2;
+    if (it->metauuid[0]) {
+      char metauuid[DLITE_UUID_LENGTH+1];
+      const char *metauri = node_get_scalar(val, "meta");
+      if (!metauri) metauri = DLITE_ENTITY_SCHEMA;
+      if (dlite_get_uuid(metauuid, metauri) < 0) return -1;
+      if (strcmp(metauuid, it->metauuid)) continue;
+    }
+    if (dlite_get_uuid(buf, key->value) < 0) return -1;
+    return 0;
+  }
+  return 1;
+}
+
+/**
+  Free's iterator created with yaml_iter_create().
+ */
+void yaml_iter_free(void *iter)
+{
+  free(iter);
+}
+
+
+static DLiteStoragePlugin dlite_yaml_plugin = {
+  /* head */
+  "yaml",                   /* name */
+  NULL,                     /* freeapi */
+
+  /* basic api */
+  yaml_open,                /* open */
+  yaml_close,               /* close */
+
+  /* queue api */
+  yaml_iter_create,         /* iterCreate */
+  yaml_iter_next,           /* iterNext */
+  yaml_iter_free,           /* iterFree */
+  NULL,                     /* getUUIDs */
+
+  /* direct api */
+  yaml_load,                /* loadInstance */
+  yaml_save,                /* saveInstance */
+
+  /* datamodel api */
+  NULL,                     /* dataModel */
+  NULL,                     /* dataModelFree */
+
+  NULL,                     /* getMetaURI */
+  NULL,                     /* resolveDimensions */
+  NULL,                     /* getDimensionSize */
+  NULL,                     /* getProperty */
+
+  /* -- datamodel api (optional) */
+  NULL,                     /* setMetaURI */
+  NULL,                     /* setDimensionSize */
+  NULL,                     /* setProperty */
+
+  NULL,                     /* hasDimension */
+  NULL,                     /* hasProperty */
+
+  NULL,                     /* getDataName, obsolute */
+  NULL,                     /* setDataName, obsolute */
+
+  /* internal data */
+  NULL                      /* data */
+};
+
+
+DSL_EXPORT const DLiteStoragePlugin *
+get_dlite_storage_plugin_api(void *state, int *iter)
+{
+  UNUSED(iter);
+  dlite_globals_set(state);
+  return &dlite_yaml_plugin;
+}
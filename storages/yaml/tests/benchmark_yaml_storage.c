@@ -0,0 +1,99 @@
+/* Benchmark comparing the time it takes to load instances from the
+   yaml and json storage plugins.
+
+   Not run by ctest.  Build it with
+
+       cmake --build . --target benchmark_yaml_storage
+
+   and run it manually with the same environment as the tests,
+   optionally with the number of instances as argument. */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlite.h"
+#include "dlite-macros.h"
+
+
+/* Returns a new instance of test-entity with dimensions 2, 3, 4 */
+static DLiteInstance *create_instance(DLiteMeta *meta, int k)
+{
+  DLiteInstance *inst;
+  size_t i, dims[] = {2, 3, 4};
+  unsigned char blob[3] = {1, 2, k};
+  double mydouble = 1.1 * k;
+  char fixstring[3] = "ab";
+  char *mystring = "a string";
+  uint16_t myshort = 17 + k;
+  int *arr;
+
+  if (!(inst = dlite_instance_create(meta, dims, NULL))) return NULL;
+  dlite_instance_set_property(inst, "myblob", blob);
+  dlite_instance_set_property(inst, "mydouble", &mydouble);
+  dlite_instance_set_property(inst, "myfixstring", fixstring);
+  dlite_instance_set_property(inst, "mystring", &mystring);
+  dlite_instance_set_property(inst, "myshort", &myshort);
+  arr = dlite_instance_get_property(inst, "myarray");
+  for (i=0; i<2*3*4; i++) arr[i] = k * 100 + i;
+  return inst;
+}
+
+
+/* Saves `n` instances of `meta` to `driver` storage `path` and times how
+   long it takes to load them back.  Returns non-zero on error. */
+static int benchmark(DLiteMeta *meta, const char *driver, const char *path,
+                     int n)
+{
+  DLiteStorage *s=NULL;
+  DLiteInstance *inst;
+  char (*uuids)[DLITE_UUID_LENGTH+1] = calloc(n, sizeof(*uuids));
+  clock_t t0;
+  int k, stat, retval=1;
+
+  if (!uuids) FAIL("allocation failure");
+  if (!(s = dlite_storage_open(driver, path, "mode=w"))) goto fail;
+  for (k=0; k<n; k++) {
+    if (!(inst = create_instance(meta, k))) goto fail;
+    strcpy(uuids[k], inst->uuid);
+    stat = dlite_instance_save(s, inst);
+    dlite_instance_decref(inst);
+    if (stat) goto fail;
+  }
+  stat = dlite_storage_close(s);
+  s = NULL;
+  if (stat) goto fail;
+
+  t0 = clock();
+  if (!(s = dlite_storage_open(driver, path, "mode=r"))) goto fail;
+  for (k=0; k<n; k++) {
+    if (!(inst = dlite_instance_load(s, uuids[k]))) goto fail;
+    dlite_instance_decref(inst);
+  }
+  stat = dlite_storage_close(s);
+  s = NULL;
+  if (stat) goto fail;
+  printf("%-4s: loaded %d instances in %.3f s\n", driver, n,
+         (double)(clock() - t0) / CLOCKS_PER_SEC);
+  retval = 0;
+ fail:
+  if (s) dlite_storage_close(s);
+  if (uuids) free(uuids);
+  return retval;
+}
+
+
+int main(int argc, char *argv[])
+{
+  char *url = "json://" STRINGIFY(DLITE_ROOT) "/src/tests/test-entity.json";
+  int n = (argc > 1) ? atoi(argv[1]) : 2000;
+  DLiteMeta *meta;
+  int retval=1;
+
+  if (!(meta = (DLiteMeta *)dlite_instance_load_url(url))) return 1;
+  if (benchmark(meta, "json", "benchmark-yaml.json", n) == 0 &&
+      benchmark(meta, "yaml", "benchmark-yaml.yaml", n) == 0)
+    retval = 0;
+  dlite_meta_decref(meta);
+  return retval;
+}
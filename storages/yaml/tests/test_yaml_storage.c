@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "minunit/minunit.h"
+
+#include "dlite.h"
+#include "dlite-macros.h"
+#include "dlite-storage-plugins.h"
+
+#include "config.h"
+
+
+/* Forward declarations */
+void *yaml_iter_create(const DLiteStorage *s, const char *metaid);
+int yaml_iter_next(void *iter, char *buf);
+void yaml_iter_free(void *iter);
+
+#define METAURI "http://onto-ns.com/meta/0.1/test-entity"
+
+DLiteMeta *meta=NULL;
+char uuid[DLITE_UUID_LENGTH+1];
+
+
+/* Returns a new instance of test-entity with dimensions 2, 3, 4 */
+static DLiteInstance *create_instance(int k)
+{
+  DLiteInstance *inst;
+  size_t i, dims[] = {2, 3, 4};
+  unsigned char blob[3] = {1, 2, k};
+  double mydouble = 1.1 * k;
+  char fixstring[3] = "ab";
+  char *mystring = (k == 2) ? "null" : "a string";
+  uint16_t myshort = 17 + k;
+  int *arr;
+
+  if (!(inst = dlite_instance_create(meta, dims, NULL))) return NULL;
+  dlite_instance_set_property(inst, "myblob", blob);
+  dlite_instance_set_property(inst, "mydouble", &mydouble);
+  dlite_instance_set_property(inst, "myfixstring", fixstring);
+  dlite_instance_set_property(inst, "mystring", &mystring);
+  dlite_instance_set_property(inst, "myshort", &myshort);
+  arr = dlite_instance_get_property(inst, "myarray");
+  for (i=0; i<2*3*4; i++) arr[i] = k * 100 + i;
+  return inst;
+}
+
+
+MU_TEST(test_save)
+{
+  char *url = "json://" STRINGIFY(DLITE_ROOT) "/src/tests/test-entity.json";
+  DLiteStorage *s;
+  DLiteInstance *inst;
+  int k;
+
+  mu_check((s = dlite_storage_open("yaml", "test2.yaml", "mode=w")));
+  mu_assert_int_eq(1, dlite_storage_is_writable(s));
+  inst = dlite_instance_get(DLITE_ENTITY_SCHEMA);
+  mu_check(inst);
+  mu_assert_int_eq(0, dlite_instance_save(s, inst));
+  dlite_instance_decref(inst);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  mu_check((meta = (DLiteMeta *)dlite_instance_load_url(url)));
+  mu_check((s = dlite_storage_open("yaml", "test-yaml.yaml", "mode=w")));
+  mu_assert_int_eq(0, dlite_instance_save(s, (DLiteInstance *)meta));
+  for (k=0; k<3; k++) {
+    mu_check((inst = create_instance(k)));
+    mu_assert_int_eq(0, dlite_instance_save(s, inst));
+    if (k == 2) strcpy(uuid, inst->uuid);
+    dlite_instance_decref(inst);
+  }
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_load)
+{
+  DLiteStorage *s;
+  DLiteInstance *inst;
+  unsigned char *blob;
+  char **mystring;
+  int *arr;
+
+  mu_check((s = dlite_storage_open("yaml", "test2.yaml", "mode=r")));
+  mu_assert_int_eq(0, dlite_storage_is_writable(s));
+  inst = dlite_instance_load(s, DLITE_ENTITY_SCHEMA);
+  mu_check(inst);
+  mu_assert_string_eq(DLITE_ENTITY_SCHEMA, inst->uri);
+  dlite_instance_decref(inst);
+  mu_assert_int_eq(0, dlite_storage_close(s));
+
+  mu_check((s = dlite_storage_open("yaml", "test-yaml.yaml", "mode=r")));
+  mu_check((inst = dlite_instance_load(s, uuid)));
+  mu_assert_string_eq(uuid, inst->uuid);
+  mu_assert_int_eq(2, dlite_instance_get_dimension_size(inst, "L"));
+  mu_assert_int_eq(4, dlite_instance_get_dimension_size(inst, "N"));
+  blob = dlite_instance_get_property(inst, "myblob");
+  mu_assert_int_eq(2, blob[2]);
+  mu_assert_double_eq(2.2,
+                      *(double *)dlite_instance_get_property(inst, "mydouble"));
+  mu_assert_string_eq("ab", dlite_instance_get_property(inst, "myfixstring"));
+  mystring = dlite_instance_get_property(inst, "mystring");
+  mu_assert_string_eq("null", *mystring);
+  mu_assert_int_eq(19,
+                   *(uint16_t *)dlite_instance_get_property(inst, "myshort"));
+  arr = dlite_instance_get_property(inst, "myarray");
+  mu_assert_int_eq(200, arr[0]);
+  mu_assert_int_eq(223, arr[23]);
+  dlite_instance_decref(inst);
+
+  mu_check(!dlite_instance_load(s, "no-such-instance"));
+  dlite_errclr();
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_load_entity)
+{
+  char *path = "test-yaml-entity.yaml";
+  DLiteStorage *s;
+  DLiteMeta *entity;
+  DLiteInstance *inst;
+  size_t dims[] = {2};
+  char **names;
+  FILE *fp;
+
+  mu_check((fp = fopen(path, "w")));
+  fprintf(fp,
+          "# A metadata library with a single entity at the root\n"
+          "uri: http://onto-ns.com/meta/0.1/YamlPerson\n"
+          "description: A person.\n"
+          "dimensions:\n"
+          "  - name: N\n"
+          "    description: Number of skills.\n"
+          "properties:\n"
+          "  - name: name\n"
+          "    type: string\n"
+          "  - name: age\n"
+          "    type: float32\n"
+          "    unit: year\n"
+          "  - name: skills\n"
+          "    type: string\n"
+          "    dims: [N]\n");
+  fclose(fp);
+
+  mu_check((s = dlite_storage_open("yaml", path, "mode=a")));
+  mu_assert_int_eq(0, dlite_storage_is_writable(s));
+  mu_check((entity = (DLiteMeta *)dlite_instance_load(s, NULL)));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  mu_check(dlite_instance_is_meta((DLiteInstance *)entity));
+  mu_assert_string_eq("http://onto-ns.com/meta/0.1/YamlPerson", entity->uri);
+  mu_assert_int_eq(1, entity->_ndimensions);
+  mu_assert_int_eq(3, entity->_nproperties);
+  mu_assert_string_eq("year", entity->_properties[1].unit);
+  mu_assert_int_eq(dliteFloat, entity->_properties[1].type);
+  mu_assert_int_eq(1, entity->_properties[2].ndims);
+
+  mu_check((inst = dlite_instance_create(entity, dims, "ada")));
+  names = dlite_instance_get_property(inst, "skills");
+  names[0] = strdup("maths");
+  mu_check((s = dlite_storage_open("yaml", "test-yaml-person.yaml",
+                                   "mode=w")));
+  mu_assert_int_eq(0, dlite_instance_save(s, inst));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_instance_decref(inst);
+
+  mu_check((s = dlite_storage_open("yaml", "test-yaml-person.yaml",
+                                   "mode=r")));
+  mu_check((inst = dlite_instance_load(s, "ada")));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  names = dlite_instance_get_property(inst, "skills");
+  mu_assert_string_eq("maths", names[0]);
+  mu_check(names[1] == NULL);
+  mu_check(*(char **)dlite_instance_get_property(inst, "name") == NULL);
+  dlite_instance_decref(inst);
+  dlite_meta_decref(entity);
+}
+
+
+MU_TEST(test_quoting)
+{
+  char *path = "test-yaml-quoting.yaml", *mystring = "0.1", buf[4096];
+  char fixstring[3] = "no";
+  DLiteStorage *s;
+  DLiteInstance *inst;
+  FILE *fp;
+  size_t n;
+
+  /* Strings that would be read as another type must be quoted */
+  mu_check((inst = create_instance(0)));
+  dlite_instance_set_property(inst, "mystring", &mystring);
+  dlite_instance_set_property(inst, "myfixstring", fixstring);
+  mu_check((s = dlite_storage_open("yaml", path, "mode=w")));
+  mu_assert_int_eq(0, dlite_instance_save(s, inst));
+  mu_assert_int_eq(0, dlite_storage_close(s));
+  dlite_instance_decref(inst);
+
+  mu_check((fp = fopen(path, "r")));
+  n = fread(buf, 1, sizeof(buf)-1, fp);
+  buf[n] = '\0';
+  fclose(fp);
+  mu_check(strstr(buf, "myblob: '010200'"));
+  mu_check(strstr(buf, "mystring: '0.1'"));
+  mu_check(strstr(buf, "myfixstring: 'no'"));
+  mu_check(strstr(buf, "mydouble: 0.0\n"));
+  mu_check(strstr(buf, "myshort: 17\n"));
+}
+
+
+MU_TEST(test_iter)
+{
+  DLiteStorage *s;
+  void *iter;
+  char buf[DLITE_UUID_LENGTH+1];
+  int n, found=0;
+
+  mu_check((s = dlite_storage_open("yaml", "test-yaml.yaml", "mode=r")));
+
+  mu_check((iter = yaml_iter_create(s, NULL)));
+  for (n=0; yaml_iter_next(iter, buf) == 0; n++)
+    if (strcmp(buf, uuid) == 0) found = 1;
+  yaml_iter_free(iter);
+  mu_assert_int_eq(4, n);
+  mu_check(found);
+
+  mu_check((iter = yaml_iter_create(s, METAURI)));
+  for (n=0; yaml_iter_next(iter, buf) == 0; n++) ;
+  yaml_iter_free(iter);
+  mu_assert_int_eq(3, n);
+
+  mu_assert_int_eq(0, dlite_storage_close(s));
+}
+
+
+MU_TEST(test_cleanup)
+{
+  dlite_meta_decref(meta);
+  dlite_storage_plugin_unload_all();
+}
+
+
+/***********************************************************************/
+
+
+MU_TEST_SUITE(test_suite)
+{
+  MU_RUN_TEST(test_save);
+  MU_RUN_TEST(test_load);
+  MU_RUN_TEST(test_load_entity);
+  MU_RUN_TEST(test_quoting);
+  MU_RUN_TEST(test_iter);
+  MU_RUN_TEST(test_cleanup);
+}
+
+int main()
+{
+  MU_RUN_SUITE(test_suite);
+  MU_REPORT();
+  return (minunit_fail) ? 1 : 0;
+}